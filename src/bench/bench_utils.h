@@ -0,0 +1,119 @@
+#pragma once
+
+//
+// Utilities shared by the benchmarks.
+// Each benchmark is a standalone program with its own main, built with optimizations. E.g, from src:
+//	g++ -std=c++20 -O2 -nostdinc++ -I. -fno-exceptions bench/tlsf_bench.cpp -o tlsf_bench -lpthread
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "vector"
+#include "algorithm"
+
+namespace czbench
+{
+	inline uint64_t nowNs()
+	{
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+	}
+
+	// Keeps the compiler from optimizing away a value we don't otherwise use
+	template<typename T>
+	inline void doNotOptimize(const T& v)
+	{
+		asm volatile("" : : "g"(&v) : "memory");
+	}
+
+	// Best time of several runs of fn, in ms. prepare runs before each one, and isn't timed
+	template<typename Prepare, typename F>
+	double bestTimeMs(int runs, Prepare&& prepare, F&& fn)
+	{
+		uint64_t bestNs = ~uint64_t(0);
+		for (int i = 0; i < runs; i++)
+		{
+			prepare();
+			const uint64_t start = nowNs();
+			fn();
+			const uint64_t elapsed = nowNs() - start;
+			bestNs = elapsed < bestNs ? elapsed : bestNs;
+		}
+		return static_cast<double>(bestNs) / 1e6;
+	}
+
+	// xorshift64*, so runs are repeatable and don't depend on the C library
+	struct Random
+	{
+		uint64_t state = 0x9E3779B97F4A7C15ull;
+
+		uint64_t next()
+		{
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1Dull;
+		}
+
+		// In [lo, hi]
+		uint32_t range(uint32_t lo, uint32_t hi)
+		{
+			return lo + static_cast<uint32_t>(next() % (hi - lo + 1));
+		}
+	};
+
+	struct Distribution
+	{
+		size_t count = 0;
+		uint64_t p50 = 0;
+		uint64_t p99 = 0;
+		uint64_t p999 = 0;
+		uint64_t max = 0;
+		double mean = 0;
+	};
+
+	// Sorts the samples
+	inline Distribution summarize(cz::vector<uint64_t>& samples)
+	{
+		Distribution d;
+		if (samples.empty())
+		{
+			return d;
+		}
+
+		std::sort(samples.begin(), samples.end());
+		auto at = [&](double fraction)
+		{
+			return samples[static_cast<size_t>(fraction * static_cast<double>(samples.size() - 1))];
+		};
+
+		uint64_t total = 0;
+		for (uint64_t s : samples)
+		{
+			total += s;
+		}
+
+		d.count = samples.size();
+		d.p50 = at(0.5);
+		d.p99 = at(0.99);
+		d.p999 = at(0.999);
+		d.max = samples.back();
+		d.mean = static_cast<double>(total) / static_cast<double>(samples.size());
+		return d;
+	}
+
+	inline void printDistributionHeader()
+	{
+		printf("%-32s %10s %8s %8s %8s %8s %10s\n", "", "samples", "mean", "p50", "p99", "p99.9", "max (ns)");
+	}
+
+	inline void printDistribution(const char* name, const Distribution& d)
+	{
+		printf("%-32s %10zu %8.1f %8llu %8llu %8llu %10llu\n", name, d.count, d.mean,
+			static_cast<unsigned long long>(d.p50), static_cast<unsigned long long>(d.p99),
+			static_cast<unsigned long long>(d.p999), static_cast<unsigned long long>(d.max));
+	}
+
+} // namespace czbench
@@ -0,0 +1,264 @@
+//
+// Cross-thread recycling of buffers: cz::concurrent_pool vs the C library's malloc.
+//
+// Producer threads allocate buffers and hand them through a ring to consumer threads, which free them, so every
+// buffer is freed by a different thread than the one that allocated it. Reports buffers per second for 1 to N
+// producer/consumer pairs (N defaults to half the cores, and can be given as the first argument).
+//
+
+#include "bench_utils.h"
+#include "impl/concurrent_pool.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+using namespace czbench;
+
+namespace
+{
+	constexpr size_t gBufferSize = 256;
+	constexpr size_t gBuffersPerPair = 2000000;
+	constexpr size_t gRingSize = 1024;
+
+	using Pool = cz::concurrent_pool<gBufferSize>;
+
+	// Single producer, single consumer
+	template<typename T>
+	class SpscRing
+	{
+	public:
+		void push(T&& v)
+		{
+			const size_t tail = __atomic_load_n(&m_tail, __ATOMIC_RELAXED);
+			while (tail - __atomic_load_n(&m_head, __ATOMIC_ACQUIRE) == gRingSize)
+			{
+				sched_yield();
+			}
+			m_items[tail % gRingSize] = std::move(v);
+			__atomic_store_n(&m_tail, tail + 1, __ATOMIC_RELEASE);
+		}
+
+		T pop()
+		{
+			const size_t head = __atomic_load_n(&m_head, __ATOMIC_RELAXED);
+			while (__atomic_load_n(&m_tail, __ATOMIC_ACQUIRE) == head)
+			{
+				sched_yield();
+			}
+			T v = std::move(m_items[head % gRingSize]);
+			__atomic_store_n(&m_head, head + 1, __ATOMIC_RELEASE);
+			return v;
+		}
+
+	private:
+		T m_items[gRingSize] = {};
+		// Padding, so producer and consumer don't share a cache line
+		char m_pad0[64];
+		size_t m_head = 0;
+		char m_pad1[64];
+		size_t m_tail = 0;
+	};
+
+	void touch(void* ptr)
+	{
+		*static_cast<volatile char*>(ptr) = 1;
+	}
+
+	struct MallocHeap
+	{
+		using item = void*;
+
+		struct local
+		{
+			explicit local(MallocHeap&) {}
+
+			void* produce()
+			{
+				void* ptr = malloc(gBufferSize);
+				touch(ptr);
+				return ptr;
+			}
+
+			void consume(void* ptr)
+			{
+				free(ptr);
+			}
+		};
+	};
+
+	struct PoolHeap
+	{
+		using item = void*;
+
+		explicit PoolHeap(size_t capacity)
+			: pool(capacity)
+		{
+		}
+
+		struct local
+		{
+			explicit local(PoolHeap& heap)
+				: cache(heap.pool)
+			{
+			}
+
+			void* produce()
+			{
+				void* ptr = cache.allocate();
+				if (!ptr)
+				{
+					printf("Pool exhausted\n");
+					exit(1);
+				}
+				touch(ptr);
+				return ptr;
+			}
+
+			void consume(void* ptr)
+			{
+				cache.deallocate(ptr);
+			}
+
+			Pool::cache cache;
+		};
+
+		Pool pool;
+	};
+
+	// cz::vector<uint8_t> buffers, with whatever VectorAllocator backend is set
+	struct VectorHeap
+	{
+		using item = cz::vector<uint8_t>;
+
+		struct local
+		{
+			explicit local(VectorHeap&) {}
+
+			item produce()
+			{
+				item v;
+				v.reserve(gBufferSize);
+				v.push_back(1);
+				return v;
+			}
+
+			void consume(item&& v)
+			{
+				item tmp(std::move(v));
+			}
+		};
+	};
+
+	template<typename Heap>
+	struct Pair
+	{
+		Heap* heap;
+		SpscRing<typename Heap::item> ring;
+		int* start;
+	};
+
+	void waitForStart(int* start)
+	{
+		while (!__atomic_load_n(start, __ATOMIC_ACQUIRE))
+		{
+			sched_yield();
+		}
+	}
+
+	template<typename Heap>
+	void* producer(void* arg)
+	{
+		Pair<Heap>& pair = *static_cast<Pair<Heap>*>(arg);
+		typename Heap::local heap(*pair.heap);
+		waitForStart(pair.start);
+		for (size_t i = 0; i < gBuffersPerPair; i++)
+		{
+			pair.ring.push(heap.produce());
+		}
+		return nullptr;
+	}
+
+	template<typename Heap>
+	void* consumer(void* arg)
+	{
+		Pair<Heap>& pair = *static_cast<Pair<Heap>*>(arg);
+		typename Heap::local heap(*pair.heap);
+		waitForStart(pair.start);
+		for (size_t i = 0; i < gBuffersPerPair; i++)
+		{
+			heap.consume(pair.ring.pop());
+		}
+		return nullptr;
+	}
+
+	// Returns buffers per second
+	template<typename Heap>
+	double run(Heap& heap, int pairCount)
+	{
+		int start = 0;
+		Pair<Heap>* pairs = new Pair<Heap>[pairCount];
+		cz::vector<pthread_t> threads(pairCount * 2);
+		for (int i = 0; i < pairCount; i++)
+		{
+			pairs[i].heap = &heap;
+			pairs[i].start = &start;
+			pthread_create(&threads[i * 2], nullptr, &producer<Heap>, &pairs[i]);
+			pthread_create(&threads[i * 2 + 1], nullptr, &consumer<Heap>, &pairs[i]);
+		}
+
+		const uint64_t startTime = nowNs();
+		__atomic_store_n(&start, 1, __ATOMIC_RELEASE);
+		for (pthread_t t : threads)
+		{
+			pthread_join(t, nullptr);
+		}
+		const uint64_t elapsed = nowNs() - startTime;
+
+		delete[] pairs;
+		return static_cast<double>(gBuffersPerPair * pairCount) * 1e9 / static_cast<double>(elapsed);
+	}
+
+	template<typename Heap>
+	void report(const char* name, Heap& heap, int pairCount)
+	{
+		// Warm up, so the first run doesn't pay for page faults
+		run(heap, pairCount);
+		printf("%-36s %8d %12.2f\n", name, pairCount, run(heap, pairCount) / 1e6);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	const int maxPairs = argc > 1 ? atoi(argv[1]) : (cores > 2 ? static_cast<int>(cores / 2) : 1);
+	// Enough for what is in the rings, plus what the caches keep
+	const size_t poolCapacity = static_cast<size_t>(maxPairs) * (gRingSize + 8 * Pool::batch_size);
+
+	printf("%zu byte buffers, %zu per pair\n", gBufferSize, gBuffersPerPair);
+	printf("%-36s %8s %12s\n", "", "pairs", "M buffers/s");
+
+	for (int pairCount = 1; pairCount <= maxPairs; pairCount *= 2)
+	{
+		MallocHeap mallocHeap;
+		report("malloc", mallocHeap, pairCount);
+
+		PoolHeap poolHeap(poolCapacity);
+		report("concurrent_pool::cache", poolHeap, pairCount);
+
+		VectorHeap vectorHeap;
+		report("vector<uint8_t>, malloc", vectorHeap, pairCount);
+
+		{
+			Pool pool(poolCapacity);
+			cz::concurrent_pool_backend<Pool> backend(pool);
+			cz::detail::VectorAllocator::_setBackend(backend.get());
+			report("vector<uint8_t>, concurrent_pool", vectorHeap, pairCount);
+			cz::detail::VectorAllocator::_setBackend(nullptr);
+			// run allocates in this thread too, and the pool goes away before it exits
+			backend.flush_thread_cache();
+		}
+	}
+
+	return 0;
+}
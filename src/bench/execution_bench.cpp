@@ -0,0 +1,114 @@
+//
+// Speedup of the unseq and par execution policies over seq, for each algorithm that has policy overloads.
+//
+// par runs on cz::default_thread_pool(). Pass a thread count as the first argument to use a pool of that size instead.
+//
+
+#include "bench_utils.h"
+#include "execution"
+#include <stdlib.h>
+
+using namespace czbench;
+
+namespace
+{
+	constexpr size_t gCount = 16 * 1024 * 1024;
+	constexpr int gRuns = 5;
+
+	struct Data
+	{
+		Data()
+			: a(gCount, 0.0f)
+			, b(gCount, 0.0f)
+			, out(gCount, 0.0f)
+		{
+		}
+
+		cz::vector<float> a;
+		cz::vector<float> b;
+		cz::vector<float> out;
+	};
+
+	// fn is called with each policy, and returns something that depends on all the work, so it's not optimized away
+	template<typename F>
+	void report(const char* name, F&& fn)
+	{
+		auto time = [&](auto policy)
+		{
+			return bestTimeMs(gRuns, [] {}, [&] { doNotOptimize(fn(policy)); });
+		};
+
+		const double seqMs = time(std::execution::seq);
+		const double unseqMs = time(std::execution::unseq);
+		const double parMs = time(std::execution::par);
+		printf("%-18s %10.2f %10.2f %7.2fx %10.2f %7.2fx\n", name, seqMs, unseqMs, seqMs / unseqMs, parMs, seqMs / parMs);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	cz::thread_pool* pool = nullptr;
+	if (argc > 1)
+	{
+		pool = new cz::thread_pool(static_cast<size_t>(atoi(argv[1])));
+		cz::set_default_thread_pool(pool);
+	}
+
+	Data data;
+	Random rnd;
+	for (size_t i = 0; i < gCount; i++)
+	{
+		data.a[i] = static_cast<float>(rnd.next() & 0xFFFF) / 256.0f;
+		data.b[i] = static_cast<float>(rnd.next() & 0xFFFF) / 256.0f;
+	}
+
+	printf("%zu floats, best of %d runs, %zu threads\n", gCount, gRuns, cz::default_thread_pool().concurrency());
+	printf("%-18s %10s %10s %8s %10s %8s\n", "", "seq (ms)", "unseq (ms)", "", "par (ms)", "");
+
+	report("for_each", [&](auto policy)
+	{
+		std::for_each(policy, data.out.begin(), data.out.end(), [](float& v) { v = v * 0.5f + 1.0f; });
+		return data.out[gCount / 2];
+	});
+
+	report("transform", [&](auto policy)
+	{
+		std::transform(policy, data.a.begin(), data.a.end(), data.out.begin(), [](float v) { return v * v * 0.5f + v; });
+		return data.out[gCount / 2];
+	});
+
+	report("fill", [&](auto policy)
+	{
+		std::fill(policy, data.out.begin(), data.out.end(), 1.0f);
+		return data.out[gCount / 2];
+	});
+
+	report("copy", [&](auto policy)
+	{
+		std::copy(policy, data.a.begin(), data.a.end(), data.out.begin());
+		return data.out[gCount / 2];
+	});
+
+	report("reduce", [&](auto policy)
+	{
+		return std::reduce(policy, data.a.begin(), data.a.end(), 0.0f);
+	});
+
+	report("transform_reduce", [&](auto policy)
+	{
+		return std::transform_reduce(policy, data.a.begin(), data.a.end(), data.b.begin(), 0.0f);
+	});
+
+	report("count_if", [&](auto policy)
+	{
+		return std::count_if(policy, data.a.begin(), data.a.end(), [](float v) { return v > 128.0f; });
+	});
+
+	if (pool)
+	{
+		cz::set_default_thread_pool(nullptr);
+		delete pool;
+	}
+	cz::shutdown_default_thread_pool();
+	return 0;
+}
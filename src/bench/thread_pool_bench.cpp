@@ -0,0 +1,154 @@
+//
+// Scaling of the thread_pool parallel algorithms, from 1 thread to all the cores.
+//
+// Runs sort, transform and reduce workloads over a big cz::vector with pools of increasing concurrency, and reports
+// the best time of a few runs, and the speedup over a plain sequential loop.
+// Pass the max concurrency as the first argument to override the number of cores.
+//
+
+#include "bench_utils.h"
+#include "impl/thread_pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+using namespace czbench;
+
+namespace
+{
+	constexpr size_t gCount = 16 * 1024 * 1024;
+	constexpr size_t gGrain = 64 * 1024;
+	constexpr int gRuns = 3;
+
+	struct Data
+	{
+		Data()
+			: input(gCount, 0)
+			, scratch(gCount, 0)
+			, floats(gCount, 0.0f)
+			, output(gCount, 0.0f)
+		{
+		}
+
+		cz::vector<uint32_t> input;
+		cz::vector<uint32_t> scratch;
+		cz::vector<float> floats;
+		cz::vector<float> output;
+	};
+
+	double sortTime(Data& data, cz::thread_pool* pool)
+	{
+		return bestTimeMs(gRuns,
+			[&] { memcpy(data.scratch.data(), data.input.data(), gCount * sizeof(uint32_t)); },
+			[&]
+			{
+				if (pool)
+				{
+					cz::parallel_sort(*pool, data.scratch.begin(), data.scratch.end(), std::less<uint32_t>());
+				}
+				else
+				{
+					std::sort(data.scratch.begin(), data.scratch.end());
+				}
+				doNotOptimize(data.scratch[gCount / 2]);
+			});
+	}
+
+	double transformTime(Data& data, cz::thread_pool* pool)
+	{
+		auto transform = [&](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; i++)
+			{
+				const float v = data.floats[i];
+				data.output[i] = v * v * 0.5f + v;
+			}
+		};
+
+		return bestTimeMs(gRuns,
+			[] {},
+			[&]
+			{
+				if (pool)
+				{
+					cz::parallel_for(*pool, size_t(0), gCount, gGrain, transform);
+				}
+				else
+				{
+					transform(0, gCount);
+				}
+				doNotOptimize(data.output[gCount / 2]);
+			});
+	}
+
+	double reduceTime(Data& data, cz::thread_pool* pool)
+	{
+		auto reduce = [&](size_t first, size_t last)
+		{
+			uint64_t sum = 0;
+			for (size_t i = first; i < last; i++)
+			{
+				sum += data.input[i];
+			}
+			return sum;
+		};
+
+		return bestTimeMs(gRuns,
+			[] {},
+			[&]
+			{
+				uint64_t sum;
+				if (pool)
+				{
+					sum = cz::parallel_reduce(*pool, size_t(0), gCount, gGrain, uint64_t(0), reduce,
+						[](uint64_t a, uint64_t b) { return a + b; });
+				}
+				else
+				{
+					sum = reduce(0, gCount);
+				}
+				doNotOptimize(sum);
+			});
+	}
+
+	void report(const char* name, double ms, double sequentialMs)
+	{
+		printf("  %-12s %10.2f ms %8.2fx\n", name, ms, sequentialMs / ms);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	const size_t maxConcurrency = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : static_cast<size_t>(cores > 0 ? cores : 1);
+
+	Data data;
+	Random rnd;
+	for (size_t i = 0; i < gCount; i++)
+	{
+		data.input[i] = static_cast<uint32_t>(rnd.next());
+		data.floats[i] = static_cast<float>(data.input[i] & 0xFFFF) / 256.0f;
+	}
+
+	printf("%zu elements, best of %d runs\n", gCount, gRuns);
+	const double sortMs = sortTime(data, nullptr);
+	const double transformMs = transformTime(data, nullptr);
+	const double reduceMs = reduceTime(data, nullptr);
+	printf("Sequential\n");
+	report("sort", sortMs, sortMs);
+	report("transform", transformMs, transformMs);
+	report("reduce", reduceMs, reduceMs);
+
+	for (size_t concurrency = 1; concurrency <= maxConcurrency;)
+	{
+		cz::thread_pool pool(concurrency);
+		printf("thread_pool, %zu threads\n", concurrency);
+		report("sort", sortTime(data, &pool), sortMs);
+		report("transform", transformTime(data, &pool), transformMs);
+		report("reduce", reduceTime(data, &pool), reduceMs);
+
+		// Powers of 2, and always the max
+		concurrency = (concurrency * 2 > maxConcurrency && concurrency < maxConcurrency) ? maxConcurrency : concurrency * 2;
+	}
+
+	return 0;
+}
@@ -0,0 +1,125 @@
+//
+// Latency distribution of cz::tlsf vs the C library's malloc, for single allocate/deallocate calls.
+//
+// Keeps a set of live allocations, and on each step picks a random slot, freeing it if it's in use, or allocating a
+// random size otherwise, so the heap stays at around half of the slots, with a mix of sizes that fragments it.
+// Each call is timed separately. What matters for real-time code is p99 and max, not the mean.
+// max also catches the process being preempted, so run it pinned to a core, with a real-time priority if possible:
+//	chrt -f 50 taskset -c 2 ./tlsf_bench
+//
+
+#include "bench_utils.h"
+#include "impl/tlsf.h"
+#include <stdlib.h>
+#include <string.h>
+
+using namespace czbench;
+
+namespace
+{
+	constexpr size_t gSlots = 4096;
+	constexpr size_t gSteps = 1000000;
+	constexpr size_t gHeapBytes = 256 * 1024 * 1024;
+
+	struct Workload
+	{
+		const char* name;
+		uint32_t minSize;
+		uint32_t maxSize;
+	};
+
+	struct MallocHeap
+	{
+		void* allocate(size_t bytes) { return malloc(bytes); }
+		void deallocate(void* ptr) { free(ptr); }
+	};
+
+	template<typename Heap>
+	void run(Heap& heap, const Workload& workload, Distribution& allocs, Distribution& frees)
+	{
+		cz::vector<void*> slots(gSlots, nullptr);
+		cz::vector<uint64_t> allocTimes;
+		cz::vector<uint64_t> freeTimes;
+		allocTimes.reserve(gSteps);
+		freeTimes.reserve(gSteps);
+
+		Random rnd;
+		for (size_t step = 0; step < gSteps; step++)
+		{
+			void*& slot = slots[rnd.next() % gSlots];
+			if (slot)
+			{
+				const uint64_t start = nowNs();
+				heap.deallocate(slot);
+				freeTimes.push_back(nowNs() - start);
+				slot = nullptr;
+			}
+			else
+			{
+				const uint32_t size = rnd.range(workload.minSize, workload.maxSize);
+				const uint64_t start = nowNs();
+				slot = heap.allocate(size);
+				allocTimes.push_back(nowNs() - start);
+				if (!slot)
+				{
+					printf("Out of memory\n");
+					exit(1);
+				}
+				// Touch it, like real code would
+				*static_cast<char*>(slot) = 1;
+			}
+		}
+
+		for (void* p : slots)
+		{
+			if (p)
+			{
+				heap.deallocate(p);
+			}
+		}
+
+		allocs = summarize(allocTimes);
+		frees = summarize(freeTimes);
+	}
+
+	template<typename Heap>
+	void report(const char* heapName, Heap& heap, const Workload& workload)
+	{
+		Distribution allocs, frees;
+		// First run is a warm up, so page faults from touching new memory don't end up in the results
+		run(heap, workload, allocs, frees);
+		run(heap, workload, allocs, frees);
+
+		char name[64];
+		snprintf(name, sizeof(name), "%s allocate", heapName);
+		printDistribution(name, allocs);
+		snprintf(name, sizeof(name), "%s deallocate", heapName);
+		printDistribution(name, frees);
+	}
+}
+
+int main()
+{
+	const Workload workloads[] = {
+		{ "Small (16-256 bytes)", 16, 256 },
+		{ "Mixed (16-64K bytes)", 16, 64 * 1024 },
+	};
+
+	void* memory = malloc(gHeapBytes);
+	memset(memory, 0, gHeapBytes);
+
+	for (const Workload& workload : workloads)
+	{
+		printf("\n%s, %zu slots, %zu steps\n", workload.name, gSlots, gSteps);
+		printDistributionHeader();
+
+		cz::tlsf heap(memory, gHeapBytes);
+		report("cz::tlsf", heap, workload);
+
+		MallocHeap mallocHeap;
+		report("malloc", mallocHeap, workload);
+	}
+
+	free(memory);
+	return 0;
+}
@@ -0,0 +1,63 @@
+/**
+Allocation with an alignment bigger than what malloc guarantees.
+
+	- aligned_malloc(size, alignment): alignment needs to be a power of 2. Returns nullptr on failure.
+	- aligned_free(ptr): Frees memory from aligned_malloc. Accepts nullptr.
+
+Uses posix_memalign or _aligned_malloc where available. Elsewhere (e.g: AVR), it over-allocates with malloc and keeps
+the original pointer right before the aligned block.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdlib.h>
+#if defined(_WIN32)
+	#include <malloc.h>
+#endif
+
+#if defined(_WIN32)
+	#define CZ_ALIGNED_ALLOC_WIN32 1
+#elif defined(__unix__) || defined(__APPLE__)
+	#define CZ_ALIGNED_ALLOC_POSIX 1
+#endif
+
+namespace cz
+{
+
+inline void* aligned_malloc(size_t size, size_t alignment)
+{
+#if defined(CZ_ALIGNED_ALLOC_WIN32)
+	return _aligned_malloc(size ? size : 1, alignment);
+#elif defined(CZ_ALIGNED_ALLOC_POSIX)
+	// posix_memalign requires at least the alignment of a pointer
+	void* ptr = nullptr;
+	return posix_memalign(&ptr, alignment < sizeof(void*) ? sizeof(void*) : alignment, size ? size : 1) == 0 ? ptr : nullptr;
+#else
+	void* raw = malloc(size + alignment + sizeof(void*));
+	if (!raw)
+	{
+		return nullptr;
+	}
+	const uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+	reinterpret_cast<void**>(aligned)[-1] = raw;
+	return reinterpret_cast<void*>(aligned);
+#endif
+}
+
+inline void aligned_free(void* ptr)
+{
+#if defined(CZ_ALIGNED_ALLOC_WIN32)
+	_aligned_free(ptr);
+#elif defined(CZ_ALIGNED_ALLOC_POSIX)
+	free(ptr);
+#else
+	if (ptr)
+	{
+		free(reinterpret_cast<void**>(ptr)[-1]);
+	}
+#endif
+}
+
+} // namespace cz
@@ -0,0 +1,77 @@
+/**
+std::allocator, std::construct_at, std::destroy_at and std::allocator_arg.
+
+Besides being the standard way to allocate/construct, these are what compilers allow in constant evaluation
+(C++20 constexpr allocation), so containers use them when std::is_constant_evaluated() is true. Compilers recognize
+them by name, so they need to be in namespace std.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <new>
+
+namespace std
+{
+
+// Tag for passing an allocator as the first argument (e.g: to a coroutine, so its frame uses that allocator)
+struct allocator_arg_t
+{
+	explicit allocator_arg_t() = default;
+};
+inline constexpr allocator_arg_t allocator_arg{};
+
+template<typename T>
+struct allocator
+{
+	using value_type = T;
+	using size_type = size_t;
+
+	constexpr allocator() noexcept = default;
+
+	template<typename U>
+	constexpr allocator(const allocator<U>&) noexcept
+	{
+	}
+
+	[[nodiscard]] constexpr T* allocate(size_t n)
+	{
+		if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+			}
+		}
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+
+	constexpr void deallocate(T* p, size_t)
+	{
+		if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				::operator delete(p, std::align_val_t(alignof(T)));
+				return;
+			}
+		}
+		::operator delete(p);
+	}
+};
+
+template<typename T, typename... Args>
+constexpr T* construct_at(T* p, Args&&... args)
+{
+	return ::new(static_cast<void*>(p)) T(std::forward<Args>(args)...);
+}
+
+template<typename T>
+constexpr void destroy_at(T* p)
+{
+	p->~T();
+}
+
+} // namespace std
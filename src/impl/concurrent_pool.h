@@ -0,0 +1,397 @@
+/**
+Fixed capacity lock-free pool of equally sized blocks, for memory that is allocated in one thread and freed in another.
+
+All the blocks are allocated upfront in a single buffer. Free blocks are kept in a Treiber stack, where each node
+is not a single block, but a batch of up to batch_size blocks, so moving a whole batch in or out of the shared
+stack is a single CAS.
+To avoid the ABA problem, the stack head is an index (not a pointer) packed together with a tag that changes on
+every operation. The links between batches are kept in a separate array, not in the blocks, so a thread that read a
+head another thread just popped only reads a stale link (with an atomic load), never memory that is in use, and the
+tag makes its CAS fail.
+With a 64 bit CAS (any 64 bit target, and most 32 bit ones), the index and tag are 32 bits each. Otherwise they are
+16 bits, so capacity is limited to 65534 blocks, and the tag wraps after 65536 pushes/pops. ABA is then possible if a
+thread is suspended in the middle of a pop for that long.
+
+Each thread should use its own concurrent_pool::cache, which keeps a few blocks locally, and only touches the shared
+stack once every batch_size allocations or deallocations.
+
+concurrent_pool_backend allows using a pool as the VectorAllocator backend, so small vector buffers come from the
+pool. E.g:
+	static cz::concurrent_pool<256> gPool(4096);
+	static cz::concurrent_pool_backend<decltype(gPool)> gBackend(gPool);
+	cz::detail::VectorAllocator::_setBackend(gBackend.get());
+
+bench/concurrent_pool_bench.cpp compares it against malloc, with buffers allocated and freed in different threads.
+*/
+
+#pragma once
+
+#include "vector.h"
+#include <cstdint>
+
+#define CZ_CONCURRENT_POOL_ASSERT(x) assert(x)
+
+namespace cz
+{
+
+template<size_t BlockSize, size_t Alignment = alignof(void*), size_t BatchSize = 32>
+class concurrent_pool
+{
+public:
+	using size_type = std::size_t;
+	// Index + tag need to fit something we can CAS natively
+	static constexpr bool wide_tag = __GCC_ATOMIC_LLONG_LOCK_FREE == 2;
+	using tagged_type = std::conditional_t<wide_tag, uint64_t, uint32_t>;
+	using index_type = std::conditional_t<wide_tag, uint32_t, uint16_t>;
+
+	static constexpr index_type invalid_index = static_cast<index_type>(-1);
+	static constexpr size_type batch_size = BatchSize;
+
+private:
+	// What a free block contains
+	struct free_block
+	{
+		// Next block in the same batch
+		index_type next;
+	};
+
+	// One per block, but only used for the first block of a batch
+	struct batch_link
+	{
+		// Next batch in the stack. Read by threads racing to pop this batch, so always accessed atomically
+		index_type nextBatch;
+		// How many blocks this batch has
+		index_type count;
+	};
+
+	static constexpr size_type _max(size_type a, size_type b)
+	{
+		return a > b ? a : b;
+	}
+
+public:
+	static constexpr size_type block_size = (_max(BlockSize, sizeof(free_block)) + Alignment - 1) & ~(Alignment - 1);
+
+	static_assert((Alignment & (Alignment - 1)) == 0, "Alignment needs to be a power of 2");
+	static_assert(BatchSize > 0, "");
+
+	/**
+	 * Per thread cache. Needs to be destroyed before the pool, and only used by one thread at a time.
+	 */
+	class cache
+	{
+	public:
+		explicit cache(concurrent_pool& pool)
+			: m_pool(pool)
+		{
+		}
+
+		cache(const cache&) = delete;
+		cache& operator=(const cache&) = delete;
+
+		~cache()
+		{
+			flush();
+		}
+
+		void* allocate()
+		{
+			if (m_count == 0)
+			{
+				m_head = m_pool._popBatch(m_count);
+				if (m_count == 0)
+				{
+					return nullptr;
+				}
+			}
+
+			index_type idx = m_head;
+			m_head = m_pool._block(idx)->next;
+			--m_count;
+			return m_pool._block(idx);
+		}
+
+		void deallocate(void* ptr)
+		{
+			index_type idx = m_pool._indexOf(ptr);
+			// Keep up to 2 batches, so alternating allocate/deallocate at the boundary doesn't hit the shared stack
+			if (m_count == 2 * BatchSize)
+			{
+				_returnBatch(BatchSize);
+			}
+			m_pool._block(idx)->next = m_head;
+			m_head = idx;
+			++m_count;
+		}
+
+		// Gives all the cached blocks back to the pool
+		void flush()
+		{
+			while (m_count)
+			{
+				_returnBatch(m_count < BatchSize ? m_count : BatchSize);
+			}
+		}
+
+		size_type size() const
+		{
+			return m_count;
+		}
+
+		concurrent_pool& pool() const
+		{
+			return m_pool;
+		}
+
+	private:
+
+		void _returnBatch(size_type count)
+		{
+			CZ_CONCURRENT_POOL_ASSERT(count && count <= m_count);
+			index_type first = m_head;
+			index_type last = first;
+			for (size_type i = 1; i < count; ++i)
+			{
+				last = m_pool._block(last)->next;
+			}
+			m_head = m_pool._block(last)->next;
+			m_count -= count;
+			m_pool._block(last)->next = invalid_index;
+			m_pool._pushBatch(first, count);
+		}
+
+		concurrent_pool& m_pool;
+		index_type m_head = invalid_index;
+		size_type m_count = 0;
+	};
+
+	explicit concurrent_pool(size_type capacity)
+		: m_capacity(capacity)
+	{
+		CZ_CONCURRENT_POOL_ASSERT(capacity > 0 && capacity < invalid_index);
+		// Over-allocate, so we can align the start.
+		// Uses malloc directly, since VectorAllocator might be using this pool as backend.
+		m_buffer = malloc(capacity * block_size + Alignment);
+		CZ_CONCURRENT_POOL_ASSERT(m_buffer);
+		m_blocks = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(m_buffer) + Alignment - 1) & ~uintptr_t(Alignment - 1));
+		m_links = static_cast<batch_link*>(malloc(capacity * sizeof(batch_link)));
+		CZ_CONCURRENT_POOL_ASSERT(m_links);
+
+		// Chain all the blocks into batches
+		for (size_type first = 0; first < capacity; first += BatchSize)
+		{
+			const size_type count = (capacity - first) < BatchSize ? (capacity - first) : BatchSize;
+			for (size_type i = first; i < first + count; ++i)
+			{
+				_block(i)->next = (i + 1 < first + count) ? static_cast<index_type>(i + 1) : invalid_index;
+			}
+			_pushBatch(static_cast<index_type>(first), count);
+		}
+	}
+
+	concurrent_pool(const concurrent_pool&) = delete;
+	concurrent_pool& operator=(const concurrent_pool&) = delete;
+
+	~concurrent_pool()
+	{
+		free(m_links);
+		free(m_buffer);
+	}
+
+	size_type capacity() const
+	{
+		return m_capacity;
+	}
+
+	// Returns true if ptr is a block from this pool
+	bool owns(const void* ptr) const
+	{
+		const char* p = static_cast<const char*>(ptr);
+		return p >= m_blocks && p < m_blocks + m_capacity * block_size;
+	}
+
+	/**
+	 * Allocation without a cache. Always touches the shared stack, so prefer using a cache.
+	 * Returns nullptr if the pool is exhausted.
+	 */
+	void* allocate()
+	{
+		size_type count;
+		index_type idx = _popBatch(count);
+		if (count == 0)
+		{
+			return nullptr;
+		}
+		if (count > 1)
+		{
+			_pushBatch(_block(idx)->next, count - 1);
+		}
+		return _block(idx);
+	}
+
+	void deallocate(void* ptr)
+	{
+		index_type idx = _indexOf(ptr);
+		_block(idx)->next = invalid_index;
+		_pushBatch(idx, 1);
+	}
+
+private:
+
+	static constexpr int tag_shift = sizeof(index_type) * 8;
+
+	static index_type _indexFromTagged(tagged_type v)
+	{
+		return static_cast<index_type>(v);
+	}
+
+	static tagged_type _makeTagged(index_type idx, tagged_type previous)
+	{
+		const tagged_type tag = (previous >> tag_shift) + 1;
+		return (tag << tag_shift) | idx;
+	}
+
+	free_block* _block(size_type idx) const
+	{
+		CZ_VECTOR_ASSERT_SLOW(idx < m_capacity);
+		return reinterpret_cast<free_block*>(m_blocks + idx * block_size);
+	}
+
+	index_type _indexOf(void* ptr) const
+	{
+		CZ_CONCURRENT_POOL_ASSERT(owns(ptr));
+		const size_type offset = static_cast<size_type>(static_cast<char*>(ptr) - m_blocks);
+		CZ_CONCURRENT_POOL_ASSERT(offset % block_size == 0);
+		return static_cast<index_type>(offset / block_size);
+	}
+
+	// first is a chain of count blocks, linked with free_block::next
+	void _pushBatch(index_type first, size_type count)
+	{
+		batch_link& link = m_links[first];
+		link.count = static_cast<index_type>(count);
+		tagged_type head = __atomic_load_n(&m_head, __ATOMIC_RELAXED);
+		while (true)
+		{
+			__atomic_store_n(&link.nextBatch, _indexFromTagged(head), __ATOMIC_RELAXED);
+			if (__atomic_compare_exchange_n(&m_head, &head, _makeTagged(first, head), true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			{
+				return;
+			}
+		}
+	}
+
+	// Returns the first block of the batch, and sets outCount to the number of blocks in it (0 if the pool is exhausted)
+	index_type _popBatch(size_type& outCount)
+	{
+		tagged_type head = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+		while (true)
+		{
+			const index_type idx = _indexFromTagged(head);
+			if (idx == invalid_index)
+			{
+				outCount = 0;
+				return invalid_index;
+			}
+
+			// If another thread pops this batch meanwhile, this reads a stale link, but the tag makes the CAS fail
+			CZ_VECTOR_ASSERT_SLOW(idx < m_capacity);
+			batch_link& link = m_links[idx];
+			const index_type next = __atomic_load_n(&link.nextBatch, __ATOMIC_RELAXED);
+			if (__atomic_compare_exchange_n(&m_head, &head, _makeTagged(next, head), true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+			{
+				outCount = link.count;
+				return idx;
+			}
+		}
+	}
+
+	void* m_buffer = nullptr;
+	char* m_blocks = nullptr;
+	batch_link* m_links = nullptr;
+	size_type m_capacity = 0;
+	// Aligned, since 32 bit targets might only align 64 bit integers to 4
+	alignas(sizeof(tagged_type)) tagged_type m_head = invalid_index;
+};
+
+/**
+ * Uses a concurrent_pool as the VectorAllocator backend.
+ * Allocations that don't fit in a block, or when the pool is exhausted, fall back to malloc.
+ * Each thread gets its own pool cache, which is flushed when the thread exits, so the pool needs to outlive all
+ * threads that use it. Only one pool per Pool type can be used this way.
+ */
+template<typename Pool>
+class concurrent_pool_backend
+{
+public:
+	explicit concurrent_pool_backend(Pool& pool)
+		: m_pool(pool)
+		, m_backend{ &_alloc, &_free, this, &_freeSized }
+	{
+	}
+
+	const detail::VectorAllocatorBackend* get() const
+	{
+		return &m_backend;
+	}
+
+	// Gives the calling thread's cached blocks back to the pool.
+	// Needed if the pool is destroyed before the thread exits.
+	void flush_thread_cache()
+	{
+		_threadCache(m_pool).flush();
+	}
+
+private:
+
+	static typename Pool::cache& _threadCache(Pool& pool)
+	{
+		thread_local typename Pool::cache c(pool);
+		CZ_CONCURRENT_POOL_ASSERT(&c.pool() == &pool);
+		return c;
+	}
+
+	static void* _alloc(void* userData, size_t bytes)
+	{
+		Pool& pool = static_cast<concurrent_pool_backend*>(userData)->m_pool;
+		if (bytes <= Pool::block_size)
+		{
+			if (void* ptr = _threadCache(pool).allocate())
+			{
+				return ptr;
+			}
+		}
+		return malloc(bytes);
+	}
+
+	static void _free(void* userData, void* ptr)
+	{
+		Pool& pool = static_cast<concurrent_pool_backend*>(userData)->m_pool;
+		if (pool.owns(ptr))
+		{
+			_threadCache(pool).deallocate(ptr);
+		}
+		else
+		{
+			free(ptr);
+		}
+	}
+
+	// Blocks are only handed out for sizes that fit, so anything bigger went to malloc
+	static void _freeSized(void* userData, void* ptr, size_t bytes)
+	{
+		if (bytes > Pool::block_size)
+		{
+			free(ptr);
+		}
+		else
+		{
+			_free(userData, ptr);
+		}
+	}
+
+	Pool& m_pool;
+	detail::VectorAllocatorBackend m_backend;
+};
+
+} // namespace cz
@@ -0,0 +1,521 @@
+/**
+C++20 coroutine types.
+
+	- generator<T>: Lazily produces a sequence with co_yield. Each element is computed when the consumer asks for it,
+	  so stages of a pipeline can be chained without materializing the whole sequence in between. Range-for
+	  compatible. Yielded values are passed by reference, so nothing is copied.
+	- task<T>: Lazily started coroutine that produces a single value with co_return, and can be co_awaited from other
+	  tasks. Awaiting resumes the awaiting task directly from the awaited one when it finishes (symmetric transfer),
+	  so long chains don't grow the stack.
+
+Frame allocation:
+By default, frames are allocated with cz::detail::NewAllocator (the global operator new backend, see <new>), so
+setting a pool or tlsf backend there is enough to keep coroutines off the system heap.
+A coroutine can also take an allocator backend explicitly, as its first parameters (or right after the object, for
+member functions):
+	cz::generator<int> numbers(std::allocator_arg_t, const cz::detail::AllocatorBackend& alloc, int count)
+	{
+		for (int i = 0; i < count; i++)
+			co_yield i;
+	}
+	...
+	for (int i : numbers(std::allocator_arg, *backend.get(), 10))
+
+If the allocation fails, the coroutine is not created, and an empty generator/task is returned instead. An empty
+generator produces no elements, and an empty task asserts if used (check with valid()).
+
+Exceptions are not supported. Coroutines that throw abort.
+*/
+
+#pragma once
+
+#include <coroutine>
+#include <new>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "optional.h"
+
+#define CZ_COROUTINE_ASSERT(x) assert(x)
+
+namespace cz
+{
+
+namespace detail
+{
+	/**
+	 * Base for the promise types, so they all allocate frames the same way.
+	 * The backend used (nullptr for NewAllocator) is kept right after the frame, so delete knows where to free.
+	 */
+	struct coroutine_frame_allocation
+	{
+		static void* operator new(size_t size) noexcept
+		{
+			return _allocate(size, nullptr);
+		}
+
+		template<typename... Args>
+		static void* operator new(size_t size, std::allocator_arg_t, const AllocatorBackend& backend, Args&...) noexcept
+		{
+			return _allocate(size, &backend);
+		}
+
+		// Member function coroutines get the object as the first parameter
+		template<typename Self, typename... Args>
+		static void* operator new(size_t size, Self&, std::allocator_arg_t, const AllocatorBackend& backend, Args&...) noexcept
+		{
+			return _allocate(size, &backend);
+		}
+
+		static void operator delete(void* ptr, size_t size) noexcept
+		{
+			const AllocatorBackend* backend;
+			memcpy(&backend, static_cast<char*>(ptr) + _backendOffset(size), sizeof(backend));
+			const size_t bytes = _backendOffset(size) + sizeof(backend);
+			if (!backend)
+			{
+				NewAllocator::_free(ptr, bytes);
+			}
+			else if (backend->freeSized)
+			{
+				backend->freeSized(backend->userData, ptr, bytes);
+			}
+			else
+			{
+				backend->free(backend->userData, ptr);
+			}
+		}
+
+	private:
+
+		static size_t _backendOffset(size_t size)
+		{
+			return (size + alignof(AllocatorBackend*) - 1) & ~(alignof(AllocatorBackend*) - 1);
+		}
+
+		static void* _allocate(size_t size, const AllocatorBackend* backend)
+		{
+			const size_t bytes = _backendOffset(size) + sizeof(backend);
+			void* ptr = backend ? backend->alloc(backend->userData, bytes) : NewAllocator::_alloc(bytes);
+			if (ptr)
+			{
+				memcpy(static_cast<char*>(ptr) + _backendOffset(size), &backend, sizeof(backend));
+			}
+			return ptr;
+		}
+	};
+} // namespace detail
+
+//////////////////////////////////////////////////////////////////////////
+//	generator
+//////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+class generator
+{
+public:
+	using value_type = std::remove_cv_t<std::remove_reference_t<T>>;
+	using reference = const value_type&;
+
+	struct promise_type : detail::coroutine_frame_allocation
+	{
+		generator get_return_object() noexcept
+		{
+			return generator(handle_type::from_promise(*this));
+		}
+
+		static generator get_return_object_on_allocation_failure() noexcept
+		{
+			return generator();
+		}
+
+		std::suspend_always initial_suspend() const noexcept
+		{
+			return {};
+		}
+
+		std::suspend_always final_suspend() const noexcept
+		{
+			return {};
+		}
+
+		// The yielded value (even a temporary) lives until the generator is resumed, so a pointer is enough
+		std::suspend_always yield_value(const value_type& value) noexcept
+		{
+			m_value = &value;
+			return {};
+		}
+
+		void return_void() const noexcept
+		{
+		}
+
+		void unhandled_exception() const noexcept
+		{
+			abort();
+		}
+
+		// Generators only produce values, so co_await is not allowed in them
+		template<typename U>
+		std::suspend_never await_transform(U&&) = delete;
+
+		const value_type* m_value = nullptr;
+	};
+
+	using handle_type = std::coroutine_handle<promise_type>;
+
+	struct sentinel
+	{
+	};
+
+	class iterator
+	{
+	public:
+		explicit iterator(handle_type handle)
+			: m_handle(handle)
+		{
+		}
+
+		reference operator*() const
+		{
+			CZ_COROUTINE_ASSERT(m_handle && !m_handle.done());
+			return *m_handle.promise().m_value;
+		}
+
+		const value_type* operator->() const
+		{
+			return &**this;
+		}
+
+		iterator& operator++()
+		{
+			CZ_COROUTINE_ASSERT(m_handle && !m_handle.done());
+			m_handle.resume();
+			return *this;
+		}
+
+		void operator++(int)
+		{
+			++*this;
+		}
+
+		friend bool operator==(const iterator& it, sentinel) noexcept
+		{
+			return !it.m_handle || it.m_handle.done();
+		}
+
+		friend bool operator!=(const iterator& it, sentinel s) noexcept
+		{
+			return !(it == s);
+		}
+
+	private:
+		handle_type m_handle;
+	};
+
+	generator() noexcept
+	{
+	}
+
+	generator(const generator&) = delete;
+	generator& operator=(const generator&) = delete;
+
+	generator(generator&& other) noexcept
+		: m_handle(other.m_handle)
+	{
+		other.m_handle = nullptr;
+	}
+
+	generator& operator=(generator&& other) noexcept
+	{
+		if (this != &other)
+		{
+			_destroy();
+			m_handle = other.m_handle;
+			other.m_handle = nullptr;
+		}
+		return *this;
+	}
+
+	~generator()
+	{
+		_destroy();
+	}
+
+	/**
+	 * Runs the coroutine until the first element. Can only be called once, since a generator is a single pass.
+	 */
+	iterator begin()
+	{
+		if (m_handle)
+		{
+			m_handle.resume();
+		}
+		return iterator(m_handle);
+	}
+
+	sentinel end() const noexcept
+	{
+		return {};
+	}
+
+	// False if the frame allocation failed
+	bool valid() const noexcept
+	{
+		return static_cast<bool>(m_handle);
+	}
+
+private:
+
+	explicit generator(handle_type handle) noexcept
+		: m_handle(handle)
+	{
+	}
+
+	void _destroy()
+	{
+		if (m_handle)
+		{
+			m_handle.destroy();
+			m_handle = nullptr;
+		}
+	}
+
+	handle_type m_handle;
+};
+
+//////////////////////////////////////////////////////////////////////////
+//	task
+//////////////////////////////////////////////////////////////////////////
+
+template<typename T = void>
+class task;
+
+namespace detail
+{
+	struct task_promise_base : coroutine_frame_allocation
+	{
+		// Resumes whoever is awaiting the task, if any
+		struct final_awaiter
+		{
+			bool await_ready() const noexcept
+			{
+				return false;
+			}
+
+			template<typename Promise>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept
+			{
+				std::coroutine_handle<> continuation = handle.promise().m_continuation;
+				if (continuation)
+				{
+					return continuation;
+				}
+				return std::noop_coroutine();
+			}
+
+			void await_resume() const noexcept
+			{
+			}
+		};
+
+		std::suspend_always initial_suspend() const noexcept
+		{
+			return {};
+		}
+
+		final_awaiter final_suspend() const noexcept
+		{
+			return {};
+		}
+
+		void unhandled_exception() const noexcept
+		{
+			abort();
+		}
+
+		std::coroutine_handle<> m_continuation;
+	};
+
+	template<typename T>
+	struct task_promise : task_promise_base
+	{
+		task<T> get_return_object() noexcept;
+
+		static task<T> get_return_object_on_allocation_failure() noexcept
+		{
+			return task<T>();
+		}
+
+		template<typename U>
+		void return_value(U&& value)
+		{
+			m_value.emplace(std::forward<U>(value));
+		}
+
+		T& result()
+		{
+			CZ_COROUTINE_ASSERT(m_value.has_value());
+			return *m_value;
+		}
+
+		optional<T> m_value;
+	};
+
+	template<>
+	struct task_promise<void> : task_promise_base
+	{
+		task<void> get_return_object() noexcept;
+
+		static task<void> get_return_object_on_allocation_failure() noexcept;
+
+		void return_void() const noexcept
+		{
+		}
+
+		void result() const
+		{
+		}
+	};
+} // namespace detail
+
+template<typename T>
+class task
+{
+public:
+	using promise_type = detail::task_promise<T>;
+	using handle_type = std::coroutine_handle<promise_type>;
+
+	task() noexcept
+	{
+	}
+
+	task(const task&) = delete;
+	task& operator=(const task&) = delete;
+
+	task(task&& other) noexcept
+		: m_handle(other.m_handle)
+	{
+		other.m_handle = nullptr;
+	}
+
+	task& operator=(task&& other) noexcept
+	{
+		if (this != &other)
+		{
+			_destroy();
+			m_handle = other.m_handle;
+			other.m_handle = nullptr;
+		}
+		return *this;
+	}
+
+	~task()
+	{
+		_destroy();
+	}
+
+	// False if the frame allocation failed
+	bool valid() const noexcept
+	{
+		return static_cast<bool>(m_handle);
+	}
+
+	bool done() const noexcept
+	{
+		CZ_COROUTINE_ASSERT(m_handle);
+		return m_handle.done();
+	}
+
+	/**
+	 * Starts the task from non-coroutine code. It runs until it finishes or suspends on something it awaits, in which
+	 * case it continues when that something resumes it.
+	 */
+	void start()
+	{
+		CZ_COROUTINE_ASSERT(m_handle && !m_handle.done());
+		m_handle.resume();
+	}
+
+	// Value given to co_return. The task needs to be done.
+	decltype(auto) result()
+	{
+		CZ_COROUTINE_ASSERT(m_handle && m_handle.done());
+		return m_handle.promise().result();
+	}
+
+	struct awaiter
+	{
+		bool await_ready() const noexcept
+		{
+			return m_handle.done();
+		}
+
+		// Starts the awaited task right away, instead of going back to the caller
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+		{
+			m_handle.promise().m_continuation = awaiting;
+			return m_handle;
+		}
+
+		// Returned by value, since the task (and its result) usually is a temporary that is gone after the co_await
+		T await_resume()
+		{
+			if constexpr (!std::is_void_v<T>)
+			{
+				return std::move(m_handle.promise().result());
+			}
+		}
+
+		handle_type m_handle;
+	};
+
+	awaiter operator co_await() && noexcept
+	{
+		CZ_COROUTINE_ASSERT(m_handle);
+		return awaiter{ m_handle };
+	}
+
+private:
+	friend promise_type;
+
+	explicit task(handle_type handle) noexcept
+		: m_handle(handle)
+	{
+	}
+
+	void _destroy()
+	{
+		if (m_handle)
+		{
+			m_handle.destroy();
+			m_handle = nullptr;
+		}
+	}
+
+	handle_type m_handle;
+};
+
+namespace detail
+{
+	template<typename T>
+	task<T> task_promise<T>::get_return_object() noexcept
+	{
+		return task<T>(task<T>::handle_type::from_promise(*this));
+	}
+
+	inline task<void> task_promise<void>::get_return_object() noexcept
+	{
+		return task<void>(task<void>::handle_type::from_promise(*this));
+	}
+
+	inline task<void> task_promise<void>::get_return_object_on_allocation_failure() noexcept
+	{
+		return task<void>();
+	}
+} // namespace detail
+
+} // namespace cz
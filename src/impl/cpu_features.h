@@ -0,0 +1,79 @@
+/**
+What the cpu we are running on supports, so code can pick the best implementation at runtime.
+
+On x86 this uses cpuid, and for the AVX levels also checks that the OS saves the wider registers. On other
+architectures everything is false.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define CZ_CPU_X86 1
+	#include <cpuid.h>
+#else
+	#define CZ_CPU_X86 0
+#endif
+
+namespace cz
+{
+
+struct cpu_features
+{
+	bool sse2 = false;
+	bool sse4_1 = false;
+	bool avx2 = false;
+	bool avx512f = false;
+	bool avx512bw = false;
+
+	/**
+	 * Probes the cpu the first time it's called
+	 */
+	static const cpu_features& get()
+	{
+		static const cpu_features features = _probe();
+		return features;
+	}
+
+private:
+
+	static cpu_features _probe()
+	{
+		cpu_features res;
+#if CZ_CPU_X86
+		unsigned int eax, ebx, ecx, edx;
+		if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		{
+			return res;
+		}
+
+		res.sse2 = (edx & (1u << 26)) != 0;
+		res.sse4_1 = (ecx & (1u << 19)) != 0;
+
+		// AVX registers are only usable if the OS saves them on context switches
+		const bool osxsave = (ecx & (1u << 27)) != 0;
+		const bool avx = (ecx & (1u << 28)) != 0;
+		uint64_t xcr0 = 0;
+		if (osxsave)
+		{
+			uint32_t lo, hi;
+			__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+			xcr0 = (static_cast<uint64_t>(hi) << 32) | lo;
+		}
+		const bool osAvx = (xcr0 & 0x6) == 0x6;
+		const bool osAvx512 = (xcr0 & 0xE6) == 0xE6;
+
+		if (__get_cpuid_max(0, nullptr) >= 7)
+		{
+			__cpuid_count(7, 0, eax, ebx, ecx, edx);
+			res.avx2 = avx && osAvx && (ebx & (1u << 5)) != 0;
+			res.avx512f = osAvx512 && (ebx & (1u << 16)) != 0;
+			res.avx512bw = res.avx512f && (ebx & (1u << 30)) != 0;
+		}
+#endif
+		return res;
+	}
+};
+
+} // namespace cz
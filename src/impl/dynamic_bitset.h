@@ -0,0 +1,330 @@
+/**
+Bit packed set of flags, with the size set at runtime.
+
+Bits are stored in machine words, so bulk operations (count, find) work a word at a time.
+Whole-set and/or/xor/and_not use the SIMD bitwise kernels (see simd.h), so on x86 they pick SSE2/AVX2/AVX-512 at
+runtime. Elsewhere (or with CZ_SIMD=0) they are plain word loops.
+*/
+
+#pragma once
+
+#include "vector.h"
+
+namespace cz
+{
+
+class dynamic_bitset
+{
+public:
+	using word_type = unsigned long;
+	using size_type = std::size_t;
+
+	static constexpr size_type bits_per_word = sizeof(word_type) * 8;
+	static constexpr size_type npos = static_cast<size_type>(-1);
+
+	dynamic_bitset() noexcept {}
+
+	explicit dynamic_bitset(size_type numBits, bool value = false) noexcept
+		: m_words(_wordsFor(numBits), value ? ~word_type(0) : word_type(0))
+		, m_numBits(numBits)
+	{
+		_clearUnusedBits();
+	}
+
+	//
+	// Single bit access
+	//
+	bool test(size_type pos) const
+	{
+		CZ_VECTOR_ASSERT_SLOW(pos < m_numBits);
+		return (m_words[_wordIndex(pos)] & _mask(pos)) != 0;
+	}
+
+	bool operator[](size_type pos) const
+	{
+		return test(pos);
+	}
+
+	dynamic_bitset& set(size_type pos)
+	{
+		CZ_VECTOR_ASSERT_SLOW(pos < m_numBits);
+		m_words[_wordIndex(pos)] |= _mask(pos);
+		return *this;
+	}
+
+	dynamic_bitset& set(size_type pos, bool value)
+	{
+		return value ? set(pos) : reset(pos);
+	}
+
+	dynamic_bitset& reset(size_type pos)
+	{
+		CZ_VECTOR_ASSERT_SLOW(pos < m_numBits);
+		m_words[_wordIndex(pos)] &= ~_mask(pos);
+		return *this;
+	}
+
+	dynamic_bitset& flip(size_type pos)
+	{
+		CZ_VECTOR_ASSERT_SLOW(pos < m_numBits);
+		m_words[_wordIndex(pos)] ^= _mask(pos);
+		return *this;
+	}
+
+	//
+	// Whole set operations
+	//
+	dynamic_bitset& set()
+	{
+		_fill(~word_type(0));
+		_clearUnusedBits();
+		return *this;
+	}
+
+	dynamic_bitset& reset()
+	{
+		_fill(0);
+		return *this;
+	}
+
+	dynamic_bitset& flip()
+	{
+		for (word_type& w : m_words)
+		{
+			w = ~w;
+		}
+		_clearUnusedBits();
+		return *this;
+	}
+
+	// Number of bits set
+	size_type count() const
+	{
+		size_type total = 0;
+		for (word_type w : m_words)
+		{
+			total += static_cast<size_type>(__builtin_popcountl(w));
+		}
+		return total;
+	}
+
+	bool any() const
+	{
+		for (word_type w : m_words)
+		{
+			if (w)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool none() const
+	{
+		return !any();
+	}
+
+	bool all() const
+	{
+		return count() == m_numBits;
+	}
+
+	// Returns the index of the first set bit, or npos if none
+	size_type find_first() const
+	{
+		return _findFrom(0);
+	}
+
+	// Returns the index of the first set bit after pos, or npos if none
+	size_type find_next(size_type pos) const
+	{
+		if (pos + 1 >= m_numBits)
+		{
+			return npos;
+		}
+
+		// Check the remaining bits of the word pos is in, then carry on a word at a time
+		const size_type next = pos + 1;
+		const word_type w = m_words[_wordIndex(next)] >> (next % bits_per_word);
+		if (w)
+		{
+			return next + _ctz(w);
+		}
+		return _findFrom(_wordIndex(next) + 1);
+	}
+
+	dynamic_bitset& operator&=(const dynamic_bitset& other)
+	{
+		return _apply<detail::simd_bitwise_op::bit_and>(other);
+	}
+
+	dynamic_bitset& operator|=(const dynamic_bitset& other)
+	{
+		return _apply<detail::simd_bitwise_op::bit_or>(other);
+	}
+
+	dynamic_bitset& operator^=(const dynamic_bitset& other)
+	{
+		return _apply<detail::simd_bitwise_op::bit_xor>(other);
+	}
+
+	// Clears all the bits that are set in other (this & ~other)
+	dynamic_bitset& and_not(const dynamic_bitset& other)
+	{
+		return _apply<detail::simd_bitwise_op::bit_and_not>(other);
+	}
+
+	friend dynamic_bitset operator&(const dynamic_bitset& a, const dynamic_bitset& b)
+	{
+		dynamic_bitset res(a);
+		res &= b;
+		return res;
+	}
+
+	friend dynamic_bitset operator|(const dynamic_bitset& a, const dynamic_bitset& b)
+	{
+		dynamic_bitset res(a);
+		res |= b;
+		return res;
+	}
+
+	friend dynamic_bitset operator^(const dynamic_bitset& a, const dynamic_bitset& b)
+	{
+		dynamic_bitset res(a);
+		res ^= b;
+		return res;
+	}
+
+	friend bool operator==(const dynamic_bitset& a, const dynamic_bitset& b)
+	{
+		return a.m_numBits == b.m_numBits && a.m_words == b.m_words;
+	}
+
+	friend bool operator!=(const dynamic_bitset& a, const dynamic_bitset& b)
+	{
+		return !(a == b);
+	}
+
+	//
+	// Capacity
+	//
+	size_type size() const noexcept
+	{
+		return m_numBits;
+	}
+
+	bool empty() const noexcept
+	{
+		return m_numBits == 0;
+	}
+
+	size_type num_words() const noexcept
+	{
+		return m_words.size();
+	}
+
+	// Direct access to the underlying words. Bits past size() are always 0
+	const word_type* data() const noexcept
+	{
+		return m_words.data();
+	}
+
+	// Changes the number of bits. If growing, the new bits are set to value
+	void resize(size_type numBits, bool value = false)
+	{
+		const size_type oldNumBits = m_numBits;
+		const size_type numWords = _wordsFor(numBits);
+		if (numWords != m_words.size())
+		{
+			vector<word_type> words(numWords, value ? ~word_type(0) : word_type(0));
+			const size_type keep = numWords < m_words.size() ? numWords : m_words.size();
+			if (keep)
+			{
+				memcpy(words.data(), m_words.data(), keep * sizeof(word_type));
+			}
+			m_words = std::move(words);
+		}
+		m_numBits = numBits;
+
+		// The bits in the last old word were 0, so they need to be set if growing with value==true
+		if (value && numBits > oldNumBits && (oldNumBits % bits_per_word))
+		{
+			m_words[_wordIndex(oldNumBits)] |= ~word_type(0) << (oldNumBits % bits_per_word);
+		}
+		_clearUnusedBits();
+	}
+
+	void clear() noexcept
+	{
+		m_words.clear();
+		m_numBits = 0;
+	}
+
+private:
+
+	static constexpr size_type _wordsFor(size_type numBits)
+	{
+		return (numBits + bits_per_word - 1) / bits_per_word;
+	}
+
+	static constexpr size_type _wordIndex(size_type pos)
+	{
+		return pos / bits_per_word;
+	}
+
+	static constexpr word_type _mask(size_type pos)
+	{
+		return word_type(1) << (pos % bits_per_word);
+	}
+
+	static size_type _ctz(word_type w)
+	{
+		return static_cast<size_type>(__builtin_ctzl(w));
+	}
+
+	// Finds the first set bit, starting at the given word
+	size_type _findFrom(size_type wordIndex) const
+	{
+		const size_type numWords = m_words.size();
+		for (; wordIndex < numWords; ++wordIndex)
+		{
+			if (word_type w = m_words[wordIndex])
+			{
+				return wordIndex * bits_per_word + _ctz(w);
+			}
+		}
+		return npos;
+	}
+
+	void _fill(word_type value)
+	{
+		for (word_type& w : m_words)
+		{
+			w = value;
+		}
+	}
+
+	// Keeps the bits past m_numBits as 0, so count/any/== don't need to special case the last word
+	void _clearUnusedBits()
+	{
+		const size_type extra = m_numBits % bits_per_word;
+		if (extra)
+		{
+			m_words.back() &= ~(~word_type(0) << extra);
+		}
+	}
+
+	template<detail::simd_bitwise_op Op>
+	dynamic_bitset& _apply(const dynamic_bitset& other)
+	{
+		CZ_VECTOR_ASSERT(m_numBits == other.m_numBits);
+		detail::simd_kernel_bitwise<Op>(m_words.data(), other.m_words.data(), m_words.size() * sizeof(word_type));
+		return *this;
+	}
+
+	vector<word_type> m_words;
+	size_type m_numBits = 0;
+};
+
+} // namespace cz
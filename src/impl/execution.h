@@ -0,0 +1,285 @@
+/**
+Execution policies, and the algorithm overloads that take them.
+
+	- seq: Same as the versions without a policy.
+	- unseq: Loops are marked as free of loop-carried dependencies, so the compiler can vectorize them, and
+	  reductions use several independent accumulators.
+	- par: The range is split in chunks, which run on cz::default_thread_pool().
+
+The chunks depend only on the size of the range (not the number of threads), and partial results are always combined
+in the same order, so par gives the same result from run to run. For an associative operation it's also the same
+result as seq. unseq is deterministic too, but regroups the reduction, so for floating point it can differ from seq.
+
+The overloads taking a policy require random access iterators.
+
+bench/execution_bench.cpp reports the speedup of unseq and par over seq for each algorithm.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include "thread_pool.h"
+
+#if defined(__clang__)
+	#define CZ_UNSEQ_LOOP _Pragma("clang loop vectorize(enable) interleave(enable)")
+#elif defined(__GNUC__)
+	#define CZ_UNSEQ_LOOP _Pragma("GCC ivdep")
+#else
+	#define CZ_UNSEQ_LOOP
+#endif
+
+namespace std
+{
+
+namespace execution
+{
+	class sequenced_policy
+	{
+	};
+
+	class unsequenced_policy
+	{
+	};
+
+	class parallel_policy
+	{
+	};
+
+	inline constexpr sequenced_policy seq{};
+	inline constexpr unsequenced_policy unseq{};
+	inline constexpr parallel_policy par{};
+}
+
+template<class T>
+struct is_execution_policy : false_type
+{
+};
+
+template<>
+struct is_execution_policy<execution::sequenced_policy> : true_type
+{
+};
+
+template<>
+struct is_execution_policy<execution::unsequenced_policy> : true_type
+{
+};
+
+template<>
+struct is_execution_policy<execution::parallel_policy> : true_type
+{
+};
+
+template<class T>
+inline constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+namespace detail
+{
+	template<class ExecutionPolicy, class R>
+	using enable_if_execution_policy_t = enable_if_t<is_execution_policy_v<decay_t<ExecutionPolicy>>, R>;
+
+	template<class ExecutionPolicy>
+	inline constexpr bool is_par_v = is_same_v<decay_t<ExecutionPolicy>, execution::parallel_policy>;
+
+	template<class ExecutionPolicy>
+	inline constexpr bool is_unseq_v = is_same_v<decay_t<ExecutionPolicy>, execution::unsequenced_policy>;
+
+	// Elements per chunk for par. Only depends on the size, so results don't depend on the number of threads
+	inline size_t par_grain(size_t size)
+	{
+		const size_t grain = size / 256;
+		return grain < 2048 ? 2048 : grain;
+	}
+
+	// Number of independent accumulators used by unseq reductions
+	static constexpr size_t unseq_lanes = 4;
+
+	// Reduces transform(i) for i in [0, size), with unseq_lanes accumulators that are combined at the end
+	template<class T, class BinaryReductionOp, class IndexTransform>
+	T unseq_reduce(size_t size, T init, BinaryReductionOp& reduce, IndexTransform&& transform)
+	{
+		if (size < unseq_lanes * 2)
+		{
+			for (size_t i = 0; i < size; ++i)
+			{
+				init = reduce(std::move(init), transform(i));
+			}
+			return init;
+		}
+
+		T acc[unseq_lanes] = { transform(0), transform(1), transform(2), transform(3) };
+		const size_t end = size - size % unseq_lanes;
+		for (size_t i = unseq_lanes; i < end; i += unseq_lanes)
+		{
+			for (size_t lane = 0; lane < unseq_lanes; ++lane)
+			{
+				acc[lane] = reduce(std::move(acc[lane]), transform(i + lane));
+			}
+		}
+		for (size_t i = end; i < size; ++i)
+		{
+			acc[0] = reduce(std::move(acc[0]), transform(i));
+		}
+
+		return reduce(std::move(init), reduce(reduce(std::move(acc[0]), std::move(acc[1])), reduce(std::move(acc[2]), std::move(acc[3]))));
+	}
+
+	// Reduces transform(i) for i in [0, size), as the given policy says
+	template<class ExecutionPolicy, class T, class BinaryReductionOp, class IndexTransform>
+	T policy_reduce(size_t size, T init, BinaryReductionOp& reduce, IndexTransform&& transform)
+	{
+		if constexpr (is_par_v<ExecutionPolicy>)
+		{
+			// Each chunk starts with its first element, so no identity value is needed
+			return cz::parallel_reduce(size_t(0), size, par_grain(size), std::move(init),
+				[&](size_t first, size_t last)
+				{
+					T acc = transform(first);
+					for (size_t i = first + 1; i < last; ++i)
+					{
+						acc = reduce(std::move(acc), transform(i));
+					}
+					return acc;
+				},
+				reduce);
+		}
+		else if constexpr (is_unseq_v<ExecutionPolicy>)
+		{
+			return unseq_reduce(size, std::move(init), reduce, transform);
+		}
+		else
+		{
+			for (size_t i = 0; i < size; ++i)
+			{
+				init = reduce(std::move(init), transform(i));
+			}
+			return init;
+		}
+	}
+
+	// Calls fn(i) for i in [0, size), as the given policy says
+	template<class ExecutionPolicy, class IndexFunction>
+	void policy_for(size_t size, IndexFunction&& fn)
+	{
+		if constexpr (is_par_v<ExecutionPolicy>)
+		{
+			cz::parallel_for(size_t(0), size, par_grain(size), [&](size_t first, size_t last)
+			{
+				for (size_t i = first; i < last; ++i)
+				{
+					fn(i);
+				}
+			});
+		}
+		else if constexpr (is_unseq_v<ExecutionPolicy>)
+		{
+			CZ_UNSEQ_LOOP
+			for (size_t i = 0; i < size; ++i)
+			{
+				fn(i);
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < size; ++i)
+			{
+				fn(i);
+			}
+		}
+	}
+
+} // namespace detail
+
+template<class ExecutionPolicy, class RandomIt, class UnaryFunction>
+detail::enable_if_execution_policy_t<ExecutionPolicy, void>
+for_each(ExecutionPolicy&&, RandomIt first, RandomIt last, UnaryFunction f)
+{
+	detail::policy_for<ExecutionPolicy>(static_cast<size_t>(last - first), [&](size_t i) { f(first[i]); });
+}
+
+template<class ExecutionPolicy, class RandomIt1, class RandomIt2, class UnaryOperation>
+detail::enable_if_execution_policy_t<ExecutionPolicy, RandomIt2>
+transform(ExecutionPolicy&&, RandomIt1 first1, RandomIt1 last1, RandomIt2 d_first, UnaryOperation unary_op)
+{
+	const size_t size = static_cast<size_t>(last1 - first1);
+	detail::policy_for<ExecutionPolicy>(size, [&](size_t i) { d_first[i] = unary_op(first1[i]); });
+	return d_first + size;
+}
+
+template<class ExecutionPolicy, class RandomIt1, class RandomIt2, class RandomIt3, class BinaryOperation>
+detail::enable_if_execution_policy_t<ExecutionPolicy, RandomIt3>
+transform(ExecutionPolicy&&, RandomIt1 first1, RandomIt1 last1, RandomIt2 first2, RandomIt3 d_first, BinaryOperation binary_op)
+{
+	const size_t size = static_cast<size_t>(last1 - first1);
+	detail::policy_for<ExecutionPolicy>(size, [&](size_t i) { d_first[i] = binary_op(first1[i], first2[i]); });
+	return d_first + size;
+}
+
+template<class ExecutionPolicy, class RandomIt, class T>
+detail::enable_if_execution_policy_t<ExecutionPolicy, void>
+fill(ExecutionPolicy&&, RandomIt first, RandomIt last, const T& value)
+{
+	detail::policy_for<ExecutionPolicy>(static_cast<size_t>(last - first), [&](size_t i) { first[i] = value; });
+}
+
+template<class ExecutionPolicy, class RandomIt1, class RandomIt2>
+detail::enable_if_execution_policy_t<ExecutionPolicy, RandomIt2>
+copy(ExecutionPolicy&&, RandomIt1 first, RandomIt1 last, RandomIt2 d_first)
+{
+	const size_t size = static_cast<size_t>(last - first);
+	detail::policy_for<ExecutionPolicy>(size, [&](size_t i) { d_first[i] = first[i]; });
+	return d_first + size;
+}
+
+template<class ExecutionPolicy, class RandomIt, class UnaryPredicate>
+detail::enable_if_execution_policy_t<ExecutionPolicy, size_t>
+count_if(ExecutionPolicy&&, RandomIt first, RandomIt last, UnaryPredicate p)
+{
+	std::plus<> add;
+	return detail::policy_reduce<ExecutionPolicy>(static_cast<size_t>(last - first), size_t(0), add,
+		[&](size_t i) -> size_t { return p(first[i]) ? 1 : 0; });
+}
+
+template<class ExecutionPolicy, class RandomIt, class T, class BinaryOperation>
+detail::enable_if_execution_policy_t<ExecutionPolicy, T>
+reduce(ExecutionPolicy&&, RandomIt first, RandomIt last, T init, BinaryOperation op)
+{
+	return detail::policy_reduce<ExecutionPolicy>(static_cast<size_t>(last - first), std::move(init), op,
+		[&](size_t i) -> T { return first[i]; });
+}
+
+template<class ExecutionPolicy, class RandomIt, class T>
+detail::enable_if_execution_policy_t<ExecutionPolicy, T>
+reduce(ExecutionPolicy&& policy, RandomIt first, RandomIt last, T init)
+{
+	return std::reduce(std::forward<ExecutionPolicy>(policy), first, last, std::move(init), std::plus<>());
+}
+
+template<class ExecutionPolicy, class RandomIt1, class RandomIt2, class T, class BinaryReductionOp, class BinaryTransformOp>
+detail::enable_if_execution_policy_t<ExecutionPolicy, T>
+transform_reduce(ExecutionPolicy&&, RandomIt1 first1, RandomIt1 last1, RandomIt2 first2, T init,
+	BinaryReductionOp reduce, BinaryTransformOp transform)
+{
+	return detail::policy_reduce<ExecutionPolicy>(static_cast<size_t>(last1 - first1), std::move(init), reduce,
+		[&](size_t i) -> T { return transform(first1[i], first2[i]); });
+}
+
+template<class ExecutionPolicy, class RandomIt1, class RandomIt2, class T>
+detail::enable_if_execution_policy_t<ExecutionPolicy, T>
+transform_reduce(ExecutionPolicy&& policy, RandomIt1 first1, RandomIt1 last1, RandomIt2 first2, T init)
+{
+	return std::transform_reduce(std::forward<ExecutionPolicy>(policy), first1, last1, first2, std::move(init),
+		std::plus<>(), std::multiplies<>());
+}
+
+template<class ExecutionPolicy, class RandomIt, class T, class BinaryReductionOp, class UnaryTransformOp>
+detail::enable_if_execution_policy_t<ExecutionPolicy, T>
+transform_reduce(ExecutionPolicy&&, RandomIt first, RandomIt last, T init, BinaryReductionOp reduce, UnaryTransformOp transform)
+{
+	return detail::policy_reduce<ExecutionPolicy>(static_cast<size_t>(last - first), std::move(init), reduce,
+		[&](size_t i) -> T { return transform(first[i]); });
+}
+
+} // namespace std
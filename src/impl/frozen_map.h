@@ -0,0 +1,250 @@
+/**
+Read-only map built at compile time, for lookup tables fixed at build time (command names, config keys, etc).
+
+	constexpr auto commands = cz::make_frozen_map<std::string_view, int>({
+		{ "start", 1 },
+		{ "stop", 2 },
+		{ "status", 3 }
+	});
+
+	if (auto it = commands.find(name); it != commands.end())
+		...
+
+Construction finds a perfect hash for the keys (CHD, "hash, displace and compress"), so a lookup is one key hash,
+one mix, and a single key comparison, and no two keys ever share a slot. When the map is constexpr, all of that
+happens at compile time and the tables end up in read-only data, with no runtime initialization.
+
+Keys are hashed with Hash (cz::hash by default), which needs to be constexpr for constexpr maps (integers, enums and
+std::string_view are). Duplicated keys are an error (an assert, or a compile error in constant evaluation).
+
+Layout:
+	- m_items: The key/value pairs, in the order they were given.
+	- m_displacements: One entry per bucket. Keys are split in buckets by hash, and each bucket stores the
+	  displacement that puts all its keys in free slots. Buckets with a single key store the slot directly.
+	- m_slots: Index into m_items, for each slot. The table is the next power of 2 of N.
+*/
+
+#pragma once
+
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <array>
+#include "hash.h"
+#include "vector.h"
+
+#define CZ_FROZEN_MAP_ASSERT(x) assert(x)
+
+namespace cz
+{
+
+template<typename K, typename V, size_t N, typename Hash = cz::hash<K>>
+class frozen_map
+{
+	static_assert(N > 0, "Empty frozen_map not supported");
+
+public:
+	using key_type = K;
+	using mapped_type = V;
+	using value_type = std::pair<K, V>;
+	using size_type = size_t;
+	using const_iterator = const value_type*;
+
+	constexpr frozen_map(const value_type (&items)[N])
+		: frozen_map(items, std::make_index_sequence<N>())
+	{
+	}
+
+	constexpr frozen_map(const std::array<value_type, N>& items)
+		: frozen_map(items.data(), std::make_index_sequence<N>())
+	{
+	}
+
+	constexpr const_iterator begin() const noexcept { return m_items.begin(); }
+	constexpr const_iterator end() const noexcept { return m_items.end(); }
+	constexpr size_type size() const noexcept { return N; }
+	constexpr bool empty() const noexcept { return false; }
+
+	constexpr const_iterator find(const K& key) const
+	{
+		const uint64_t h = _hash(key, m_seed);
+		const uint32_t d = m_displacements[h & (ms_numBuckets - 1)];
+		const size_t slot = (d & ms_directSlot) ? (d & ~ms_directSlot) : _slot(h, d);
+		const value_type& item = m_items[m_slots[slot]];
+		return item.first == key ? &item : end();
+	}
+
+	constexpr bool contains(const K& key) const
+	{
+		return find(key) != end();
+	}
+
+	constexpr size_type count(const K& key) const
+	{
+		return contains(key) ? 1 : 0;
+	}
+
+private:
+
+	static constexpr size_t _nextPow2(size_t v)
+	{
+		size_t res = 1;
+		while (res < v)
+		{
+			res <<= 1;
+		}
+		return res;
+	}
+
+	// Average of 2 keys per bucket. Fewer buckets make the tables smaller, but the build slower
+	static constexpr size_t ms_numBuckets = _nextPow2((N + 1) / 2);
+	static constexpr size_t ms_numSlots = _nextPow2(N);
+	// Set in a displacement if it's a slot index, for buckets with a single key
+	static constexpr uint32_t ms_directSlot = 0x80000000u;
+	// Displacements tried per bucket, and seeds tried, before giving up
+	static constexpr uint32_t ms_maxDisplacement = 1u << 20;
+	static constexpr uint64_t ms_maxSeeds = 64;
+
+	static_assert(ms_numSlots < ms_directSlot, "Too many keys");
+
+	using index_type = std::conditional_t<(N <= 0xFFFF), uint16_t, uint32_t>;
+
+	static constexpr uint64_t _hash(const K& key, uint64_t seed)
+	{
+		return hash_mix(static_cast<uint64_t>(Hash()(key)) ^ seed);
+	}
+
+	static constexpr size_t _slot(uint64_t h, uint32_t d)
+	{
+		return static_cast<size_t>(hash_mix(h ^ (d * 0x9e3779b97f4a7c15ull))) & (ms_numSlots - 1);
+	}
+
+	template<size_t... Is>
+	constexpr frozen_map(const value_type* items, std::index_sequence<Is...>)
+		: m_items{ { items[Is]... } }
+	{
+		for (size_t i = 0; i < N; i++)
+		{
+			for (size_t j = i + 1; j < N; j++)
+			{
+				// Duplicated key
+				CZ_FROZEN_MAP_ASSERT(!(m_items[i].first == m_items[j].first));
+			}
+		}
+
+		for (uint64_t attempt = 0; attempt < ms_maxSeeds; attempt++)
+		{
+			m_seed = hash_mix(attempt);
+			if (_build())
+			{
+				return;
+			}
+		}
+
+		// Can only happen if Hash gives the same value for different keys
+		CZ_FROZEN_MAP_ASSERT(false);
+	}
+
+	// Tries to find a displacement for every bucket with the current seed
+	constexpr bool _build()
+	{
+		cz::vector<uint64_t> hashes(N);
+		cz::vector<cz::vector<index_type>> buckets(ms_numBuckets);
+		size_t maxBucketSize = 0;
+		for (size_t i = 0; i < N; i++)
+		{
+			hashes[i] = _hash(m_items[i].first, m_seed);
+			cz::vector<index_type>& bucket = buckets[hashes[i] & (ms_numBuckets - 1)];
+			bucket.push_back(static_cast<index_type>(i));
+			maxBucketSize = bucket.size() > maxBucketSize ? bucket.size() : maxBucketSize;
+		}
+
+		cz::vector<bool> used(ms_numSlots, false);
+		cz::vector<size_t> slots(maxBucketSize);
+		m_displacements = {};
+		m_slots = {};
+
+		// Biggest buckets first, while there are more free slots
+		for (size_t bucketSize = maxBucketSize; bucketSize >= 2; bucketSize--)
+		{
+			for (size_t b = 0; b < ms_numBuckets; b++)
+			{
+				const cz::vector<index_type>& bucket = buckets[b];
+				if (bucket.size() != bucketSize)
+				{
+					continue;
+				}
+
+				uint32_t d = 0;
+				for (;; d++)
+				{
+					if (d == ms_maxDisplacement)
+					{
+						return false;
+					}
+
+					bool fits = true;
+					for (size_t k = 0; k < bucketSize && fits; k++)
+					{
+						slots[k] = _slot(hashes[bucket[k]], d);
+						fits = !used[slots[k]];
+						// Keys in the same bucket can't take the same slot either
+						for (size_t prev = 0; prev < k && fits; prev++)
+						{
+							fits = slots[prev] != slots[k];
+						}
+					}
+
+					if (fits)
+					{
+						break;
+					}
+				}
+
+				m_displacements[b] = d;
+				for (size_t k = 0; k < bucketSize; k++)
+				{
+					used[slots[k]] = true;
+					m_slots[slots[k]] = bucket[k];
+				}
+			}
+		}
+
+		// Buckets with a single key take any free slot
+		size_t freeSlot = 0;
+		for (size_t b = 0; b < ms_numBuckets; b++)
+		{
+			if (buckets[b].size() == 1)
+			{
+				while (used[freeSlot])
+				{
+					freeSlot++;
+				}
+				used[freeSlot] = true;
+				m_displacements[b] = ms_directSlot | static_cast<uint32_t>(freeSlot);
+				m_slots[freeSlot] = buckets[b][0];
+			}
+		}
+
+		return true;
+	}
+
+	std::array<value_type, N> m_items;
+	std::array<uint32_t, ms_numBuckets> m_displacements = {};
+	// Unused slots point to item 0, which never matches a key that hashes there
+	std::array<index_type, ms_numSlots> m_slots = {};
+	uint64_t m_seed = 0;
+};
+
+/**
+ * Deduces N from the number of items. E.g:
+ *	constexpr auto m = cz::make_frozen_map<int, int>({ { 1, 10 }, { 2, 20 } });
+ */
+template<typename K, typename V, typename Hash = cz::hash<K>, size_t N>
+constexpr frozen_map<K, V, N, Hash> make_frozen_map(const std::pair<K, V> (&items)[N])
+{
+	return frozen_map<K, V, N, Hash>(items);
+}
+
+} // namespace cz
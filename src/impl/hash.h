@@ -0,0 +1,313 @@
+/**
+Fast non-cryptographic hashing.
+
+	- cz::hash<T>: Hash functor for integers, enums, pointers, floating point, std::string_view, std::span and
+	  cz::vector. Not defined for other types, unless specialized.
+	- hash_bytes(data, size, seed): Hashes raw bytes with wyhash (https://github.com/wangyi-fudan/wyhash, final
+	  version 4), which processes 48 bytes per iteration and passes SMHasher.
+	- hash_mix(x): Strong 64 bits integer mixer (splitmix64 finalizer), so hash<int> is good even with tables that
+	  use the low bits as bucket index.
+	- hash_combine(seed, v): Combines the hash of v into seed, to hash several values together.
+
+hash<T> for integers, enums and std::string_view is constexpr, and gives the same result at compile time and at runtime,
+so it can be used to build tables at compile time (see cz::frozen_map).
+
+Ranges of types where equal values have equal bytes are hashed as a single block of bytes. This is the case for
+integers, enums and pointers, and other types can opt-in by specializing cz::is_trivially_hashable. E.g:
+
+	template<>
+	struct cz::is_trivially_hashable<Point> : std::true_type {};
+
+Only do that for types without padding, or where padding is always zeroed.
+Hashes are meant for in-memory containers. They can change between versions, and bytes are read in the native
+byte order, so they shouldn't be persisted or sent over the network.
+*/
+
+#pragma once
+
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <string.h>
+#include <string_view>
+#include <span>
+#include "vector.h"
+
+namespace cz
+{
+
+/**
+ * True if hashing the bytes of a T gives equal hashes for equal values
+ */
+template<typename T>
+struct is_trivially_hashable : std::bool_constant<
+	detail::is_integer_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>>
+{
+};
+
+template<typename T>
+inline constexpr bool is_trivially_hashable_v = is_trivially_hashable<T>::value;
+
+namespace detail
+{
+	// Full 64x64->128 bits multiply. Returns the low half in a, and the high half in b
+	constexpr void hash_mum(uint64_t& a, uint64_t& b)
+	{
+#if defined(__SIZEOF_INT128__)
+		const __uint128_t r = static_cast<__uint128_t>(a) * b;
+		a = static_cast<uint64_t>(r);
+		b = static_cast<uint64_t>(r >> 64);
+#else
+		const uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<uint32_t>(a), lb = static_cast<uint32_t>(b);
+		const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+		const uint64_t t = rl + (rm0 << 32);
+		uint64_t carry = t < rl;
+		const uint64_t lo = t + (rm1 << 32);
+		carry += lo < t;
+		const uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+		a = lo;
+		b = hi;
+#endif
+	}
+
+	constexpr uint64_t hash_wymix(uint64_t a, uint64_t b)
+	{
+		hash_mum(a, b);
+		return a ^ b;
+	}
+
+	// Reads N bytes in the native byte order. Byte is char or uint8_t, so it also works in constant evaluation
+	// (where memcpy isn't allowed), giving the same result as at runtime
+	template<size_t N, typename Byte>
+	constexpr uint64_t hash_readN(const Byte* p)
+	{
+		if (std::is_constant_evaluated())
+		{
+			uint64_t v = 0;
+			for (size_t i = 0; i < N; i++)
+			{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+				v = (v << 8) | static_cast<uint8_t>(p[i]);
+#else
+				v |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (i * 8);
+#endif
+			}
+			return v;
+		}
+		else if constexpr (N == 8)
+		{
+			uint64_t v;
+			memcpy(&v, p, 8);
+			return v;
+		}
+		else
+		{
+			uint32_t v;
+			memcpy(&v, p, 4);
+			return v;
+		}
+	}
+
+	template<typename Byte>
+	constexpr uint64_t hash_read8(const Byte* p)
+	{
+		return hash_readN<8>(p);
+	}
+
+	template<typename Byte>
+	constexpr uint64_t hash_read4(const Byte* p)
+	{
+		return hash_readN<4>(p);
+	}
+
+	// Reads 1 to 3 bytes
+	template<typename Byte>
+	constexpr uint64_t hash_read3(const Byte* p, size_t k)
+	{
+		return (static_cast<uint64_t>(static_cast<uint8_t>(p[0])) << 16) |
+			(static_cast<uint64_t>(static_cast<uint8_t>(p[k >> 1])) << 8) | static_cast<uint8_t>(p[k - 1]);
+	}
+
+	inline constexpr uint64_t hash_secret[4] = {
+		0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull };
+
+} // namespace detail
+
+/**
+ * Mixes all bits of x into all bits of the result
+ */
+constexpr uint64_t hash_mix(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ull;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebull;
+	x ^= x >> 31;
+	return x;
+}
+
+namespace detail
+{
+	// hash_bytes, templated on the byte type so hashing chars can be constexpr
+	template<typename Byte>
+	constexpr uint64_t hash_bytes_impl(const Byte* p, size_t size, uint64_t seed)
+	{
+		seed ^= hash_wymix(seed ^ hash_secret[0], hash_secret[1]);
+		uint64_t a, b;
+		if (size <= 16)
+		{
+			if (size >= 4)
+			{
+				// Two overlapping reads from each end cover everything up to 16 bytes
+				a = (hash_read4(p) << 32) | hash_read4(p + ((size >> 3) << 2));
+				b = (hash_read4(p + size - 4) << 32) | hash_read4(p + size - 4 - ((size >> 3) << 2));
+			}
+			else if (size > 0)
+			{
+				a = hash_read3(p, size);
+				b = 0;
+			}
+			else
+			{
+				a = b = 0;
+			}
+		}
+		else
+		{
+			size_t i = size;
+			if (i > 48)
+			{
+				// 3 independent lanes, so the multiplies can overlap
+				uint64_t see1 = seed, see2 = seed;
+				do
+				{
+					seed = hash_wymix(hash_read8(p) ^ hash_secret[1], hash_read8(p + 8) ^ seed);
+					see1 = hash_wymix(hash_read8(p + 16) ^ hash_secret[2], hash_read8(p + 24) ^ see1);
+					see2 = hash_wymix(hash_read8(p + 32) ^ hash_secret[3], hash_read8(p + 40) ^ see2);
+					p += 48;
+					i -= 48;
+				} while (i > 48);
+				seed ^= see1 ^ see2;
+			}
+			while (i > 16)
+			{
+				seed = hash_wymix(hash_read8(p) ^ hash_secret[1], hash_read8(p + 8) ^ seed);
+				i -= 16;
+				p += 16;
+			}
+			a = hash_read8(p + i - 16);
+			b = hash_read8(p + i - 8);
+		}
+
+		a ^= hash_secret[1];
+		b ^= seed;
+		hash_mum(a, b);
+		return hash_wymix(a ^ hash_secret[0] ^ size, b ^ hash_secret[1]);
+	}
+} // namespace detail
+
+inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0)
+{
+	return detail::hash_bytes_impl(static_cast<const uint8_t*>(data), size, seed);
+}
+
+/**
+ * Primary template is disabled, like std::hash for types without a specialization
+ */
+template<typename T, typename Enable = void>
+struct hash
+{
+	hash() = delete;
+};
+
+template<typename T>
+struct hash<T, std::enable_if_t<detail::is_integer_v<T> || std::is_enum_v<T>>>
+{
+	constexpr size_t operator()(T v) const noexcept
+	{
+		return static_cast<size_t>(hash_mix(static_cast<uint64_t>(v)));
+	}
+};
+
+template<typename T>
+struct hash<T*>
+{
+	size_t operator()(T* v) const noexcept
+	{
+		return static_cast<size_t>(hash_mix(reinterpret_cast<uintptr_t>(v)));
+	}
+};
+
+template<typename T>
+struct hash<T, std::enable_if_t<std::is_floating_point<T>::value>>
+{
+	size_t operator()(T v) const noexcept
+	{
+		// 0.0 and -0.0 are equal, so need the same hash
+		if (v == T(0))
+		{
+			v = T(0);
+		}
+		return static_cast<size_t>(hash_bytes(&v, sizeof(v)));
+	}
+};
+
+template<>
+struct hash<std::string_view>
+{
+	constexpr size_t operator()(std::string_view v) const noexcept
+	{
+		return static_cast<size_t>(detail::hash_bytes_impl(v.data(), v.size(), 0));
+	}
+};
+
+/**
+ * Hashes the elements of [first, last) together
+ */
+template<typename T>
+uint64_t hash_range(const T* first, const T* last, uint64_t seed = 0)
+{
+	if constexpr (is_trivially_hashable_v<T>)
+	{
+		return hash_bytes(first, static_cast<size_t>(last - first) * sizeof(T), seed);
+	}
+	else
+	{
+		uint64_t res = hash_mix(seed ^ static_cast<uint64_t>(last - first));
+		for (; first != last; ++first)
+		{
+			res = detail::hash_wymix(res ^ detail::hash_secret[0], hash<T>()(*first) ^ detail::hash_secret[1]);
+		}
+		return res;
+	}
+}
+
+template<typename T>
+struct hash<std::span<T>>
+{
+	size_t operator()(std::span<T> v) const noexcept
+	{
+		return static_cast<size_t>(hash_range<std::remove_cv_t<T>>(v.begin(), v.end()));
+	}
+};
+
+template<typename T, size_t Alignment>
+struct hash<vector<T, Alignment>>
+{
+	size_t operator()(const vector<T, Alignment>& v) const noexcept
+	{
+		return static_cast<size_t>(hash_range<T>(v.begin(), v.end()));
+	}
+};
+
+/**
+ * Combines the hash of v into seed. The order values are combined in matters
+ */
+template<typename T>
+void hash_combine(size_t& seed, const T& v)
+{
+	seed = static_cast<size_t>(detail::hash_wymix(
+		static_cast<uint64_t>(seed) ^ detail::hash_secret[0], static_cast<uint64_t>(hash<T>()(v)) ^ detail::hash_secret[1]));
+}
+
+} // namespace cz
@@ -0,0 +1,268 @@
+/**
+Type-erased callable that never allocates.
+
+inplace_function<R(Args...), Capacity> stores the callable in an inline buffer of Capacity bytes. Callables that
+don't fit (or are over-aligned) are rejected at compile time, instead of silently falling back to the heap.
+
+Dispatch is done through a single static table of function pointers per callable type, so there are no virtual
+functions and no RTTI. An empty inplace_function points to a table whose invoke asserts, so calling doesn't need a
+null check.
+
+Moving an inplace_function relocates the stored callable with a memcpy if it's trivially relocatable (see
+cz::is_trivially_relocatable), or with its move constructor otherwise, so lambdas can capture things like a cz::vector.
+Since the stored callable isn't known at compile time, inplace_function itself is not trivially relocatable.
+Stored callables need to be copy constructible, like with std::function, so move-only callables are rejected at compile time.
+*/
+
+#pragma once
+
+#include "vector.h"
+
+namespace cz
+{
+
+namespace detail
+{
+	// Used to calculate the default alignment
+	union inplace_function_max_align
+	{
+		void* p;
+		long long ll;
+		double d;
+		void (*fn)();
+	};
+
+	template<typename R, typename... Args>
+	struct inplace_function_ops
+	{
+		using invoke_fn = R (*)(void* storage, Args&&... args);
+		using copy_fn = void (*)(void* dest, const void* src);
+		using destroy_fn = void (*)(void* storage);
+		// Moves src into dest, and destroys src. nullptr if a memcpy does the same
+		using relocate_fn = void (*)(void* dest, void* src);
+
+		invoke_fn invoke;
+		copy_fn copy;
+		destroy_fn destroy;
+		relocate_fn relocate;
+
+		static R _emptyInvoke(void*, Args&&...)
+		{
+			CZ_VECTOR_ASSERT(false && "Calling an empty inplace_function");
+			__builtin_unreachable();
+		}
+
+		static void _emptyCopy(void*, const void*)
+		{
+		}
+
+		static void _emptyDestroy(void*)
+		{
+		}
+
+		static constexpr inplace_function_ops empty = { &_emptyInvoke, &_emptyCopy, &_emptyDestroy, nullptr };
+	};
+
+	template<typename F, typename R, typename... Args>
+	struct inplace_function_callable_ops
+	{
+		static R _invoke(void* storage, Args&&... args)
+		{
+			F& f = *static_cast<F*>(storage);
+			if constexpr (std::is_void_v<R>)
+			{
+				f(std::forward<Args>(args)...);
+			}
+			else
+			{
+				return f(std::forward<Args>(args)...);
+			}
+		}
+
+		static void _copy(void* dest, const void* src)
+		{
+			new(dest) F(*static_cast<const F*>(src));
+		}
+
+		static void _destroy(void* storage)
+		{
+			static_cast<F*>(storage)->~F();
+		}
+
+		static void _relocate(void* dest, void* src)
+		{
+			F* f = static_cast<F*>(src);
+			new(dest) F(std::move(*f));
+			f->~F();
+		}
+
+		static constexpr inplace_function_ops<R, Args...> ops = {
+			&_invoke, &_copy, &_destroy, is_trivially_relocatable_v<F> ? nullptr : &_relocate };
+	};
+
+} // namespace detail
+
+template<typename Signature, size_t Capacity = 4 * sizeof(void*), size_t Alignment = alignof(detail::inplace_function_max_align)>
+class inplace_function;
+
+template<typename R, typename... Args, size_t Capacity, size_t Alignment>
+class inplace_function<R(Args...), Capacity, Alignment>
+{
+private:
+	using ops_type = detail::inplace_function_ops<R, Args...>;
+
+	template<typename F>
+	static constexpr bool is_callable_v =
+		!std::is_same_v<std::decay_t<F>, inplace_function> && !std::is_same_v<std::decay_t<F>, std::nullptr_t>;
+
+public:
+	using result_type = R;
+
+	static constexpr size_t capacity = Capacity;
+	static constexpr size_t alignment = Alignment;
+
+	inplace_function() noexcept
+	{
+	}
+
+	inplace_function(std::nullptr_t) noexcept
+	{
+	}
+
+	template<typename F, typename = std::enable_if_t<is_callable_v<F>>>
+	inplace_function(F&& f)
+	{
+		_construct(std::forward<F>(f));
+	}
+
+	inplace_function(const inplace_function& other)
+		: m_ops(other.m_ops)
+	{
+		m_ops->copy(m_storage, other.m_storage);
+	}
+
+	inplace_function(inplace_function&& other) noexcept
+		: m_ops(other.m_ops)
+	{
+		_relocate(m_ops, m_storage, other.m_storage);
+		other.m_ops = &ops_type::empty;
+	}
+
+	~inplace_function()
+	{
+		m_ops->destroy(m_storage);
+	}
+
+	inplace_function& operator=(const inplace_function& other)
+	{
+		if (this != &other)
+		{
+			inplace_function tmp(other);
+			*this = std::move(tmp);
+		}
+		return *this;
+	}
+
+	inplace_function& operator=(inplace_function&& other) noexcept
+	{
+		if (this != &other)
+		{
+			m_ops->destroy(m_storage);
+			m_ops = other.m_ops;
+			_relocate(m_ops, m_storage, other.m_storage);
+			other.m_ops = &ops_type::empty;
+		}
+		return *this;
+	}
+
+	inplace_function& operator=(std::nullptr_t) noexcept
+	{
+		m_ops->destroy(m_storage);
+		m_ops = &ops_type::empty;
+		return *this;
+	}
+
+	template<typename F, typename = std::enable_if_t<is_callable_v<F>>>
+	inplace_function& operator=(F&& f)
+	{
+		m_ops->destroy(m_storage);
+		m_ops = &ops_type::empty;
+		_construct(std::forward<F>(f));
+		return *this;
+	}
+
+	void swap(inplace_function& other) noexcept
+	{
+		alignas(Alignment) unsigned char tmp[Capacity];
+		_relocate(m_ops, tmp, m_storage);
+		_relocate(other.m_ops, m_storage, other.m_storage);
+		_relocate(m_ops, other.m_storage, tmp);
+		const ops_type* tmpOps = m_ops;
+		m_ops = other.m_ops;
+		other.m_ops = tmpOps;
+	}
+
+	explicit operator bool() const noexcept
+	{
+		return m_ops != &ops_type::empty;
+	}
+
+	R operator()(Args... args) const
+	{
+		return m_ops->invoke(m_storage, std::forward<Args>(args)...);
+	}
+
+private:
+
+	static void _relocate(const ops_type* ops, void* dest, void* src)
+	{
+		if (ops->relocate)
+		{
+			ops->relocate(dest, src);
+		}
+		else
+		{
+			memcpy(dest, src, Capacity);
+		}
+	}
+
+	template<typename F>
+	void _construct(F&& f)
+	{
+		using Callable = std::decay_t<F>;
+		static_assert(sizeof(Callable) <= Capacity, "Callable too big for this inplace_function. Increase the Capacity.");
+		static_assert(Alignment % alignof(Callable) == 0, "Callable alignment not supported by this inplace_function");
+		// Like std::function, since inplace_function itself is copyable
+		static_assert(std::is_copy_constructible_v<Callable>, "Callable needs to be copy constructible");
+
+		// Function references can't be null, so only check actual pointers
+		if constexpr (std::is_pointer_v<std::remove_reference_t<F>>)
+		{
+			if (f == nullptr)
+			{
+				return;
+			}
+		}
+
+		new(m_storage) Callable(std::forward<F>(f));
+		m_ops = &detail::inplace_function_callable_ops<Callable, R, Args...>::ops;
+	}
+
+	const ops_type* m_ops = &ops_type::empty;
+	// mutable, so a const inplace_function can call a non-const operator() of the callable, like std::function
+	alignas(Alignment) mutable unsigned char m_storage[Capacity];
+};
+
+template<typename Signature, size_t Capacity, size_t Alignment>
+bool operator==(const inplace_function<Signature, Capacity, Alignment>& f, std::nullptr_t) noexcept
+{
+	return !f;
+}
+
+template<typename Signature, size_t Capacity, size_t Alignment>
+bool operator!=(const inplace_function<Signature, Capacity, Alignment>& f, std::nullptr_t) noexcept
+{
+	return static_cast<bool>(f);
+}
+
+} // namespace cz
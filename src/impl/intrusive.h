@@ -0,0 +1,612 @@
+/**
+Intrusive containers.
+
+The links live inside the elements (as a hook member), so inserting and removing never allocates, and an element
+can be unlinked in O(1) given just a reference to it.
+The containers don't own the elements. An element must be removed from a container before being destroyed.
+
+Usage:
+	struct Foo
+	{
+		int value;
+		cz::intrusive_list_hook hook;
+	};
+	cz::intrusive_list<Foo, &Foo::hook> list;
+
+With CZ_INTRUSIVE_SAFE_MODE (enabled by default in debug), inserting an element that is already linked or destroying
+an element that is still linked asserts.
+*/
+
+#pragma once
+
+#include <assert.h>
+#include <cstddef>
+#include <type_traits>
+#include <functional>
+
+#define CZ_INTRUSIVE_ASSERT(x) assert(x)
+
+#ifndef CZ_INTRUSIVE_SAFE_MODE
+	#ifdef NDEBUG
+		#define CZ_INTRUSIVE_SAFE_MODE 0
+	#else
+		#define CZ_INTRUSIVE_SAFE_MODE 1
+	#endif
+#endif
+
+#if CZ_INTRUSIVE_SAFE_MODE
+	#define CZ_INTRUSIVE_SAFE_ASSERT(x) CZ_INTRUSIVE_ASSERT(x)
+#else
+	#define CZ_INTRUSIVE_SAFE_ASSERT(x)
+#endif
+
+namespace cz
+{
+
+namespace detail
+{
+	/**
+	 * Common hook behaviour. An unlinked hook has next==nullptr, since all the containers are circular.
+	 * Copying an element doesn't copy its links.
+	 */
+	template<typename Derived>
+	struct intrusive_hook_base
+	{
+		Derived* next = nullptr;
+
+		constexpr intrusive_hook_base() noexcept {}
+		intrusive_hook_base(const intrusive_hook_base&) noexcept {}
+		intrusive_hook_base& operator=(const intrusive_hook_base&) noexcept { return *this; }
+
+#if CZ_INTRUSIVE_SAFE_MODE
+		~intrusive_hook_base()
+		{
+			// Destroying an element that is still in a container
+			CZ_INTRUSIVE_ASSERT(next == nullptr);
+		}
+#endif
+
+		bool is_linked() const noexcept
+		{
+			return next != nullptr;
+		}
+	};
+
+	// Converts between an element and its hook
+	template<typename T, typename Hook, Hook T::*Member>
+	struct intrusive_traits
+	{
+		static Hook* toHook(T& value)
+		{
+			return &(value.*Member);
+		}
+
+		static T* toValue(Hook* hook)
+		{
+			return reinterpret_cast<T*>(reinterpret_cast<char*>(hook) - _offset());
+		}
+
+		static const T* toValue(const Hook* hook)
+		{
+			return reinterpret_cast<const T*>(reinterpret_cast<const char*>(hook) - _offset());
+		}
+
+	private:
+		static size_t _offset()
+		{
+			return reinterpret_cast<size_t>(&(static_cast<T*>(nullptr)->*Member));
+		}
+	};
+
+	template<typename Traits, typename Hook, typename ValueType, bool Bidirectional>
+	class intrusive_iterator
+	{
+	public:
+		explicit intrusive_iterator(Hook* node)
+			: m_node(node)
+		{
+		}
+
+		ValueType& operator*() const { return *Traits::toValue(m_node); }
+		ValueType* operator->() const { return Traits::toValue(m_node); }
+
+		intrusive_iterator& operator++()
+		{
+			m_node = m_node->next;
+			return *this;
+		}
+
+		intrusive_iterator operator++(int)
+		{
+			intrusive_iterator tmp = *this;
+			m_node = m_node->next;
+			return tmp;
+		}
+
+		template<bool B = Bidirectional, typename = std::enable_if_t<B>>
+		intrusive_iterator& operator--()
+		{
+			m_node = m_node->prev;
+			return *this;
+		}
+
+		bool operator==(const intrusive_iterator& other) const { return m_node == other.m_node; }
+		bool operator!=(const intrusive_iterator& other) const { return m_node != other.m_node; }
+
+		Hook* node() const { return m_node; }
+
+	private:
+		Hook* m_node;
+	};
+
+} // namespace detail
+
+//////////////////////////////////////////////////////////////////////////
+//	Doubly linked list
+//////////////////////////////////////////////////////////////////////////
+
+struct intrusive_list_hook : public detail::intrusive_hook_base<intrusive_list_hook>
+{
+	intrusive_list_hook* prev = nullptr;
+
+	// Like the base, copying leaves the links alone, so copying to or from a linked element doesn't corrupt its list
+	constexpr intrusive_list_hook() noexcept {}
+	intrusive_list_hook(const intrusive_list_hook&) noexcept : intrusive_hook_base() {}
+	intrusive_list_hook& operator=(const intrusive_list_hook&) noexcept { return *this; }
+};
+
+template<typename T, intrusive_list_hook T::*Member>
+class intrusive_list
+{
+private:
+	using traits = detail::intrusive_traits<T, intrusive_list_hook, Member>;
+	using hook = intrusive_list_hook;
+public:
+	using size_type = std::size_t;
+	using iterator = detail::intrusive_iterator<traits, hook, T, true>;
+	using const_iterator = detail::intrusive_iterator<traits, hook, const T, true>;
+
+	intrusive_list() noexcept
+	{
+		_resetRoot();
+	}
+
+	// The root is a sentinel inside the list, so the list itself can't be moved around without fixing the links
+	intrusive_list(const intrusive_list&) = delete;
+	intrusive_list& operator=(const intrusive_list&) = delete;
+
+	~intrusive_list()
+	{
+		clear();
+		m_root.next = nullptr;
+	}
+
+	bool empty() const noexcept
+	{
+		return m_size == 0;
+	}
+
+	size_type size() const noexcept
+	{
+		return m_size;
+	}
+
+	T& front()
+	{
+		CZ_INTRUSIVE_ASSERT(m_size);
+		return *traits::toValue(m_root.next);
+	}
+
+	T& back()
+	{
+		CZ_INTRUSIVE_ASSERT(m_size);
+		return *traits::toValue(m_root.prev);
+	}
+
+	iterator begin() noexcept { return iterator(m_root.next); }
+	iterator end() noexcept { return iterator(&m_root); }
+	const_iterator begin() const noexcept { return const_iterator(m_root.next); }
+	const_iterator end() const noexcept { return const_iterator(const_cast<hook*>(&m_root)); }
+
+	void push_front(T& value)
+	{
+		_linkBefore(m_root.next, traits::toHook(value));
+	}
+
+	void push_back(T& value)
+	{
+		_linkBefore(&m_root, traits::toHook(value));
+	}
+
+	// Inserts value before pos
+	iterator insert(iterator pos, T& value)
+	{
+		hook* node = traits::toHook(value);
+		_linkBefore(pos.node(), node);
+		return iterator(node);
+	}
+
+	void pop_front()
+	{
+		CZ_INTRUSIVE_ASSERT(m_size);
+		_unlink(m_root.next);
+	}
+
+	void pop_back()
+	{
+		CZ_INTRUSIVE_ASSERT(m_size);
+		_unlink(m_root.prev);
+	}
+
+	// Returns the iterator to the element after the one removed
+	iterator erase(iterator pos)
+	{
+		hook* next = pos.node()->next;
+		_unlink(pos.node());
+		return iterator(next);
+	}
+
+	// O(1) removal. The element must be in this list.
+	void remove(T& value)
+	{
+		_unlink(traits::toHook(value));
+	}
+
+	// Unlinks all elements
+	void clear() noexcept
+	{
+		hook* node = m_root.next;
+		while (node != &m_root)
+		{
+			hook* next = node->next;
+			node->next = nullptr;
+			node->prev = nullptr;
+			node = next;
+		}
+		_resetRoot();
+	}
+
+	// Returns an iterator to the given element, which must be in this list
+	iterator iterator_to(T& value)
+	{
+		return iterator(traits::toHook(value));
+	}
+
+private:
+
+	void _resetRoot()
+	{
+		m_root.next = &m_root;
+		m_root.prev = &m_root;
+		m_size = 0;
+	}
+
+	void _linkBefore(hook* pos, hook* node)
+	{
+		CZ_INTRUSIVE_SAFE_ASSERT(!node->is_linked());
+		node->next = pos;
+		node->prev = pos->prev;
+		pos->prev->next = node;
+		pos->prev = node;
+		++m_size;
+	}
+
+	void _unlink(hook* node)
+	{
+		CZ_INTRUSIVE_SAFE_ASSERT(node->is_linked() && node != &m_root);
+		node->prev->next = node->next;
+		node->next->prev = node->prev;
+		node->next = nullptr;
+		node->prev = nullptr;
+		--m_size;
+	}
+
+	hook m_root;
+	size_type m_size = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+//	Singly linked list
+//////////////////////////////////////////////////////////////////////////
+
+struct intrusive_slist_hook : public detail::intrusive_hook_base<intrusive_slist_hook>
+{
+};
+
+template<typename T, intrusive_slist_hook T::*Member>
+class intrusive_slist
+{
+private:
+	using traits = detail::intrusive_traits<T, intrusive_slist_hook, Member>;
+	using hook = intrusive_slist_hook;
+public:
+	using size_type = std::size_t;
+	using iterator = detail::intrusive_iterator<traits, hook, T, false>;
+	using const_iterator = detail::intrusive_iterator<traits, hook, const T, false>;
+
+	intrusive_slist() noexcept
+	{
+		_resetRoot();
+	}
+
+	intrusive_slist(const intrusive_slist&) = delete;
+	intrusive_slist& operator=(const intrusive_slist&) = delete;
+
+	~intrusive_slist()
+	{
+		clear();
+		m_root.next = nullptr;
+	}
+
+	bool empty() const noexcept
+	{
+		return m_size == 0;
+	}
+
+	size_type size() const noexcept
+	{
+		return m_size;
+	}
+
+	T& front()
+	{
+		CZ_INTRUSIVE_ASSERT(m_size);
+		return *traits::toValue(m_root.next);
+	}
+
+	T& back()
+	{
+		CZ_INTRUSIVE_ASSERT(m_size);
+		return *traits::toValue(m_tail);
+	}
+
+	// before_begin() can be used with insert_after/erase_after to operate on the front
+	iterator before_begin() noexcept { return iterator(&m_root); }
+	iterator begin() noexcept { return iterator(m_root.next); }
+	iterator end() noexcept { return iterator(&m_root); }
+	const_iterator begin() const noexcept { return const_iterator(m_root.next); }
+	const_iterator end() const noexcept { return const_iterator(const_cast<hook*>(&m_root)); }
+
+	void push_front(T& value)
+	{
+		_linkAfter(&m_root, traits::toHook(value));
+	}
+
+	void push_back(T& value)
+	{
+		_linkAfter(m_tail, traits::toHook(value));
+	}
+
+	iterator insert_after(iterator pos, T& value)
+	{
+		hook* node = traits::toHook(value);
+		_linkAfter(pos.node(), node);
+		return iterator(node);
+	}
+
+	void pop_front()
+	{
+		CZ_INTRUSIVE_ASSERT(m_size);
+		_unlinkAfter(&m_root);
+	}
+
+	// Removes the element after pos, and returns an iterator to the one after the removed element
+	iterator erase_after(iterator pos)
+	{
+		_unlinkAfter(pos.node());
+		return iterator(pos.node()->next);
+	}
+
+	// O(n) removal, since it needs to find the previous element. The element must be in this list.
+	void remove(T& value)
+	{
+		hook* node = traits::toHook(value);
+		hook* prev = &m_root;
+		while (prev->next != node)
+		{
+			CZ_INTRUSIVE_ASSERT(prev->next != &m_root);
+			prev = prev->next;
+		}
+		_unlinkAfter(prev);
+	}
+
+	void clear() noexcept
+	{
+		hook* node = m_root.next;
+		while (node != &m_root)
+		{
+			hook* next = node->next;
+			node->next = nullptr;
+			node = next;
+		}
+		_resetRoot();
+	}
+
+private:
+
+	void _resetRoot()
+	{
+		m_root.next = &m_root;
+		m_tail = &m_root;
+		m_size = 0;
+	}
+
+	void _linkAfter(hook* pos, hook* node)
+	{
+		CZ_INTRUSIVE_SAFE_ASSERT(!node->is_linked());
+		node->next = pos->next;
+		pos->next = node;
+		if (pos == m_tail)
+		{
+			m_tail = node;
+		}
+		++m_size;
+	}
+
+	void _unlinkAfter(hook* pos)
+	{
+		hook* node = pos->next;
+		CZ_INTRUSIVE_SAFE_ASSERT(node != &m_root);
+		pos->next = node->next;
+		if (node == m_tail)
+		{
+			m_tail = pos;
+		}
+		node->next = nullptr;
+		--m_size;
+	}
+
+	hook m_root;
+	hook* m_tail;
+	size_type m_size = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+//	Chained hash table
+//////////////////////////////////////////////////////////////////////////
+
+/**
+ * Hash table with a fixed number of buckets stored inline, and chains made of the elements' slist hooks.
+ *
+ * KeyOf: Functor that returns the key of an element
+ * Hash: Functor that returns the hash of a key
+ * NumBuckets: Must be a power of 2
+ */
+template<
+	typename T, intrusive_slist_hook T::*Member,
+	typename KeyOf, typename Hash, size_t NumBuckets,
+	typename KeyEqual = std::equal_to<>>
+class intrusive_hash_table
+{
+	static_assert(NumBuckets && (NumBuckets & (NumBuckets - 1)) == 0, "NumBuckets must be a power of 2");
+
+private:
+	using traits = detail::intrusive_traits<T, intrusive_slist_hook, Member>;
+	using hook = intrusive_slist_hook;
+public:
+	using size_type = std::size_t;
+
+	explicit intrusive_hash_table(const KeyOf& keyOf = KeyOf(), const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+		: m_keyOf(keyOf)
+		, m_hash(hash)
+		, m_equal(equal)
+	{
+		for (hook& bucket : m_buckets)
+		{
+			bucket.next = &bucket;
+		}
+	}
+
+	intrusive_hash_table(const intrusive_hash_table&) = delete;
+	intrusive_hash_table& operator=(const intrusive_hash_table&) = delete;
+
+	~intrusive_hash_table()
+	{
+		clear();
+		for (hook& bucket : m_buckets)
+		{
+			bucket.next = nullptr;
+		}
+	}
+
+	bool empty() const noexcept
+	{
+		return m_size == 0;
+	}
+
+	size_type size() const noexcept
+	{
+		return m_size;
+	}
+
+	static constexpr size_type bucket_count() noexcept
+	{
+		return NumBuckets;
+	}
+
+	// Inserts the element. It doesn't check for duplicate keys.
+	void insert(T& value)
+	{
+		hook* node = traits::toHook(value);
+		CZ_INTRUSIVE_SAFE_ASSERT(!node->is_linked());
+		hook& bucket = _bucket(m_keyOf(value));
+		node->next = bucket.next;
+		bucket.next = node;
+		++m_size;
+	}
+
+	template<typename Key>
+	T* find(const Key& key)
+	{
+		hook& bucket = _bucket(key);
+		for (hook* node = bucket.next; node != &bucket; node = node->next)
+		{
+			T* value = traits::toValue(node);
+			if (m_equal(m_keyOf(*value), key))
+			{
+				return value;
+			}
+		}
+		return nullptr;
+	}
+
+	// Removes the element, which must be in the table. O(chain length)
+	void erase(T& value)
+	{
+		hook* node = traits::toHook(value);
+		hook& bucket = _bucket(m_keyOf(value));
+		hook* prev = &bucket;
+		while (prev->next != node)
+		{
+			CZ_INTRUSIVE_ASSERT(prev->next != &bucket);
+			prev = prev->next;
+		}
+		prev->next = node->next;
+		node->next = nullptr;
+		--m_size;
+	}
+
+	// Removes and returns the element with the given key, or nullptr if not found
+	template<typename Key>
+	T* erase_key(const Key& key)
+	{
+		T* value = find(key);
+		if (value)
+		{
+			erase(*value);
+		}
+		return value;
+	}
+
+	void clear() noexcept
+	{
+		for (hook& bucket : m_buckets)
+		{
+			hook* node = bucket.next;
+			while (node != &bucket)
+			{
+				hook* next = node->next;
+				node->next = nullptr;
+				node = next;
+			}
+			bucket.next = &bucket;
+		}
+		m_size = 0;
+	}
+
+private:
+
+	template<typename Key>
+	hook& _bucket(const Key& key)
+	{
+		return m_buckets[static_cast<size_type>(m_hash(key)) & (NumBuckets - 1)];
+	}
+
+	hook m_buckets[NumBuckets];
+	size_type m_size = 0;
+	KeyOf m_keyOf;
+	Hash m_hash;
+	KeyEqual m_equal;
+};
+
+} // namespace cz
@@ -0,0 +1,362 @@
+/**
+Read-only array of trivially copyable elements, memory-mapped from a file.
+
+Opening only maps the file, so it's close to free regardless of size, and pages are loaded by the OS on first access.
+They're shared with the page cache instead of copied, so there is no second copy in memory like with read + assign,
+and reopening a file that was recently used (warm cache) doesn't touch the disk.
+
+Has the read API of cz::vector (data, size, begin/end, operator[], front/back).
+
+Files are written with mapped_vector<T>::write, and have a small header that open validates:
+	- magic ("CZMV"), which also catches files written with a different byte order
+	- format version
+	- sizeof(T) and alignof(T)
+	- element count, checked against the file size
+Elements start at offset 64, so they are aligned for any T with alignof(T) <= 64.
+It doesn't know anything else about T, so it's up to the caller to use the same T for writing and reading.
+
+Only needs POSIX mmap. The hugepage hint is Linux only, and ignored elsewhere.
+*/
+
+#pragma once
+
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <assert.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CZ_MAPPED_VECTOR_ASSERT(x) assert(x)
+
+namespace cz
+{
+
+enum class mapped_vector_result
+{
+	ok,
+	// Failed to open/create the file
+	open_failed,
+	// Failed to write or to get the file size
+	io_failed,
+	// The file is smaller than the header
+	no_header,
+	bad_magic,
+	bad_version,
+	// The file was written with a different T
+	bad_element,
+	// The file is smaller than what the header says
+	truncated,
+	// mmap failed
+	map_failed
+};
+
+/**
+ * Access pattern hints, passed to madvise. Can be combined.
+ */
+enum class mapped_advice : unsigned
+{
+	none = 0,
+	// Aggressive read-ahead, and pages can be dropped soon after being read
+	sequential = 1 << 0,
+	// No read-ahead
+	random = 1 << 1,
+	// Start loading everything in the background
+	willneed = 1 << 2,
+	// Use transparent huge pages if possible, so large arrays need fewer TLB entries
+	hugepage = 1 << 3
+};
+
+constexpr mapped_advice operator|(mapped_advice a, mapped_advice b)
+{
+	return static_cast<mapped_advice>(static_cast<unsigned>(a) | static_cast<unsigned>(b));
+}
+
+constexpr bool operator&(mapped_advice a, mapped_advice b)
+{
+	return (static_cast<unsigned>(a) & static_cast<unsigned>(b)) != 0;
+}
+
+namespace detail
+{
+	struct mapped_vector_header
+	{
+		static constexpr uint32_t ms_magic = 0x564d5a43; // "CZMV" in little endian
+		static constexpr uint32_t ms_version = 1;
+		static constexpr size_t ms_dataOffset = 64;
+
+		uint32_t magic;
+		uint32_t version;
+		uint32_t elementSize;
+		uint32_t elementAlign;
+		uint64_t count;
+	};
+
+	static_assert(sizeof(mapped_vector_header) <= mapped_vector_header::ms_dataOffset);
+}
+
+template<typename T>
+class mapped_vector
+{
+	static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be mapped");
+	static_assert(alignof(T) <= detail::mapped_vector_header::ms_dataOffset, "Alignment not supported");
+
+public:
+	using value_type = T;
+	using size_type = std::size_t;
+	using const_reference = const T&;
+	using const_iterator = const T*;
+
+	mapped_vector() noexcept {}
+
+	mapped_vector(const mapped_vector&) = delete;
+	mapped_vector& operator=(const mapped_vector&) = delete;
+
+	mapped_vector(mapped_vector&& other) noexcept
+		: m_map(other.m_map)
+		, m_mapSize(other.m_mapSize)
+		, m_size(other.m_size)
+	{
+		other.m_map = nullptr;
+		other.m_mapSize = 0;
+		other.m_size = 0;
+	}
+
+	mapped_vector& operator=(mapped_vector&& other) noexcept
+	{
+		if (this != &other)
+		{
+			close();
+			m_map = other.m_map;
+			m_mapSize = other.m_mapSize;
+			m_size = other.m_size;
+			other.m_map = nullptr;
+			other.m_mapSize = 0;
+			other.m_size = 0;
+		}
+		return *this;
+	}
+
+	~mapped_vector()
+	{
+		close();
+	}
+
+	/**
+	 * Writes count elements to a new file (or replaces an existing one), in the format open expects
+	 */
+	static mapped_vector_result write(const char* path, const T* data, size_type count)
+	{
+		const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+		{
+			return mapped_vector_result::open_failed;
+		}
+
+		uint8_t header[detail::mapped_vector_header::ms_dataOffset] = {};
+		const detail::mapped_vector_header h = {
+			detail::mapped_vector_header::ms_magic, detail::mapped_vector_header::ms_version,
+			static_cast<uint32_t>(sizeof(T)), static_cast<uint32_t>(alignof(T)), static_cast<uint64_t>(count) };
+		memcpy(header, &h, sizeof(h));
+
+		const bool ok = _writeAll(fd, header, sizeof(header)) && _writeAll(fd, data, count * sizeof(T));
+		return (::close(fd) == 0 && ok) ? mapped_vector_result::ok : mapped_vector_result::io_failed;
+	}
+
+	/**
+	 * Maps a file created with write. On failure, the mapped_vector is left empty.
+	 */
+	mapped_vector_result open(const char* path, mapped_advice advice = mapped_advice::none)
+	{
+		close();
+
+		const int fd = ::open(path, O_RDONLY);
+		if (fd < 0)
+		{
+			return mapped_vector_result::open_failed;
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) != 0)
+		{
+			::close(fd);
+			return mapped_vector_result::io_failed;
+		}
+
+		const size_type fileSize = static_cast<size_type>(st.st_size);
+		if (fileSize < detail::mapped_vector_header::ms_dataOffset)
+		{
+			::close(fd);
+			return mapped_vector_result::no_header;
+		}
+
+		void* map = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+		// The mapping keeps its own reference to the file
+		::close(fd);
+		if (map == MAP_FAILED)
+		{
+			return mapped_vector_result::map_failed;
+		}
+
+		const mapped_vector_result res = _validate(map, fileSize);
+		if (res != mapped_vector_result::ok)
+		{
+			munmap(map, fileSize);
+			return res;
+		}
+
+		detail::mapped_vector_header h;
+		memcpy(&h, map, sizeof(h));
+		m_map = map;
+		m_mapSize = fileSize;
+		m_size = static_cast<size_type>(h.count);
+		advise(advice);
+		return mapped_vector_result::ok;
+	}
+
+	/**
+	 * Applies access pattern hints to the whole mapping. They are only hints, so failures are ignored, other than
+	 * returning false.
+	 */
+	bool advise(mapped_advice advice)
+	{
+		if (!m_map)
+		{
+			return false;
+		}
+
+		bool ok = true;
+		if (advice & mapped_advice::sequential)
+		{
+			ok = madvise(m_map, m_mapSize, MADV_SEQUENTIAL) == 0 && ok;
+		}
+		if (advice & mapped_advice::random)
+		{
+			ok = madvise(m_map, m_mapSize, MADV_RANDOM) == 0 && ok;
+		}
+		if (advice & mapped_advice::willneed)
+		{
+			ok = madvise(m_map, m_mapSize, MADV_WILLNEED) == 0 && ok;
+		}
+#if defined(MADV_HUGEPAGE)
+		if (advice & mapped_advice::hugepage)
+		{
+			ok = madvise(m_map, m_mapSize, MADV_HUGEPAGE) == 0 && ok;
+		}
+#endif
+		return ok;
+	}
+
+	void close()
+	{
+		if (m_map)
+		{
+			munmap(m_map, m_mapSize);
+			m_map = nullptr;
+			m_mapSize = 0;
+			m_size = 0;
+		}
+	}
+
+	bool is_open() const noexcept
+	{
+		return m_map != nullptr;
+	}
+
+	//
+	// Element access
+	//
+	const T* data() const noexcept
+	{
+		return m_map ? reinterpret_cast<const T*>(static_cast<const uint8_t*>(m_map) + detail::mapped_vector_header::ms_dataOffset) : nullptr;
+	}
+
+	const T& operator[](size_type pos) const
+	{
+		CZ_MAPPED_VECTOR_ASSERT(pos < m_size);
+		return data()[pos];
+	}
+
+	const T& front() const
+	{
+		CZ_MAPPED_VECTOR_ASSERT(m_size);
+		return data()[0];
+	}
+
+	const T& back() const
+	{
+		CZ_MAPPED_VECTOR_ASSERT(m_size);
+		return data()[m_size - 1];
+	}
+
+	const T* begin() const noexcept
+	{
+		return data();
+	}
+
+	const T* end() const noexcept
+	{
+		return data() + m_size;
+	}
+
+	bool empty() const noexcept
+	{
+		return m_size == 0;
+	}
+
+	size_type size() const noexcept
+	{
+		return m_size;
+	}
+
+private:
+
+	static bool _writeAll(int fd, const void* data, size_type bytes)
+	{
+		const uint8_t* ptr = static_cast<const uint8_t*>(data);
+		while (bytes)
+		{
+			const ssize_t written = ::write(fd, ptr, bytes);
+			if (written <= 0)
+			{
+				return false;
+			}
+			ptr += written;
+			bytes -= static_cast<size_type>(written);
+		}
+		return true;
+	}
+
+	static mapped_vector_result _validate(const void* map, size_type fileSize)
+	{
+		detail::mapped_vector_header h;
+		memcpy(&h, map, sizeof(h));
+		if (h.magic != detail::mapped_vector_header::ms_magic)
+		{
+			return mapped_vector_result::bad_magic;
+		}
+		if (h.version != detail::mapped_vector_header::ms_version)
+		{
+			return mapped_vector_result::bad_version;
+		}
+		if (h.elementSize != sizeof(T) || h.elementAlign != alignof(T))
+		{
+			return mapped_vector_result::bad_element;
+		}
+		// Written like this so a huge count can't overflow
+		if (h.count > (fileSize - detail::mapped_vector_header::ms_dataOffset) / sizeof(T))
+		{
+			return mapped_vector_result::truncated;
+		}
+		return mapped_vector_result::ok;
+	}
+
+	void* m_map = nullptr;
+	size_type m_mapSize = 0;
+	size_type m_size = 0;
+};
+
+} // namespace cz
@@ -0,0 +1,498 @@
+/**
+Minimal std::optional implementation.
+
+optional<T> is trivially copyable/destructible if T is.
+
+Niche optimization:
+Types that have a value that can never be a valid object (e.g: a pointer to the last byte of the address space, or
+a handle with an "invalid" value) can use that value to represent the empty state, so optional<T> is the same size
+as T, instead of needing an extra bool. Pointers have this by default, and other types can opt-in by specializing
+cz::optional_niche. E.g:
+
+	template<>
+	struct cz::optional_niche<FileHandle> : cz::sentinel_niche<FileHandle, FileHandle::Invalid> {};
+
+Note that with a niche, the sentinel value itself can't be stored in the optional.
+*/
+
+#pragma once
+
+#include <assert.h>
+#include <type_traits>
+#include <utility>
+#include <cstdint>
+#include <new>
+#include "special_members.h"
+
+#define CZ_OPTIONAL_ASSERT(x) assert(x)
+
+namespace cz
+{
+
+struct nullopt_t
+{
+	explicit constexpr nullopt_t(int) {}
+};
+inline constexpr nullopt_t nullopt{0};
+
+/**
+ * Specialize to give a type a niche. Specializations need to provide:
+ *	static constexpr bool value = true;
+ *	static T empty_value();           // Value that represents the empty state
+ *	static bool is_empty(const T& v); // Checks if v is the empty state
+ * T needs to be trivially copyable and destructible.
+ */
+template<typename T>
+struct optional_niche
+{
+	static constexpr bool value = false;
+};
+
+/**
+ * Helper to implement optional_niche for types with a sentinel value.
+ */
+template<typename T, T Empty>
+struct sentinel_niche
+{
+	static constexpr bool value = true;
+
+	static constexpr T empty_value()
+	{
+		return Empty;
+	}
+
+	static constexpr bool is_empty(const T& v)
+	{
+		return v == Empty;
+	}
+};
+
+// Pointers use an address that can't hold an object
+template<typename T>
+struct optional_niche<T*>
+{
+	static constexpr bool value = true;
+
+	static T* empty_value()
+	{
+		return reinterpret_cast<T*>(~uintptr_t(0));
+	}
+
+	static bool is_empty(T* v)
+	{
+		return v == empty_value();
+	}
+};
+
+template<typename T>
+inline constexpr bool optional_niche_v = optional_niche<T>::value;
+
+namespace detail
+{
+	/**
+	 * Union to control the lifetime of T manually.
+	 * Only has a destructor if T needs one, so the optional can be trivially destructible.
+	 */
+	template<typename T, bool TrivialDtor = std::is_trivially_destructible_v<T>>
+	union optional_union
+	{
+		char m_dummy;
+		T m_value;
+
+		constexpr optional_union() noexcept
+			: m_dummy()
+		{
+		}
+
+		template<typename... Args>
+		constexpr explicit optional_union(std::in_place_t, Args&&... args)
+			: m_value(std::forward<Args>(args)...)
+		{
+		}
+	};
+
+	template<typename T>
+	union optional_union<T, false>
+	{
+		char m_dummy;
+		T m_value;
+
+		constexpr optional_union() noexcept
+			: m_dummy()
+		{
+		}
+
+		template<typename... Args>
+		constexpr explicit optional_union(std::in_place_t, Args&&... args)
+			: m_value(std::forward<Args>(args)...)
+		{
+		}
+
+		~optional_union()
+		{
+		}
+	};
+
+	/**
+	 * Storage using a bool to track if it's engaged.
+	 */
+	template<typename T, bool UseNiche = optional_niche_v<T>, bool TrivialDtor = std::is_trivially_destructible_v<T>>
+	struct optional_storage
+	{
+		optional_union<T> m_u;
+		bool m_engaged = false;
+
+		constexpr optional_storage() noexcept
+		{
+		}
+
+		template<typename... Args>
+		constexpr explicit optional_storage(std::in_place_t, Args&&... args)
+			: m_u(std::in_place, std::forward<Args>(args)...)
+			, m_engaged(true)
+		{
+		}
+
+		T& _get()
+		{
+			return m_u.m_value;
+		}
+
+		const T& _get() const
+		{
+			return m_u.m_value;
+		}
+
+		bool _hasValue() const
+		{
+			return m_engaged;
+		}
+
+		template<typename... Args>
+		void _construct(Args&&... args)
+		{
+			new(&m_u.m_value) T(std::forward<Args>(args)...);
+			m_engaged = true;
+		}
+
+		void _reset()
+		{
+			if (m_engaged)
+			{
+				m_u.m_value.~T();
+				m_engaged = false;
+			}
+		}
+	};
+
+	template<typename T>
+	struct optional_storage<T, false, false> : optional_storage<T, false, true>
+	{
+		using optional_storage<T, false, true>::optional_storage;
+		optional_storage() = default;
+		optional_storage(const optional_storage&) = default;
+		optional_storage(optional_storage&&) = default;
+		optional_storage& operator=(const optional_storage&) = default;
+		optional_storage& operator=(optional_storage&&) = default;
+
+		~optional_storage()
+		{
+			this->_reset();
+		}
+	};
+
+	/**
+	 * Storage using the niche value to mark the empty state, so there is no extra bool
+	 */
+	template<typename T, bool TrivialDtor>
+	struct optional_storage<T, true, TrivialDtor>
+	{
+		static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>,
+			"Types with a niche need to be trivially copyable and destructible");
+
+		T m_value;
+
+		// constexpr if optional_niche<T>::empty_value() is
+		constexpr optional_storage() noexcept
+			: m_value(optional_niche<T>::empty_value())
+		{
+		}
+
+		template<typename... Args>
+		constexpr explicit optional_storage(std::in_place_t, Args&&... args)
+			: m_value(std::forward<Args>(args)...)
+		{
+			CZ_OPTIONAL_ASSERT(_hasValue() && "Can't store the niche value in an optional");
+		}
+
+		T& _get()
+		{
+			return m_value;
+		}
+
+		const T& _get() const
+		{
+			return m_value;
+		}
+
+		constexpr bool _hasValue() const
+		{
+			return !optional_niche<T>::is_empty(m_value);
+		}
+
+		template<typename... Args>
+		void _construct(Args&&... args)
+		{
+			m_value = T(std::forward<Args>(args)...);
+			CZ_OPTIONAL_ASSERT(_hasValue() && "Can't store the niche value in an optional");
+		}
+
+		void _reset()
+		{
+			m_value = optional_niche<T>::empty_value();
+		}
+	};
+
+	// Implements what detail::special_members_t needs.
+	// Other is either "const optional_base&" or "optional_base&&", so std::move on the value copies or moves accordingly
+	template<typename T>
+	struct optional_base : optional_storage<T>
+	{
+		using optional_storage<T>::optional_storage;
+
+		template<typename Other>
+		void _constructFrom(Other&& other)
+		{
+			if (other._hasValue())
+			{
+				this->_construct(std::move(other._get()));
+			}
+		}
+
+		template<typename Other>
+		void _assignFrom(Other&& other)
+		{
+			if (other._hasValue())
+			{
+				if (this->_hasValue())
+				{
+					this->_get() = std::move(other._get());
+				}
+				else
+				{
+					this->_construct(std::move(other._get()));
+				}
+			}
+			else
+			{
+				this->_reset();
+			}
+		}
+	};
+
+} // namespace detail
+
+template<typename T>
+class optional : private detail::special_members_t<detail::optional_base<T>, T>
+{
+private:
+	using base = detail::special_members_t<detail::optional_base<T>, T>;
+
+	template<typename U>
+	static constexpr bool is_value_arg_v =
+		!std::is_same_v<std::decay_t<U>, optional> && !std::is_same_v<std::decay_t<U>, std::in_place_t> &&
+		!std::is_same_v<std::decay_t<U>, nullopt_t> && std::is_constructible_v<T, U&&>;
+
+public:
+	using value_type = T;
+
+	constexpr optional() noexcept
+	{
+	}
+
+	constexpr optional(nullopt_t) noexcept
+	{
+	}
+
+	template<typename... Args>
+	constexpr explicit optional(std::in_place_t, Args&&... args)
+		: base(std::in_place, std::forward<Args>(args)...)
+	{
+	}
+
+	template<typename U = T, typename = std::enable_if_t<is_value_arg_v<U>>>
+	constexpr optional(U&& value)
+		: base(std::in_place, std::forward<U>(value))
+	{
+	}
+
+	optional(const optional&) = default;
+	optional(optional&&) = default;
+	optional& operator=(const optional&) = default;
+	optional& operator=(optional&&) = default;
+
+	optional& operator=(nullopt_t) noexcept
+	{
+		reset();
+		return *this;
+	}
+
+	template<typename U = T, typename = std::enable_if_t<is_value_arg_v<U>>>
+	optional& operator=(U&& value)
+	{
+		if (has_value())
+		{
+			this->_get() = std::forward<U>(value);
+		}
+		else
+		{
+			this->_construct(std::forward<U>(value));
+		}
+		return *this;
+	}
+
+	//
+	// Observers
+	//
+	bool has_value() const noexcept
+	{
+		return this->_hasValue();
+	}
+
+	explicit operator bool() const noexcept
+	{
+		return this->_hasValue();
+	}
+
+	T& value() &
+	{
+		CZ_OPTIONAL_ASSERT(has_value());
+		return this->_get();
+	}
+
+	const T& value() const&
+	{
+		CZ_OPTIONAL_ASSERT(has_value());
+		return this->_get();
+	}
+
+	T&& value() &&
+	{
+		CZ_OPTIONAL_ASSERT(has_value());
+		return std::move(this->_get());
+	}
+
+	T& operator*() &
+	{
+		return value();
+	}
+
+	const T& operator*() const&
+	{
+		return value();
+	}
+
+	T&& operator*() &&
+	{
+		return std::move(*this).value();
+	}
+
+	T* operator->()
+	{
+		return &value();
+	}
+
+	const T* operator->() const
+	{
+		return &value();
+	}
+
+	template<typename U>
+	T value_or(U&& defaultValue) const&
+	{
+		return has_value() ? this->_get() : static_cast<T>(std::forward<U>(defaultValue));
+	}
+
+	template<typename U>
+	T value_or(U&& defaultValue) &&
+	{
+		return has_value() ? std::move(this->_get()) : static_cast<T>(std::forward<U>(defaultValue));
+	}
+
+	//
+	// Modifiers
+	//
+	void reset() noexcept
+	{
+		this->_reset();
+	}
+
+	template<typename... Args>
+	T& emplace(Args&&... args)
+	{
+		this->_reset();
+		this->_construct(std::forward<Args>(args)...);
+		return this->_get();
+	}
+
+	void swap(optional& other)
+	{
+		optional tmp(std::move(other));
+		other = std::move(*this);
+		*this = std::move(tmp);
+	}
+};
+
+template<typename T>
+optional<std::decay_t<T>> make_optional(T&& value)
+{
+	return optional<std::decay_t<T>>(std::forward<T>(value));
+}
+
+template<typename T, typename... Args>
+optional<T> make_optional(Args&&... args)
+{
+	return optional<T>(std::in_place, std::forward<Args>(args)...);
+}
+
+template<typename T, typename U>
+bool operator==(const optional<T>& a, const optional<U>& b)
+{
+	if (a.has_value() != b.has_value())
+	{
+		return false;
+	}
+	return !a.has_value() || *a == *b;
+}
+
+template<typename T, typename U>
+bool operator!=(const optional<T>& a, const optional<U>& b)
+{
+	return !(a == b);
+}
+
+template<typename T>
+bool operator==(const optional<T>& a, nullopt_t)
+{
+	return !a;
+}
+
+template<typename T>
+bool operator!=(const optional<T>& a, nullopt_t)
+{
+	return a.has_value();
+}
+
+template<typename T, typename U, typename = std::enable_if_t<!std::is_same_v<U, nullopt_t>>>
+bool operator==(const optional<T>& a, const U& b)
+{
+	return a.has_value() && *a == b;
+}
+
+template<typename T, typename U, typename = std::enable_if_t<!std::is_same_v<U, nullopt_t>>>
+bool operator!=(const optional<T>& a, const U& b)
+{
+	return !(a == b);
+}
+
+} // namespace cz
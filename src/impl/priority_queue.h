@@ -0,0 +1,155 @@
+/**
+Priority queue adaptor over cz::vector.
+
+The heap arity is a template parameter. A 4-ary heap is shallower than a binary one and its children share a
+cache line, which usually makes pop cheaper for big queues.
+
+If IndexUpdater is specified, it's called as IndexUpdater(element, index) whenever an element is placed at a new
+position, so the elements (e.g: timers) can keep track of where they are and later be updated or removed
+with update/decrease_key/erase.
+*/
+
+#pragma once
+
+#include "vector.h"
+#include <functional>
+
+namespace cz
+{
+
+template<typename T, typename Compare = std::less<T>, size_t Arity = 2, typename IndexUpdater = std::detail::heap_no_index>
+class priority_queue
+{
+	static_assert(Arity >= 2, "Heap arity needs to be at least 2");
+
+public:
+	using value_type = T;
+	using size_type = std::size_t;
+
+	explicit priority_queue(const Compare& comp = Compare(), const IndexUpdater& updater = IndexUpdater())
+		: m_comp(comp)
+		, m_updater(updater)
+	{
+	}
+
+	//
+	// Element access
+	//
+	const T& top() const
+	{
+		CZ_VECTOR_ASSERT_SLOW(m_data.size());
+		return m_data.front();
+	}
+
+	// Access by position, for use with IndexUpdater.
+	// If the element's priority is changed, update or decrease_key needs to be called.
+	T& operator[](size_type pos)
+	{
+		return m_data[pos];
+	}
+
+	const T& operator[](size_type pos) const
+	{
+		return m_data[pos];
+	}
+
+	//
+	// Capacity
+	//
+	bool empty() const noexcept
+	{
+		return m_data.empty();
+	}
+
+	size_type size() const noexcept
+	{
+		return m_data.size();
+	}
+
+	void reserve(size_type newCapacity)
+	{
+		m_data.reserve(newCapacity);
+	}
+
+	//
+	// Modifiers
+	//
+	void clear() noexcept
+	{
+		m_data.clear();
+	}
+
+	template<typename... Args>
+	void emplace(Args&&... args)
+	{
+		// vector only grows by what it needs, so grow geometrically here to keep pushes amortized O(log n)
+		if (m_data.size() == m_data.capacity())
+		{
+			m_data.reserve(m_data.capacity() ? m_data.capacity() * 2 : 4);
+		}
+		m_data.emplace_back(std::forward<Args>(args)...);
+		std::detail::heap_sift_up<Arity>(m_data.data(), m_data.size() - 1, m_comp, m_updater);
+	}
+
+	void push(const T& value)
+	{
+		emplace(value);
+	}
+
+	void push(T&& value)
+	{
+		emplace(std::move(value));
+	}
+
+	void pop()
+	{
+		CZ_VECTOR_ASSERT_SLOW(m_data.size());
+		std::detail::pop_heap<Arity>(m_data.data(), m_data.size(), m_comp, m_updater);
+		m_data.pop_back();
+	}
+
+	// Restores the heap after the element at pos moved towards the top (e.g: decreasing the key in a min-heap)
+	void decrease_key(size_type pos)
+	{
+		CZ_VECTOR_ASSERT_SLOW(pos < m_data.size());
+		std::detail::heap_sift_up<Arity>(m_data.data(), pos, m_comp, m_updater);
+	}
+
+	// Restores the heap after the priority of the element at pos changed in either direction
+	void update(size_type pos)
+	{
+		CZ_VECTOR_ASSERT_SLOW(pos < m_data.size());
+		if (pos > 0 && m_comp(m_data[(pos - 1) / Arity], m_data[pos]))
+		{
+			std::detail::heap_sift_up<Arity>(m_data.data(), pos, m_comp, m_updater);
+		}
+		else
+		{
+			std::detail::heap_sift_down<Arity>(m_data.data(), pos, m_data.size(), m_comp, m_updater);
+		}
+	}
+
+	// Removes the element at pos
+	void erase(size_type pos)
+	{
+		CZ_VECTOR_ASSERT_SLOW(pos < m_data.size());
+		const size_type last = m_data.size() - 1;
+		if (pos != last)
+		{
+			m_data[pos] = std::move(m_data[last]);
+			m_data.pop_back();
+			update(pos);
+		}
+		else
+		{
+			m_data.pop_back();
+		}
+	}
+
+private:
+	vector<T> m_data;
+	Compare m_comp;
+	IndexUpdater m_updater;
+};
+
+} // namespace cz
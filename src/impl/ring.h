@@ -0,0 +1,409 @@
+/**
+Minimal circular buffer.
+
+Elements live in a single block of memory, and adding at the back or removing from the front never shifts
+the other elements.
+When full, depending on the policy, it either grows or overwrites the oldest element.
+*/
+
+#pragma once
+
+#include "vector.h"
+#include <span>
+
+namespace cz
+{
+
+enum class ring_policy
+{
+	// When full, pushing reallocates to a bigger buffer
+	grow,
+	// When full, pushing overwrites the oldest element. Capacity never changes unless reserve is called
+	overwrite
+};
+
+template<typename T>
+class ring : public detail::base_vector<T>
+{
+private:
+	using util = detail::base_vector<T>;
+public:
+	using value_type = T;
+	using size_type = std::size_t;
+	using reference = value_type&;
+	using const_reference = const value_type&;
+
+	/**
+	 * Random access iterator. Just an index into the owning ring, so it's valid for as long as the index is.
+	 */
+	template<typename RingType, typename ValueType>
+	class base_iterator
+	{
+	public:
+		base_iterator(RingType* owner, size_type index)
+			: m_owner(owner), m_index(index)
+		{
+		}
+
+		ValueType& operator*() const { return (*m_owner)[m_index]; }
+		ValueType* operator->() const { return &(*m_owner)[m_index]; }
+		ValueType& operator[](ptrdiff_t n) const { return (*m_owner)[m_index + n]; }
+
+		base_iterator& operator++() { ++m_index; return *this; }
+		base_iterator& operator--() { --m_index; return *this; }
+		base_iterator operator++(int) { base_iterator tmp = *this; ++m_index; return tmp; }
+		base_iterator operator--(int) { base_iterator tmp = *this; --m_index; return tmp; }
+		base_iterator& operator+=(ptrdiff_t n) { m_index += n; return *this; }
+		base_iterator& operator-=(ptrdiff_t n) { m_index -= n; return *this; }
+		base_iterator operator+(ptrdiff_t n) const { return base_iterator(m_owner, m_index + n); }
+		base_iterator operator-(ptrdiff_t n) const { return base_iterator(m_owner, m_index - n); }
+		ptrdiff_t operator-(const base_iterator& other) const
+		{
+			return static_cast<ptrdiff_t>(m_index) - static_cast<ptrdiff_t>(other.m_index);
+		}
+
+		bool operator==(const base_iterator& other) const { return m_index == other.m_index; }
+		bool operator!=(const base_iterator& other) const { return m_index != other.m_index; }
+		bool operator<(const base_iterator& other) const { return m_index < other.m_index; }
+
+	private:
+		RingType* m_owner;
+		size_type m_index;
+	};
+
+	using iterator = base_iterator<ring, T>;
+	using const_iterator = base_iterator<const ring, const T>;
+
+	constexpr ring() noexcept {}
+
+	explicit ring(size_type capacity, ring_policy policy = ring_policy::grow) noexcept
+		: m_data(util::_allocate(capacity))
+		, m_capacity(capacity)
+		, m_policy(policy)
+	{
+	}
+
+	// The copy is linearized (the oldest element ends up at the start of the buffer)
+	ring(const ring& other) noexcept
+		: m_data(util::_allocate(other.m_capacity))
+		, m_capacity(other.m_capacity)
+		, m_size(other.m_size)
+		, m_policy(other.m_policy)
+	{
+		std::span<const T> a = other.first_span();
+		std::span<const T> b = other.second_span();
+		util::_copyConstructRange(a.begin(), a.end(), m_data);
+		util::_copyConstructRange(b.begin(), b.end(), m_data + a.size());
+	}
+
+	ring(ring&& other) noexcept
+		: m_data(util::_exchange(other.m_data, nullptr))
+		, m_capacity(util::_exchange(other.m_capacity, 0))
+		, m_size(util::_exchange(other.m_size, 0))
+		, m_head(util::_exchange(other.m_head, 0))
+		, m_policy(other.m_policy)
+	{
+	}
+
+	ring& operator=(const ring& other) noexcept
+	{
+		if (this != &other)
+		{
+			ring tmp(other);
+			*this = std::move(tmp);
+		}
+		return *this;
+	}
+
+	ring& operator=(ring&& other) noexcept
+	{
+		if (this != &other)
+		{
+			_tidy();
+			m_data = util::_exchange(other.m_data, nullptr);
+			m_capacity = util::_exchange(other.m_capacity, 0);
+			m_size = util::_exchange(other.m_size, 0);
+			m_head = util::_exchange(other.m_head, 0);
+			m_policy = other.m_policy;
+		}
+		return *this;
+	}
+
+	~ring() noexcept
+	{
+		_tidy();
+	}
+
+	//
+	// Element access
+	//
+	// Index 0 is the oldest element
+	T& operator[](size_type pos)
+	{
+		CZ_VECTOR_ASSERT_SLOW(pos < m_size);
+		return m_data[_physical(pos)];
+	}
+
+	const T& operator[](size_type pos) const
+	{
+		CZ_VECTOR_ASSERT_SLOW(pos < m_size);
+		return m_data[_physical(pos)];
+	}
+
+	T& front()
+	{
+		CZ_VECTOR_ASSERT_SLOW(m_size);
+		return m_data[m_head];
+	}
+
+	const T& front() const
+	{
+		CZ_VECTOR_ASSERT_SLOW(m_size);
+		return m_data[m_head];
+	}
+
+	T& back()
+	{
+		CZ_VECTOR_ASSERT_SLOW(m_size);
+		return m_data[_physical(m_size - 1)];
+	}
+
+	const T& back() const
+	{
+		CZ_VECTOR_ASSERT_SLOW(m_size);
+		return m_data[_physical(m_size - 1)];
+	}
+
+	//
+	// The contents as two contiguous blocks, oldest elements first.
+	// The second span is empty if the elements don't wrap around the end of the buffer.
+	//
+	std::span<T> first_span() noexcept
+	{
+		return std::span<T>(m_data + m_head, _firstSize());
+	}
+
+	std::span<const T> first_span() const noexcept
+	{
+		return std::span<const T>(m_data + m_head, _firstSize());
+	}
+
+	std::span<T> second_span() noexcept
+	{
+		return std::span<T>(m_data, m_size - _firstSize());
+	}
+
+	std::span<const T> second_span() const noexcept
+	{
+		return std::span<const T>(m_data, m_size - _firstSize());
+	}
+
+	//
+	// Iterators
+	//
+	iterator begin() noexcept { return iterator(this, 0); }
+	iterator end() noexcept { return iterator(this, m_size); }
+	const_iterator begin() const noexcept { return const_iterator(this, 0); }
+	const_iterator end() const noexcept { return const_iterator(this, m_size); }
+
+	//
+	// Capacity related methods
+	//
+	bool empty() const noexcept
+	{
+		return m_size == 0;
+	}
+
+	bool full() const noexcept
+	{
+		return m_size == m_capacity;
+	}
+
+	size_type size() const noexcept
+	{
+		return m_size;
+	}
+
+	size_type capacity() const noexcept
+	{
+		return m_capacity;
+	}
+
+	ring_policy policy() const noexcept
+	{
+		return m_policy;
+	}
+
+	// Grows the buffer. This also linearizes the elements.
+	void reserve(size_type newCapacity)
+	{
+		if (newCapacity > m_capacity)
+		{
+			_setCapacity(newCapacity);
+		}
+	}
+
+	//
+	// Modifiers API
+	//
+	void clear() noexcept
+	{
+		pop_front(m_size);
+	}
+
+	template<typename... Args>
+	T& emplace_back(Args&&... args)
+	{
+		if (m_size == m_capacity)
+		{
+			if (m_policy == ring_policy::overwrite)
+			{
+				return _emplace_back_overwrite(std::forward<Args>(args)...);
+			}
+			else
+			{
+				return _emplace_back_reallocate(std::forward<Args>(args)...);
+			}
+		}
+
+		T* ptr = m_data + _physical(m_size);
+		util::_constructSingle(ptr, std::forward<Args>(args)...);
+		++m_size;
+		return *ptr;
+	}
+
+	void push_back(const T& value)
+	{
+		emplace_back(value);
+	}
+
+	void push_back(T&& value)
+	{
+		emplace_back(std::move(value));
+	}
+
+	void pop_back()
+	{
+		CZ_VECTOR_ASSERT_SLOW(m_size > 0);
+		util::_destroySingle(m_data + _physical(m_size - 1));
+		--m_size;
+		if (m_size == 0)
+		{
+			m_head = 0;
+		}
+	}
+
+	void pop_front()
+	{
+		pop_front(1);
+	}
+
+	// Removes the "count" oldest elements
+	void pop_front(size_type count)
+	{
+		CZ_VECTOR_ASSERT_SLOW(count <= m_size);
+		if (count == 0)
+		{
+			return;
+		}
+
+		const size_type firstCount = util::_min(count, _firstSize());
+		util::_destroyRange(m_data + m_head, m_data + m_head + firstCount);
+		util::_destroyRange(m_data, m_data + (count - firstCount));
+		m_size -= count;
+		// Once empty, starting again from the beginning of the buffer avoids a wrap around for as long as possible
+		m_head = m_size ? _physical(count) : 0;
+	}
+
+private:
+
+	// Converts a logical index (0 is the oldest element) to an index into m_data
+	size_type _physical(size_type index) const
+	{
+		size_type pos = m_head + index;
+		return pos >= m_capacity ? pos - m_capacity : pos;
+	}
+
+	// How many elements are in the first contiguous block
+	size_type _firstSize() const
+	{
+		return util::_min(m_size, m_capacity - m_head);
+	}
+
+	template<typename... Args>
+	T& _emplace_back_overwrite(Args&&... args)
+	{
+		CZ_VECTOR_ASSERT(m_capacity);
+		// handle aliasing (passing a reference to the element we are about to overwrite)
+		T value(std::forward<Args>(args)...);
+		T* ptr = m_data + m_head;
+		*ptr = std::move(value);
+		m_head = _physical(1);
+		return *ptr;
+	}
+
+	template<typename... Args>
+	T& _emplace_back_reallocate(Args&&... args)
+	{
+		CZ_VECTOR_ASSERT_SLOW(m_size == m_capacity);
+
+		const size_type newCapacity = m_capacity ? m_capacity * 2 : 1;
+		T* newData = util::_allocate(newCapacity);
+
+		// Construct the new element first, since args might be referencing an element we are about to move
+		util::_constructSingle(newData + m_size, std::forward<Args>(args)...);
+		_moveTo(newData);
+		_changeArray(newData, m_size + 1, newCapacity);
+		return m_data[m_size - 1];
+	}
+
+	// Moves all elements to the start of the new memory, and destroys the old ones
+	void _moveTo(T* dest)
+	{
+		std::span<T> a = first_span();
+		std::span<T> b = second_span();
+		util::_relocateRange(a.begin(), a.end(), dest);
+		util::_relocateRange(b.begin(), b.end(), dest + a.size());
+	}
+
+	// Replaces the buffer with one containing newSize linearized elements
+	void _changeArray(T* newData, size_type newSize, size_type newCapacity)
+	{
+		if (m_data)
+		{
+			util::_free(m_data, m_capacity);
+		}
+		m_data = newData;
+		m_size = newSize;
+		m_capacity = newCapacity;
+		m_head = 0;
+	}
+
+	void _setCapacity(size_type newCapacity)
+	{
+		CZ_VECTOR_ASSERT_SLOW(newCapacity >= m_size);
+		T* newData = util::_allocate(newCapacity);
+		_moveTo(newData);
+		_changeArray(newData, m_size, newCapacity);
+	}
+
+	void _tidy()
+	{
+		if (m_data)
+		{
+			clear();
+			util::_free(m_data, m_capacity);
+			m_data = nullptr;
+			m_capacity = 0;
+		}
+	}
+
+	T* m_data = nullptr;
+	size_type m_capacity = 0;
+	size_type m_size = 0;
+	// Physical index of the oldest element
+	size_type m_head = 0;
+	ring_policy m_policy = ring_policy::grow;
+};
+
+} // namespace cz
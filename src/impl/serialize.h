@@ -0,0 +1,547 @@
+/**
+Binary serialization of cz::vector (and spans) of trivially copyable elements, designed so reading can be zero-copy.
+
+	cz::vector<uint8_t> buf;
+	cz::serialize(buf, positions);	// cz::vector<Vec3>
+	cz::serialize(buf, meshes);		// cz::vector<cz::vector<uint32_t>>
+
+	cz::binary_reader in(buf.data(), buf.size());
+	std::span<const Vec3> positionsView;
+	cz::serialized_nested_view<uint32_t> meshesView;
+	if (cz::deserialize(in, positionsView) != cz::serialize_result::ok || cz::deserialize(in, meshesView) != ...)
+		...
+
+Each vector is a block:
+	- 16 bytes header: magic "CZ", byte order ('L' or 'B'), kind ('E' elements or 'N' nested), element size (uint32)
+	  and count (uint64), in the byte order of the writer.
+	- Elements block: The elements, as they are in memory, so they're written with a single append from data().
+	  The header is placed so the elements start aligned to max(16, alignof(T)).
+	- Nested block (vector of vectors): A table of count + 1 uint64 offsets, followed by the inner blocks.
+	  offsets[i] is where inner block i starts, and offsets[count] where the nested block ends, relative to the nested
+	  block header. Any inner vector can be accessed without parsing the others.
+	- Blocks are padded to 16 bytes.
+
+Alignment is relative to the start of the buffer, so for zero-copy views the buffer needs to be aligned to at least the
+alignment of the elements (malloc and mmap memory is). Views are only possible if the byte order matches too.
+Deserializing into a cz::vector always works, copying (and byte swapping arithmetic and enum elements if needed).
+
+Buffers are validated as they are read (sizes, offsets, headers), so it's safe to read untrusted data, although
+element contents themselves are not checked.
+*/
+
+#pragma once
+
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <string.h>
+#include <span>
+#include "vector.h"
+
+namespace cz
+{
+
+enum class serialize_result
+{
+	ok,
+	// The buffer ends before the block does
+	truncated,
+	// Not a block header
+	bad_header,
+	// Tried to read an elements block as nested, or the other way around
+	bad_kind,
+	// Element size doesn't match sizeof(T)
+	bad_element_size,
+	// Written with a different byte order, and the elements can't be used as they are
+	byte_order,
+	// The elements are not aligned for T, so can't be viewed in place
+	misaligned,
+	// A nested block offset table is inconsistent
+	bad_offsets
+};
+
+/**
+ * Position in a buffer being deserialized. Doesn't own the buffer.
+ */
+class binary_reader
+{
+public:
+	binary_reader(const void* data, size_t size)
+		: m_data(static_cast<const uint8_t*>(data)), m_size(size)
+	{
+	}
+
+	const uint8_t* data() const { return m_data; }
+	size_t size() const { return m_size; }
+	size_t position() const { return m_pos; }
+	bool at_end() const { return m_pos >= m_size; }
+
+	void set_position(size_t pos)
+	{
+		m_pos = pos < m_size ? pos : m_size;
+	}
+
+private:
+	const uint8_t* m_data;
+	size_t m_size;
+	size_t m_pos = 0;
+};
+
+namespace detail
+{
+	inline constexpr size_t serialize_block_align = 16;
+	inline constexpr uint8_t serialize_kind_elements = 'E';
+	inline constexpr uint8_t serialize_kind_nested = 'N';
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	inline constexpr uint8_t serialize_native_order = 'B';
+#else
+	inline constexpr uint8_t serialize_native_order = 'L';
+#endif
+
+	struct serialize_header
+	{
+		uint8_t magic[2];
+		uint8_t byteOrder;
+		uint8_t kind;
+		uint32_t elementSize;
+		uint64_t count;
+	};
+	static_assert(sizeof(serialize_header) == 16);
+
+	template<typename T>
+	inline constexpr size_t serialize_data_align = alignof(T) > serialize_block_align ? alignof(T) : serialize_block_align;
+
+	template<typename T>
+	struct serialize_is_vector : std::false_type {};
+
+	template<typename T, size_t Alignment>
+	struct serialize_is_vector<vector<T, Alignment>> : std::true_type {};
+
+	// Elements that can be converted from the other byte order
+	template<typename T>
+	inline constexpr bool serialize_swappable =
+		std::is_arithmetic_v<T> || std::is_enum_v<T> || sizeof(T) == 1;
+
+	inline constexpr size_t serialize_align_up(size_t v, size_t alignment)
+	{
+		return (v + alignment - 1) & ~(alignment - 1);
+	}
+
+	inline void serialize_append(vector<uint8_t>& out, const void* data, size_t bytes)
+	{
+		// Grow geometrically, since a buffer is usually built with lots of small appends
+		if (out.size() + bytes > out.capacity())
+		{
+			const size_t doubled = out.capacity() * 2;
+			out.reserve(doubled > out.size() + bytes ? doubled : out.size() + bytes);
+		}
+		const uint8_t* ptr = static_cast<const uint8_t*>(data);
+		out.insert(out.end(), ptr, ptr + bytes);
+	}
+
+	inline void serialize_append_zeros(vector<uint8_t>& out, size_t count)
+	{
+		static constexpr uint8_t zeros[64] = {};
+		while (count)
+		{
+			const size_t chunk = count < sizeof(zeros) ? count : sizeof(zeros);
+			serialize_append(out, zeros, chunk);
+			count -= chunk;
+		}
+	}
+
+	inline void serialize_pad(vector<uint8_t>& out, size_t alignment)
+	{
+		serialize_append_zeros(out, serialize_align_up(out.size(), alignment) - out.size());
+	}
+
+	// Writes a header placed so the data that follows is aligned to dataAlign. Returns where the header is
+	inline size_t serialize_write_header(vector<uint8_t>& out, uint8_t kind, size_t elementSize, size_t count, size_t dataAlign)
+	{
+		serialize_pad(out, serialize_block_align);
+		const size_t headerPos = serialize_align_up(out.size() + sizeof(serialize_header), dataAlign) - sizeof(serialize_header);
+		serialize_append_zeros(out, headerPos - out.size());
+
+		const serialize_header h = { { 'C', 'Z' }, serialize_native_order, kind, static_cast<uint32_t>(elementSize), static_cast<uint64_t>(count) };
+		serialize_append(out, &h, sizeof(h));
+		return headerPos;
+	}
+
+	/**
+	 * Reads the header at pos (after skipping the padding needed for dataAlign). On success, pos is updated to right
+	 * after the header
+	 */
+	inline serialize_result serialize_read_header(const binary_reader& in, size_t& pos, size_t dataAlign, serialize_header& h, bool& swapped)
+	{
+		pos = serialize_align_up(pos + sizeof(serialize_header), dataAlign) - sizeof(serialize_header);
+		if (pos > in.size() || in.size() - pos < sizeof(serialize_header))
+		{
+			return serialize_result::truncated;
+		}
+
+		memcpy(&h, in.data() + pos, sizeof(h));
+		if (h.magic[0] != 'C' || h.magic[1] != 'Z' || (h.byteOrder != 'L' && h.byteOrder != 'B') ||
+			(h.kind != serialize_kind_elements && h.kind != serialize_kind_nested))
+		{
+			return serialize_result::bad_header;
+		}
+
+		swapped = h.byteOrder != serialize_native_order;
+		if (swapped)
+		{
+			h.elementSize = __builtin_bswap32(h.elementSize);
+			h.count = __builtin_bswap64(h.count);
+		}
+		pos += sizeof(serialize_header);
+		return serialize_result::ok;
+	}
+
+	template<typename T>
+	T serialize_byteswap(T v)
+	{
+		if constexpr (sizeof(T) == 2)
+		{
+			uint16_t tmp;
+			memcpy(&tmp, &v, 2);
+			tmp = __builtin_bswap16(tmp);
+			memcpy(&v, &tmp, 2);
+		}
+		else if constexpr (sizeof(T) == 4)
+		{
+			uint32_t tmp;
+			memcpy(&tmp, &v, 4);
+			tmp = __builtin_bswap32(tmp);
+			memcpy(&v, &tmp, 4);
+		}
+		else if constexpr (sizeof(T) == 8)
+		{
+			uint64_t tmp;
+			memcpy(&tmp, &v, 8);
+			tmp = __builtin_bswap64(tmp);
+			memcpy(&v, &tmp, 8);
+		}
+		return v;
+	}
+
+	/**
+	 * Reads an elements block header, and validates it for T.
+	 * On success, data points to the elements, and the reader is past the block
+	 */
+	template<typename T>
+	serialize_result serialize_read_elements(binary_reader& in, const uint8_t*& data, size_t& count, bool& swapped)
+	{
+		size_t pos = in.position();
+		serialize_header h;
+		const serialize_result res = serialize_read_header(in, pos, serialize_data_align<T>, h, swapped);
+		if (res != serialize_result::ok)
+		{
+			return res;
+		}
+		if (h.kind != serialize_kind_elements)
+		{
+			return serialize_result::bad_kind;
+		}
+		if (h.elementSize != sizeof(T))
+		{
+			return serialize_result::bad_element_size;
+		}
+		// Written like this so a huge count can't overflow
+		if (h.count > (in.size() - pos) / sizeof(T))
+		{
+			return serialize_result::truncated;
+		}
+
+		data = in.data() + pos;
+		count = static_cast<size_t>(h.count);
+		in.set_position(serialize_align_up(pos + count * sizeof(T), serialize_block_align));
+		return serialize_result::ok;
+	}
+
+	/**
+	 * Reads a nested block header and offset table, and validates the offsets.
+	 * On success, header points to the block header, and the reader is past the block
+	 */
+	inline serialize_result serialize_read_nested(binary_reader& in, const uint8_t*& header, size_t& count, bool& swapped)
+	{
+		size_t pos = in.position();
+		serialize_header h;
+		const serialize_result res = serialize_read_header(in, pos, serialize_block_align, h, swapped);
+		if (res != serialize_result::ok)
+		{
+			return res;
+		}
+		if (h.kind != serialize_kind_nested)
+		{
+			return serialize_result::bad_kind;
+		}
+
+		const size_t headerPos = pos - sizeof(serialize_header);
+		if (h.count >= (in.size() - pos) / sizeof(uint64_t))
+		{
+			return serialize_result::truncated;
+		}
+
+		// Offsets need to be increasing, after the table, and inside the buffer
+		const size_t tableEnd = pos + (static_cast<size_t>(h.count) + 1) * sizeof(uint64_t) - headerPos;
+		uint64_t prev = tableEnd;
+		for (uint64_t i = 0; i <= h.count; i++)
+		{
+			uint64_t offset;
+			memcpy(&offset, in.data() + pos + i * sizeof(uint64_t), sizeof(offset));
+			offset = swapped ? __builtin_bswap64(offset) : offset;
+			if (offset < prev || offset > in.size() - headerPos)
+			{
+				return serialize_result::bad_offsets;
+			}
+			prev = offset;
+		}
+
+		header = in.data() + headerPos;
+		count = static_cast<size_t>(h.count);
+		in.set_position(headerPos + static_cast<size_t>(prev));
+		return serialize_result::ok;
+	}
+
+	inline uint64_t serialize_nested_offset(const uint8_t* header, size_t index, bool swapped)
+	{
+		uint64_t offset;
+		memcpy(&offset, header + sizeof(serialize_header) + index * sizeof(uint64_t), sizeof(offset));
+		return swapped ? __builtin_bswap64(offset) : offset;
+	}
+
+	template<typename T, size_t Alignment>
+	size_t serialize_block(vector<uint8_t>& out, const vector<T, Alignment>& v);
+
+	template<typename T>
+	size_t serialize_block(vector<uint8_t>& out, std::span<const T> v)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable elements can be serialized");
+		const size_t headerPos = serialize_write_header(out, serialize_kind_elements, sizeof(T), v.size(), serialize_data_align<T>);
+		serialize_append(out, v.data(), v.size_bytes());
+		serialize_pad(out, serialize_block_align);
+		return headerPos;
+	}
+
+	template<typename T, size_t Alignment>
+	size_t serialize_block(vector<uint8_t>& out, const vector<T, Alignment>& v)
+	{
+		if constexpr (serialize_is_vector<T>::value)
+		{
+			const size_t headerPos = serialize_write_header(out, serialize_kind_nested, 0, v.size(), serialize_block_align);
+			const size_t tablePos = out.size();
+			for (size_t i = 0; i <= v.size(); i++)
+			{
+				const uint64_t placeholder = 0;
+				serialize_append(out, &placeholder, sizeof(placeholder));
+			}
+			serialize_pad(out, serialize_block_align);
+
+			// Inner blocks can be anywhere after the table, so the table is filled as they are written
+			for (size_t i = 0; i <= v.size(); i++)
+			{
+				const uint64_t offset = (i < v.size() ? serialize_block(out, v[i]) : out.size()) - headerPos;
+				memcpy(out.data() + tablePos + i * sizeof(uint64_t), &offset, sizeof(offset));
+			}
+			return headerPos;
+		}
+		else
+		{
+			return serialize_block(out, std::span<const T>(v.data(), v.size()));
+		}
+	}
+
+} // namespace detail
+
+/**
+ * View of a serialized vector of vectors, where each inner vector is accessed in place
+ */
+template<typename T>
+class serialized_nested_view
+{
+public:
+	serialized_nested_view() {}
+
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	std::span<const T> operator[](size_t index) const
+	{
+		CZ_VECTOR_ASSERT(index < m_size);
+		const uint8_t* inner = m_header + detail::serialize_nested_offset(m_header, index, false);
+		detail::serialize_header h;
+		memcpy(&h, inner, sizeof(h));
+		return std::span<const T>(reinterpret_cast<const T*>(inner + sizeof(h)), static_cast<size_t>(h.count));
+	}
+
+	// Only deserialize should create non-empty views, since it validates the block
+	serialized_nested_view(const uint8_t* header, size_t size)
+		: m_header(header), m_size(size)
+	{
+	}
+
+private:
+	const uint8_t* m_header = nullptr;
+	size_t m_size = 0;
+};
+
+/**
+ * Appends v to out
+ */
+template<typename T, size_t Alignment>
+void serialize(vector<uint8_t>& out, const vector<T, Alignment>& v)
+{
+	detail::serialize_block(out, v);
+}
+
+template<typename T>
+void serialize(vector<uint8_t>& out, std::span<T> v)
+{
+	detail::serialize_block(out, std::span<const std::remove_cv_t<T>>(v.data(), v.size()));
+}
+
+/**
+ * Zero-copy read of an elements block. out points into the reader's buffer.
+ * Fails with byte_order or misaligned if the elements can't be used in place.
+ */
+template<typename T>
+serialize_result deserialize(binary_reader& in, std::span<const T>& out)
+{
+	const size_t start = in.position();
+	const uint8_t* data = nullptr;
+	size_t count = 0;
+	bool swapped = false;
+	serialize_result res = detail::serialize_read_elements<T>(in, data, count, swapped);
+	if (res == serialize_result::ok && swapped && sizeof(T) > 1)
+	{
+		res = serialize_result::byte_order;
+	}
+	else if (res == serialize_result::ok && reinterpret_cast<uintptr_t>(data) % alignof(T) != 0)
+	{
+		res = serialize_result::misaligned;
+	}
+
+	if (res != serialize_result::ok)
+	{
+		in.set_position(start);
+		return res;
+	}
+
+	out = std::span<const T>(reinterpret_cast<const T*>(data), count);
+	return serialize_result::ok;
+}
+
+/**
+ * Zero-copy read of a nested block. Inner blocks are all validated here, so the view can access them without checks
+ */
+template<typename T>
+serialize_result deserialize(binary_reader& in, serialized_nested_view<T>& out)
+{
+	const size_t start = in.position();
+	const uint8_t* header = nullptr;
+	size_t count = 0;
+	bool swapped = false;
+	serialize_result res = detail::serialize_read_nested(in, header, count, swapped);
+	if (res == serialize_result::ok && swapped)
+	{
+		res = serialize_result::byte_order;
+	}
+
+	for (size_t i = 0; i < count && res == serialize_result::ok; i++)
+	{
+		// Each inner block needs to fit before the next one starts
+		const size_t headerPos = static_cast<size_t>(header - in.data());
+		binary_reader inner(in.data(), headerPos + detail::serialize_nested_offset(header, i + 1, false));
+		inner.set_position(headerPos + detail::serialize_nested_offset(header, i, false));
+		std::span<const T> elements;
+		res = deserialize(inner, elements);
+		// The view finds the header right at the offset, and the elements right after it. Checked for empty blocks too,
+		// since reading the header skips alignment padding, so an unaligned offset would otherwise pass.
+		if (res == serialize_result::ok &&
+			reinterpret_cast<const uint8_t*>(elements.data()) != header + detail::serialize_nested_offset(header, i, false) + sizeof(detail::serialize_header))
+		{
+			res = serialize_result::bad_offsets;
+		}
+	}
+
+	if (res != serialize_result::ok)
+	{
+		in.set_position(start);
+		return res;
+	}
+
+	out = serialized_nested_view<T>(header, count);
+	return serialize_result::ok;
+}
+
+/**
+ * Reads a block into a vector, copying. Arithmetic and enum elements are converted if the byte order doesn't match.
+ * Vectors of vectors read nested blocks.
+ */
+template<typename T, size_t Alignment>
+serialize_result deserialize(binary_reader& in, vector<T, Alignment>& out)
+{
+	const size_t start = in.position();
+	serialize_result res;
+
+	if constexpr (detail::serialize_is_vector<T>::value)
+	{
+		const uint8_t* header = nullptr;
+		size_t count = 0;
+		bool swapped = false;
+		res = detail::serialize_read_nested(in, header, count, swapped);
+		if (res == serialize_result::ok)
+		{
+			out = vector<T, Alignment>(count);
+			const size_t headerPos = static_cast<size_t>(header - in.data());
+			for (size_t i = 0; i < count && res == serialize_result::ok; i++)
+			{
+				binary_reader inner(in.data(), headerPos + detail::serialize_nested_offset(header, i + 1, swapped));
+				inner.set_position(headerPos + detail::serialize_nested_offset(header, i, swapped));
+				res = deserialize(inner, out[i]);
+			}
+		}
+	}
+	else
+	{
+		const uint8_t* data = nullptr;
+		size_t count = 0;
+		bool swapped = false;
+		res = detail::serialize_read_elements<T>(in, data, count, swapped);
+		swapped = swapped && sizeof(T) > 1;
+		if (res == serialize_result::ok && swapped && !detail::serialize_swappable<T>)
+		{
+			res = serialize_result::byte_order;
+		}
+		else if (res == serialize_result::ok)
+		{
+			if (!swapped && reinterpret_cast<uintptr_t>(data) % alignof(T) == 0)
+			{
+				const T* first = reinterpret_cast<const T*>(data);
+				out.assign(first, first + count);
+			}
+			else
+			{
+				out = vector<T, Alignment>(count);
+				memcpy(static_cast<void*>(out.data()), data, count * sizeof(T));
+				if constexpr (detail::serialize_swappable<T>)
+				{
+					if (swapped)
+					{
+						for (T& v : out)
+						{
+							v = detail::serialize_byteswap(v);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (res != serialize_result::ok)
+	{
+		in.set_position(start);
+	}
+	return res;
+}
+
+} // namespace cz
@@ -0,0 +1,591 @@
+/**
+Minimal shared_ptr/weak_ptr and intrusive_ptr.
+
+The reference counting policy is a template parameter:
+	- atomic_refcount : Safe to share between threads. This is the default, as with std::shared_ptr
+	- plain_refcount : For objects that never cross threads (or interrupt handlers), so copies don't pay for atomic
+	  read-modify-write operations.
+
+make_shared puts the control block and the object in a single allocation.
+*/
+
+#pragma once
+
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+#include <new>
+
+namespace cz
+{
+
+struct atomic_refcount
+{
+	using count_type = long;
+
+	static void increment(count_type& c) noexcept
+	{
+		__atomic_fetch_add(&c, 1, __ATOMIC_RELAXED);
+	}
+
+	// Returns the new value
+	static count_type decrement(count_type& c) noexcept
+	{
+		return __atomic_sub_fetch(&c, 1, __ATOMIC_ACQ_REL);
+	}
+
+	// Increments only if not 0. Returns true if incremented
+	static bool increment_if_not_zero(count_type& c) noexcept
+	{
+		count_type expected = __atomic_load_n(&c, __ATOMIC_RELAXED);
+		while (expected != 0)
+		{
+			if (__atomic_compare_exchange_n(&c, &expected, expected + 1, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static count_type load(const count_type& c) noexcept
+	{
+		return __atomic_load_n(&c, __ATOMIC_RELAXED);
+	}
+};
+
+struct plain_refcount
+{
+	using count_type = long;
+
+	static void increment(count_type& c) noexcept
+	{
+		++c;
+	}
+
+	static count_type decrement(count_type& c) noexcept
+	{
+		return --c;
+	}
+
+	static bool increment_if_not_zero(count_type& c) noexcept
+	{
+		if (c == 0)
+		{
+			return false;
+		}
+		++c;
+		return true;
+	}
+
+	static count_type load(const count_type& c) noexcept
+	{
+		return c;
+	}
+};
+
+template<typename T, typename RefCount = atomic_refcount>
+class shared_ptr;
+
+template<typename T, typename RefCount = atomic_refcount>
+class weak_ptr;
+
+namespace detail
+{
+	template<typename RefCount>
+	class control_block
+	{
+	public:
+		using count_type = typename RefCount::count_type;
+
+		virtual ~control_block() {}
+
+		void addRef() noexcept
+		{
+			RefCount::increment(m_uses);
+		}
+
+		void release() noexcept
+		{
+			if (RefCount::decrement(m_uses) == 0)
+			{
+				destroyObject();
+				releaseWeak();
+			}
+		}
+
+		void addWeakRef() noexcept
+		{
+			RefCount::increment(m_weaks);
+		}
+
+		void releaseWeak() noexcept
+		{
+			if (RefCount::decrement(m_weaks) == 0)
+			{
+				delete this;
+			}
+		}
+
+		bool tryAddRef() noexcept
+		{
+			return RefCount::increment_if_not_zero(m_uses);
+		}
+
+		count_type useCount() const noexcept
+		{
+			return RefCount::load(m_uses);
+		}
+
+	protected:
+		virtual void destroyObject() noexcept = 0;
+
+	private:
+		count_type m_uses = 1;
+		// All the strong references together hold one weak reference, so the block outlives the last weak_ptr
+		// or the last shared_ptr, whatever comes last
+		count_type m_weaks = 1;
+	};
+
+	// Used when taking ownership of an existing pointer
+	template<typename T, typename Deleter, typename RefCount>
+	class ptr_control_block final : public control_block<RefCount>
+	{
+	public:
+		ptr_control_block(T* ptr, Deleter deleter)
+			: m_ptr(ptr), m_deleter(std::move(deleter))
+		{
+		}
+
+	protected:
+		void destroyObject() noexcept override
+		{
+			m_deleter(m_ptr);
+		}
+
+	private:
+		T* m_ptr;
+		Deleter m_deleter;
+	};
+
+	// Used by make_shared, with the object living inside the control block
+	template<typename T, typename RefCount>
+	class inplace_control_block final : public control_block<RefCount>
+	{
+	public:
+		template<typename... Args>
+		explicit inplace_control_block(Args&&... args)
+		{
+			new(&m_storage) T(std::forward<Args>(args)...);
+		}
+
+		T* object() noexcept
+		{
+			return reinterpret_cast<T*>(&m_storage);
+		}
+
+	protected:
+		void destroyObject() noexcept override
+		{
+			object()->~T();
+		}
+
+	private:
+		alignas(T) unsigned char m_storage[sizeof(T)];
+	};
+
+	// Tag for shared_ptr's private constructor, that takes over an existing reference
+	struct shared_ptr_adopt {};
+
+	struct shared_ptr_default_delete
+	{
+		template<typename T>
+		void operator()(T* ptr) const
+		{
+			delete ptr;
+		}
+	};
+} // namespace detail
+
+template<typename T, typename RefCount>
+class shared_ptr
+{
+private:
+	using control_block = detail::control_block<RefCount>;
+	template<typename, typename> friend class shared_ptr;
+	template<typename, typename> friend class weak_ptr;
+	template<typename U, typename RC, typename... Args> friend shared_ptr<U, RC> make_shared(Args&&...);
+
+public:
+	using element_type = T;
+
+	constexpr shared_ptr() noexcept {}
+	constexpr shared_ptr(std::nullptr_t) noexcept {}
+
+	template<typename U>
+	explicit shared_ptr(U* ptr)
+		: shared_ptr(ptr, detail::shared_ptr_default_delete())
+	{
+	}
+
+	template<typename U, typename Deleter>
+	shared_ptr(U* ptr, Deleter deleter)
+		: m_ptr(ptr)
+		, m_cb(ptr ? new detail::ptr_control_block<U, Deleter, RefCount>(ptr, std::move(deleter)) : nullptr)
+	{
+	}
+
+	shared_ptr(const shared_ptr& other) noexcept
+		: m_ptr(other.m_ptr)
+		, m_cb(other.m_cb)
+	{
+		_addRef();
+	}
+
+	shared_ptr(shared_ptr&& other) noexcept
+		: m_ptr(other.m_ptr)
+		, m_cb(other.m_cb)
+	{
+		other.m_ptr = nullptr;
+		other.m_cb = nullptr;
+	}
+
+	// Constructor for use with types derived from T
+	template<typename U>
+	shared_ptr(const shared_ptr<U, RefCount>& other) noexcept
+		: m_ptr(other.m_ptr)
+		, m_cb(other.m_cb)
+	{
+		_addRef();
+	}
+
+	template<typename U>
+	shared_ptr(shared_ptr<U, RefCount>&& other) noexcept
+		: m_ptr(other.m_ptr)
+		, m_cb(other.m_cb)
+	{
+		other.m_ptr = nullptr;
+		other.m_cb = nullptr;
+	}
+
+	~shared_ptr()
+	{
+		if (m_cb)
+		{
+			m_cb->release();
+		}
+	}
+
+	shared_ptr& operator=(const shared_ptr& other) noexcept
+	{
+		shared_ptr(other).swap(*this);
+		return *this;
+	}
+
+	shared_ptr& operator=(shared_ptr&& other) noexcept
+	{
+		shared_ptr(std::move(other)).swap(*this);
+		return *this;
+	}
+
+	void swap(shared_ptr& other) noexcept
+	{
+		T* tmpPtr = m_ptr;
+		m_ptr = other.m_ptr;
+		other.m_ptr = tmpPtr;
+		control_block* tmpCb = m_cb;
+		m_cb = other.m_cb;
+		other.m_cb = tmpCb;
+	}
+
+	void reset() noexcept
+	{
+		shared_ptr().swap(*this);
+	}
+
+	template<typename U>
+	void reset(U* ptr)
+	{
+		shared_ptr(ptr).swap(*this);
+	}
+
+	T* get() const noexcept { return m_ptr; }
+	T* operator->() const noexcept { return m_ptr; }
+	T& operator*() const noexcept { return *m_ptr; }
+	explicit operator bool() const noexcept { return m_ptr != nullptr; }
+
+	long use_count() const noexcept
+	{
+		return m_cb ? static_cast<long>(m_cb->useCount()) : 0;
+	}
+
+	template<typename U>
+	bool operator==(const shared_ptr<U, RefCount>& other) const noexcept { return m_ptr == other.m_ptr; }
+	template<typename U>
+	bool operator!=(const shared_ptr<U, RefCount>& other) const noexcept { return m_ptr != other.m_ptr; }
+	bool operator==(std::nullptr_t) const noexcept { return m_ptr == nullptr; }
+	bool operator!=(std::nullptr_t) const noexcept { return m_ptr != nullptr; }
+
+private:
+
+	// Takes over a reference that was already added
+	shared_ptr(detail::shared_ptr_adopt, T* ptr, control_block* cb) noexcept
+		: m_ptr(ptr)
+		, m_cb(cb)
+	{
+	}
+
+	void _addRef() noexcept
+	{
+		if (m_cb)
+		{
+			m_cb->addRef();
+		}
+	}
+
+	T* m_ptr = nullptr;
+	control_block* m_cb = nullptr;
+};
+
+template<typename T, typename RefCount>
+class weak_ptr
+{
+private:
+	using control_block = detail::control_block<RefCount>;
+	template<typename, typename> friend class weak_ptr;
+
+public:
+	constexpr weak_ptr() noexcept {}
+
+	template<typename U>
+	weak_ptr(const shared_ptr<U, RefCount>& other) noexcept
+		: m_ptr(other.m_ptr)
+		, m_cb(other.m_cb)
+	{
+		_addWeakRef();
+	}
+
+	weak_ptr(const weak_ptr& other) noexcept
+		: m_ptr(other.m_ptr)
+		, m_cb(other.m_cb)
+	{
+		_addWeakRef();
+	}
+
+	weak_ptr(weak_ptr&& other) noexcept
+		: m_ptr(other.m_ptr)
+		, m_cb(other.m_cb)
+	{
+		other.m_ptr = nullptr;
+		other.m_cb = nullptr;
+	}
+
+	~weak_ptr()
+	{
+		if (m_cb)
+		{
+			m_cb->releaseWeak();
+		}
+	}
+
+	weak_ptr& operator=(const weak_ptr& other) noexcept
+	{
+		weak_ptr(other).swap(*this);
+		return *this;
+	}
+
+	weak_ptr& operator=(weak_ptr&& other) noexcept
+	{
+		weak_ptr(std::move(other)).swap(*this);
+		return *this;
+	}
+
+	void swap(weak_ptr& other) noexcept
+	{
+		T* tmpPtr = m_ptr;
+		m_ptr = other.m_ptr;
+		other.m_ptr = tmpPtr;
+		control_block* tmpCb = m_cb;
+		m_cb = other.m_cb;
+		other.m_cb = tmpCb;
+	}
+
+	void reset() noexcept
+	{
+		weak_ptr().swap(*this);
+	}
+
+	long use_count() const noexcept
+	{
+		return m_cb ? static_cast<long>(m_cb->useCount()) : 0;
+	}
+
+	bool expired() const noexcept
+	{
+		return use_count() == 0;
+	}
+
+	// Returns an empty shared_ptr if the object was already destroyed
+	shared_ptr<T, RefCount> lock() const noexcept
+	{
+		if (m_cb && m_cb->tryAddRef())
+		{
+			return shared_ptr<T, RefCount>(detail::shared_ptr_adopt(), m_ptr, m_cb);
+		}
+		return shared_ptr<T, RefCount>();
+	}
+
+private:
+
+	void _addWeakRef() noexcept
+	{
+		if (m_cb)
+		{
+			m_cb->addWeakRef();
+		}
+	}
+
+	T* m_ptr = nullptr;
+	control_block* m_cb = nullptr;
+};
+
+// Creates the object and the control block with a single allocation
+template<typename T, typename RefCount = atomic_refcount, typename... Args>
+shared_ptr<T, RefCount> make_shared(Args&&... args)
+{
+	auto cb = new detail::inplace_control_block<T, RefCount>(std::forward<Args>(args)...);
+	return shared_ptr<T, RefCount>(detail::shared_ptr_adopt(), cb->object(), cb);
+}
+
+/**
+ * Pointer to an object that keeps its own reference count.
+ * T needs to be usable with the (ADL found) functions:
+ *	void intrusive_ptr_add_ref(T*);
+ *	void intrusive_ptr_release(T*);
+ * intrusive_ref_counter provides those.
+ */
+template<typename T>
+class intrusive_ptr
+{
+public:
+	using element_type = T;
+
+	constexpr intrusive_ptr() noexcept {}
+	constexpr intrusive_ptr(std::nullptr_t) noexcept {}
+
+	intrusive_ptr(T* ptr, bool addRef = true) noexcept
+		: m_ptr(ptr)
+	{
+		if (m_ptr && addRef)
+		{
+			intrusive_ptr_add_ref(m_ptr);
+		}
+	}
+
+	intrusive_ptr(const intrusive_ptr& other) noexcept
+		: intrusive_ptr(other.m_ptr)
+	{
+	}
+
+	intrusive_ptr(intrusive_ptr&& other) noexcept
+		: m_ptr(other.m_ptr)
+	{
+		other.m_ptr = nullptr;
+	}
+
+	template<typename U>
+	intrusive_ptr(const intrusive_ptr<U>& other) noexcept
+		: intrusive_ptr(other.get())
+	{
+	}
+
+	~intrusive_ptr()
+	{
+		if (m_ptr)
+		{
+			intrusive_ptr_release(m_ptr);
+		}
+	}
+
+	intrusive_ptr& operator=(const intrusive_ptr& other) noexcept
+	{
+		intrusive_ptr(other).swap(*this);
+		return *this;
+	}
+
+	intrusive_ptr& operator=(intrusive_ptr&& other) noexcept
+	{
+		intrusive_ptr(std::move(other)).swap(*this);
+		return *this;
+	}
+
+	void swap(intrusive_ptr& other) noexcept
+	{
+		T* tmp = m_ptr;
+		m_ptr = other.m_ptr;
+		other.m_ptr = tmp;
+	}
+
+	void reset() noexcept
+	{
+		intrusive_ptr().swap(*this);
+	}
+
+	// Gives up ownership without decrementing the count
+	T* detach() noexcept
+	{
+		T* result = m_ptr;
+		m_ptr = nullptr;
+		return result;
+	}
+
+	T* get() const noexcept { return m_ptr; }
+	T* operator->() const noexcept { return m_ptr; }
+	T& operator*() const noexcept { return *m_ptr; }
+	explicit operator bool() const noexcept { return m_ptr != nullptr; }
+
+	bool operator==(const intrusive_ptr& other) const noexcept { return m_ptr == other.m_ptr; }
+	bool operator!=(const intrusive_ptr& other) const noexcept { return m_ptr != other.m_ptr; }
+
+private:
+	T* m_ptr = nullptr;
+};
+
+/**
+ * Base class that provides the reference count for intrusive_ptr.
+ * Derived is deleted when the count reaches 0.
+ */
+template<typename Derived, typename RefCount = atomic_refcount>
+class intrusive_ref_counter
+{
+public:
+	long use_count() const noexcept
+	{
+		return static_cast<long>(RefCount::load(m_refs));
+	}
+
+	friend void intrusive_ptr_add_ref(const intrusive_ref_counter* p) noexcept
+	{
+		RefCount::increment(p->m_refs);
+	}
+
+	friend void intrusive_ptr_release(const intrusive_ref_counter* p) noexcept
+	{
+		if (RefCount::decrement(p->m_refs) == 0)
+		{
+			delete static_cast<const Derived*>(p);
+		}
+	}
+
+protected:
+	intrusive_ref_counter() noexcept {}
+	// Copying an object doesn't copy its count
+	intrusive_ref_counter(const intrusive_ref_counter&) noexcept {}
+	intrusive_ref_counter& operator=(const intrusive_ref_counter&) noexcept { return *this; }
+	~intrusive_ref_counter() {}
+
+private:
+	mutable typename RefCount::count_type m_refs = 0;
+};
+
+} // namespace cz
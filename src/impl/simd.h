@@ -0,0 +1,1140 @@
+/**
+fill/copy/find/count/minmax_element/equal for contiguous ranges, using SIMD where possible.
+
+On x86 (with gcc or clang), kernels are compiled for SSE2, AVX2 and AVX-512BW regardless of the compiler flags, and
+the best one the cpu supports (see cpu_features) is picked the first time one is needed. All kernels for a level
+are kept in a table of function pointers, so picking is done once. set_simd_level() can force a lower level (e.g: to
+test all of them on the same machine).
+On other architectures, or if CZ_SIMD is defined to 0, only the plain loops exist, and they are called directly,
+without the table.
+
+Which types get the SIMD kernels:
+	- fill: Trivially copyable types of 1, 2, 4 or 8 bytes. Bigger trivially copyable types just fill with memcpy.
+	- copy: Trivially copyable types use memmove, which the C library already vectorizes.
+	- find/count: Integers, enums and pointers of 1, 2, 4 or 8 bytes, searching for a value of the same type. Floating
+	  point types use the plain loop, because comparing bits is not the same as == for NaN and -0.0.
+	- minmax_element: Integers of 1, 2 or 4 bytes.
+	- equal: Integers, enums and pointers, compared as bytes.
+	- bitwise and/or/xor/and_not of two byte ranges (detail::simd_kernel_bitwise), for cz::dynamic_bitset.
+Everything else uses the same loops as the <algorithm> versions.
+*/
+
+#pragma once
+
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <string.h>
+#include "cpu_features.h"
+
+#ifndef CZ_SIMD
+	#if CZ_CPU_X86 && defined(__GNUC__)
+		#define CZ_SIMD 1
+	#else
+		#define CZ_SIMD 0
+	#endif
+#endif
+
+#if CZ_SIMD
+	#include <immintrin.h>
+
+	// Code between these is compiled for the given instruction set, even if the compiler flags don't enable it
+	#if defined(__clang__)
+		#define CZ_SIMD_TARGET_BEGIN(isa) _Pragma(CZ_SIMD_TARGET_PRAGMA(clang attribute push(__attribute__((target(isa))), apply_to = function)))
+		#define CZ_SIMD_TARGET_END _Pragma("clang attribute pop")
+	#else
+		#define CZ_SIMD_TARGET_BEGIN(isa) _Pragma("GCC push_options") _Pragma(CZ_SIMD_TARGET_PRAGMA(GCC target(isa)))
+		#define CZ_SIMD_TARGET_END _Pragma("GCC pop_options")
+	#endif
+	#define CZ_SIMD_TARGET_PRAGMA(x) #x
+#endif
+
+namespace cz
+{
+
+template<typename T>
+struct min_max_result
+{
+	T min;
+	T max;
+};
+
+enum class simd_level : uint8_t
+{
+	scalar,
+	sse2,
+	avx2,
+	avx512
+};
+
+namespace detail
+{
+	template<size_t N>
+	using simd_uint_t = std::conditional_t<N == 1, uint8_t,
+		std::conditional_t<N == 2, uint16_t, std::conditional_t<N == 4, uint32_t, uint64_t>>>;
+
+	template<size_t N>
+	using simd_int_t = std::conditional_t<N == 1, int8_t,
+		std::conditional_t<N == 2, int16_t, std::conditional_t<N == 4, int32_t, int64_t>>>;
+
+	// Index into the simd_table arrays for lanes of N bytes
+	template<size_t N>
+	inline constexpr size_t simd_lane_index_v = N == 1 ? 0 : (N == 2 ? 1 : (N == 4 ? 2 : 3));
+
+	// Operations of the bitwise kernel (dest = dest op src). Also the index into simd_table::bitwise
+	enum class simd_bitwise_op : uint8_t
+	{
+		bit_and,
+		bit_or,
+		bit_xor,
+		// dest & ~src
+		bit_and_not
+	};
+
+	template<simd_bitwise_op Op, typename T>
+	T simd_bitwise_word(T a, T b)
+	{
+		if constexpr (Op == simd_bitwise_op::bit_and)
+		{
+			return static_cast<T>(a & b);
+		}
+		else if constexpr (Op == simd_bitwise_op::bit_or)
+		{
+			return static_cast<T>(a | b);
+		}
+		else if constexpr (Op == simd_bitwise_op::bit_xor)
+		{
+			return static_cast<T>(a ^ b);
+		}
+		else
+		{
+			return static_cast<T>(a & ~b);
+		}
+	}
+
+#if CZ_SIMD
+	/**
+	 * All the kernels for one level. Ranges are given as a pointer and number of lanes
+	 */
+	struct simd_table
+	{
+		void (*fill[4])(void* dest, size_t count, const void* value);
+		const void* (*find[4])(const void* first, size_t count, const void* value);
+		const void* (*find_last[4])(const void* first, size_t count, const void* value);
+		size_t (*count[4])(const void* first, size_t count, const void* value);
+		// [lane index][signed]
+		void (*minmax[3][2])(const void* first, size_t count, void* outMin, void* outMax);
+		size_t (*mismatch)(const void* a, const void* b, size_t bytes);
+		// [simd_bitwise_op]
+		void (*bitwise[4])(void* dest, const void* src, size_t bytes);
+	};
+#endif
+
+	//
+	// Plain loops, used when the cpu has nothing better.
+	// Without CZ_SIMD, these are called directly, so only the ones used end up in the binary.
+	//
+	namespace simd_scalar_kernels
+	{
+		template<size_t N>
+		void fill(void* dest, size_t count, const void* value)
+		{
+			char* p = static_cast<char*>(dest);
+			for (size_t i = 0; i < count; ++i)
+			{
+				memcpy(p + i * N, value, N);
+			}
+		}
+
+		template<size_t N>
+		const void* find(const void* first, size_t count, const void* value)
+		{
+			const simd_uint_t<N>* p = static_cast<const simd_uint_t<N>*>(first);
+			simd_uint_t<N> needle;
+			memcpy(&needle, value, N);
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (p[i] == needle)
+				{
+					return p + i;
+				}
+			}
+			return p + count;
+		}
+
+		template<size_t N>
+		const void* find_last(const void* first, size_t count, const void* value)
+		{
+			const simd_uint_t<N>* p = static_cast<const simd_uint_t<N>*>(first);
+			simd_uint_t<N> needle;
+			memcpy(&needle, value, N);
+			for (size_t i = count; i--; )
+			{
+				if (p[i] == needle)
+				{
+					return p + i;
+				}
+			}
+			return p + count;
+		}
+
+		template<size_t N>
+		size_t count(const void* first, size_t count, const void* value)
+		{
+			const simd_uint_t<N>* p = static_cast<const simd_uint_t<N>*>(first);
+			simd_uint_t<N> needle;
+			memcpy(&needle, value, N);
+			size_t res = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				res += (p[i] == needle) ? 1 : 0;
+			}
+			return res;
+		}
+
+		template<size_t N, bool Signed>
+		void minmax(const void* first, size_t count, void* outMin, void* outMax)
+		{
+			using T = std::conditional_t<Signed, simd_int_t<N>, simd_uint_t<N>>;
+			const T* p = static_cast<const T*>(first);
+			T resMin = p[0];
+			T resMax = p[0];
+			for (size_t i = 1; i < count; ++i)
+			{
+				resMin = p[i] < resMin ? p[i] : resMin;
+				resMax = resMax < p[i] ? p[i] : resMax;
+			}
+			memcpy(outMin, &resMin, N);
+			memcpy(outMax, &resMax, N);
+		}
+
+		inline size_t mismatch(const void* a, const void* b, size_t bytes)
+		{
+			const char* pa = static_cast<const char*>(a);
+			const char* pb = static_cast<const char*>(b);
+			for (size_t i = 0; i < bytes; ++i)
+			{
+				if (pa[i] != pb[i])
+				{
+					return i;
+				}
+			}
+			return bytes;
+		}
+
+		template<simd_bitwise_op Op>
+		void bitwise(void* dest, const void* src, size_t bytes)
+		{
+			char* d = static_cast<char*>(dest);
+			const char* s = static_cast<const char*>(src);
+			size_t i = 0;
+			for (; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t))
+			{
+				uint64_t a;
+				uint64_t b;
+				memcpy(&a, d + i, sizeof(a));
+				memcpy(&b, s + i, sizeof(b));
+				a = simd_bitwise_word<Op>(a, b);
+				memcpy(d + i, &a, sizeof(a));
+			}
+			for (; i < bytes; ++i)
+			{
+				d[i] = simd_bitwise_word<Op>(d[i], s[i]);
+			}
+		}
+
+#if CZ_SIMD
+		inline constexpr simd_table table = {
+			{ &fill<1>, &fill<2>, &fill<4>, &fill<8> },
+			{ &find<1>, &find<2>, &find<4>, &find<8> },
+			{ &find_last<1>, &find_last<2>, &find_last<4>, &find_last<8> },
+			{ &count<1>, &count<2>, &count<4>, &count<8> },
+			{ { &minmax<1, false>, &minmax<1, true> }, { &minmax<2, false>, &minmax<2, true> }, { &minmax<4, false>, &minmax<4, true> } },
+			&mismatch,
+			{ &bitwise<simd_bitwise_op::bit_and>, &bitwise<simd_bitwise_op::bit_or>, &bitwise<simd_bitwise_op::bit_xor>,
+				&bitwise<simd_bitwise_op::bit_and_not> }
+		};
+#endif
+	}
+
+#if CZ_SIMD
+
+	//
+	// Thin wrappers around the intrinsics, so the kernels can be written once for all register widths.
+	// Lane sizes (N) are in bytes. eqmask returns one bit per byte, so a matching lane sets N bits.
+	// min_signed/max_signed only support N <= 4.
+	//
+
+CZ_SIMD_TARGET_BEGIN("sse2")
+
+	struct simd_sse2
+	{
+		using reg = __m128i;
+		static constexpr size_t width = 16;
+
+		static reg load(const void* ptr)
+		{
+			return _mm_loadu_si128(static_cast<const __m128i*>(ptr));
+		}
+
+		static void store(void* ptr, reg v)
+		{
+			_mm_storeu_si128(static_cast<__m128i*>(ptr), v);
+		}
+
+		// Broadcasts the N bytes at value to all lanes
+		template<size_t N>
+		static reg broadcast(const void* value)
+		{
+			simd_int_t<N> v;
+			memcpy(&v, value, N);
+			if constexpr (N == 1)
+			{
+				return _mm_set1_epi8(v);
+			}
+			else if constexpr (N == 2)
+			{
+				return _mm_set1_epi16(v);
+			}
+			else if constexpr (N == 4)
+			{
+				return _mm_set1_epi32(v);
+			}
+			else
+			{
+				return _mm_set1_epi64x(v);
+			}
+		}
+
+		template<size_t N>
+		static uint64_t eqmask(reg a, reg b)
+		{
+			reg eq;
+			if constexpr (N == 1)
+			{
+				eq = _mm_cmpeq_epi8(a, b);
+			}
+			else if constexpr (N == 2)
+			{
+				eq = _mm_cmpeq_epi16(a, b);
+			}
+			else if constexpr (N == 4)
+			{
+				eq = _mm_cmpeq_epi32(a, b);
+			}
+			else
+			{
+				// Both 32 bits halves need to be equal
+				const reg eq32 = _mm_cmpeq_epi32(a, b);
+				eq = _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+			}
+			return static_cast<uint32_t>(_mm_movemask_epi8(eq));
+		}
+
+		template<size_t N>
+		static reg min_signed(reg a, reg b)
+		{
+			if constexpr (N == 2)
+			{
+				return _mm_min_epi16(a, b);
+			}
+			else
+			{
+				return _select(_cmpgt<N>(a, b), a, b);
+			}
+		}
+
+		template<size_t N>
+		static reg max_signed(reg a, reg b)
+		{
+			if constexpr (N == 2)
+			{
+				return _mm_max_epi16(a, b);
+			}
+			else
+			{
+				return _select(_cmpgt<N>(b, a), a, b);
+			}
+		}
+
+		static reg bitxor(reg a, reg b)
+		{
+			return _mm_xor_si128(a, b);
+		}
+
+		template<simd_bitwise_op Op>
+		static reg bitwise(reg a, reg b)
+		{
+			if constexpr (Op == simd_bitwise_op::bit_and)
+			{
+				return _mm_and_si128(a, b);
+			}
+			else if constexpr (Op == simd_bitwise_op::bit_or)
+			{
+				return _mm_or_si128(a, b);
+			}
+			else if constexpr (Op == simd_bitwise_op::bit_xor)
+			{
+				return _mm_xor_si128(a, b);
+			}
+			else
+			{
+				return _mm_andnot_si128(b, a);
+			}
+		}
+
+	private:
+
+		template<size_t N>
+		static reg _cmpgt(reg a, reg b)
+		{
+			static_assert(N == 1 || N == 4, "");
+			if constexpr (N == 1)
+			{
+				return _mm_cmpgt_epi8(a, b);
+			}
+			else
+			{
+				return _mm_cmpgt_epi32(a, b);
+			}
+		}
+
+		// mask ? b : a
+		static reg _select(reg mask, reg a, reg b)
+		{
+			return _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, a));
+		}
+	};
+
+	namespace simd_sse2_kernels
+	{
+		using isa = simd_sse2;
+		#include "simd_kernels.inl"
+	}
+
+CZ_SIMD_TARGET_END
+
+CZ_SIMD_TARGET_BEGIN("avx2")
+
+	struct simd_avx2
+	{
+		using reg = __m256i;
+		static constexpr size_t width = 32;
+
+		static reg load(const void* ptr)
+		{
+			return _mm256_loadu_si256(static_cast<const __m256i*>(ptr));
+		}
+
+		static void store(void* ptr, reg v)
+		{
+			_mm256_storeu_si256(static_cast<__m256i*>(ptr), v);
+		}
+
+		template<size_t N>
+		static reg broadcast(const void* value)
+		{
+			simd_int_t<N> v;
+			memcpy(&v, value, N);
+			if constexpr (N == 1)
+			{
+				return _mm256_set1_epi8(v);
+			}
+			else if constexpr (N == 2)
+			{
+				return _mm256_set1_epi16(v);
+			}
+			else if constexpr (N == 4)
+			{
+				return _mm256_set1_epi32(v);
+			}
+			else
+			{
+				return _mm256_set1_epi64x(v);
+			}
+		}
+
+		template<size_t N>
+		static uint64_t eqmask(reg a, reg b)
+		{
+			reg eq;
+			if constexpr (N == 1)
+			{
+				eq = _mm256_cmpeq_epi8(a, b);
+			}
+			else if constexpr (N == 2)
+			{
+				eq = _mm256_cmpeq_epi16(a, b);
+			}
+			else if constexpr (N == 4)
+			{
+				eq = _mm256_cmpeq_epi32(a, b);
+			}
+			else
+			{
+				eq = _mm256_cmpeq_epi64(a, b);
+			}
+			return static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+		}
+
+		template<size_t N>
+		static reg min_signed(reg a, reg b)
+		{
+			if constexpr (N == 1)
+			{
+				return _mm256_min_epi8(a, b);
+			}
+			else if constexpr (N == 2)
+			{
+				return _mm256_min_epi16(a, b);
+			}
+			else
+			{
+				return _mm256_min_epi32(a, b);
+			}
+		}
+
+		template<size_t N>
+		static reg max_signed(reg a, reg b)
+		{
+			if constexpr (N == 1)
+			{
+				return _mm256_max_epi8(a, b);
+			}
+			else if constexpr (N == 2)
+			{
+				return _mm256_max_epi16(a, b);
+			}
+			else
+			{
+				return _mm256_max_epi32(a, b);
+			}
+		}
+
+		static reg bitxor(reg a, reg b)
+		{
+			return _mm256_xor_si256(a, b);
+		}
+
+		template<simd_bitwise_op Op>
+		static reg bitwise(reg a, reg b)
+		{
+			if constexpr (Op == simd_bitwise_op::bit_and)
+			{
+				return _mm256_and_si256(a, b);
+			}
+			else if constexpr (Op == simd_bitwise_op::bit_or)
+			{
+				return _mm256_or_si256(a, b);
+			}
+			else if constexpr (Op == simd_bitwise_op::bit_xor)
+			{
+				return _mm256_xor_si256(a, b);
+			}
+			else
+			{
+				return _mm256_andnot_si256(b, a);
+			}
+		}
+	};
+
+	namespace simd_avx2_kernels
+	{
+		using isa = simd_avx2;
+		#include "simd_kernels.inl"
+	}
+
+CZ_SIMD_TARGET_END
+
+CZ_SIMD_TARGET_BEGIN("avx512f,avx512bw")
+
+	struct simd_avx512
+	{
+		using reg = __m512i;
+		static constexpr size_t width = 64;
+
+		static reg load(const void* ptr)
+		{
+			return _mm512_loadu_si512(ptr);
+		}
+
+		static void store(void* ptr, reg v)
+		{
+			_mm512_storeu_si512(ptr, v);
+		}
+
+		template<size_t N>
+		static reg broadcast(const void* value)
+		{
+			simd_int_t<N> v;
+			memcpy(&v, value, N);
+			if constexpr (N == 1)
+			{
+				return _mm512_set1_epi8(v);
+			}
+			else if constexpr (N == 2)
+			{
+				return _mm512_set1_epi16(v);
+			}
+			else if constexpr (N == 4)
+			{
+				return _mm512_set1_epi32(v);
+			}
+			else
+			{
+				return _mm512_set1_epi64(v);
+			}
+		}
+
+		// Compares give one bit per lane, so they are widened to one bit per byte
+		template<size_t N>
+		static uint64_t eqmask(reg a, reg b)
+		{
+			if constexpr (N == 1)
+			{
+				return _mm512_cmpeq_epi8_mask(a, b);
+			}
+			else if constexpr (N == 2)
+			{
+				return _mm512_movepi8_mask(_mm512_maskz_set1_epi16(_mm512_cmpeq_epi16_mask(a, b), -1));
+			}
+			else if constexpr (N == 4)
+			{
+				return _mm512_movepi8_mask(_mm512_maskz_set1_epi32(_mm512_cmpeq_epi32_mask(a, b), -1));
+			}
+			else
+			{
+				return _mm512_movepi8_mask(_mm512_maskz_set1_epi64(_mm512_cmpeq_epi64_mask(a, b), -1));
+			}
+		}
+
+		template<size_t N>
+		static reg min_signed(reg a, reg b)
+		{
+			if constexpr (N == 1)
+			{
+				return _mm512_min_epi8(a, b);
+			}
+			else if constexpr (N == 2)
+			{
+				return _mm512_min_epi16(a, b);
+			}
+			else
+			{
+				// The maskz version avoids a false -Wmaybe-uninitialized from gcc's own header
+				return _mm512_maskz_min_epi32(static_cast<__mmask16>(-1), a, b);
+			}
+		}
+
+		template<size_t N>
+		static reg max_signed(reg a, reg b)
+		{
+			if constexpr (N == 1)
+			{
+				return _mm512_max_epi8(a, b);
+			}
+			else if constexpr (N == 2)
+			{
+				return _mm512_max_epi16(a, b);
+			}
+			else
+			{
+				// The maskz version avoids a false -Wmaybe-uninitialized from gcc's own header
+				return _mm512_maskz_max_epi32(static_cast<__mmask16>(-1), a, b);
+			}
+		}
+
+		static reg bitxor(reg a, reg b)
+		{
+			return _mm512_xor_si512(a, b);
+		}
+
+		template<simd_bitwise_op Op>
+		static reg bitwise(reg a, reg b)
+		{
+			if constexpr (Op == simd_bitwise_op::bit_and)
+			{
+				return _mm512_and_si512(a, b);
+			}
+			else if constexpr (Op == simd_bitwise_op::bit_or)
+			{
+				return _mm512_or_si512(a, b);
+			}
+			else if constexpr (Op == simd_bitwise_op::bit_xor)
+			{
+				return _mm512_xor_si512(a, b);
+			}
+			else
+			{
+				// The maskz version avoids a false -Wmaybe-uninitialized from gcc's own header
+				return _mm512_maskz_andnot_epi32(static_cast<__mmask16>(-1), b, a);
+			}
+		}
+	};
+
+	namespace simd_avx512_kernels
+	{
+		using isa = simd_avx512;
+		#include "simd_kernels.inl"
+	}
+
+CZ_SIMD_TARGET_END
+
+#endif // CZ_SIMD
+
+	inline simd_level simd_best_level()
+	{
+#if CZ_SIMD
+		const cpu_features& cpu = cpu_features::get();
+		if (cpu.avx512f && cpu.avx512bw)
+		{
+			return simd_level::avx512;
+		}
+		else if (cpu.avx2)
+		{
+			return simd_level::avx2;
+		}
+		else if (cpu.sse2)
+		{
+			return simd_level::sse2;
+		}
+#endif
+		return simd_level::scalar;
+	}
+
+#if CZ_SIMD
+	inline const simd_table& simd_table_for(simd_level level)
+	{
+		switch (level)
+		{
+		case simd_level::avx512:
+			return simd_avx512_kernels::table;
+		case simd_level::avx2:
+			return simd_avx2_kernels::table;
+		case simd_level::sse2:
+			return simd_sse2_kernels::table;
+		default:
+			return simd_scalar_kernels::table;
+		}
+	}
+
+	// nullptr until the first use. The tables are constant, so relaxed loads/stores are enough
+	inline const simd_table* g_simdTable = nullptr;
+	inline simd_level g_simdLevel = simd_level::scalar;
+
+	inline const simd_table& simd_get_table()
+	{
+		const simd_table* table = __atomic_load_n(&g_simdTable, __ATOMIC_RELAXED);
+		if (!table)
+		{
+			const simd_level level = simd_best_level();
+			table = &simd_table_for(level);
+			__atomic_store_n(&g_simdLevel, level, __ATOMIC_RELAXED);
+			__atomic_store_n(&g_simdTable, table, __ATOMIC_RELAXED);
+		}
+		return *table;
+	}
+#endif
+
+	//
+	// Kernel calls, for lanes of N bytes. Through the table with CZ_SIMD, or straight to the plain loops without.
+	//
+
+	template<size_t N>
+	void simd_kernel_fill(void* dest, size_t count, const void* value)
+	{
+#if CZ_SIMD
+		simd_get_table().fill[simd_lane_index_v<N>](dest, count, value);
+#else
+		simd_scalar_kernels::fill<N>(dest, count, value);
+#endif
+	}
+
+	template<size_t N>
+	const void* simd_kernel_find(const void* first, size_t count, const void* value)
+	{
+#if CZ_SIMD
+		return simd_get_table().find[simd_lane_index_v<N>](first, count, value);
+#else
+		return simd_scalar_kernels::find<N>(first, count, value);
+#endif
+	}
+
+	template<size_t N>
+	const void* simd_kernel_find_last(const void* first, size_t count, const void* value)
+	{
+#if CZ_SIMD
+		return simd_get_table().find_last[simd_lane_index_v<N>](first, count, value);
+#else
+		return simd_scalar_kernels::find_last<N>(first, count, value);
+#endif
+	}
+
+	template<size_t N>
+	size_t simd_kernel_count(const void* first, size_t count, const void* value)
+	{
+#if CZ_SIMD
+		return simd_get_table().count[simd_lane_index_v<N>](first, count, value);
+#else
+		return simd_scalar_kernels::count<N>(first, count, value);
+#endif
+	}
+
+	template<size_t N, bool Signed>
+	void simd_kernel_minmax(const void* first, size_t count, void* outMin, void* outMax)
+	{
+#if CZ_SIMD
+		simd_get_table().minmax[simd_lane_index_v<N>][Signed](first, count, outMin, outMax);
+#else
+		simd_scalar_kernels::minmax<N, Signed>(first, count, outMin, outMax);
+#endif
+	}
+
+	inline size_t simd_kernel_mismatch(const void* a, const void* b, size_t bytes)
+	{
+#if CZ_SIMD
+		return simd_get_table().mismatch(a, b, bytes);
+#else
+		return simd_scalar_kernels::mismatch(a, b, bytes);
+#endif
+	}
+
+	// dest = dest op src, for bytes bytes. The ranges can be the same, but can't partially overlap
+	template<simd_bitwise_op Op>
+	void simd_kernel_bitwise(void* dest, const void* src, size_t bytes)
+	{
+#if CZ_SIMD
+		simd_get_table().bitwise[static_cast<size_t>(Op)](dest, src, bytes);
+#else
+		simd_scalar_kernels::bitwise<Op>(dest, src, bytes);
+#endif
+	}
+
+	// All the integer types. std::is_integral here is based on the fixed size types, so it misses some of them
+	// (e.g: long long where int64_t is long), and includes float and double.
+	template<typename T> struct is_integer_base : std::false_type {};
+	template<> struct is_integer_base<bool> : std::true_type {};
+	template<> struct is_integer_base<char> : std::true_type {};
+	template<> struct is_integer_base<signed char> : std::true_type {};
+	template<> struct is_integer_base<unsigned char> : std::true_type {};
+	template<> struct is_integer_base<wchar_t> : std::true_type {};
+#if defined(__cpp_char8_t)
+	template<> struct is_integer_base<char8_t> : std::true_type {};
+#endif
+	template<> struct is_integer_base<char16_t> : std::true_type {};
+	template<> struct is_integer_base<char32_t> : std::true_type {};
+	template<> struct is_integer_base<short> : std::true_type {};
+	template<> struct is_integer_base<unsigned short> : std::true_type {};
+	template<> struct is_integer_base<int> : std::true_type {};
+	template<> struct is_integer_base<unsigned int> : std::true_type {};
+	template<> struct is_integer_base<long> : std::true_type {};
+	template<> struct is_integer_base<unsigned long> : std::true_type {};
+	template<> struct is_integer_base<long long> : std::true_type {};
+	template<> struct is_integer_base<unsigned long long> : std::true_type {};
+
+	template<typename T>
+	inline constexpr bool is_integer_v = is_integer_base<std::remove_cv_t<T>>::value;
+
+	// Types where == is the same as comparing the bits
+	template<typename T>
+	inline constexpr bool simd_bitwise_equality_v = is_integer_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>;
+
+	template<typename T>
+	inline constexpr bool simd_lane_size_v = sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8;
+
+	template<typename T>
+	inline constexpr bool simd_find_v = simd_bitwise_equality_v<T> && simd_lane_size_v<T>;
+
+	template<typename T>
+	inline constexpr bool simd_minmax_v = is_integer_v<T> && sizeof(T) <= 4 && !std::is_same_v<T, bool>;
+
+	// Fills count elements at dest with value. dest can be uninitialized memory
+	template<typename T>
+	void simd_fill(T* dest, size_t count, const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "");
+		if constexpr (sizeof(T) == 1)
+		{
+			memset(static_cast<void*>(dest), *reinterpret_cast<const unsigned char*>(&value), count);
+		}
+		else if constexpr (simd_lane_size_v<T>)
+		{
+			simd_kernel_fill<sizeof(T)>(dest, count, &value);
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				memcpy(static_cast<void*>(dest + i), &value, sizeof(T));
+			}
+		}
+	}
+
+	template<typename T>
+	const T* simd_find(const T* first, const T* last, const T& value)
+	{
+		if constexpr (simd_find_v<T>)
+		{
+			return static_cast<const T*>(simd_kernel_find<sizeof(T)>(first, static_cast<size_t>(last - first), &value));
+		}
+		else
+		{
+			for (; first != last; ++first)
+			{
+				if (*first == value)
+				{
+					return first;
+				}
+			}
+			return last;
+		}
+	}
+
+	// Like simd_find, but returns the last match (or last if not found)
+	template<typename T>
+	const T* simd_find_last(const T* first, const T* last, const T& value)
+	{
+		if constexpr (simd_find_v<T>)
+		{
+			return static_cast<const T*>(simd_kernel_find_last<sizeof(T)>(first, static_cast<size_t>(last - first), &value));
+		}
+		else
+		{
+			for (const T* it = last; it != first; )
+			{
+				--it;
+				if (*it == value)
+				{
+					return it;
+				}
+			}
+			return last;
+		}
+	}
+
+	template<typename T>
+	size_t simd_count(const T* first, const T* last, const T& value)
+	{
+		if constexpr (simd_find_v<T>)
+		{
+			return simd_kernel_count<sizeof(T)>(first, static_cast<size_t>(last - first), &value);
+		}
+		else
+		{
+			size_t res = 0;
+			for (; first != last; ++first)
+			{
+				if (*first == value)
+				{
+					++res;
+				}
+			}
+			return res;
+		}
+	}
+
+	// Returns the smallest and biggest values. [first, last) can't be empty
+	template<typename T>
+	min_max_result<T> simd_minmax_value(const T* first, const T* last)
+	{
+		static_assert(simd_minmax_v<T>, "");
+		constexpr bool isSigned = static_cast<T>(-1) < static_cast<T>(0);
+		min_max_result<T> res;
+		simd_kernel_minmax<sizeof(T), isSigned>(first, static_cast<size_t>(last - first), &res.min, &res.max);
+		return res;
+	}
+
+} // namespace detail
+
+/**
+ * Level of the kernels in use
+ */
+inline simd_level get_simd_level()
+{
+#if CZ_SIMD
+	detail::simd_get_table();
+	return __atomic_load_n(&detail::g_simdLevel, __ATOMIC_RELAXED);
+#else
+	return simd_level::scalar;
+#endif
+}
+
+/**
+ * Forces the kernels of the given level. Levels the cpu doesn't support are lowered to the best supported one.
+ * Returns the level actually set.
+ * Not meant to be called while other threads are using the kernels, although that's still safe.
+ */
+inline simd_level set_simd_level(simd_level level)
+{
+#if CZ_SIMD
+	const simd_level best = detail::simd_best_level();
+	if (static_cast<int>(level) > static_cast<int>(best))
+	{
+		level = best;
+	}
+	__atomic_store_n(&detail::g_simdLevel, level, __ATOMIC_RELAXED);
+	__atomic_store_n(&detail::g_simdTable, &detail::simd_table_for(level), __ATOMIC_RELAXED);
+	return level;
+#else
+	(void)level;
+	return simd_level::scalar;
+#endif
+}
+
+/**
+ * Same as std::fill
+ */
+template<typename T>
+void fill(T* first, T* last, const T& value)
+{
+	if constexpr (std::is_trivially_copyable_v<T>)
+	{
+		detail::simd_fill(first, static_cast<size_t>(last - first), value);
+	}
+	else
+	{
+		for (; first != last; ++first)
+		{
+			*first = value;
+		}
+	}
+}
+
+/**
+ * Same as std::copy, but the ranges can overlap if T is trivially copyable.
+ */
+template<typename T>
+T* copy(const T* first, const T* last, T* dest)
+{
+	if constexpr (std::is_trivially_copyable_v<T>)
+	{
+		const size_t count = static_cast<size_t>(last - first);
+		// Empty ranges can be null, which memmove doesn't allow
+		if (count)
+		{
+			memmove(static_cast<void*>(dest), first, count * sizeof(T));
+		}
+		return dest + count;
+	}
+	else
+	{
+		for (; first != last; ++first, ++dest)
+		{
+			*dest = *first;
+		}
+		return dest;
+	}
+}
+
+/**
+ * Same as std::find.
+ * Only uses SIMD if U is the same type as the elements, since otherwise == can convert in ways the bit
+ * comparison wouldn't.
+ */
+template<typename T, typename U>
+T* find(T* first, T* last, const U& value)
+{
+	if constexpr (std::is_same_v<std::remove_cv_t<T>, U>)
+	{
+		return const_cast<T*>(detail::simd_find<U>(first, last, value));
+	}
+	else
+	{
+		for (; first != last; ++first)
+		{
+			if (*first == value)
+			{
+				return first;
+			}
+		}
+		return last;
+	}
+}
+
+/**
+ * Same as std::count
+ */
+template<typename T, typename U>
+size_t count(const T* first, const T* last, const U& value)
+{
+	if constexpr (std::is_same_v<std::remove_cv_t<T>, U>)
+	{
+		return detail::simd_count<U>(first, last, value);
+	}
+	else
+	{
+		size_t res = 0;
+		for (; first != last; ++first)
+		{
+			if (*first == value)
+			{
+				++res;
+			}
+		}
+		return res;
+	}
+}
+
+/**
+ * Same as std::minmax_element: Returns the first smallest element and the last biggest element, or {last, last} if
+ * the range is empty.
+ */
+template<typename T>
+min_max_result<T*> minmax_element(T* first, T* last)
+{
+	if (first == last)
+	{
+		return { last, last };
+	}
+
+	using value_type = std::remove_cv_t<T>;
+	if constexpr (detail::simd_minmax_v<value_type>)
+	{
+		// Find the values first, then where they are
+		const min_max_result<value_type> values = detail::simd_minmax_value<value_type>(first, last);
+		return { const_cast<T*>(detail::simd_find<value_type>(first, last, values.min)),
+			const_cast<T*>(detail::simd_find_last<value_type>(first, last, values.max)) };
+	}
+	else
+	{
+		min_max_result<T*> res = { first, first };
+		for (++first; first != last; ++first)
+		{
+			if (*first < *res.min)
+			{
+				res.min = first;
+			}
+			if (!(*first < *res.max))
+			{
+				res.max = first;
+			}
+		}
+		return res;
+	}
+}
+
+/**
+ * Same as std::equal. Types where == compares the bits are compared as bytes.
+ */
+template<typename T>
+bool equal(const T* first1, const T* last1, const T* first2)
+{
+	if constexpr (detail::simd_bitwise_equality_v<T>)
+	{
+		const size_t bytes = static_cast<size_t>(last1 - first1) * sizeof(T);
+		return detail::simd_kernel_mismatch(first1, first2, bytes) == bytes;
+	}
+	else
+	{
+		for (; first1 != last1; ++first1, ++first2)
+		{
+			if (!(*first1 == *first2))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+} // namespace cz
@@ -0,0 +1,213 @@
+/**
+SIMD kernels, written once for all instruction sets.
+
+simd.h includes this once per instruction set, inside a namespace that defines `isa` as the matching wrapper, and with
+the compiler's target options set for that instruction set. So there is no include guard on purpose.
+
+Kernels work on lanes of N bytes, and ranges are given as a pointer and number of lanes.
+*/
+
+template<size_t N>
+void fill(void* dest, size_t count, const void* value)
+{
+	constexpr size_t lanes = isa::width / N;
+	char* p = static_cast<char*>(dest);
+	const typename isa::reg v = isa::template broadcast<N>(value);
+	size_t i = 0;
+	for (; i + lanes <= count; i += lanes)
+	{
+		isa::store(p + i * N, v);
+	}
+	for (; i < count; ++i)
+	{
+		memcpy(p + i * N, value, N);
+	}
+}
+
+template<size_t N>
+const void* find(const void* first, size_t count, const void* value)
+{
+	constexpr size_t lanes = isa::width / N;
+	const char* p = static_cast<const char*>(first);
+	const typename isa::reg v = isa::template broadcast<N>(value);
+	size_t i = 0;
+	for (; i + lanes <= count; i += lanes)
+	{
+		const uint64_t mask = isa::template eqmask<N>(isa::load(p + i * N), v);
+		if (mask)
+		{
+			return p + i * N + __builtin_ctzll(mask);
+		}
+	}
+
+	simd_uint_t<N> needle;
+	memcpy(&needle, value, N);
+	for (; i < count; ++i)
+	{
+		simd_uint_t<N> x;
+		memcpy(&x, p + i * N, N);
+		if (x == needle)
+		{
+			return p + i * N;
+		}
+	}
+	return p + count * N;
+}
+
+// Returns the end of the range if not found
+template<size_t N>
+const void* find_last(const void* first, size_t count, const void* value)
+{
+	constexpr size_t lanes = isa::width / N;
+	const char* p = static_cast<const char*>(first);
+	const typename isa::reg v = isa::template broadcast<N>(value);
+	size_t i = count;
+	for (; i >= lanes; i -= lanes)
+	{
+		const uint64_t mask = isa::template eqmask<N>(isa::load(p + (i - lanes) * N), v);
+		if (mask)
+		{
+			// The highest set bit is the last byte of the match
+			return p + (i - lanes) * N + (63 - __builtin_clzll(mask)) - (N - 1);
+		}
+	}
+
+	simd_uint_t<N> needle;
+	memcpy(&needle, value, N);
+	while (i--)
+	{
+		simd_uint_t<N> x;
+		memcpy(&x, p + i * N, N);
+		if (x == needle)
+		{
+			return p + i * N;
+		}
+	}
+	return p + count * N;
+}
+
+template<size_t N>
+size_t count(const void* first, size_t count, const void* value)
+{
+	constexpr size_t lanes = isa::width / N;
+	const char* p = static_cast<const char*>(first);
+	const typename isa::reg v = isa::template broadcast<N>(value);
+	size_t res = 0;
+	size_t i = 0;
+	for (; i + lanes <= count; i += lanes)
+	{
+		// Each matching lane sets N bits
+		res += static_cast<size_t>(__builtin_popcountll(isa::template eqmask<N>(isa::load(p + i * N), v))) / N;
+	}
+
+	simd_uint_t<N> needle;
+	memcpy(&needle, value, N);
+	for (; i < count; ++i)
+	{
+		simd_uint_t<N> x;
+		memcpy(&x, p + i * N, N);
+		res += (x == needle) ? 1 : 0;
+	}
+	return res;
+}
+
+// count needs to be > 0
+template<size_t N, bool Signed>
+void minmax(const void* first, size_t count, void* outMin, void* outMax)
+{
+	using T = std::conditional_t<Signed, simd_int_t<N>, simd_uint_t<N>>;
+	using reg = typename isa::reg;
+	constexpr size_t lanes = isa::width / N;
+	const char* p = static_cast<const char*>(first);
+
+	T resMin;
+	memcpy(&resMin, p, N);
+	T resMax = resMin;
+	size_t i = 0;
+	if (count >= lanes)
+	{
+		// The SIMD compares are signed, so unsigned values get the sign bit flipped before comparing
+		const T signBit = Signed ? T(0) : static_cast<T>(T(1) << (N * 8 - 1));
+		const reg flip = isa::template broadcast<N>(&signBit);
+
+		reg vmin = isa::bitxor(isa::load(p), flip);
+		reg vmax = vmin;
+		for (i = lanes; i + lanes <= count; i += lanes)
+		{
+			const reg v = isa::bitxor(isa::load(p + i * N), flip);
+			vmin = isa::template min_signed<N>(vmin, v);
+			vmax = isa::template max_signed<N>(vmax, v);
+		}
+
+		T mins[lanes];
+		T maxs[lanes];
+		isa::store(mins, isa::bitxor(vmin, flip));
+		isa::store(maxs, isa::bitxor(vmax, flip));
+		for (size_t lane = 0; lane < lanes; ++lane)
+		{
+			resMin = mins[lane] < resMin ? mins[lane] : resMin;
+			resMax = resMax < maxs[lane] ? maxs[lane] : resMax;
+		}
+	}
+
+	for (; i < count; ++i)
+	{
+		T x;
+		memcpy(&x, p + i * N, N);
+		resMin = x < resMin ? x : resMin;
+		resMax = resMax < x ? x : resMax;
+	}
+
+	memcpy(outMin, &resMin, N);
+	memcpy(outMax, &resMax, N);
+}
+
+// Returns the index of the first byte that differs, or bytes if they are equal
+inline size_t mismatch(const void* a, const void* b, size_t bytes)
+{
+	const char* pa = static_cast<const char*>(a);
+	const char* pb = static_cast<const char*>(b);
+	constexpr uint64_t allEqual = isa::width == 64 ? ~uint64_t(0) : (uint64_t(1) << isa::width) - 1;
+	size_t i = 0;
+	for (; i + isa::width <= bytes; i += isa::width)
+	{
+		const uint64_t mask = isa::template eqmask<1>(isa::load(pa + i), isa::load(pb + i));
+		if (mask != allEqual)
+		{
+			return i + __builtin_ctzll(~mask);
+		}
+	}
+	for (; i < bytes; ++i)
+	{
+		if (pa[i] != pb[i])
+		{
+			return i;
+		}
+	}
+	return bytes;
+}
+
+// dest = dest op src
+template<simd_bitwise_op Op>
+void bitwise(void* dest, const void* src, size_t bytes)
+{
+	char* d = static_cast<char*>(dest);
+	const char* s = static_cast<const char*>(src);
+	size_t i = 0;
+	for (; i + isa::width <= bytes; i += isa::width)
+	{
+		isa::store(d + i, isa::template bitwise<Op>(isa::load(d + i), isa::load(s + i)));
+	}
+	simd_scalar_kernels::bitwise<Op>(d + i, s + i, bytes - i);
+}
+
+inline constexpr simd_table table = {
+	{ &fill<1>, &fill<2>, &fill<4>, &fill<8> },
+	{ &find<1>, &find<2>, &find<4>, &find<8> },
+	{ &find_last<1>, &find_last<2>, &find_last<4>, &find_last<8> },
+	{ &count<1>, &count<2>, &count<4>, &count<8> },
+	{ { &minmax<1, false>, &minmax<1, true> }, { &minmax<2, false>, &minmax<2, true> }, { &minmax<4, false>, &minmax<4, true> } },
+	&mismatch,
+	{ &bitwise<simd_bitwise_op::bit_and>, &bitwise<simd_bitwise_op::bit_or>, &bitwise<simd_bitwise_op::bit_xor>,
+		&bitwise<simd_bitwise_op::bit_and_not> }
+};
@@ -0,0 +1,392 @@
+/**
+Struct-of-arrays vector.
+
+soa_vector<A, B, C> behaves like a vector of records with the fields A, B and C, but stores each field in its own
+contiguous array, so loops that only touch some of the fields don't waste bandwidth on the others.
+All the arrays live in a single allocation, aligned for the most aligned column (over-aligned types are supported).
+*/
+
+#pragma once
+
+#include "vector.h"
+#include <span>
+
+namespace cz
+{
+
+namespace detail
+{
+	// Exposes base_vector's helpers, so they can be used for each column
+	template<typename T>
+	struct soa_column : public base_vector<T>
+	{
+		using base_vector<T>::_constructSingle;
+		using base_vector<T>::_copyConstructRange;
+		using base_vector<T>::_moveConstructRange;
+		using base_vector<T>::_relocateRange;
+		using base_vector<T>::_destroySingle;
+		using base_vector<T>::_destroyRange;
+		using base_vector<T>::_exchange;
+	};
+} // namespace detail
+
+template<typename... Ts>
+class soa_vector
+{
+	static_assert(sizeof...(Ts) > 0, "soa_vector needs at least one column");
+
+public:
+	using size_type = std::size_t;
+
+	static constexpr size_type num_columns = sizeof...(Ts);
+
+	template<size_type I>
+	using column_type = std::detail::type_pack_element_t<I, Ts...>;
+
+	/**
+	 * Proxy to a single row, since there is no record object to return a reference to.
+	 */
+	template<typename SoaType, bool IsConst>
+	class row_proxy
+	{
+	public:
+		row_proxy(SoaType* owner, size_type index)
+			: m_owner(owner), m_index(index)
+		{
+		}
+
+		template<size_type I>
+		std::conditional_t<IsConst, const column_type<I>&, column_type<I>&> get() const
+		{
+			return m_owner->template column<I>()[m_index];
+		}
+
+		size_type index() const
+		{
+			return m_index;
+		}
+
+	private:
+		SoaType* m_owner;
+		size_type m_index;
+	};
+
+	using reference = row_proxy<soa_vector, false>;
+	using const_reference = row_proxy<const soa_vector, true>;
+
+	constexpr soa_vector() noexcept {}
+
+	soa_vector(const soa_vector& other) noexcept
+	{
+		if (other.m_size == 0)
+		{
+			return;
+		}
+
+		_setCapacity(other.m_size);
+		_forEachColumn([&](auto I)
+		{
+			using T = column_type<I>;
+			detail::soa_column<T>::_copyConstructRange(other._column<I>(), other._column<I>() + other.m_size, _column<I>());
+		});
+		m_size = other.m_size;
+	}
+
+	soa_vector(soa_vector&& other) noexcept
+	{
+		_steal(other);
+	}
+
+	soa_vector& operator=(const soa_vector& other) noexcept
+	{
+		if (this != &other)
+		{
+			soa_vector tmp(other);
+			*this = std::move(tmp);
+		}
+		return *this;
+	}
+
+	soa_vector& operator=(soa_vector&& other) noexcept
+	{
+		if (this != &other)
+		{
+			_tidy();
+			_steal(other);
+		}
+		return *this;
+	}
+
+	~soa_vector() noexcept
+	{
+		_tidy();
+	}
+
+	//
+	// Element access
+	//
+
+	// A whole column, for field by field processing
+	template<size_type I>
+	std::span<column_type<I>> column() noexcept
+	{
+		return std::span<column_type<I>>(_column<I>(), m_size);
+	}
+
+	template<size_type I>
+	std::span<const column_type<I>> column() const noexcept
+	{
+		return std::span<const column_type<I>>(_column<I>(), m_size);
+	}
+
+	template<size_type I>
+	column_type<I>& get(size_type pos)
+	{
+		CZ_VECTOR_ASSERT_SLOW(pos < m_size);
+		return _column<I>()[pos];
+	}
+
+	template<size_type I>
+	const column_type<I>& get(size_type pos) const
+	{
+		CZ_VECTOR_ASSERT_SLOW(pos < m_size);
+		return _column<I>()[pos];
+	}
+
+	reference operator[](size_type pos)
+	{
+		CZ_VECTOR_ASSERT_SLOW(pos < m_size);
+		return reference(this, pos);
+	}
+
+	const_reference operator[](size_type pos) const
+	{
+		CZ_VECTOR_ASSERT_SLOW(pos < m_size);
+		return const_reference(this, pos);
+	}
+
+	reference back()
+	{
+		CZ_VECTOR_ASSERT_SLOW(m_size);
+		return reference(this, m_size - 1);
+	}
+
+	const_reference back() const
+	{
+		CZ_VECTOR_ASSERT_SLOW(m_size);
+		return const_reference(this, m_size - 1);
+	}
+
+	//
+	// Capacity related methods
+	//
+	bool empty() const noexcept
+	{
+		return m_size == 0;
+	}
+
+	size_type size() const noexcept
+	{
+		return m_size;
+	}
+
+	size_type capacity() const noexcept
+	{
+		return m_capacity;
+	}
+
+	void reserve(size_type newCapacity)
+	{
+		if (newCapacity > m_capacity)
+		{
+			_setCapacity(newCapacity);
+		}
+	}
+
+	//
+	// Modifiers API
+	//
+	void clear() noexcept
+	{
+		_forEachColumn([&](auto I)
+		{
+			using T = column_type<I>;
+			detail::soa_column<T>::_destroyRange(_column<I>(), _column<I>() + m_size);
+		});
+		m_size = 0;
+	}
+
+	// Adds a row, with one argument per column. Each column is constructed from the respective argument.
+	template<typename... Args>
+	void emplace_back(Args&&... args)
+	{
+		static_assert(sizeof...(Args) == num_columns, "emplace_back needs one argument per column");
+		if (m_size == m_capacity)
+		{
+			_setCapacity(m_capacity ? m_capacity * 2 : 1);
+		}
+		_constructRow(std::index_sequence_for<Ts...>(), std::forward<Args>(args)...);
+		++m_size;
+	}
+
+	void push_back(const Ts&... values)
+	{
+		emplace_back(values...);
+	}
+
+	void push_back(Ts&&... values)
+	{
+		emplace_back(std::move(values)...);
+	}
+
+	void pop_back()
+	{
+		CZ_VECTOR_ASSERT_SLOW(m_size > 0);
+		--m_size;
+		_forEachColumn([&](auto I)
+		{
+			using T = column_type<I>;
+			detail::soa_column<T>::_destroySingle(_column<I>() + m_size);
+		});
+	}
+
+private:
+
+	template<size_type I>
+	column_type<I>* _column() const
+	{
+		return static_cast<column_type<I>*>(m_columns[I]);
+	}
+
+	template<typename F, size_type... Is>
+	static void _forEachColumnImpl(F&& f, std::index_sequence<Is...>)
+	{
+		(f(std::integral_constant<size_type, Is>()), ...);
+	}
+
+	// Calls f(std::integral_constant<size_type, I>) for each column I
+	template<typename F>
+	static void _forEachColumn(F&& f)
+	{
+		_forEachColumnImpl(f, std::index_sequence_for<Ts...>());
+	}
+
+	template<size_type... Is, typename... Args>
+	void _constructRow(std::index_sequence<Is...>, Args&&... args)
+	{
+		(detail::soa_column<column_type<Is>>::_constructSingle(_column<Is>() + m_size, std::forward<Args>(args)), ...);
+	}
+
+	static constexpr size_type ms_alignment = []
+	{
+		size_type res = 1;
+		((res = alignof(Ts) > res ? alignof(Ts) : res), ...);
+		return res;
+	}();
+	static constexpr bool ms_overAligned = ms_alignment > alignof(std::max_align_t);
+
+	static constexpr size_type _alignUp(size_type offset, size_type alignment)
+	{
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Calculates where each column starts for the given capacity, and returns the total size of the block
+	static size_type _layout(size_type capacity, size_type* offsets)
+	{
+		size_type offset = 0;
+		size_type idx = 0;
+		((offset = _alignUp(offset, alignof(Ts)), offsets[idx++] = offset, offset += sizeof(Ts) * capacity), ...);
+		return offset;
+	}
+
+	// The block is aligned for the most aligned column, the same way cz::vector handles over-aligned elements
+	static void* _allocBlock(size_type bytes)
+	{
+		if constexpr (ms_overAligned)
+		{
+			return detail::VectorAllocator::_allocAligned(bytes, ms_alignment);
+		}
+		else
+		{
+			return detail::VectorAllocator::_alloc(bytes);
+		}
+	}
+
+	static void _freeBlock(void* ptr)
+	{
+		if constexpr (ms_overAligned)
+		{
+			detail::VectorAllocator::_freeAligned(ptr);
+		}
+		else
+		{
+			detail::VectorAllocator::_free(ptr);
+		}
+	}
+
+	void _setCapacity(size_type newCapacity)
+	{
+		CZ_VECTOR_ASSERT_SLOW(newCapacity >= m_size);
+
+		size_type offsets[num_columns];
+		const size_type bytes = _layout(newCapacity, offsets);
+		char* newData = static_cast<char*>(_allocBlock(bytes));
+#if CZ_DEBUG
+		memset(newData, 0xCD, bytes);
+#endif
+
+		_forEachColumn([&](auto I)
+		{
+			using T = column_type<I>;
+			T* dest = reinterpret_cast<T*>(newData + offsets[I]);
+			if (m_size)
+			{
+				T* first = _column<I>();
+				detail::soa_column<T>::_relocateRange(first, first + m_size, dest);
+			}
+			m_columns[I] = dest;
+		});
+
+		if (m_data)
+		{
+			_freeBlock(m_data);
+		}
+		m_data = newData;
+		m_capacity = newCapacity;
+	}
+
+	void _steal(soa_vector& other)
+	{
+		m_data = detail::soa_column<char>::_exchange(other.m_data, nullptr);
+		m_capacity = detail::soa_column<char>::_exchange(other.m_capacity, 0);
+		m_size = detail::soa_column<char>::_exchange(other.m_size, 0);
+		for (size_type i = 0; i < num_columns; ++i)
+		{
+			m_columns[i] = detail::soa_column<char>::_exchange(other.m_columns[i], nullptr);
+		}
+	}
+
+	void _tidy()
+	{
+		if (m_data)
+		{
+			clear();
+			_freeBlock(m_data);
+			m_data = nullptr;
+			m_capacity = 0;
+			for (void*& col : m_columns)
+			{
+				col = nullptr;
+			}
+		}
+	}
+
+	// The single allocation holding all the columns
+	void* m_data = nullptr;
+	// Start of each column inside m_data
+	void* m_columns[num_columns] = {};
+	size_type m_capacity = 0;
+	size_type m_size = 0;
+};
+
+} // namespace cz
@@ -0,0 +1,191 @@
+/**
+Building blocks to give a wrapper type (optional, variant) the same copy/move semantics as the types it holds.
+
+If all held types are trivially copyable, the wrapper should also be trivially copyable, so it can be passed in
+registers and copied with memcpy. That requires the special members to be defaulted, which can't be done
+conditionally in a single class, so each special member gets its own layer, picked depending on the held types:
+	- trivial: The layer is skipped, and the compiler generated (trivial) version is used
+	- nontrivial: Implemented by calling into the storage
+	- deleted: The held types don't support the operation
+
+The storage (Base) needs to provide:
+	void _constructFrom(const Base& other);
+	void _constructFrom(Base&& other);
+	void _assignFrom(const Base& other);
+	void _assignFrom(Base&& other);
+And its default constructor needs to leave it in an empty state, ready for _constructFrom.
+The destructor is not handled here, since the storage itself needs to be specialized for that.
+*/
+
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+namespace cz
+{
+
+namespace detail
+{
+	enum class special_member_mode
+	{
+		trivial,
+		nontrivial,
+		deleted
+	};
+
+	template<bool Trivial, bool Supported>
+	inline constexpr special_member_mode special_member_mode_v =
+		Trivial ? special_member_mode::trivial
+				: (Supported ? special_member_mode::nontrivial : special_member_mode::deleted);
+
+	//
+	// Copy constructor
+	//
+	template<typename Base, special_member_mode Mode>
+	struct copy_ctor_layer : Base
+	{
+		using Base::Base;
+		copy_ctor_layer() = default;
+		copy_ctor_layer(const copy_ctor_layer& other)
+			: Base()
+		{
+			this->_constructFrom(static_cast<const Base&>(other));
+		}
+		copy_ctor_layer(copy_ctor_layer&&) = default;
+		copy_ctor_layer& operator=(const copy_ctor_layer&) = default;
+		copy_ctor_layer& operator=(copy_ctor_layer&&) = default;
+	};
+
+	template<typename Base>
+	struct copy_ctor_layer<Base, special_member_mode::deleted> : Base
+	{
+		using Base::Base;
+		copy_ctor_layer() = default;
+		copy_ctor_layer(const copy_ctor_layer&) = delete;
+		copy_ctor_layer(copy_ctor_layer&&) = default;
+		copy_ctor_layer& operator=(const copy_ctor_layer&) = default;
+		copy_ctor_layer& operator=(copy_ctor_layer&&) = default;
+	};
+
+	//
+	// Move constructor
+	//
+	template<typename Base, special_member_mode Mode>
+	struct move_ctor_layer : Base
+	{
+		using Base::Base;
+		move_ctor_layer() = default;
+		move_ctor_layer(const move_ctor_layer&) = default;
+		move_ctor_layer(move_ctor_layer&& other)
+			: Base()
+		{
+			this->_constructFrom(static_cast<Base&&>(other));
+		}
+		move_ctor_layer& operator=(const move_ctor_layer&) = default;
+		move_ctor_layer& operator=(move_ctor_layer&&) = default;
+	};
+
+	template<typename Base>
+	struct move_ctor_layer<Base, special_member_mode::deleted> : Base
+	{
+		using Base::Base;
+		move_ctor_layer() = default;
+		move_ctor_layer(const move_ctor_layer&) = default;
+		move_ctor_layer(move_ctor_layer&&) = delete;
+		move_ctor_layer& operator=(const move_ctor_layer&) = default;
+		move_ctor_layer& operator=(move_ctor_layer&&) = default;
+	};
+
+	//
+	// Copy assignment
+	//
+	template<typename Base, special_member_mode Mode>
+	struct copy_assign_layer : Base
+	{
+		using Base::Base;
+		copy_assign_layer() = default;
+		copy_assign_layer(const copy_assign_layer&) = default;
+		copy_assign_layer(copy_assign_layer&&) = default;
+		copy_assign_layer& operator=(const copy_assign_layer& other)
+		{
+			this->_assignFrom(static_cast<const Base&>(other));
+			return *this;
+		}
+		copy_assign_layer& operator=(copy_assign_layer&&) = default;
+	};
+
+	template<typename Base>
+	struct copy_assign_layer<Base, special_member_mode::deleted> : Base
+	{
+		using Base::Base;
+		copy_assign_layer() = default;
+		copy_assign_layer(const copy_assign_layer&) = default;
+		copy_assign_layer(copy_assign_layer&&) = default;
+		copy_assign_layer& operator=(const copy_assign_layer&) = delete;
+		copy_assign_layer& operator=(copy_assign_layer&&) = default;
+	};
+
+	//
+	// Move assignment
+	//
+	template<typename Base, special_member_mode Mode>
+	struct move_assign_layer : Base
+	{
+		using Base::Base;
+		move_assign_layer() = default;
+		move_assign_layer(const move_assign_layer&) = default;
+		move_assign_layer(move_assign_layer&&) = default;
+		move_assign_layer& operator=(const move_assign_layer&) = default;
+		move_assign_layer& operator=(move_assign_layer&& other)
+		{
+			this->_assignFrom(static_cast<Base&&>(other));
+			return *this;
+		}
+	};
+
+	template<typename Base>
+	struct move_assign_layer<Base, special_member_mode::deleted> : Base
+	{
+		using Base::Base;
+		move_assign_layer() = default;
+		move_assign_layer(const move_assign_layer&) = default;
+		move_assign_layer(move_assign_layer&&) = default;
+		move_assign_layer& operator=(const move_assign_layer&) = default;
+		move_assign_layer& operator=(move_assign_layer&&) = delete;
+	};
+
+	template<typename Base, special_member_mode Mode>
+	using select_copy_ctor = std::conditional_t<Mode == special_member_mode::trivial, Base, copy_ctor_layer<Base, Mode>>;
+	template<typename Base, special_member_mode Mode>
+	using select_move_ctor = std::conditional_t<Mode == special_member_mode::trivial, Base, move_ctor_layer<Base, Mode>>;
+	template<typename Base, special_member_mode Mode>
+	using select_copy_assign = std::conditional_t<Mode == special_member_mode::trivial, Base, copy_assign_layer<Base, Mode>>;
+	template<typename Base, special_member_mode Mode>
+	using select_move_assign = std::conditional_t<Mode == special_member_mode::trivial, Base, move_assign_layer<Base, Mode>>;
+
+	/**
+	 * Stacks the layers on top of Base, according to the types held (Ts...)
+	 */
+	template<typename Base, typename... Ts>
+	using special_members_t =
+		select_move_assign<
+			select_copy_assign<
+				select_move_ctor<
+					select_copy_ctor<Base,
+						special_member_mode_v<
+							(std::is_trivially_copy_constructible_v<Ts> && ...),
+							(std::is_copy_constructible_v<Ts> && ...)>>,
+					special_member_mode_v<
+						(std::is_trivially_move_constructible_v<Ts> && ...),
+						(std::is_move_constructible_v<Ts> && ...)>>,
+				special_member_mode_v<
+					((std::is_trivially_copy_constructible_v<Ts> && std::is_trivially_copy_assignable_v<Ts> && std::is_trivially_destructible_v<Ts>) && ...),
+					((std::is_copy_constructible_v<Ts> && std::is_copy_assignable_v<Ts>) && ...)>>,
+			special_member_mode_v<
+				((std::is_trivially_move_constructible_v<Ts> && std::is_trivially_move_assignable_v<Ts> && std::is_trivially_destructible_v<Ts>) && ...),
+				((std::is_move_constructible_v<Ts> && std::is_move_assignable_v<Ts>) && ...)>>;
+
+} // namespace detail
+
+} // namespace cz
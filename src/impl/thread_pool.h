@@ -0,0 +1,672 @@
+/**
+Work-stealing thread pool, and fork-join parallel algorithms on top of it.
+
+Each participant (worker threads plus the thread that calls into the pool) has a Chase-Lev deque of tasks.
+A participant pushes and pops tasks at the bottom of its own deque (LIFO, so it works on the data it just touched),
+and when it runs out of work it steals from the top of someone else's deque (FIFO, so it takes the biggest pieces).
+
+Tasks are always waited on by whoever spawned them, so they live in the stack of the spawning function, and no
+allocations are needed to schedule work. While waiting, a participant keeps executing other tasks.
+
+Only needs pthreads.
+
+The parallel algorithms use default_thread_pool() unless a pool is given. It is created on first use and lives until
+exit, unless released earlier with shutdown_default_thread_pool().
+	- parallel_for(first, last, grain, fn): Calls fn(subFirst, subLast) for chunks of at most grain elements.
+	- parallel_reduce(first, last, grain, init, reduceFn, combineFn): reduceFn(subFirst, subLast) reduces a chunk, and
+	  combineFn(a, b) combines results. Chunks are always split and combined the same way for the same grain, so
+	  the result is deterministic even if combineFn is not commutative.
+	- parallel_sort(first, last, comp)
+
+first/last can be random access iterators or integers.
+
+bench/thread_pool_bench.cpp measures how sort, transform and reduce workloads scale from 1 thread to all the cores.
+*/
+
+#pragma once
+
+#include "vector.h"
+#include "optional.h"
+#include <algorithm>
+#include <pthread.h>
+#include <unistd.h>
+
+#define CZ_THREAD_POOL_ASSERT(x) assert(x)
+
+namespace cz
+{
+
+class thread_pool;
+
+namespace detail
+{
+	struct pool_task
+	{
+		void (*execute)(pool_task* task) = nullptr;
+		int done = 0;
+
+		bool _isDone() const
+		{
+			return __atomic_load_n(&done, __ATOMIC_ACQUIRE) != 0;
+		}
+
+		void _run()
+		{
+			execute(this);
+			__atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+		}
+	};
+
+	/**
+	 * Chase-Lev work-stealing deque, as described in "Correct and Efficient Work-Stealing for Weak Memory Models"
+	 * (Le, Pop, Cohen, Zappa Nardelli).
+	 * Fixed capacity. If full, push fails and the owner should run the task itself.
+	 */
+	class work_stealing_deque
+	{
+	public:
+		static constexpr ptrdiff_t capacity = 1024;
+
+		// Owner only
+		bool push(pool_task* task)
+		{
+			const ptrdiff_t b = __atomic_load_n(&m_bottom, __ATOMIC_RELAXED);
+			const ptrdiff_t t = __atomic_load_n(&m_top, __ATOMIC_ACQUIRE);
+			if (b - t >= capacity)
+			{
+				return false;
+			}
+			__atomic_store_n(&m_tasks[b & (capacity - 1)], task, __ATOMIC_RELAXED);
+			// Release store instead of the paper's fence + relaxed store. Same cost on most cpus, and sanitizers
+			// understand it.
+			__atomic_store_n(&m_bottom, b + 1, __ATOMIC_RELEASE);
+			return true;
+		}
+
+		// Owner only
+		pool_task* pop()
+		{
+			const ptrdiff_t b = __atomic_load_n(&m_bottom, __ATOMIC_RELAXED) - 1;
+			__atomic_store_n(&m_bottom, b, __ATOMIC_RELAXED);
+			__atomic_thread_fence(__ATOMIC_SEQ_CST);
+			ptrdiff_t t = __atomic_load_n(&m_top, __ATOMIC_RELAXED);
+
+			pool_task* task = nullptr;
+			if (t <= b)
+			{
+				task = __atomic_load_n(&m_tasks[b & (capacity - 1)], __ATOMIC_RELAXED);
+				if (t == b)
+				{
+					// Last element, so race against thieves
+					if (!__atomic_compare_exchange_n(&m_top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+					{
+						task = nullptr;
+					}
+					__atomic_store_n(&m_bottom, b + 1, __ATOMIC_RELAXED);
+				}
+			}
+			else
+			{
+				__atomic_store_n(&m_bottom, b + 1, __ATOMIC_RELAXED);
+			}
+			return task;
+		}
+
+		// Any thread
+		pool_task* steal()
+		{
+			ptrdiff_t t = __atomic_load_n(&m_top, __ATOMIC_ACQUIRE);
+			__atomic_thread_fence(__ATOMIC_SEQ_CST);
+			const ptrdiff_t b = __atomic_load_n(&m_bottom, __ATOMIC_ACQUIRE);
+			if (t < b)
+			{
+				pool_task* task = __atomic_load_n(&m_tasks[t & (capacity - 1)], __ATOMIC_RELAXED);
+				if (__atomic_compare_exchange_n(&m_top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+				{
+					return task;
+				}
+			}
+			return nullptr;
+		}
+
+		bool empty() const
+		{
+			return __atomic_load_n(&m_bottom, __ATOMIC_SEQ_CST) <= __atomic_load_n(&m_top, __ATOMIC_SEQ_CST);
+		}
+
+	private:
+		// Padded, so the owner and thieves don't fight over the same cache line.
+		// Padding instead of alignas, so it doesn't require aligned new.
+		char m_padding0[64];
+		ptrdiff_t m_top = 0;
+		char m_padding1[64 - sizeof(ptrdiff_t)];
+		ptrdiff_t m_bottom = 0;
+		char m_padding2[64 - sizeof(ptrdiff_t)];
+		pool_task* m_tasks[capacity] = {};
+	};
+
+	struct pool_worker
+	{
+		thread_pool* pool = nullptr;
+		size_t index = 0;
+		pthread_t thread;
+		// False if the thread couldn't be created (and always for worker 0, which has no thread of its own)
+		bool started = false;
+		work_stealing_deque deque;
+		// State for picking steal victims
+		uint32_t rng = 0;
+	};
+
+	// Worker the current thread is acting as, if any
+	inline thread_local pool_worker* tl_poolWorker = nullptr;
+
+} // namespace detail
+
+class thread_pool
+{
+public:
+	using size_type = std::size_t;
+
+	/**
+	 * concurrency is the total number of threads that execute tasks, including the thread calling the parallel
+	 * algorithms, so concurrency-1 threads are created. 0 uses the number of online cpus.
+	 */
+	explicit thread_pool(size_type concurrency = 0)
+	{
+		if (concurrency == 0)
+		{
+			const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+			concurrency = cpus > 0 ? static_cast<size_type>(cpus) : 1;
+		}
+
+		pthread_mutex_init(&m_mutex, nullptr);
+		pthread_mutex_init(&m_externalMutex, nullptr);
+		pthread_cond_init(&m_cond, nullptr);
+
+		m_workers.reserve(concurrency);
+		for (size_type i = 0; i < concurrency; ++i)
+		{
+			m_workers.emplace_back(new detail::pool_worker());
+			m_workers[i]->pool = this;
+			m_workers[i]->index = i;
+			m_workers[i]->rng = static_cast<uint32_t>(i * 2654435761u + 1);
+		}
+
+		// Worker 0 is used by external threads calling into the pool.
+		// If a thread can't be created, its worker stays idle with an empty deque, and the others (or the thread
+		// waiting on the tasks) do the work.
+		for (size_type i = 1; i < concurrency; ++i)
+		{
+			m_workers[i]->started = pthread_create(&m_workers[i]->thread, nullptr, &thread_pool::_threadEntry, m_workers[i]) == 0;
+		}
+	}
+
+	thread_pool(const thread_pool&) = delete;
+	thread_pool& operator=(const thread_pool&) = delete;
+
+	~thread_pool()
+	{
+		pthread_mutex_lock(&m_mutex);
+		__atomic_store_n(&m_quit, true, __ATOMIC_SEQ_CST);
+		++m_wakeEpoch;
+		pthread_cond_broadcast(&m_cond);
+		pthread_mutex_unlock(&m_mutex);
+
+		for (detail::pool_worker* worker : m_workers)
+		{
+			if (worker->started)
+			{
+				pthread_join(worker->thread, nullptr);
+			}
+		}
+		for (detail::pool_worker* worker : m_workers)
+		{
+			delete worker;
+		}
+
+		pthread_cond_destroy(&m_cond);
+		pthread_mutex_destroy(&m_externalMutex);
+		pthread_mutex_destroy(&m_mutex);
+	}
+
+	size_type concurrency() const
+	{
+		return m_workers.size();
+	}
+
+	/**
+	 * Runs fn() with the calling thread acting as a participant of this pool, which is required to spawn and wait for
+	 * tasks. If the thread is already a participant, it just calls fn. Otherwise, external threads are serialized.
+	 */
+	template<typename F>
+	void run(F&& fn)
+	{
+		if (detail::tl_poolWorker && detail::tl_poolWorker->pool == this)
+		{
+			fn();
+			return;
+		}
+
+		pthread_mutex_lock(&m_externalMutex);
+		detail::pool_worker* previous = detail::tl_poolWorker;
+		detail::tl_poolWorker = m_workers[0];
+		fn();
+		detail::tl_poolWorker = previous;
+		pthread_mutex_unlock(&m_externalMutex);
+	}
+
+	/**
+	 * Makes the task available to other participants. Needs to be called from inside run, and the task needs to
+	 * be waited on with wait before it goes out of scope.
+	 */
+	void spawn(detail::pool_task& task)
+	{
+		detail::pool_worker* self = _self();
+		if (m_workers.size() == 1 || !self->deque.push(&task))
+		{
+			task._run();
+			return;
+		}
+
+		// The push is a store and m_sleepers a load of a different variable, so without a full fence the load could be
+		// done before the task is visible. A worker could then go to sleep without seeing the task, while we don't see
+		// the worker. Pairs with the fence in _workerLoop.
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&m_sleepers, __ATOMIC_SEQ_CST))
+		{
+			pthread_mutex_lock(&m_mutex);
+			++m_wakeEpoch;
+			pthread_cond_signal(&m_cond);
+			pthread_mutex_unlock(&m_mutex);
+		}
+	}
+
+	// Waits for the task to finish, executing other tasks meanwhile
+	void wait(detail::pool_task& task)
+	{
+		detail::pool_worker* self = _self();
+		while (!task._isDone())
+		{
+			if (detail::pool_task* other = self->deque.pop())
+			{
+				other->_run();
+			}
+			else if (detail::pool_task* stolen = _stealFromOthers(self))
+			{
+				stolen->_run();
+			}
+			else
+			{
+				_pause();
+			}
+		}
+	}
+
+private:
+
+	detail::pool_worker* _self()
+	{
+		CZ_THREAD_POOL_ASSERT(detail::tl_poolWorker && detail::tl_poolWorker->pool == this);
+		return detail::tl_poolWorker;
+	}
+
+	static void _pause()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#endif
+	}
+
+	detail::pool_task* _stealFromOthers(detail::pool_worker* self)
+	{
+		const size_type count = m_workers.size();
+		// xorshift, to pick a random starting victim
+		self->rng ^= self->rng << 13;
+		self->rng ^= self->rng >> 17;
+		self->rng ^= self->rng << 5;
+		const size_type start = self->rng % count;
+		for (size_type i = 0; i < count; ++i)
+		{
+			detail::pool_worker* victim = m_workers[(start + i) % count];
+			if (victim != self)
+			{
+				if (detail::pool_task* task = victim->deque.steal())
+				{
+					return task;
+				}
+			}
+		}
+		return nullptr;
+	}
+
+	bool _anyWork() const
+	{
+		for (detail::pool_worker* worker : m_workers)
+		{
+			if (!worker->deque.empty())
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static void* _threadEntry(void* arg)
+	{
+		detail::pool_worker* self = static_cast<detail::pool_worker*>(arg);
+		detail::tl_poolWorker = self;
+		self->pool->_workerLoop(self);
+		return nullptr;
+	}
+
+	void _workerLoop(detail::pool_worker* self)
+	{
+		constexpr int spinsBeforeSleep = 2000;
+		int spins = 0;
+		while (!__atomic_load_n(&m_quit, __ATOMIC_ACQUIRE))
+		{
+			// Workers only run stolen tasks here. Tasks they spawn are popped from their own deque in wait
+			if (detail::pool_task* task = _stealFromOthers(self))
+			{
+				task->_run();
+				spins = 0;
+				continue;
+			}
+
+			if (++spins < spinsBeforeSleep)
+			{
+				_pause();
+				continue;
+			}
+			spins = 0;
+
+			// Announce we are going to sleep before checking for work, so spawn sees us, or we see its task
+			pthread_mutex_lock(&m_mutex);
+			const unsigned epoch = m_wakeEpoch;
+			__atomic_fetch_add(&m_sleepers, 1, __ATOMIC_SEQ_CST);
+			pthread_mutex_unlock(&m_mutex);
+			// Pairs with the fence in spawn, so either spawn sees m_sleepers, or _anyWork sees the task
+			__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+			if (!_anyWork())
+			{
+				pthread_mutex_lock(&m_mutex);
+				while (epoch == m_wakeEpoch && !__atomic_load_n(&m_quit, __ATOMIC_ACQUIRE))
+				{
+					pthread_cond_wait(&m_cond, &m_mutex);
+				}
+				pthread_mutex_unlock(&m_mutex);
+			}
+			__atomic_fetch_sub(&m_sleepers, 1, __ATOMIC_SEQ_CST);
+		}
+	}
+
+	vector<detail::pool_worker*> m_workers;
+	pthread_mutex_t m_mutex;
+	pthread_mutex_t m_externalMutex;
+	pthread_cond_t m_cond;
+	unsigned m_wakeEpoch = 0;
+	int m_sleepers = 0;
+	bool m_quit = false;
+};
+
+namespace detail
+{
+	// Set with set_default_thread_pool
+	inline thread_pool* g_defaultThreadPool = nullptr;
+
+	// The built-in default pool. Created on first use, and destroyed at exit or with shutdown_default_thread_pool
+	struct builtin_thread_pool
+	{
+		thread_pool* pool = nullptr;
+		pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+		~builtin_thread_pool()
+		{
+			delete pool;
+		}
+	};
+	inline builtin_thread_pool g_builtinThreadPool;
+}
+
+/**
+ * Pool used by the parallel algorithms when none is given. Created on first use, with one thread per cpu.
+ * It keeps its threads and memory (allocated through the vector and global new allocators) until exit, or until
+ * shutdown_default_thread_pool is called.
+ */
+inline thread_pool& default_thread_pool()
+{
+	if (detail::g_defaultThreadPool)
+	{
+		return *detail::g_defaultThreadPool;
+	}
+
+	detail::builtin_thread_pool& builtin = detail::g_builtinThreadPool;
+	thread_pool* pool = __atomic_load_n(&builtin.pool, __ATOMIC_ACQUIRE);
+	if (!pool)
+	{
+		pthread_mutex_lock(&builtin.mutex);
+		pool = builtin.pool;
+		if (!pool)
+		{
+			pool = new thread_pool();
+			__atomic_store_n(&builtin.pool, pool, __ATOMIC_RELEASE);
+		}
+		pthread_mutex_unlock(&builtin.mutex);
+	}
+	return *pool;
+}
+
+// Makes the parallel algorithms use the given pool by default, or go back to the built-in one if nullptr
+inline void set_default_thread_pool(thread_pool* pool)
+{
+	detail::g_defaultThreadPool = pool;
+}
+
+/**
+ * Destroys the built-in default pool, if it was created, joining its threads and freeing its memory (e.g: before
+ * checking for leaks, or before changing the allocator backends). It is created again if used afterwards.
+ * Nothing can be using the pool while this is called.
+ */
+inline void shutdown_default_thread_pool()
+{
+	detail::builtin_thread_pool& builtin = detail::g_builtinThreadPool;
+	pthread_mutex_lock(&builtin.mutex);
+	thread_pool* pool = builtin.pool;
+	__atomic_store_n(&builtin.pool, nullptr, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&builtin.mutex);
+	delete pool;
+}
+
+//
+// Parallel algorithms
+//
+namespace detail
+{
+	// Calls fn for chunks of [first, last)
+	template<typename It, typename F>
+	void parallel_for_impl(thread_pool& pool, It first, It last, size_t grain, F& fn)
+	{
+		if (static_cast<size_t>(last - first) <= grain)
+		{
+			if (first != last)
+			{
+				fn(first, last);
+			}
+			return;
+		}
+
+		struct task_type : pool_task
+		{
+			thread_pool* pool;
+			It first;
+			It last;
+			size_t grain;
+			F* fn;
+		} right;
+
+		It mid = first + (last - first) / 2;
+		right.execute = [](pool_task* t)
+		{
+			task_type* self = static_cast<task_type*>(t);
+			parallel_for_impl(*self->pool, self->first, self->last, self->grain, *self->fn);
+		};
+		right.pool = &pool;
+		right.first = mid;
+		right.last = last;
+		right.grain = grain;
+		right.fn = &fn;
+		pool.spawn(right);
+
+		parallel_for_impl(pool, first, mid, grain, fn);
+		pool.wait(right);
+	}
+
+	template<typename T, typename It, typename ReduceFn, typename CombineFn>
+	T parallel_reduce_impl(thread_pool& pool, It first, It last, size_t grain, ReduceFn& reduceFn, CombineFn& combineFn)
+	{
+		if (static_cast<size_t>(last - first) <= grain)
+		{
+			return reduceFn(first, last);
+		}
+
+		struct task_type : pool_task
+		{
+			thread_pool* pool;
+			It first;
+			It last;
+			size_t grain;
+			ReduceFn* reduceFn;
+			CombineFn* combineFn;
+			optional<T> result;
+		} right;
+
+		It mid = first + (last - first) / 2;
+		right.execute = [](pool_task* t)
+		{
+			task_type* self = static_cast<task_type*>(t);
+			self->result.emplace(parallel_reduce_impl<T>(*self->pool, self->first, self->last, self->grain, *self->reduceFn, *self->combineFn));
+		};
+		right.pool = &pool;
+		right.first = mid;
+		right.last = last;
+		right.grain = grain;
+		right.reduceFn = &reduceFn;
+		right.combineFn = &combineFn;
+		pool.spawn(right);
+
+		T left = parallel_reduce_impl<T>(pool, first, mid, grain, reduceFn, combineFn);
+		pool.wait(right);
+		return combineFn(std::move(left), std::move(*right.result));
+	}
+
+	// Like std::sort, falls back to a sequential introsort if partitioning goes badly for too long
+	template<typename It, typename Compare>
+	void parallel_sort_impl(thread_pool& pool, It first, It last, size_t grain, size_t depthLimit, Compare& comp)
+	{
+		if (static_cast<size_t>(last - first) <= grain || depthLimit == 0)
+		{
+			std::detail::sort(first, last, comp);
+			return;
+		}
+
+		It pivot = std::detail::sort_partition(first, last, comp);
+
+		struct task_type : pool_task
+		{
+			thread_pool* pool;
+			It first;
+			It last;
+			size_t grain;
+			size_t depthLimit;
+			Compare* comp;
+		} right;
+
+		right.execute = [](pool_task* t)
+		{
+			task_type* self = static_cast<task_type*>(t);
+			parallel_sort_impl(*self->pool, self->first, self->last, self->grain, self->depthLimit, *self->comp);
+		};
+		right.pool = &pool;
+		right.first = pivot + 1;
+		right.last = last;
+		right.grain = grain;
+		right.depthLimit = depthLimit - 1;
+		right.comp = &comp;
+		pool.spawn(right);
+
+		parallel_sort_impl(pool, first, pivot, grain, depthLimit - 1, comp);
+		pool.wait(right);
+	}
+
+} // namespace detail
+
+template<typename It, typename F>
+void parallel_for(thread_pool& pool, It first, It last, size_t grain, F&& fn)
+{
+	CZ_THREAD_POOL_ASSERT(grain > 0);
+	pool.run([&]()
+	{
+		detail::parallel_for_impl(pool, first, last, grain, fn);
+	});
+}
+
+template<typename It, typename F>
+void parallel_for(It first, It last, size_t grain, F&& fn)
+{
+	parallel_for(default_thread_pool(), first, last, grain, std::forward<F>(fn));
+}
+
+template<typename It, typename T, typename ReduceFn, typename CombineFn>
+T parallel_reduce(thread_pool& pool, It first, It last, size_t grain, T init, ReduceFn&& reduceFn, CombineFn&& combineFn)
+{
+	CZ_THREAD_POOL_ASSERT(grain > 0);
+	if (first == last)
+	{
+		return init;
+	}
+
+	optional<T> result;
+	pool.run([&]()
+	{
+		result.emplace(detail::parallel_reduce_impl<T>(pool, first, last, grain, reduceFn, combineFn));
+	});
+	return combineFn(std::move(init), std::move(*result));
+}
+
+template<typename It, typename T, typename ReduceFn, typename CombineFn>
+T parallel_reduce(It first, It last, size_t grain, T init, ReduceFn&& reduceFn, CombineFn&& combineFn)
+{
+	return parallel_reduce(default_thread_pool(), first, last, grain, std::move(init),
+		std::forward<ReduceFn>(reduceFn), std::forward<CombineFn>(combineFn));
+}
+
+// Ranges smaller than grain are sorted sequentially
+template<typename It, typename Compare>
+void parallel_sort(thread_pool& pool, It first, It last, Compare comp, size_t grain = 4096)
+{
+	CZ_THREAD_POOL_ASSERT(grain > std::detail::sort_insertion_threshold);
+	size_t depthLimit = 0;
+	for (size_t n = static_cast<size_t>(last - first); n > 1; n >>= 1)
+	{
+		depthLimit += 2;
+	}
+	pool.run([&]()
+	{
+		detail::parallel_sort_impl(pool, first, last, grain, depthLimit, comp);
+	});
+}
+
+template<typename It, typename Compare>
+void parallel_sort(It first, It last, Compare comp)
+{
+	parallel_sort(default_thread_pool(), first, last, comp);
+}
+
+template<typename It>
+void parallel_sort(It first, It last)
+{
+	parallel_sort(default_thread_pool(), first, last, std::less<>());
+}
+
+} // namespace cz
@@ -0,0 +1,375 @@
+/**
+Hierarchical timing wheel, for large numbers of timers.
+
+Time is in ticks, and only moves forward with advance/advance_to. Each level is a ring of 2^SlotBits slots, each slot
+being a list of timers. Level 0 slots are 1 tick apart, level 1 slots are 2^SlotBits ticks apart, and so on.
+A timer is put in the lowest level that covers its expiry time, and when time reaches the start of a higher level
+slot, that slot's timers are moved down (cascaded) to lower levels, until they end up in level 0 and expire.
+Timers further away than the last level can cover wait in the last level, and get placed again when it cascades.
+
+	- schedule is O(1)
+	- cancel is O(1), through the handle schedule returns. Handles are index + generation, so a handle to a timer that
+	  already expired or was cancelled is detected, instead of cancelling whatever timer reused the node.
+	- advance is O(ticks with something to do + expired timers + cascaded timers). Empty ticks are skipped with a
+	  bitmap per level, which gives the next occupied slot of each level, so large jumps are cheap even if the
+	  wheel is empty.
+
+Timers live in a node pool with a fixed capacity, allocated once at construction, so scheduling never allocates.
+schedule returns an invalid handle if the pool is exhausted.
+Callbacks are cz::inplace_function<void()>, with a configurable capacity. They can schedule and cancel timers.
+
+Not thread safe.
+
+Example:
+	cz::timer_wheel<> wheel(1000);
+	cz::timer_handle h = wheel.schedule(10, [] { ... });
+	wheel.cancel(h);
+	wheel.advance(1); // From a periodic tick interrupt/loop
+*/
+
+#pragma once
+
+#include <cstdint>
+#include "vector.h"
+#include "intrusive.h"
+#include "inplace_function.h"
+
+#define CZ_TIMER_WHEEL_ASSERT(x) assert(x)
+
+namespace cz
+{
+
+struct timer_handle
+{
+	static constexpr uint32_t invalid_index = 0xFFFFFFFF;
+
+	uint32_t index = invalid_index;
+	uint32_t generation = 0;
+
+	bool is_valid() const
+	{
+		return index != invalid_index;
+	}
+};
+
+template<size_t CallbackCapacity = 4 * sizeof(void*), unsigned Levels = 4, unsigned SlotBits = 6>
+class timer_wheel
+{
+public:
+	using size_type = std::size_t;
+	using tick_type = uint64_t;
+	using callback_type = inplace_function<void(), CallbackCapacity>;
+
+	static constexpr unsigned slot_count = 1u << SlotBits;
+
+	static_assert(SlotBits > 0 && SlotBits <= 6, "Slot occupancy needs to fit a 64 bits mask");
+	static_assert(Levels > 0 && Levels * SlotBits < 64, "");
+
+private:
+
+	static constexpr tick_type ms_slotMask = slot_count - 1;
+	// Biggest delay the levels can cover
+	static constexpr tick_type ms_maxDelay = (tick_type(1) << (Levels * SlotBits)) - 1;
+	// Slot index for timers that are currently running their callback
+	static constexpr uint32_t ms_firing = 0xFFFFFFFF;
+	// Slot index for nodes in the free list
+	static constexpr uint32_t ms_unused = 0xFFFFFFFE;
+
+	struct node
+	{
+		intrusive_list_hook hook;
+		callback_type callback;
+		tick_type expiry = 0;
+		uint32_t generation = 0;
+		// Index into m_slots, or ms_firing/ms_unused
+		uint32_t slot = ms_unused;
+	};
+
+	using list_type = intrusive_list<node, &node::hook>;
+
+public:
+
+	explicit timer_wheel(size_type capacity, tick_type now = 0)
+		: m_nodes(capacity)
+		, m_now(now)
+	{
+		CZ_TIMER_WHEEL_ASSERT(capacity < timer_handle::invalid_index);
+		for (node& n : m_nodes)
+		{
+			m_free.push_back(n);
+		}
+	}
+
+	// Nodes are linked to each other, so the wheel can't be copied or moved
+	timer_wheel(const timer_wheel&) = delete;
+	timer_wheel& operator=(const timer_wheel&) = delete;
+
+	~timer_wheel()
+	{
+		// Unlink everything before the nodes are destroyed
+		for (list_type& l : m_slots)
+		{
+			l.clear();
+		}
+		m_free.clear();
+	}
+
+	tick_type now() const
+	{
+		return m_now;
+	}
+
+	size_type capacity() const
+	{
+		return m_nodes.size();
+	}
+
+	// How many timers are scheduled
+	size_type size() const
+	{
+		return m_size;
+	}
+
+	bool empty() const
+	{
+		return m_size == 0;
+	}
+
+	/**
+	 * Calls callback in delay ticks. A delay of 0 is treated as 1, since the current tick was already processed.
+	 * Returns an invalid handle if there are no free nodes.
+	 */
+	template<typename F>
+	timer_handle schedule(tick_type delay, F&& callback)
+	{
+		return schedule_at(m_now + (delay ? delay : 1), std::forward<F>(callback));
+	}
+
+	/**
+	 * Calls callback when time reaches expiry. Times in the past are treated as the next tick.
+	 */
+	template<typename F>
+	timer_handle schedule_at(tick_type expiry, F&& callback)
+	{
+		if (m_free.empty())
+		{
+			return timer_handle();
+		}
+
+		node& n = m_free.front();
+		m_free.pop_front();
+		n.callback = std::forward<F>(callback);
+		n.expiry = expiry > m_now ? expiry : m_now + 1;
+		_insert(n);
+		++m_size;
+
+		timer_handle h;
+		h.index = static_cast<uint32_t>(&n - m_nodes.data());
+		h.generation = n.generation;
+		return h;
+	}
+
+	/**
+	 * Returns false if the timer already expired (or is running its callback), or was already cancelled.
+	 */
+	bool cancel(timer_handle h)
+	{
+		node* n = _find(h);
+		if (!n)
+		{
+			return false;
+		}
+
+		_removeFromSlot(*n);
+		_release(*n);
+		--m_size;
+		return true;
+	}
+
+	bool is_pending(timer_handle h) const
+	{
+		return _find(h) != nullptr;
+	}
+
+	// Ticks left until the timer expires, or 0 if the handle is not pending
+	tick_type remaining(timer_handle h) const
+	{
+		const node* n = _find(h);
+		return n ? n->expiry - m_now : 0;
+	}
+
+	/**
+	 * Moves time forward, calling the callbacks of all timers that expire, in expiry order. Timers that expire on the
+	 * same tick are called together as a batch, in no particular order.
+	 * Returns how many callbacks were called.
+	 */
+	size_type advance(tick_type ticks)
+	{
+		return advance_to(m_now + ticks);
+	}
+
+	size_type advance_to(tick_type target)
+	{
+		size_type fired = 0;
+		while (m_now < target)
+		{
+			// Skip straight to the next tick with something to do
+			const tick_type next = _nextEvent();
+			if (next > target)
+			{
+				m_now = target;
+				break;
+			}
+
+			m_now = next;
+			fired += _tick();
+		}
+		return fired;
+	}
+
+private:
+
+	// Puts the timer in the level and slot for its expiry, given the current time
+	void _insert(node& n)
+	{
+		const tick_type delay = n.expiry - m_now;
+		// For timers beyond what the wheel covers, use the furthest slot. It gets placed again when it cascades.
+		const tick_type expiry = delay > ms_maxDelay ? m_now + ms_maxDelay : n.expiry;
+		const tick_type clampedDelay = expiry - m_now;
+
+		unsigned level = 0;
+		while (level + 1 < Levels && clampedDelay >= (tick_type(1) << ((level + 1) * SlotBits)))
+		{
+			++level;
+		}
+
+		const unsigned slot = static_cast<unsigned>((expiry >> (level * SlotBits)) & ms_slotMask);
+		n.slot = level * slot_count + slot;
+		m_slots[n.slot].push_back(n);
+		m_occupied[level] |= uint64_t(1) << slot;
+	}
+
+	void _removeFromSlot(node& n)
+	{
+		list_type& l = m_slots[n.slot];
+		l.remove(n);
+		if (l.empty())
+		{
+			m_occupied[n.slot / slot_count] &= ~(uint64_t(1) << (n.slot % slot_count));
+		}
+	}
+
+	void _release(node& n)
+	{
+		n.callback = nullptr;
+		n.slot = ms_unused;
+		++n.generation;
+		m_free.push_front(n);
+	}
+
+	// Returns the node if the handle refers to a scheduled timer
+	node* _find(timer_handle h) const
+	{
+		if (h.index >= m_nodes.size())
+		{
+			return nullptr;
+		}
+		node& n = const_cast<node&>(m_nodes[h.index]);
+		return (n.generation == h.generation && n.slot < Levels * slot_count) ? &n : nullptr;
+	}
+
+	// Slots the next occupied slot of a level is away from the current one (1 to slot_count), or 0 if the level is
+	// empty. The current slot itself counts as a whole ring away, since it was already processed.
+	static unsigned _nextOccupied(uint64_t occupied, unsigned current)
+	{
+		const uint64_t after = current == ms_slotMask ? 0 : occupied >> (current + 1);
+		if (after)
+		{
+			return 1 + __builtin_ctzll(after);
+		}
+		const uint64_t upToCurrent = occupied & ((uint64_t(2) << current) - 1);
+		if (upToCurrent)
+		{
+			return slot_count - current + __builtin_ctzll(upToCurrent);
+		}
+		return 0;
+	}
+
+	/**
+	 * Next tick that expires a level 0 slot or cascades a non empty slot of a higher level, or the max tick if there
+	 * are no timers. Nothing happens in the ticks in between, so those can be skipped.
+	 */
+	tick_type _nextEvent() const
+	{
+		tick_type next = ~tick_type(0);
+		for (unsigned level = 0; level < Levels; ++level)
+		{
+			const tick_type levelNow = m_now >> (level * SlotBits);
+			const unsigned distance = _nextOccupied(m_occupied[level], static_cast<unsigned>(levelNow & ms_slotMask));
+			if (distance)
+			{
+				const tick_type t = (levelNow + distance) << (level * SlotBits);
+				next = t < next ? t : next;
+			}
+		}
+		return next;
+	}
+
+	// Processes m_now: cascades whatever levels start a new slot, then expires the level 0 slot
+	size_type _tick()
+	{
+		unsigned topLevel = 0;
+		while (topLevel + 1 < Levels && (m_now & ((tick_type(1) << ((topLevel + 1) * SlotBits)) - 1)) == 0)
+		{
+			++topLevel;
+		}
+		for (unsigned level = topLevel; level > 0; --level)
+		{
+			_cascade(level);
+		}
+
+		const unsigned slot = static_cast<unsigned>(m_now & ms_slotMask);
+		list_type& l = m_slots[slot];
+		size_type fired = 0;
+		// Popping one at a time, so callbacks can cancel timers in this same batch
+		while (!l.empty())
+		{
+			node& n = l.front();
+			l.pop_front();
+			if (l.empty())
+			{
+				m_occupied[0] &= ~(uint64_t(1) << slot);
+			}
+			CZ_TIMER_WHEEL_ASSERT(n.expiry == m_now);
+
+			n.slot = ms_firing;
+			--m_size;
+			n.callback();
+			_release(n);
+			++fired;
+		}
+		return fired;
+	}
+
+	void _cascade(unsigned level)
+	{
+		const unsigned slot = static_cast<unsigned>((m_now >> (level * SlotBits)) & ms_slotMask);
+		list_type& l = m_slots[level * slot_count + slot];
+		m_occupied[level] &= ~(uint64_t(1) << slot);
+		while (!l.empty())
+		{
+			node& n = l.front();
+			l.pop_front();
+			_insert(n);
+		}
+	}
+
+	vector<node> m_nodes;
+	list_type m_free;
+	list_type m_slots[Levels * slot_count];
+	uint64_t m_occupied[Levels] = {};
+	tick_type m_now;
+	size_type m_size = 0;
+};
+
+} // namespace cz
@@ -0,0 +1,610 @@
+/**
+Two-Level Segregated Fit allocator, over one or more memory regions provided by the caller.
+
+allocate and deallocate are O(1), with no loops that depend on how many blocks there are, so the worst case is
+bounded and close to the average. Meant for real-time code, where malloc's worst case (searching free lists,
+asking the system for more memory) isn't acceptable.
+
+Free blocks are kept in segregated lists, indexed by two levels:
+	- First level: power of 2 range of the size
+	- Second level: the range split linearly in 32 parts
+A bitmap per level tells which lists are non-empty, so finding a list with a big enough block is a couple of bit
+scans. Requests are rounded up to the next second level size before searching, so any block in the list found is
+big enough (good fit, not best fit). That bounds the waste per allocation to 1/32 of its size.
+Freed blocks are merged with their free neighbours right away, which keeps fragmentation low.
+
+Each block has a 2 pointers header. Regions can't be removed, and are never given back.
+Not thread safe.
+bench/tlsf_bench.cpp compares the latency distribution of allocate/deallocate against malloc.
+
+tlsf_backend allows using it as the global operator new backend, or the VectorAllocator backend. E.g:
+	static char gHeapMemory[64 * 1024];
+	static cz::tlsf gHeap(gHeapMemory, sizeof(gHeapMemory));
+	static cz::tlsf_backend gBackend(gHeap);
+	cz::detail::NewAllocator::_setBackend(gBackend.get());
+	cz::detail::VectorAllocator::_setBackend(gBackend.get());
+*/
+
+#pragma once
+
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <assert.h>
+
+#define CZ_TLSF_ASSERT(x) assert(x)
+
+namespace cz
+{
+
+struct tlsf_stats
+{
+	// Bytes that can be handed out, in all regions (doesn't include block headers)
+	size_t totalBytes;
+	// Bytes in allocated blocks. Can be a bit more than what was requested, due to rounding.
+	size_t usedBytes;
+	// Highest usedBytes since the allocator was created
+	size_t peakUsedBytes;
+	size_t freeBytes;
+	// Biggest allocation that can succeed, ignoring rounding
+	size_t largestFreeBlock;
+	size_t usedBlocks;
+	size_t freeBlocks;
+};
+
+namespace detail
+{
+	constexpr size_t tlsf_roundUp(size_t v, size_t align)
+	{
+		return (v + align - 1) & ~(align - 1);
+	}
+
+	constexpr unsigned tlsf_log2(size_t v)
+	{
+		return v > 1 ? 1 + tlsf_log2(v >> 1) : 0;
+	}
+}
+
+class tlsf
+{
+public:
+	using size_type = std::size_t;
+
+	// Alignment of all returned pointers. Needs at least 4, since the low 2 bits of a block's size are flags.
+	static constexpr size_type alignment = alignof(std::max_align_t) > 4 ? alignof(std::max_align_t) : 4;
+
+private:
+
+	struct block
+	{
+		// Block right before this one in memory, or nullptr if this is the first of its region
+		block* prevPhys;
+		// Size of the block's memory (not counting the header), and ms_freeBit/ms_prevFreeBit
+		size_type sizeAndFlags;
+		// Only used while the block is free. These are in the block's memory, after the header.
+		block* nextFree;
+		block* prevFree;
+	};
+
+	// Regions are linked together, with this at the start of each one
+	struct region
+	{
+		region* next;
+		size_type size;
+	};
+
+	static constexpr size_type ms_freeBit = 1;
+	static constexpr size_type ms_prevFreeBit = 2;
+	static constexpr size_type ms_flagsMask = ms_freeBit | ms_prevFreeBit;
+
+	static constexpr size_type ms_headerSize = detail::tlsf_roundUp(offsetof(block, nextFree), alignment);
+	static constexpr size_type ms_regionHeaderSize = detail::tlsf_roundUp(sizeof(region), alignment);
+	// Needs to fit the free list pointers
+	static constexpr size_type ms_minBlockSize =
+		sizeof(block) > ms_headerSize ? detail::tlsf_roundUp(sizeof(block) - ms_headerSize, alignment) : alignment;
+
+	static constexpr unsigned ms_slLog2 = 5;
+	static constexpr unsigned ms_slCount = 1u << ms_slLog2;
+	// Sizes below this all go in the first level, spaced by alignment
+	static constexpr unsigned ms_flShift = ms_slLog2 + detail::tlsf_log2(alignment);
+	static constexpr size_type ms_smallBlockSize = size_type(1) << ms_flShift;
+	// Biggest block is below 1 << ms_flMax
+	static constexpr unsigned ms_flMax = sizeof(size_type) >= 8 ? 38 : (sizeof(size_type) * 8 - 2);
+	static constexpr unsigned ms_flCount = ms_flMax - ms_flShift + 1;
+
+	static_assert((alignment & (alignment - 1)) == 0, "Alignment needs to be a power of 2");
+	static_assert(ms_flCount <= 32, "First level bitmap doesn't fit");
+
+public:
+	// Biggest size allocate can handle. Anything bigger fails.
+	static constexpr size_type max_allocation = size_type(1) << (ms_flMax - 1);
+
+	tlsf()
+	{
+	}
+
+	// Same as calling add_region
+	tlsf(void* memory, size_type bytes)
+	{
+		add_region(memory, bytes);
+	}
+
+	tlsf(const tlsf&) = delete;
+	tlsf& operator=(const tlsf&) = delete;
+
+	/**
+	 * Adds memory to the pool. It needs to stay valid for as long as the tlsf is used.
+	 * Returns false if it's too small to be used. Memory beyond what the biggest block can hold is ignored.
+	 */
+	bool add_region(void* memory, size_type bytes)
+	{
+		const uintptr_t start = detail::tlsf_roundUp(reinterpret_cast<uintptr_t>(memory), alignment);
+		const uintptr_t end = (reinterpret_cast<uintptr_t>(memory) + bytes) & ~static_cast<uintptr_t>(alignment - 1);
+		const size_type overhead = ms_regionHeaderSize + 2 * ms_headerSize;
+		if (end <= start || end - start < overhead + ms_minBlockSize)
+		{
+			return false;
+		}
+
+		size_type size = static_cast<size_type>(end - start) - overhead;
+		const size_type maxBlockSize = (size_type(1) << ms_flMax) - alignment;
+		if (size > maxBlockSize)
+		{
+			size = maxBlockSize;
+		}
+
+		region* r = reinterpret_cast<region*>(start);
+		r->next = m_regions;
+		r->size = ms_regionHeaderSize + 2 * ms_headerSize + size;
+		m_regions = r;
+
+		block* first = reinterpret_cast<block*>(start + ms_regionHeaderSize);
+		first->prevPhys = nullptr;
+		first->sizeAndFlags = size | ms_freeBit;
+
+		// Zero sized block that is always used, so the last block never tries to merge with what comes after
+		block* sentinel = _next(first);
+		sentinel->prevPhys = first;
+		sentinel->sizeAndFlags = ms_prevFreeBit;
+
+		_insertFree(first);
+		m_totalBytes += size;
+		return true;
+	}
+
+	/**
+	 * Returns nullptr if there is no free block big enough.
+	 * 0 bytes gives a valid minimum sized block.
+	 */
+	void* allocate(size_type bytes)
+	{
+		if (bytes > max_allocation)
+		{
+			return nullptr;
+		}
+
+		const size_type size = bytes < ms_minBlockSize ? ms_minBlockSize : detail::tlsf_roundUp(bytes, alignment);
+		// Rounding up to the next list, so any block there fits
+		const size_type searchSize = size >= ms_smallBlockSize ? size + (size_type(1) << (_fls(size) - ms_slLog2)) - 1 : size;
+		unsigned fl, sl;
+		_mapping(searchSize, fl, sl);
+		if (fl >= ms_flCount)
+		{
+			return nullptr;
+		}
+
+		block* b = _findFree(fl, sl);
+		if (!b)
+		{
+			return nullptr;
+		}
+
+		_removeFree(b, fl, sl);
+		_split(b, size);
+
+		b->sizeAndFlags &= ~ms_freeBit;
+		_next(b)->sizeAndFlags &= ~ms_prevFreeBit;
+
+		m_usedBytes += _size(b);
+		++m_usedBlocks;
+		if (m_usedBytes > m_peakUsedBytes)
+		{
+			m_peakUsedBytes = m_usedBytes;
+		}
+		return _payload(b);
+	}
+
+	/**
+	 * ptr needs to come from this allocator. Accepts nullptr.
+	 */
+	void deallocate(void* ptr)
+	{
+		if (!ptr)
+		{
+			return;
+		}
+
+		block* b = _blockFromPayload(ptr);
+		CZ_TLSF_ASSERT(!(b->sizeAndFlags & ms_freeBit));
+		m_usedBytes -= _size(b);
+		--m_usedBlocks;
+
+		b->sizeAndFlags |= ms_freeBit;
+		block* next = _next(b);
+
+		if (b->sizeAndFlags & ms_prevFreeBit)
+		{
+			block* prev = b->prevPhys;
+			_removeFree(prev);
+			prev->sizeAndFlags += ms_headerSize + _size(b);
+			b = prev;
+			next->prevPhys = b;
+		}
+
+		if (next->sizeAndFlags & ms_freeBit)
+		{
+			_removeFree(next);
+			b->sizeAndFlags += ms_headerSize + _size(next);
+			next = _next(b);
+			next->prevPhys = b;
+		}
+
+		next->sizeAndFlags |= ms_prevFreeBit;
+		_insertFree(b);
+	}
+
+	/**
+	 * How many bytes can be used at ptr. At least what was requested.
+	 */
+	static size_type usable_size(const void* ptr)
+	{
+		return _size(_blockFromPayload(const_cast<void*>(ptr)));
+	}
+
+	/**
+	 * Returns true if ptr is in one of the regions.
+	 * This is O(number of regions), unlike allocate/deallocate.
+	 */
+	bool owns(const void* ptr) const
+	{
+		const uintptr_t p = reinterpret_cast<uintptr_t>(ptr);
+		for (const region* r = m_regions; r; r = r->next)
+		{
+			const uintptr_t start = reinterpret_cast<uintptr_t>(r);
+			if (p >= start && p < start + r->size)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	size_type used_bytes() const
+	{
+		return m_usedBytes;
+	}
+
+	size_type total_bytes() const
+	{
+		return m_totalBytes;
+	}
+
+	/**
+	 * Calls f(const void* ptr, size_t size, bool used) for every block, in memory order within each region.
+	 * Free blocks are included, so this can be used to look at fragmentation.
+	 */
+	template<typename F>
+	void walk(F&& f) const
+	{
+		for (const region* r = m_regions; r; r = r->next)
+		{
+			for (block* b = _firstBlock(r); _size(b); b = _next(b))
+			{
+				f(static_cast<const void*>(_payload(b)), _size(b), !(b->sizeAndFlags & ms_freeBit));
+			}
+		}
+	}
+
+	/**
+	 * Walks the heap, so it's O(number of blocks). Meant for diagnostics, not the hot path.
+	 */
+	tlsf_stats stats() const
+	{
+		tlsf_stats s = {};
+		s.totalBytes = m_totalBytes;
+		s.usedBytes = m_usedBytes;
+		s.peakUsedBytes = m_peakUsedBytes;
+		s.usedBlocks = m_usedBlocks;
+		walk([&s](const void*, size_type size, bool used)
+		{
+			if (!used)
+			{
+				s.freeBytes += size;
+				++s.freeBlocks;
+				if (size > s.largestFreeBlock)
+				{
+					s.largestFreeBlock = size;
+				}
+			}
+		});
+		return s;
+	}
+
+	/**
+	 * Checks the heap is consistent (links between neighbours, flags, free lists and bitmaps).
+	 * Returns false if something got corrupted, e.g: by writing past the end of an allocation.
+	 */
+	bool validate() const
+	{
+		size_type freeInHeap = 0;
+		for (const region* r = m_regions; r; r = r->next)
+		{
+			const block* prev = nullptr;
+			const block* b = _firstBlock(r);
+			while (true)
+			{
+				if (b->prevPhys != prev)
+				{
+					return false;
+				}
+				const bool prevFree = prev && (prev->sizeAndFlags & ms_freeBit);
+				if (prevFree != ((b->sizeAndFlags & ms_prevFreeBit) != 0))
+				{
+					return false;
+				}
+				if (_size(b) == 0)
+				{
+					break;
+				}
+				if (b->sizeAndFlags & ms_freeBit)
+				{
+					// Free neighbours are always merged
+					if (prevFree || !_isInFreeList(b))
+					{
+						return false;
+					}
+					++freeInHeap;
+				}
+				prev = b;
+				b = _next(b);
+			}
+			if (reinterpret_cast<uintptr_t>(b) + ms_headerSize != reinterpret_cast<uintptr_t>(r) + r->size)
+			{
+				return false;
+			}
+		}
+
+		size_type freeInLists = 0;
+		for (unsigned fl = 0; fl < ms_flCount; ++fl)
+		{
+			if (((m_flBitmap >> fl) & 1) != (m_slBitmap[fl] != 0))
+			{
+				return false;
+			}
+			for (unsigned sl = 0; sl < ms_slCount; ++sl)
+			{
+				if (((m_slBitmap[fl] >> sl) & 1) != (m_free[fl][sl] != nullptr))
+				{
+					return false;
+				}
+				for (const block* b = m_free[fl][sl]; b; b = b->nextFree)
+				{
+					++freeInLists;
+				}
+			}
+		}
+		return freeInHeap == freeInLists;
+	}
+
+private:
+
+	static unsigned _fls(size_type v)
+	{
+		return static_cast<unsigned>(sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(v));
+	}
+
+	static unsigned _ffs(uint32_t v)
+	{
+		return static_cast<unsigned>(__builtin_ctz(v));
+	}
+
+	static size_type _size(const block* b)
+	{
+		return b->sizeAndFlags & ~ms_flagsMask;
+	}
+
+	static void* _payload(const block* b)
+	{
+		return reinterpret_cast<char*>(const_cast<block*>(b)) + ms_headerSize;
+	}
+
+	static block* _blockFromPayload(void* ptr)
+	{
+		return reinterpret_cast<block*>(static_cast<char*>(ptr) - ms_headerSize);
+	}
+
+	static block* _next(const block* b)
+	{
+		return reinterpret_cast<block*>(static_cast<char*>(_payload(b)) + _size(b));
+	}
+
+	static block* _firstBlock(const region* r)
+	{
+		return reinterpret_cast<block*>(reinterpret_cast<uintptr_t>(r) + ms_regionHeaderSize);
+	}
+
+	static void _mapping(size_type size, unsigned& fl, unsigned& sl)
+	{
+		if (size < ms_smallBlockSize)
+		{
+			fl = 0;
+			sl = static_cast<unsigned>(size / alignment);
+		}
+		else
+		{
+			const unsigned msb = _fls(size);
+			sl = static_cast<unsigned>(size >> (msb - ms_slLog2)) ^ ms_slCount;
+			fl = msb - ms_flShift + 1;
+		}
+	}
+
+	// Finds a non-empty list at (fl, sl) or above, and updates fl/sl to it
+	block* _findFree(unsigned& fl, unsigned& sl) const
+	{
+		uint32_t slMap = m_slBitmap[fl] & (~uint32_t(0) << sl);
+		if (!slMap)
+		{
+			const uint32_t flMap = fl + 1 < 32 ? m_flBitmap & (~uint32_t(0) << (fl + 1)) : 0;
+			if (!flMap)
+			{
+				return nullptr;
+			}
+			fl = _ffs(flMap);
+			slMap = m_slBitmap[fl];
+		}
+		sl = _ffs(slMap);
+		return m_free[fl][sl];
+	}
+
+	void _insertFree(block* b)
+	{
+		unsigned fl, sl;
+		_mapping(_size(b), fl, sl);
+		block* head = m_free[fl][sl];
+		b->nextFree = head;
+		b->prevFree = nullptr;
+		if (head)
+		{
+			head->prevFree = b;
+		}
+		m_free[fl][sl] = b;
+		m_flBitmap |= uint32_t(1) << fl;
+		m_slBitmap[fl] |= uint32_t(1) << sl;
+	}
+
+	void _removeFree(block* b, unsigned fl, unsigned sl)
+	{
+		if (b->prevFree)
+		{
+			b->prevFree->nextFree = b->nextFree;
+		}
+		else
+		{
+			m_free[fl][sl] = b->nextFree;
+			if (!b->nextFree)
+			{
+				m_slBitmap[fl] &= ~(uint32_t(1) << sl);
+				if (!m_slBitmap[fl])
+				{
+					m_flBitmap &= ~(uint32_t(1) << fl);
+				}
+			}
+		}
+		if (b->nextFree)
+		{
+			b->nextFree->prevFree = b->prevFree;
+		}
+	}
+
+	void _removeFree(block* b)
+	{
+		unsigned fl, sl;
+		_mapping(_size(b), fl, sl);
+		_removeFree(b, fl, sl);
+	}
+
+	// If the free block b is big enough, cuts it to size and puts the rest back as a free block
+	void _split(block* b, size_type size)
+	{
+		const size_type total = _size(b);
+		if (total < size + ms_headerSize + ms_minBlockSize)
+		{
+			return;
+		}
+
+		b->sizeAndFlags = size | (b->sizeAndFlags & ms_flagsMask);
+		block* rest = _next(b);
+		rest->prevPhys = b;
+		rest->sizeAndFlags = (total - size - ms_headerSize) | ms_freeBit;
+		// What comes after rest was already flagged as having a free block before it
+		_next(rest)->prevPhys = rest;
+		_insertFree(rest);
+	}
+
+	bool _isInFreeList(const block* b) const
+	{
+		unsigned fl, sl;
+		_mapping(_size(b), fl, sl);
+		for (const block* it = m_free[fl][sl]; it; it = it->nextFree)
+		{
+			if (it == b)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	region* m_regions = nullptr;
+	uint32_t m_flBitmap = 0;
+	uint32_t m_slBitmap[ms_flCount] = {};
+	block* m_free[ms_flCount][ms_slCount] = {};
+	size_type m_totalBytes = 0;
+	size_type m_usedBytes = 0;
+	size_type m_peakUsedBytes = 0;
+	size_type m_usedBlocks = 0;
+};
+
+/**
+ * Uses a tlsf as the backend for the global operator new, or VectorAllocator.
+ * Pointers that aren't from the tlsf (allocated before the backend was set) are given to free.
+ * When the tlsf is full, allocations fail (nullptr), unless mallocFallback is true, which trades the bounded latency
+ * for not failing.
+ */
+class tlsf_backend
+{
+public:
+	explicit tlsf_backend(tlsf& heap, bool mallocFallback = false)
+		: m_heap(heap)
+		, m_mallocFallback(mallocFallback)
+		, m_backend{ &_alloc, &_free, this }
+	{
+	}
+
+	const detail::AllocatorBackend* get() const
+	{
+		return &m_backend;
+	}
+
+private:
+
+	static void* _alloc(void* userData, size_t bytes)
+	{
+		tlsf_backend& self = *static_cast<tlsf_backend*>(userData);
+		void* ptr = self.m_heap.allocate(bytes);
+		if (!ptr && self.m_mallocFallback)
+		{
+			ptr = malloc(bytes);
+		}
+		return ptr;
+	}
+
+	static void _free(void* userData, void* ptr)
+	{
+		tlsf& heap = static_cast<tlsf_backend*>(userData)->m_heap;
+		if (heap.owns(ptr))
+		{
+			heap.deallocate(ptr);
+		}
+		else
+		{
+			free(ptr);
+		}
+	}
+
+	tlsf& m_heap;
+	bool m_mallocFallback;
+	detail::AllocatorBackend m_backend;
+};
+
+} // namespace cz
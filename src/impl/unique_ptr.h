@@ -1,94 +1,336 @@
 #pragma once
 
 #include <utility>
+#include <type_traits>
+#include <cstddef>
+#include <new>
 
 namespace std
 {
 
+template<typename T>
+struct default_delete
+{
+	constexpr default_delete() noexcept = default;
+
+	// Allows unique_ptr<Derived> to unique_ptr<Base> conversions
+	template<typename U, typename = enable_if_t<is_convertible_v<U*, T*>>>
+	default_delete(const default_delete<U>&) noexcept { }
+
+	void operator()(T* ptr) const
+	{
+		static_assert(sizeof(T) > 0, "Can't delete an incomplete type");
+		delete ptr;
+	}
+};
+
+template<typename T>
+struct default_delete<T[]>
+{
+	constexpr default_delete() noexcept = default;
+
+	void operator()(T* ptr) const
+	{
+		static_assert(sizeof(T) > 0, "Can't delete an incomplete type");
+		delete[] ptr;
+	}
+};
+
+namespace detail
+{
+	/*
+	Holds the pointer and the deleter.
+	Stateless deleters are used as a base class (empty base optimization), so they take no space.
+	*/
+	template<typename T, typename Deleter, bool UseEbo = is_empty_v<Deleter> && !is_final_v<Deleter>>
+	class unique_ptr_storage : private Deleter
+	{
+	public:
+		constexpr unique_ptr_storage() noexcept { }
+
+		template<typename D>
+		unique_ptr_storage(T* ptr, D&& deleter) noexcept
+			: Deleter(std::forward<D>(deleter)), m_ptr(ptr)
+		{
+		}
+
+		Deleter& deleter() noexcept { return *this; }
+		const Deleter& deleter() const noexcept { return *this; }
+
+		T* m_ptr = nullptr;
+	};
+
+	template<typename T, typename Deleter>
+	class unique_ptr_storage<T, Deleter, false>
+	{
+	public:
+		constexpr unique_ptr_storage() noexcept { }
+
+		template<typename D>
+		unique_ptr_storage(T* ptr, D&& deleter) noexcept
+			: m_ptr(ptr), m_deleter(std::forward<D>(deleter))
+		{
+		}
+
+		Deleter& deleter() noexcept { return m_deleter; }
+		const Deleter& deleter() const noexcept { return m_deleter; }
+
+		T* m_ptr = nullptr;
+		Deleter m_deleter;
+	};
+
+	/*
+	Functionality shared by the single object and the array unique_ptr.
+	*/
+	template<typename T, typename Deleter>
+	class unique_ptr_base
+	{
+	protected:
+		detail::unique_ptr_storage<T, Deleter> m_storage;
+
+	public:
+		using pointer = T*;
+		using element_type = T;
+		using deleter_type = Deleter;
+
+		constexpr unique_ptr_base() noexcept { }
+
+		template<typename D>
+		unique_ptr_base(T* p, D&& deleter) noexcept
+			: m_storage(p, std::forward<D>(deleter))
+		{
+		}
+
+		~unique_ptr_base()
+		{
+			if (m_storage.m_ptr)
+			{
+				m_storage.deleter()(m_storage.m_ptr);
+			}
+		}
+
+		// Remove compiler generated copy semantics
+		unique_ptr_base(const unique_ptr_base&) = delete;
+		unique_ptr_base& operator=(const unique_ptr_base&) = delete;
+
+		T* get() const noexcept { return m_storage.m_ptr; }
+		explicit operator bool() const noexcept { return m_storage.m_ptr != nullptr; }
+
+		Deleter& get_deleter() noexcept { return m_storage.deleter(); }
+		const Deleter& get_deleter() const noexcept { return m_storage.deleter(); }
+
+		T* release() noexcept
+		{
+			T* result = m_storage.m_ptr;
+			m_storage.m_ptr = nullptr;
+			return result;
+		}
+
+		// Takes ownership of p, and deletes the previously owned object, if any
+		void reset(T* p = nullptr) noexcept
+		{
+			T* old = m_storage.m_ptr;
+			m_storage.m_ptr = p;
+			if (old)
+			{
+				m_storage.deleter()(old);
+			}
+		}
+
+		void swap(unique_ptr_base& other) noexcept
+		{
+			T* tmp = m_storage.m_ptr;
+			m_storage.m_ptr = other.m_storage.m_ptr;
+			other.m_storage.m_ptr = tmp;
+
+			Deleter d = std::move(m_storage.deleter());
+			m_storage.deleter() = std::move(other.m_storage.deleter());
+			other.m_storage.deleter() = std::move(d);
+		}
+	};
+}
+
+template<typename T, typename Deleter = default_delete<T>>
+class unique_ptr;
+
+namespace detail
+{
+	// If unique_ptr<U, E> can be moved into unique_ptr<T, Deleter>
+	template<typename T, typename Deleter, typename U, typename E>
+	inline constexpr bool unique_ptr_convertible_v =
+		!is_array_v<U> &&
+		is_convertible_v<typename unique_ptr<U, E>::pointer, T*> &&
+		is_convertible_v<E, Deleter>;
+}
+
 /*
 Minimal std::unique_ptr implementation, close enough for my personal needs
 */
-template<typename T>
-class unique_ptr
+template<typename T, typename Deleter>
+class unique_ptr : public detail::unique_ptr_base<T, Deleter>
 {
 private:
-	T* m_ptr = nullptr;
+	using base = detail::unique_ptr_base<T, Deleter>;
 public:
-	~unique_ptr()
-	{
-		delete m_ptr;
-	}
 
 	constexpr unique_ptr() noexcept { }
+	constexpr unique_ptr(std::nullptr_t) noexcept { }
+
 	explicit unique_ptr(T* p) noexcept
-		: m_ptr(p)
+		: base(p, Deleter())
+	{
+	}
+
+	unique_ptr(T* p, const Deleter& deleter) noexcept
+		: base(p, deleter)
+	{
+	}
+
+	unique_ptr(T* p, Deleter&& deleter) noexcept
+		: base(p, std::move(deleter))
 	{
 	}
 
 	unique_ptr(unique_ptr&& other) noexcept
+		: base(other.release(), std::move(other.get_deleter()))
 	{
-		this->swap(other);
 	}
 
-	// Constructor/Assignment for use with types derived from T
-	template<typename U>
-	unique_ptr(unique_ptr<U>&& moving)
+	// Constructor/Assignment for use with types derived from T.
+	// Arrays are excluded, since their deleter would be the wrong one for the single object.
+	template<typename U, typename E, typename = enable_if_t<detail::unique_ptr_convertible_v<T, Deleter, U, E>>>
+	unique_ptr(unique_ptr<U, E>&& moving) noexcept
+		: base(moving.release(), std::move(moving.get_deleter()))
 	{
-		unique_ptr<T> tmp(moving.release());
-		tmp.swap(*this);
 	}
 
-	template<typename U>
-	unique_ptr& operator=(unique_ptr<U>&& moving)
+	template<typename U, typename E, typename = enable_if_t<detail::unique_ptr_convertible_v<T, Deleter, U, E>>>
+	unique_ptr& operator=(unique_ptr<U, E>&& moving) noexcept
 	{
-		unique_ptr<T> tmp(moving.release());
-		tmp.swap(*this);
+		this->reset(moving.release());
+		this->get_deleter() = std::move(moving.get_deleter());
 		return *this;
 	}
-		
-	// Remove compiler generated copy semantics
-	unique_ptr(const unique_ptr&) = delete;
-	unique_ptr& operator=(const unique_ptr&) = delete;
 
-	void swap(unique_ptr& other) noexcept
+	unique_ptr& operator=(unique_ptr&& other) noexcept
 	{
-		T* tmp = m_ptr;
-		m_ptr = other.m_ptr;
-		other.m_ptr = tmp;
+		if (this != &other)
+		{
+			this->reset(other.release());
+			this->get_deleter() = std::move(other.get_deleter());
+		}
+		return *this;
 	}
 
-	T* operator->() const { return m_ptr; }
-	T& operator*() const { return m_ptr; }
+	unique_ptr& operator=(std::nullptr_t) noexcept
+	{
+		this->reset();
+		return *this;
+	}
 
-	unique_ptr& operator=(unique_ptr&& other) noexcept
+	T* operator->() const noexcept { return this->get(); }
+	T& operator*() const { return *this->get(); }
+};
+
+/*
+Array version. Uses delete[] by default, and provides operator[] instead of * and ->
+*/
+template<typename T, typename Deleter>
+class unique_ptr<T[], Deleter> : public detail::unique_ptr_base<T, Deleter>
+{
+private:
+	using base = detail::unique_ptr_base<T, Deleter>;
+public:
+
+	constexpr unique_ptr() noexcept { }
+	constexpr unique_ptr(std::nullptr_t) noexcept { }
+
+	explicit unique_ptr(T* p) noexcept
+		: base(p, Deleter())
 	{
-		other.swap(*this);
-		return* this;
 	}
 
-	T* get() const { return m_ptr; }
-	explicit operator bool() const { return m_ptr; }
+	unique_ptr(T* p, const Deleter& deleter) noexcept
+		: base(p, deleter)
+	{
+	}
 
-	T* release() noexcept
+	unique_ptr(unique_ptr&& other) noexcept
+		: base(other.release(), std::move(other.get_deleter()))
 	{
-		T* result = m_ptr;
-		m_ptr = nullptr;
-		return result;
 	}
 
-	void reset()
+	unique_ptr& operator=(unique_ptr&& other) noexcept
 	{
-		T* tmp = release();
-		delete tmp;
+		if (this != &other)
+		{
+			this->reset(other.release());
+			this->get_deleter() = std::move(other.get_deleter());
+		}
+		return *this;
+	}
+
+	unique_ptr& operator=(std::nullptr_t) noexcept
+	{
+		this->reset();
+		return *this;
 	}
 
+	T& operator[](size_t idx) const { return this->get()[idx]; }
 };
 
+template<typename T1, typename D1, typename T2, typename D2>
+bool operator==(const unique_ptr<T1, D1>& a, const unique_ptr<T2, D2>& b) { return a.get() == b.get(); }
+template<typename T1, typename D1, typename T2, typename D2>
+bool operator!=(const unique_ptr<T1, D1>& a, const unique_ptr<T2, D2>& b) { return a.get() != b.get(); }
+template<typename T, typename D>
+bool operator==(const unique_ptr<T, D>& a, std::nullptr_t) { return !a; }
+template<typename T, typename D>
+bool operator!=(const unique_ptr<T, D>& a, std::nullptr_t) { return static_cast<bool>(a); }
+
 template<typename T, typename... Args>
-std::unique_ptr<T> make_unique(Args&&... args)
+enable_if_t<!is_array_v<T>, unique_ptr<T>> make_unique(Args&&... args)
 {
-    return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
+	return unique_ptr<T>(new T(std::forward<Args>(args)...));
 }
-	
+
+// Value-initializes count elements
+template<typename T>
+enable_if_t<is_array_v<T> && extent_v<T> == 0, unique_ptr<T>> make_unique(size_t count)
+{
+	return unique_ptr<T>(new remove_all_extents_t<T>[count]());
+}
+
 } // namespace std
 
+namespace cz
+{
+
+/*
+Deleter for objects created with allocate_unique.
+Alloc needs to provide:
+	void* allocate(size_t bytes, size_t alignment);
+	void deallocate(void* ptr, size_t bytes);
+*/
+template<typename T, typename Alloc>
+struct allocator_delete
+{
+	Alloc* alloc = nullptr;
+
+	void operator()(T* ptr) const
+	{
+		ptr->~T();
+		alloc->deallocate(ptr, sizeof(T));
+	}
+};
+
+// Creates an object with memory from the given allocator (e.g: an arena or pool)
+template<typename T, typename Alloc, typename... Args>
+std::unique_ptr<T, allocator_delete<T, Alloc>> allocate_unique(Alloc& alloc, Args&&... args)
+{
+	void* mem = alloc.allocate(sizeof(T), alignof(T));
+	T* obj = new(mem) T(std::forward<Args>(args)...);
+	return std::unique_ptr<T, allocator_delete<T, Alloc>>(obj, allocator_delete<T, Alloc>{&alloc});
+}
+
+} // namespace cz
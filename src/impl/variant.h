@@ -0,0 +1,546 @@
+/**
+Minimal std::variant implementation.
+
+- The discriminant uses the smallest unsigned type that fits the number of alternatives (uint8_t for up to 254).
+- variant<Ts...> is trivially copyable/destructible if all Ts are.
+- visit dispatches with a single indirect call through a table of function pointers, instead of a chain of
+  comparisons on the index.
+- There are no exceptions, so there is no valueless_by_exception state. Accessing the wrong alternative asserts.
+- visit only supports a single variant.
+*/
+
+#pragma once
+
+#include <assert.h>
+#include <type_traits>
+#include <utility>
+#include <cstdint>
+#include <new>
+#include "special_members.h"
+
+#define CZ_VARIANT_ASSERT(x) assert(x)
+
+namespace cz
+{
+
+// Use as the first alternative, to make a variant default constructible when the other alternatives are not
+struct monostate
+{
+};
+
+constexpr bool operator==(monostate, monostate) { return true; }
+constexpr bool operator!=(monostate, monostate) { return false; }
+
+template<typename... Ts>
+class variant;
+
+template<size_t I, typename Variant>
+struct variant_alternative;
+
+template<size_t I, typename... Ts>
+struct variant_alternative<I, variant<Ts...>>
+{
+	using type = std::detail::type_pack_element_t<I, Ts...>;
+};
+
+template<size_t I, typename Variant>
+using variant_alternative_t = typename variant_alternative<I, Variant>::type;
+
+template<typename Variant>
+struct variant_size;
+
+template<typename... Ts>
+struct variant_size<variant<Ts...>> : std::integral_constant<size_t, sizeof...(Ts)>
+{
+};
+
+template<typename Variant>
+inline constexpr size_t variant_size_v = variant_size<Variant>::value;
+
+namespace detail
+{
+	// Smallest unsigned type that can hold the indexes [0, N), plus an invalid index
+	template<size_t N>
+	using variant_index_t =
+		std::conditional_t<(N < 0xFF), uint8_t,
+			std::conditional_t<(N < 0xFFFF), uint16_t, uint32_t>>;
+
+	// Index of T in Ts...
+	template<typename T, typename... Ts>
+	struct variant_type_index;
+
+	template<typename T, typename... Ts>
+	struct variant_type_index<T, T, Ts...> : std::integral_constant<size_t, 0>
+	{
+	};
+
+	template<typename T, typename U, typename... Ts>
+	struct variant_type_index<T, U, Ts...> : std::integral_constant<size_t, 1 + variant_type_index<T, Ts...>::value>
+	{
+	};
+
+	// Number of times T shows up in Ts...
+	template<typename T, typename... Ts>
+	inline constexpr size_t variant_type_count_v = (size_t(0) + ... + size_t(std::is_same_v<T, Ts>));
+
+	/**
+	 * Picks the alternative to construct from a U, using overload resolution, as if there was a function
+	 * F(T_i) for each alternative.
+	 */
+	template<size_t I, typename T>
+	struct variant_overload
+	{
+		std::integral_constant<size_t, I> operator()(T) const;
+	};
+
+	template<typename Seq, typename... Ts>
+	struct variant_overloads;
+
+	template<size_t... Is, typename... Ts>
+	struct variant_overloads<std::index_sequence<Is...>, Ts...> : variant_overload<Is, Ts>...
+	{
+		using variant_overload<Is, Ts>::operator()...;
+	};
+
+	template<typename U, typename... Ts>
+	using variant_accepted_index = decltype(
+		variant_overloads<std::index_sequence_for<Ts...>, Ts...>{}(std::declval<U>()));
+
+	template<typename U, typename... Ts>
+	auto variant_accepts_test(int) -> decltype(variant_accepted_index<U, Ts...>(), std::true_type());
+	template<typename U, typename... Ts>
+	std::false_type variant_accepts_test(...);
+
+	// If a variant<Ts...> can be constructed from a U
+	template<typename U, typename... Ts>
+	inline constexpr bool variant_accepts_v = decltype(variant_accepts_test<U, Ts...>(0))::value;
+
+	/**
+	 * Recursive union holding all the alternatives.
+	 * Only has a destructor if an alternative needs one, so the variant can be trivially destructible.
+	 */
+	template<bool TrivialDtor, typename... Ts>
+	union variant_union;
+
+	template<bool TrivialDtor>
+	union variant_union<TrivialDtor>
+	{
+	};
+
+	template<typename T, typename... Ts>
+	union variant_union<true, T, Ts...>
+	{
+		char m_dummy;
+		T m_head;
+		variant_union<true, Ts...> m_tail;
+
+		constexpr variant_union() noexcept
+			: m_dummy()
+		{
+		}
+
+		template<typename... Args>
+		constexpr explicit variant_union(std::in_place_index_t<0>, Args&&... args)
+			: m_head(std::forward<Args>(args)...)
+		{
+		}
+
+		template<size_t I, typename... Args>
+		constexpr explicit variant_union(std::in_place_index_t<I>, Args&&... args)
+			: m_tail(std::in_place_index<I - 1>, std::forward<Args>(args)...)
+		{
+		}
+	};
+
+	template<typename T, typename... Ts>
+	union variant_union<false, T, Ts...>
+	{
+		char m_dummy;
+		T m_head;
+		variant_union<false, Ts...> m_tail;
+
+		constexpr variant_union() noexcept
+			: m_dummy()
+		{
+		}
+
+		template<typename... Args>
+		constexpr explicit variant_union(std::in_place_index_t<0>, Args&&... args)
+			: m_head(std::forward<Args>(args)...)
+		{
+		}
+
+		template<size_t I, typename... Args>
+		constexpr explicit variant_union(std::in_place_index_t<I>, Args&&... args)
+			: m_tail(std::in_place_index<I - 1>, std::forward<Args>(args)...)
+		{
+		}
+
+		~variant_union()
+		{
+		}
+	};
+
+	template<size_t I, typename Union>
+	constexpr auto& variant_union_get(Union& u)
+	{
+		if constexpr (I == 0)
+		{
+			return u.m_head;
+		}
+		else
+		{
+			return variant_union_get<I - 1>(u.m_tail);
+		}
+	}
+
+	template<size_t I, typename R, typename F>
+	R variant_dispatch_entry(F& f)
+	{
+		return f(std::integral_constant<size_t, I>());
+	}
+
+	/**
+	 * Calls f(std::integral_constant<size_t, index>()) through a table of function pointers.
+	 * All the table entries need to return R.
+	 */
+	template<typename R, typename F, size_t... Is>
+	R variant_dispatch(size_t index, F& f, std::index_sequence<Is...>)
+	{
+		using entry_type = R (*)(F&);
+		static constexpr entry_type table[] = { &variant_dispatch_entry<Is, R, F>... };
+		return table[index](f);
+	}
+
+	template<bool TrivialDtor, typename... Ts>
+	struct variant_storage
+	{
+		using index_type = variant_index_t<sizeof...(Ts)>;
+		static constexpr index_type invalid_index = static_cast<index_type>(-1);
+
+		variant_union<(std::is_trivially_destructible_v<Ts> && ...), Ts...> m_union;
+		index_type m_index = invalid_index;
+
+		constexpr variant_storage() noexcept
+		{
+		}
+
+		template<size_t I, typename... Args>
+		constexpr explicit variant_storage(std::in_place_index_t<I>, Args&&... args)
+			: m_union(std::in_place_index<I>, std::forward<Args>(args)...)
+			, m_index(static_cast<index_type>(I))
+		{
+		}
+
+		template<size_t I>
+		auto& _get()
+		{
+			return variant_union_get<I>(m_union);
+		}
+
+		template<size_t I>
+		const auto& _get() const
+		{
+			return variant_union_get<I>(m_union);
+		}
+
+		// Calls f(std::integral_constant<size_t, m_index>())
+		template<typename R, typename F>
+		R _dispatch(F&& f) const
+		{
+			CZ_VARIANT_ASSERT(m_index != invalid_index);
+			return variant_dispatch<R>(m_index, f, std::index_sequence_for<Ts...>());
+		}
+
+		template<size_t I, typename... Args>
+		void _construct(Args&&... args)
+		{
+			using T = std::detail::type_pack_element_t<I, Ts...>;
+			new(&_get<I>()) T(std::forward<Args>(args)...);
+			m_index = static_cast<index_type>(I);
+		}
+
+		void _reset()
+		{
+			if constexpr (!(std::is_trivially_destructible_v<Ts> && ...))
+			{
+				if (m_index != invalid_index)
+				{
+					_dispatch<void>([this](auto I)
+					{
+						using T = std::detail::type_pack_element_t<I, Ts...>;
+						_get<I>().~T();
+					});
+				}
+			}
+			m_index = invalid_index;
+		}
+	};
+
+	template<typename... Ts>
+	struct variant_storage<false, Ts...> : variant_storage<true, Ts...>
+	{
+		using variant_storage<true, Ts...>::variant_storage;
+		variant_storage() = default;
+		variant_storage(const variant_storage&) = default;
+		variant_storage(variant_storage&&) = default;
+		variant_storage& operator=(const variant_storage&) = default;
+		variant_storage& operator=(variant_storage&&) = default;
+
+		~variant_storage()
+		{
+			this->_reset();
+		}
+	};
+
+	// Implements what detail::special_members_t needs.
+	// Other is either "const variant_base&" or "variant_base&&", so std::move on the value copies or moves accordingly
+	template<typename... Ts>
+	struct variant_base : variant_storage<(std::is_trivially_destructible_v<Ts> && ...), Ts...>
+	{
+		using variant_storage<(std::is_trivially_destructible_v<Ts> && ...), Ts...>::variant_storage;
+
+		template<typename Other>
+		void _constructFrom(Other&& other)
+		{
+			other.template _dispatch<void>([&](auto I)
+			{
+				this->template _construct<I>(std::move(other.template _get<I>()));
+			});
+		}
+
+		template<typename Other>
+		void _assignFrom(Other&& other)
+		{
+			if (this->m_index == other.m_index)
+			{
+				other.template _dispatch<void>([&](auto I)
+				{
+					this->template _get<I>() = std::move(other.template _get<I>());
+				});
+			}
+			else
+			{
+				this->_reset();
+				_constructFrom(std::forward<Other>(other));
+			}
+		}
+	};
+
+} // namespace detail
+
+template<typename... Ts>
+class variant : private detail::special_members_t<detail::variant_base<Ts...>, Ts...>
+{
+	static_assert(sizeof...(Ts) > 0, "variant needs at least one alternative");
+
+private:
+	using base = detail::special_members_t<detail::variant_base<Ts...>, Ts...>;
+
+	template<typename... Us>
+	friend class variant;
+
+	template<typename U>
+	static constexpr bool is_value_arg_v =
+		!std::is_same_v<std::decay_t<U>, variant> && detail::variant_accepts_v<U, Ts...>;
+
+public:
+
+	using index_type = detail::variant_index_t<sizeof...(Ts)>;
+
+	template<typename T = std::detail::type_pack_element_t<0, Ts...>,
+			typename = std::enable_if_t<std::is_constructible_v<T>>>
+	constexpr variant()
+		: base(std::in_place_index<0>)
+	{
+	}
+
+	template<typename U, typename = std::enable_if_t<is_value_arg_v<U>>>
+	constexpr variant(U&& value)
+		: base(std::in_place_index<detail::variant_accepted_index<U, Ts...>::value>, std::forward<U>(value))
+	{
+	}
+
+	template<size_t I, typename... Args>
+	constexpr explicit variant(std::in_place_index_t<I>, Args&&... args)
+		: base(std::in_place_index<I>, std::forward<Args>(args)...)
+	{
+	}
+
+	template<typename T, typename... Args>
+	constexpr explicit variant(std::in_place_type_t<T>, Args&&... args)
+		: base(std::in_place_index<detail::variant_type_index<T, Ts...>::value>, std::forward<Args>(args)...)
+	{
+	}
+
+	variant(const variant&) = default;
+	variant(variant&&) = default;
+	variant& operator=(const variant&) = default;
+	variant& operator=(variant&&) = default;
+
+	template<typename U, typename = std::enable_if_t<is_value_arg_v<U>>>
+	variant& operator=(U&& value)
+	{
+		constexpr size_t I = detail::variant_accepted_index<U, Ts...>::value;
+		if (this->m_index == I)
+		{
+			this->template _get<I>() = std::forward<U>(value);
+		}
+		else
+		{
+			emplace<I>(std::forward<U>(value));
+		}
+		return *this;
+	}
+
+	size_t index() const noexcept
+	{
+		return this->m_index;
+	}
+
+	template<size_t I, typename... Args>
+	auto& emplace(Args&&... args)
+	{
+		this->_reset();
+		this->template _construct<I>(std::forward<Args>(args)...);
+		return this->template _get<I>();
+	}
+
+	template<typename T, typename... Args>
+	T& emplace(Args&&... args)
+	{
+		return emplace<detail::variant_type_index<T, Ts...>::value>(std::forward<Args>(args)...);
+	}
+
+	void swap(variant& other)
+	{
+		variant tmp(std::move(other));
+		other = std::move(*this);
+		*this = std::move(tmp);
+	}
+
+	// Internal. Used by get/visit
+	template<size_t I>
+	auto& _unsafeGet() { return this->template _get<I>(); }
+	template<size_t I>
+	const auto& _unsafeGet() const { return this->template _get<I>(); }
+
+	template<typename R, typename F>
+	R _dispatch(F&& f) const
+	{
+		return base::template _dispatch<R>(std::forward<F>(f));
+	}
+};
+
+//
+// Element access
+//
+
+template<typename T, typename... Ts>
+constexpr bool holds_alternative(const variant<Ts...>& v) noexcept
+{
+	static_assert(detail::variant_type_count_v<T, Ts...> == 1, "T needs to show up exactly once in Ts...");
+	return v.index() == detail::variant_type_index<T, Ts...>::value;
+}
+
+template<size_t I, typename... Ts>
+variant_alternative_t<I, variant<Ts...>>& get(variant<Ts...>& v)
+{
+	CZ_VARIANT_ASSERT(v.index() == I);
+	return v.template _unsafeGet<I>();
+}
+
+template<size_t I, typename... Ts>
+const variant_alternative_t<I, variant<Ts...>>& get(const variant<Ts...>& v)
+{
+	CZ_VARIANT_ASSERT(v.index() == I);
+	return v.template _unsafeGet<I>();
+}
+
+template<size_t I, typename... Ts>
+variant_alternative_t<I, variant<Ts...>>&& get(variant<Ts...>&& v)
+{
+	CZ_VARIANT_ASSERT(v.index() == I);
+	return std::move(v.template _unsafeGet<I>());
+}
+
+template<typename T, typename... Ts>
+T& get(variant<Ts...>& v)
+{
+	return get<detail::variant_type_index<T, Ts...>::value>(v);
+}
+
+template<typename T, typename... Ts>
+const T& get(const variant<Ts...>& v)
+{
+	return get<detail::variant_type_index<T, Ts...>::value>(v);
+}
+
+template<typename T, typename... Ts>
+T&& get(variant<Ts...>&& v)
+{
+	return get<detail::variant_type_index<T, Ts...>::value>(std::move(v));
+}
+
+template<size_t I, typename... Ts>
+variant_alternative_t<I, variant<Ts...>>* get_if(variant<Ts...>* v) noexcept
+{
+	return (v && v->index() == I) ? &v->template _unsafeGet<I>() : nullptr;
+}
+
+template<size_t I, typename... Ts>
+const variant_alternative_t<I, variant<Ts...>>* get_if(const variant<Ts...>* v) noexcept
+{
+	return (v && v->index() == I) ? &v->template _unsafeGet<I>() : nullptr;
+}
+
+template<typename T, typename... Ts>
+T* get_if(variant<Ts...>* v) noexcept
+{
+	return get_if<detail::variant_type_index<T, Ts...>::value>(v);
+}
+
+template<typename T, typename... Ts>
+const T* get_if(const variant<Ts...>* v) noexcept
+{
+	return get_if<detail::variant_type_index<T, Ts...>::value>(v);
+}
+
+//
+// visit
+//
+
+// Calls f with the active alternative. f needs to return the same type for all alternatives.
+template<typename F, typename Variant>
+decltype(auto) visit(F&& f, Variant&& v)
+{
+	using R = decltype(std::forward<F>(f)(get<0>(std::forward<Variant>(v))));
+	return v.template _dispatch<R>([&](auto I) -> R
+	{
+		return std::forward<F>(f)(get<I>(std::forward<Variant>(v)));
+	});
+}
+
+//
+// Comparison
+//
+template<typename... Ts>
+bool operator==(const variant<Ts...>& a, const variant<Ts...>& b)
+{
+	if (a.index() != b.index())
+	{
+		return false;
+	}
+	return a.template _dispatch<bool>([&](auto I)
+	{
+		return get<I>(a) == get<I>(b);
+	});
+}
+
+template<typename... Ts>
+bool operator!=(const variant<Ts...>& a, const variant<Ts...>& b)
+{
+	return !(a == b);
+}
+
+} // namespace cz
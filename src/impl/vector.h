@@ -2,6 +2,10 @@
 Minimal std::vector implementation.
 
 It's not meant to be a full replacement, so depending on needs, some things my be missing.
+
+cz::vector<T, Alignment> takes the buffer alignment as an optional second parameter. It defaults to alignof(T), and can
+be raised (e.g: cz::vector<float, 64>) so SIMD loops can use aligned loads, or elements don't share cache lines with
+other allocations.
 */
 
 #pragma once
@@ -12,6 +16,11 @@ It's not meant to be a full replacement, so depending on needs, some things my b
 #include <algorithm>
 #include <utility>
 #include <new.h>
+#include <new>
+#include <array>
+#include "allocator.h"
+#include "aligned_alloc.h"
+#include "simd.h"
 
 #define CZ_VECTOR_ASSERT(x) assert(x)
 #define CZ_VECTOR_ASSERT_SLOW(x) assert(x)
@@ -22,8 +31,9 @@ It's not meant to be a full replacement, so depending on needs, some things my b
 	CZ_VECTOR_ASSERT_SLOW(iter >= _ptrAt(0) && iter < _ptrAt(m_size));
 #define CZ_VECTOR_CHECK_ITERATOR_RANGE(first, last) \
 	CZ_VECTOR_ASSERT_SLOW(first <= last && first>=_ptrAt(0) && last <= _ptrAt(m_size))
+// Comparing pointers to different allocations isn't allowed in constant evaluation, so that check is runtime only
 #define CZ_VECTOR_CHECK_ITERATOR_EXTERNAL_RANGE(first, last) \
-	CZ_VECTOR_ASSERT_SLOW(first <= last && (last <_ptrAt(0) || first>=_ptrAt(m_capacity)))
+	CZ_VECTOR_ASSERT_SLOW(first <= last && (std::is_constant_evaluated() || last <_ptrAt(0) || first>=_ptrAt(m_capacity)))
 
 #define CZ_DEBUG 1
 
@@ -36,37 +46,127 @@ namespace cz
  */
 namespace detail
 {
+	/**
+	 * Allows replacing malloc/free used by VectorAllocator (e.g: with a pool).
+	 * Same as what the global operator new can use (see <new>), so one backend works for both.
+	 */
+	using VectorAllocatorBackend = AllocatorBackend;
+
 #if !defined(CZ_VECTOR_UNITTEST_ALLOCATOR) || CZ_VECTOR_UNITTEST_ALLOCATOR==0
 	struct VectorAllocator
 	{
+		static inline const VectorAllocatorBackend* ms_backend = nullptr;
+
+		// Not thread safe. Should be set at startup, before other threads use vectors. nullptr restores malloc/free
+		static void _setBackend(const VectorAllocatorBackend* backend)
+		{
+			ms_backend = backend;
+		}
+
 		static inline void* _alloc(size_t bytes)
 		{
-			void* ptr = malloc(bytes);
+			void* ptr = ms_backend ? ms_backend->alloc(ms_backend->userData, bytes) : malloc(bytes);
 			CZ_VECTOR_ASSERT(ptr);
 			return ptr;
 		}
 
 		static void _free(void* ptr)
 		{
-			free(ptr);
+			if (ms_backend)
+			{
+				ms_backend->free(ms_backend->userData, ptr);
+			}
+			else
+			{
+				free(ptr);
+			}
+		}
+
+		// For alignments bigger than what _alloc guarantees (alignof(std::max_align_t)).
+		// Backends don't need to support alignment, so with a backend it over-allocates, and keeps the pointer the
+		// backend returned right before the aligned block.
+		static void* _allocAligned(size_t bytes, size_t alignment)
+		{
+			void* ptr;
+			if (ms_backend)
+			{
+				void* raw = ms_backend->alloc(ms_backend->userData, bytes + alignment + sizeof(void*));
+				CZ_VECTOR_ASSERT(raw);
+				const uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+				reinterpret_cast<void**>(aligned)[-1] = raw;
+				ptr = reinterpret_cast<void*>(aligned);
+			}
+			else
+			{
+				ptr = aligned_malloc(bytes, alignment);
+			}
+			CZ_VECTOR_ASSERT(ptr);
+			return ptr;
+		}
+
+		// The backend can't change between _allocAligned and _freeAligned
+		static void _freeAligned(void* ptr)
+		{
+			if (ms_backend)
+			{
+				if (ptr)
+				{
+					ms_backend->free(ms_backend->userData, reinterpret_cast<void**>(ptr)[-1]);
+				}
+			}
+			else
+			{
+				aligned_free(ptr);
+			}
 		}
 	};
 #endif
 } // namespace detail
 
+template<typename T, size_t Alignment = alignof(T)>
+class vector;
+
+/**
+ * A type is trivially relocatable if moving it to new memory and destroying the source is equivalent to a memcpy.
+ * Containers use this to move elements around with memcpy when growing, even if T has non-trivial move/destroy
+ * (e.g: a type that owns a heap buffer, but doesn't keep pointers to itself).
+ * Specialize it for such types.
+ */
+template<typename T>
+struct is_trivially_relocatable
+	: std::bool_constant<std::is_trivially_move_constructible_v<T> && std::is_trivially_destructible_v<T>>
+{
+};
+
+template<typename T, size_t Alignment>
+struct is_trivially_relocatable<vector<T, Alignment>> : std::true_type
+{
+};
+
+template<typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
 
 namespace detail
 {
-	template<typename T>
+	/**
+	 * Alignment is the alignment of the buffer, and can be bigger than alignof(T) (e.g: to use aligned SIMD loads)
+	 */
+	template<typename T, size_t Alignment = alignof(T)>
 	class base_vector
 	{
+		static_assert(Alignment >= alignof(T), "Alignment can't be smaller than alignof(T)");
+		static_assert((Alignment & (Alignment - 1)) == 0, "Alignment needs to be a power of 2");
+
+		// What VectorAllocator::_alloc already guarantees
+		static constexpr bool ms_overAligned = Alignment > alignof(std::max_align_t);
+
 	public:
 		using size_type = std::size_t;
 
 	protected:
 
 		template<typename A, class B = A>
-		static A _exchange(A& val, B&& newVal)
+		static constexpr A _exchange(A& val, B&& newVal)
 		{
 			A oldVal = static_cast<A&&>(val);
 			val = static_cast<B&&>(newVal);
@@ -74,7 +174,7 @@ namespace detail
 		}
 
 		template<typename Type>
-		static Type _min(Type a, Type b)
+		static constexpr Type _min(Type a, Type b)
 		{
 			return a <= b ? a : b;
 		}
@@ -83,104 +183,144 @@ namespace detail
 		// Construct a single element at the given position.
 		// Depending on Args, it can do default construction, copy construction or move construction
 		template<typename... Args>
-		static void _constructSingle(void* at, Args&&... args)
+		static constexpr void _constructSingle(T* at, Args&&... args)
 		{
-			new(at) T(std::forward<Args>(args)...);
+			std::construct_at(at, std::forward<Args>(args)...);
 		}
 
 		// Constructs N elements start at the given location
 		// Depending on Args, it can do default construction or copy construction
 		// Move construction doesn't make sense, because we can't be moving something to multiple elements
 		template<typename... Args>
-		static void _constructN(void* at, size_type count, Args&&... args)
+		static constexpr void _constructN(T* at, size_type count, Args&&... args)
 		{
+			if constexpr (sizeof...(Args) == 1 && std::is_trivially_copyable_v<T> &&
+				(std::is_same_v<std::remove_cv_t<std::remove_reference_t<Args>>, T> && ...))
+			{
+				if (!std::is_constant_evaluated())
+				{
+					cz::detail::simd_fill(at, count, args...);
+					return;
+				}
+			}
+
 			while (count--)
 			{
-				new(at) T(std::forward<Args>(args)...);
-				at = reinterpret_cast<T*>(at) + 1;
+				std::construct_at(at, std::forward<Args>(args)...);
+				++at;
 			}
 		}
 
 		//
 		// copy construct [first, last) to new memory [dest, ...)
-		static void _copyConstructRange(const T* first, const T* last, T* dest)
+		static constexpr void _copyConstructRange(const T* first, const T* last, T* dest)
 		{
 			if constexpr (std::is_trivially_copy_constructible_v<T>)
 			{
-				const size_type size = static_cast<size_type>(last - first) * sizeof(T);
-				memmove(dest, first, size);
-			}
-			else
-			{
-				while (first != last)
+				if (!std::is_constant_evaluated())
 				{
-					new(dest) T(*first);
-					++dest;
-					++first;
+					cz::copy(first, last, dest);
+					return;
 				}
 			}
+
+			while (first != last)
+			{
+				std::construct_at(dest, *first);
+				++dest;
+				++first;
+			}
+		}
+
+		// Fills destroyed or not yet constructed memory with a pattern, so use of dead elements is easier to spot.
+		// Not possible (nor useful) in constant evaluation, where the compiler already diagnoses that
+		static constexpr void _debugFill([[maybe_unused]] T* first, [[maybe_unused]] size_type count, [[maybe_unused]] int pattern)
+		{
+#if CZ_DEBUG
+			if (!std::is_constant_evaluated())
+			{
+				memset(static_cast<void*>(first), pattern, count * sizeof(T));
+			}
+#endif
 		}
 
-		static void _destroySingle(T* pos)
+		static constexpr void _destroySingle(T* pos)
 		{
 			if constexpr (!std::is_trivially_destructible_v<T>)
 			{
-				pos->~T();
+				std::destroy_at(pos);
 			}
 
-#if CZ_DEBUG
-			memset(reinterpret_cast<void*>(pos), 0xDD, sizeof(T));
-#endif
+			_debugFill(pos, 1, 0xDD);
 		}
 
 		// Destroyed [first, last)
-		static void _destroyRange(T* first, T* last)
+		static constexpr void _destroyRange(T* first, T* last)
 		{
-#if CZ_DEBUG
 			T* tmp = first;
-#endif
 
 			if constexpr (!std::is_trivially_destructible_v<T>)
 			{
 				while (first != last)
 				{
-					first->~T();
+					std::destroy_at(first);
 					++first;
 				}
 			}
 
-#if CZ_DEBUG
-			memset(reinterpret_cast<void*>(tmp), 0xDD, (last - tmp) * sizeof(T));
-#endif
+			_debugFill(tmp, static_cast<size_type>(last - tmp), 0xDD);
 		}
 		
 		// Move constructs [first, last) to new memory [dest,...)
-		static void _moveConstructRange(T* first, T* last, T* dest)
+		static constexpr void _moveConstructRange(T* first, T* last, T* dest)
 		{
 			if constexpr (std::is_trivially_move_constructible_v<T>)
 			{
-				const size_type size = static_cast<size_type>(last - first) * sizeof(T);
-				memmove(reinterpret_cast<void*>(dest), first, size);
+				if (!std::is_constant_evaluated())
+				{
+					const size_type size = static_cast<size_type>(last - first) * sizeof(T);
+					memmove(static_cast<void*>(dest), first, size);
+					return;
+				}
 			}
-			else
+
+			while (first != last)
 			{
-				while (first != last)
+				std::construct_at(dest, std::move(*first));
+				++dest;
+				++first;
+			}
+		}
+		
+		// Moves [first, last) to new memory [dest,...) and destroys the source elements
+		static constexpr void _relocateRange(T* first, T* last, T* dest)
+		{
+			if constexpr (is_trivially_relocatable_v<T>)
+			{
+				if (!std::is_constant_evaluated())
 				{
-					new(dest) T(std::move(*first));
-					++dest;
-					++first;
+					const size_type size = static_cast<size_type>(last - first) * sizeof(T);
+					memmove(static_cast<void*>(dest), first, size);
+					_debugFill(first, static_cast<size_type>(last - first), 0xDD);
+					return;
 				}
 			}
+
+			_moveConstructRange(first, last, dest);
+			_destroyRange(first, last);
 		}
-		
+
 		// Copy assigns [first, last) to [dest,...)
-		static T* _copyAssignRange(const T* first, const T* last, T* dest)
+		static constexpr T* _copyAssignRange(const T* first, const T* last, T* dest)
 		{
 			if constexpr(std::is_trivially_copy_assignable_v<T>)
 			{
-				const size_type count = static_cast<size_type>(last - first);
-				memmove(reinterpret_cast<void*>(dest), first, count * sizeof(T));
-				return dest + count;
+				if (!std::is_constant_evaluated())
+				{
+					const size_type count = static_cast<size_type>(last - first);
+					memmove(static_cast<void*>(dest), first, count * sizeof(T));
+					return dest + count;
+				}
 			}
 
 			while(first != last)
@@ -194,13 +334,16 @@ namespace detail
 
 		// Moves [first, last) to [dest,...)
 		// Returns a pointer after the last pos we moved to. As-in: "dest + count"
-		static T* _moveAssignRange(T* first, T* last, T* dest)
+		static constexpr T* _moveAssignRange(T* first, T* last, T* dest)
 		{
 			if constexpr (std::is_trivially_move_assignable_v<T>)
 			{
-				const size_type count = static_cast<size_type>(last - first);
-				memmove(reinterpret_cast<void*>(dest), first, count * sizeof(T));
-				return dest + count;
+				if (!std::is_constant_evaluated())
+				{
+					const size_type count = static_cast<size_type>(last - first);
+					memmove(static_cast<void*>(dest), first, count * sizeof(T));
+					return dest + count;
+				}
 			}
 
 			while (first != last)
@@ -214,56 +357,85 @@ namespace detail
 
 		//
 		// move [first, last) to [..., dest)
-		T* _moveAssignBackwardRange(T* first, T* last, T* dest)
+		constexpr T* _moveAssignBackwardRange(T* first, T* last, T* dest)
 		{
 			if constexpr (std::is_trivially_move_assignable_v<T>)
 			{
-				const size_type count = static_cast<size_type>(last - first);
-				memmove(reinterpret_cast<void*>(dest - count), first, count * sizeof(T));
-			}
-			else
-			{
-				while (first != last)
+				if (!std::is_constant_evaluated())
 				{
-					--dest;
-					--last;
-					*dest = std::move(*last);
+					const size_type count = static_cast<size_type>(last - first);
+					memmove(static_cast<void*>(dest - count), first, count * sizeof(T));
+					return dest - count;
 				}
 			}
 
+			while (first != last)
+			{
+				--dest;
+				--last;
+				*dest = std::move(*last);
+			}
+
 			return dest;
 		}
 
-		T* _allocate(size_type capacity)
+		// In constant evaluation, memory comes from std::allocator, since that's the only allocation the compiler
+		// allows there. It's freed before evaluation ends, so VectorAllocator never sees those pointers.
+		constexpr T* _allocate(size_type capacity)
 		{
 			if (capacity == 0)
 			{
 				return nullptr;
 			}
+			else if (std::is_constant_evaluated())
+			{
+				return std::allocator<T>().allocate(capacity);
+			}
 			else
 			{
-				T* ptr = reinterpret_cast<T*>(VectorAllocator::_alloc(capacity * sizeof(T)));
-#if CZ_DEBUG
-				memset(reinterpret_cast<void*>(ptr), 0xCD, capacity * sizeof(T));
-#endif
+				T* ptr;
+				if constexpr (ms_overAligned)
+				{
+					ptr = static_cast<T*>(VectorAllocator::_allocAligned(capacity * sizeof(T), Alignment));
+				}
+				else
+				{
+					ptr = static_cast<T*>(VectorAllocator::_alloc(capacity * sizeof(T)));
+				}
+				_debugFill(ptr, capacity, 0xCD);
 				return ptr;
 			}
 		}
 
-		void _free(void* ptr)
+		// capacity needs to be what the memory was allocated with
+		constexpr void _free(T* ptr, size_type capacity)
 		{
-			VectorAllocator::_free(ptr);
+			if (std::is_constant_evaluated())
+			{
+				if (ptr)
+				{
+					std::allocator<T>().deallocate(ptr, capacity);
+				}
+			}
+			else if constexpr (ms_overAligned)
+			{
+				VectorAllocator::_freeAligned(ptr);
+			}
+			else
+			{
+				VectorAllocator::_free(ptr);
+			}
 		}
 
 	};
 
 } // namespace detail
 
-template<typename T>
-class vector : public detail::base_vector<T>
+template<typename T, size_t Alignment>
+class vector : public detail::base_vector<T, Alignment>
 {
 private:
-	using util = detail::base_vector<T>;
+	using util = detail::base_vector<T, Alignment>;
 	using value_type = T;
 	using size_type = std::size_t;
 	using reference = value_type&;
@@ -272,7 +444,7 @@ public:
 	
 	constexpr vector() noexcept {}
 
-	explicit vector(size_type count) noexcept
+	explicit constexpr vector(size_type count) noexcept
 		: m_data(util::_allocate(count))
 		, m_capacity(count)
 		, m_size(count)
@@ -280,7 +452,7 @@ public:
 		util::_constructN(m_data, count);
 	}
 
-	explicit vector(size_type count, const T& value) noexcept
+	explicit constexpr vector(size_type count, const T& value) noexcept
 		: m_data(util::_allocate(count))
 		, m_capacity(count)
 		, m_size(count)
@@ -288,22 +460,22 @@ public:
 		util::_constructN(m_data, count, value);
 	}
 
-	vector(const vector& other) noexcept
+	constexpr vector(const vector& other) noexcept
 		: m_data(util::_allocate(other.m_size))
-		, m_capacity(other.m_capacity)
+		, m_capacity(other.m_size)
 		, m_size(other.m_size)
 	{
 		util::_copyConstructRange(other._ptrAt(0), other._ptrAt(other.m_size), _ptrAt(0));
 	}
 
-	vector(vector&& other) noexcept
+	constexpr vector(vector&& other) noexcept
 		: m_data(util::_exchange(other.m_data, nullptr))
 		, m_capacity(util::_exchange(other.m_capacity, 0))
 		, m_size(util::_exchange(other.m_size, 0))
 	{
 	}
 
-	vector& operator=(const vector& other) noexcept
+	constexpr vector& operator=(const vector& other) noexcept
 	{
 		if (this != &other)
 		{
@@ -312,7 +484,7 @@ public:
 		return *this;
 	}
 
-	vector& operator=(vector&& other) noexcept
+	constexpr vector& operator=(vector&& other) noexcept
 	{
 		if (this != &other)
 		{
@@ -324,7 +496,7 @@ public:
 		return *this;
 	}
 
-	~vector() noexcept
+	constexpr ~vector() noexcept
 	{
 		_tidy();
 	}
@@ -332,13 +504,13 @@ public:
 	//
 	// Element access
 	//
-	T* data()
+	constexpr T* data()
 	{
-		return static_cast<T*>(m_data);
+		return m_data;
 	}
-	const T* data() const
+	constexpr const T* data() const
 	{
-		return static_cast<const T*>(m_data);
+		return m_data;
 	}
 
 	// "at" is not implemented since it requires throwing a std::out_of_range exception
@@ -347,37 +519,37 @@ public:
 	const T& at(size_type pos);
 	*/
 
-	T& operator[](size_type pos)
+	constexpr T& operator[](size_type pos)
 	{
 		CZ_VECTOR_ASSERT_SLOW(pos < m_size);
 		return _refAt(pos);
 	}
 	
-	const T& operator[](size_type pos) const
+	constexpr const T& operator[](size_type pos) const
 	{
 		CZ_VECTOR_ASSERT_SLOW(pos < m_size);
 		return _refAt(pos);
 	}
 
-	T& front()
+	constexpr T& front()
 	{
 		CZ_VECTOR_ASSERT_SLOW(m_size);
 		return _refAt(0);
 	}
 	
-	const T& front() const
+	constexpr const T& front() const
 	{
 		CZ_VECTOR_ASSERT_SLOW(m_size);
 		return _refAt(0);
 	}
 
-	T& back()
+	constexpr T& back()
 	{
 		CZ_VECTOR_ASSERT_SLOW(m_size);
 		return _refAt(m_size-1);
 	}
 	
-	const T& back() const
+	constexpr const T& back() const
 	{
 		CZ_VECTOR_ASSERT_SLOW(m_size);
 		return _refAt(m_size-1);
@@ -386,22 +558,22 @@ public:
 	//
 	// Iterators
 	//
-	T* begin() noexcept
+	constexpr T* begin() noexcept
 	{
 		return _ptrAt(0);
 	}
 
-	const T* begin() const noexcept
+	constexpr const T* begin() const noexcept
 	{
 		return _ptrAt(0);
 	}
 
-	T* end() noexcept
+	constexpr T* end() noexcept
 	{
 		return _ptrAt(m_size);
 	}
 
-	const T* end() const noexcept
+	constexpr const T* end() const noexcept
 	{
 		return _ptrAt(m_size);
 	}
@@ -410,17 +582,17 @@ public:
 	//
 	// Capacity related methods
 	//
-	bool empty() const noexcept
+	constexpr bool empty() const noexcept
 	{
 		return m_size==0 ? true : false;
 	}
 
-	size_type size() const noexcept
+	constexpr size_type size() const noexcept
 	{
 		return m_size;
 	}
 
-	void reserve(size_type newCapacity)
+	constexpr void reserve(size_type newCapacity)
 	{
 		if (newCapacity > m_capacity)
 		{
@@ -428,12 +600,12 @@ public:
 		}
 	}
 
-	size_type capacity() const
+	constexpr size_type capacity() const
 	{
 		return m_capacity;
 	}
 
-	void shrink_to_fit()
+	constexpr void shrink_to_fit()
 	{
 		_setCapacity(m_size);
 	}
@@ -441,13 +613,13 @@ public:
 	//
 	// Modifiers API
 	//
-	void clear() noexcept
+	constexpr void clear() noexcept
 	{
 		_clear();
 	}
 
 	template<typename... Args>
-	T& emplace_back(Args&&... args)
+	constexpr T& emplace_back(Args&&... args)
 	{
 		if (m_size == m_capacity)
 		{
@@ -457,7 +629,7 @@ public:
 	}
 
 	template<typename... Args>
-	T* emplace(T* pos, Args&&... args)
+	constexpr T* emplace(T* pos, Args&&... args)
 	{
 		CZ_VECTOR_CHECK_ITERATOR(pos);
 
@@ -485,17 +657,64 @@ public:
 		}
 	}
 
-	T* insert(T* pos, const T& value)
+	constexpr T* insert(T* pos, const T& value)
 	{
 		return emplace(pos, value);
 	}
 
-	T* insert(T* pos, T&& value)
+	constexpr T* insert(T* pos, T&& value)
 	{
 		return emplace(pos, std::move(value));
 	}
 
-	T* erase(const T* _pos)
+	// Inserts copies of [first, last) before pos. The range can't be part of this vector
+	constexpr T* insert(const T* _pos, const T* first, const T* last)
+	{
+		T* pos = const_cast<T*>(_pos);
+		CZ_VECTOR_CHECK_ITERATOR(pos);
+		CZ_VECTOR_CHECK_ITERATOR_EXTERNAL_RANGE(first, last);
+
+		const size_type count = static_cast<size_type>(last - first);
+		const size_type posIndex = _ptrToIndex(pos);
+		if (count == 0)
+		{
+			return pos;
+		}
+
+		if (m_size + count > m_capacity)
+		{
+			const size_type newSize = m_size + count;
+			T* newVec = util::_allocate(newSize);
+			util::_copyConstructRange(first, last, newVec + posIndex);
+			util::_relocateRange(_ptrAt(0), _ptrAt(posIndex), newVec);
+			util::_relocateRange(_ptrAt(posIndex), _ptrAt(m_size), newVec + posIndex + count);
+			_changeArray(newVec, newSize, newSize);
+		}
+		else
+		{
+			T* oldEnd = _ptrAt(m_size);
+			const size_type tail = m_size - posIndex;
+			if (count <= tail)
+			{
+				// The last count elements go to unused capacity, and the rest of the tail shifts by count
+				util::_moveConstructRange(oldEnd - count, oldEnd, oldEnd);
+				util::_moveAssignBackwardRange(pos, oldEnd - count, oldEnd);
+				util::_copyAssignRange(first, last, pos);
+			}
+			else
+			{
+				// The whole tail goes to unused capacity, and so does the part of the range that goes past oldEnd
+				util::_copyConstructRange(first + tail, last, oldEnd);
+				util::_moveConstructRange(pos, oldEnd, oldEnd + (count - tail));
+				util::_copyAssignRange(first, first + tail, pos);
+			}
+			m_size += count;
+		}
+
+		return _ptrAt(posIndex);
+	}
+
+	constexpr T* erase(const T* _pos)
 	{
 		T* pos = const_cast<T*>(_pos);
 		CZ_VECTOR_CHECK_ITERATOR_DEREFERANCEABLE(pos);
@@ -506,7 +725,7 @@ public:
 	}
 
 	// erases [first, last)
-	T* erase(const T* _first, const T* _last)
+	constexpr T* erase(const T* _first, const T* _last)
 	{
 		CZ_VECTOR_CHECK_ITERATOR_RANGE(_first, _last);
 		T* first = const_cast<T*>(_first);
@@ -527,23 +746,39 @@ public:
 		return first;
 	}
 
-	void assign(const T* first, const T* last)
+	// Erases pos by moving the last element into its place. O(1), but doesn't keep the order of the elements.
+	// Returns pos, which now holds what was the last element (or is end() if pos was the last element).
+	constexpr T* erase_unordered(const T* _pos)
+	{
+		T* pos = const_cast<T*>(_pos);
+		CZ_VECTOR_CHECK_ITERATOR_DEREFERANCEABLE(pos);
+		T* last = _ptrAt(m_size - 1);
+		if (pos != last)
+		{
+			*pos = std::move(*last);
+		}
+		util::_destroySingle(last);
+		m_size--;
+		return pos;
+	}
+
+	constexpr void assign(const T* first, const T* last)
 	{
 		CZ_VECTOR_CHECK_ITERATOR_EXTERNAL_RANGE(first, last);
 		_assign_range(first, last);
 	}
 
-	void push_back(const T& value)
+	constexpr void push_back(const T& value)
 	{
 		emplace_back(value);
 	}
 
-	void push_back(T&& value)
+	constexpr void push_back(T&& value)
 	{
 		emplace_back(std::move(value));
 	}
 
-	void pop_back()
+	constexpr void pop_back()
 	{
 		CZ_VECTOR_ASSERT_SLOW(m_size>0);
 		util::_destroyRange(_ptrAt(m_size-1), _ptrAt(m_size));
@@ -553,17 +788,21 @@ public:
 	//
 	// operators
 	//
-	friend bool operator==(const vector<T>& a, const vector<T>& b)
+	friend constexpr bool operator==(const vector& a, const vector& b)
 	{
 		if (a.m_size != b.m_size)
 		{
 			return false;
 		}
 
-		return std::equal(a._ptrAt(0), a._ptrAt(a.m_size), b._ptrAt(0));
+		if (std::is_constant_evaluated())
+		{
+			return std::equal(a._ptrAt(0), a._ptrAt(a.m_size), b._ptrAt(0));
+		}
+		return cz::equal(a._ptrAt(0), a._ptrAt(a.m_size), b._ptrAt(0));
 	}
 
-	friend bool operator!=(const vector<T>& a, const vector<T>& b)
+	friend constexpr bool operator!=(const vector& a, const vector& b)
 	{
 		return !(operator==(a,b));
 	}
@@ -573,7 +812,7 @@ public:
 private:
 
 	// Assigns a range
-	void _assign_range(const T* first, const T* last)
+	constexpr void _assign_range(const T* first, const T* last)
 	{
          const size_t newSize = last - first;
 		
@@ -584,7 +823,17 @@ private:
 				_clearAndSetCapacity(newSize);
 			}
 
-			memmove(_ptrAt(0), first, newSize * sizeof(T));
+			if (std::is_constant_evaluated())
+			{
+				// Elements past m_size aren't alive yet, so they need constructing instead of assigning
+				const size_type assignCount = util::_min(newSize, m_size);
+				util::_copyAssignRange(first, first + assignCount, _ptrAt(0));
+				util::_copyConstructRange(first + assignCount, last, _ptrAt(assignCount));
+			}
+			else
+			{
+				cz::copy(first, last, _ptrAt(0));
+			}
 			m_size = newSize;
 		}
 		else
@@ -613,7 +862,7 @@ private:
 	}
 
 	template<typename... Args>
-	T* _emplace_reallocate(const T* pos, Args&&... args)
+	constexpr T* _emplace_reallocate(const T* pos, Args&&... args)
 	{
 		CZ_VECTOR_ASSERT_SLOW(m_size == m_capacity);
 		
@@ -630,25 +879,25 @@ private:
 		if (posIndex == m_size)
 		{
 			// Move all elements to the new memory
-			util::_moveConstructRange(_ptrAt(0), _ptrAt(m_size), newVec);
+			util::_relocateRange(_ptrAt(0), _ptrAt(m_size), newVec);
 		}
 		else
 		{
 			// If we are inserting between members, we need to split the move into two blocks
-			util::_moveConstructRange(_ptrAt(0), _ptrAt(posIndex), newVec);
-			util::_moveConstructRange(_ptrAt(posIndex), _ptrAt(m_size), newVec + posIndex + 1); 
+			util::_relocateRange(_ptrAt(0), _ptrAt(posIndex), newVec);
+			util::_relocateRange(_ptrAt(posIndex), _ptrAt(m_size), newVec + posIndex + 1); 
 		}
 
 		_changeArray(newVec, newSize, newCapacity);
 		return _ptrAt(posIndex);
 	}
 
-	void _tidy()
+	constexpr void _tidy()
 	{
 		if (m_data)
 		{
 			util::_destroyRange(_ptrAt(0), _ptrAt(m_size));
-			util::_free(m_data);
+			util::_free(m_data, m_capacity);
 			m_data = nullptr;
 			m_size = 0;
 			m_capacity = 0;
@@ -656,13 +905,13 @@ private:
 	}
 
 	//
-	// Replaces all internals with a set of fully constructed data
-	void _changeArray(T* newVec, size_type newSize, size_type newCapacity)
+	// Replaces all internals with a set of fully constructed data.
+	// The old elements are expected to have been relocated already, so only the memory is freed.
+	constexpr void _changeArray(T* newVec, size_type newSize, size_type newCapacity)
 	{
 		if (m_data)
 		{
-			util::_destroyRange(_ptrAt(0), _ptrAt(m_size));
-			util::_free(m_data);
+			util::_free(m_data, m_capacity);
 		}
 
 		m_data = newVec;
@@ -670,33 +919,33 @@ private:
 		m_capacity = newCapacity;
 	}
 
-	inline const T& _refAt(size_type index) const
+	constexpr const T& _refAt(size_type index) const
 	{
-		return *(reinterpret_cast<const T*>(&(((char*)m_data)[sizeof(T) * index])));
+		return m_data[index];
 	}
 
-	inline T& _refAt(size_type index)
+	constexpr T& _refAt(size_type index)
 	{
-		return *(reinterpret_cast<T*>(&(((char*)m_data)[sizeof(T) * index])));
+		return m_data[index];
 	}
 
-	inline const T* _ptrAt(size_type index) const
+	constexpr const T* _ptrAt(size_type index) const
 	{
-		return reinterpret_cast<const T*>(&(((char*)m_data)[sizeof(T) * index]));
+		return m_data + index;
 	}
 
-	inline T* _ptrAt(size_type index)
+	constexpr T* _ptrAt(size_type index)
 	{
-		return reinterpret_cast<T*>(&(((char*)m_data)[sizeof(T) * index]));
+		return m_data + index;
 	}
 
-	inline size_type _ptrToIndex(const T* pos)
+	constexpr size_type _ptrToIndex(const T* pos)
 	{
-		return pos - (T*)m_data;
+		return pos - m_data;
 	}
 
 	template<typename... Args>
-	T& _emplace_back_with_unused_capacity(Args&&... args)
+	constexpr T& _emplace_back_with_unused_capacity(Args&&... args)
 	{
 		T* ptr = _ptrAt(m_size);
 		util::_constructSingle(ptr, std::forward<Args>(args)...);
@@ -706,7 +955,7 @@ private:
 
 	// Can be used to grow or shrink to fit.
 	// If newCapacity is 0, it will deallocate the buffer
-	void _setCapacity(size_type newCapacity)
+	constexpr void _setCapacity(size_type newCapacity)
 	{
 		CZ_VECTOR_ASSERT_SLOW(newCapacity >= m_size);
 
@@ -716,7 +965,7 @@ private:
 		}
 		else if (newCapacity == 0)
 		{
-			util::_free(m_data);
+			util::_free(m_data, m_capacity);
 			m_data = nullptr;
 			m_capacity = 0;
 		}
@@ -728,17 +977,16 @@ private:
 			{
 				T* oldFirst = _ptrAt(0);
 				T* oldLast = _ptrAt(m_size);
-				util::_moveConstructRange(oldFirst, oldLast, newVec);
-				util::_destroyRange(oldFirst, oldLast);
+				util::_relocateRange(oldFirst, oldLast, newVec);
 			}
 			
-			util::_free(m_data);
+			util::_free(m_data, m_capacity);
 			m_data = newVec;
 			m_capacity = newCapacity;
 		}
 	}
 
-	void _clear()
+	constexpr void _clear()
 	{
 		if (m_size)
 		{
@@ -747,17 +995,67 @@ private:
 		}
 	}
 
-	void _clearAndSetCapacity(size_t newCapacity)
+	constexpr void _clearAndSetCapacity(size_t newCapacity)
 	{
 		_clear();
 		_setCapacity(newCapacity);
 	}
 	
 
-	void* m_data = nullptr;
+	T* m_data = nullptr;
 	size_type m_capacity = 0;
 	size_type m_size = 0;
 };
 
+/**
+ * Erases all elements for which pred is true, in a single pass, and returns how many were erased.
+ * Unlike calling erase for each element, every kept element is moved at most once.
+ */
+template<typename T, size_t Alignment, typename Pred>
+constexpr size_t erase_if(vector<T, Alignment>& v, Pred pred)
+{
+	T* newEnd = std::remove_if(v.begin(), v.end(), pred);
+	const size_t count = static_cast<size_t>(v.end() - newEnd);
+	v.erase(newEnd, v.end());
+	return count;
+}
+
+template<typename T, size_t Alignment, typename U>
+constexpr size_t erase(vector<T, Alignment>& v, const U& value)
+{
+	return erase_if(v, [&value](const T& e) { return e == value; });
+}
+
+/**
+ * Runs Make (a lambda or function returning a cz::vector) at compile time, and copies the result into a std::array,
+ * so tables can be built with the vector API and still end up in read-only data, without any runtime cost. E.g:
+ *
+ *	constexpr auto squares = cz::freeze_vector<[]
+ *	{
+ *		cz::vector<int> v;
+ *		for (int i = 0; i < 10; i++)
+ *			v.push_back(i * i);
+ *		return v;
+ *	}>();
+ *
+ * The vector memory can't outlive constant evaluation, which is why it can't be a constexpr variable directly.
+ * Make is called twice (once to get the size), and T needs to be default constructible.
+ */
+template<auto Make>
+consteval auto freeze_vector()
+{
+	using T = std::remove_cv_t<std::remove_reference_t<decltype(Make()[0])>>;
+	constexpr size_t count = Make().size();
+	static_assert(count > 0, "std::array doesn't support 0 elements");
+
+	std::array<T, count> res{};
+	const auto v = Make();
+	for (size_t i = 0; i < count; i++)
+	{
+		res[i] = v[i];
+	}
+	return res;
+}
+
 }
 
@@ -0,0 +1,183 @@
+#include "test_utils.h"
+#include "impl/concurrent_pool.h"
+#include <pthread.h>
+
+using namespace cz;
+
+namespace czconcurrentpooltests
+{
+	using Pool = concurrent_pool<24, 8, 4>;
+
+	struct ThreadData
+	{
+		Pool* pool;
+		int iterations;
+		bool ok;
+	};
+
+	// Allocates a few blocks at a time, writes a pattern to them, and checks nobody else touched them before freeing
+	void* stressThread(void* arg)
+	{
+		ThreadData& data = *static_cast<ThreadData*>(arg);
+		Pool::cache cache(*data.pool);
+		data.ok = true;
+		for (int i = 0; i < data.iterations; i++)
+		{
+			void* ptrs[6];
+			int count = 0;
+			for (; count < 6; count++)
+			{
+				ptrs[count] = cache.allocate();
+				if (!ptrs[count])
+				{
+					break;
+				}
+				memset(ptrs[count], (i + count) & 0xFF, Pool::block_size);
+			}
+
+			for (int j = 0; j < count; j++)
+			{
+				const unsigned char* p = static_cast<const unsigned char*>(ptrs[j]);
+				for (size_t b = 0; b < Pool::block_size; b++)
+				{
+					if (p[b] != ((i + j) & 0xFF))
+					{
+						data.ok = false;
+					}
+				}
+				cache.deallocate(ptrs[j]);
+			}
+		}
+		return nullptr;
+	}
+}
+
+using namespace czconcurrentpooltests;
+
+// Links between batches aren't kept in the blocks, so blocks can be as small as an index
+static_assert(concurrent_pool<4, 4>::block_size == 4, "");
+static_assert(!Pool::wide_tag || sizeof(Pool::tagged_type) == 8, "");
+
+TEST_CASE("concurrent_pool", "[concurrent_pool]")
+{
+	SECTION("Single thread")
+	{
+		Pool pool(10);
+		CHECK(Pool::block_size == 24);
+
+		void* ptrs[10];
+		for (auto& p : ptrs)
+		{
+			p = pool.allocate();
+			CHECK(p && pool.owns(p) && reinterpret_cast<uintptr_t>(p) % 8 == 0);
+		}
+		// Exhausted
+		CHECK(pool.allocate() == nullptr);
+
+		for (int i = 0; i < 10; i++)
+		{
+			for (int j = i + 1; j < 10; j++)
+			{
+				CHECK(ptrs[i] != ptrs[j]);
+			}
+			pool.deallocate(ptrs[i]);
+		}
+
+		int dummy;
+		CHECK(!pool.owns(&dummy));
+	}
+
+	SECTION("Cache")
+	{
+		Pool pool(10);
+		{
+			Pool::cache cache(pool);
+			void* ptrs[10];
+			for (auto& p : ptrs)
+			{
+				p = cache.allocate();
+				CHECK(p);
+			}
+			CHECK(cache.allocate() == nullptr);
+
+			for (auto& p : ptrs)
+			{
+				cache.deallocate(p);
+			}
+			// Keeps at most 2 batches locally, and gives the rest back
+			CHECK(cache.size() <= 2 * Pool::batch_size);
+			const size_t inPool = 10 - cache.size();
+			CHECK(inPool > 0);
+			size_t count = 0;
+			while (void* p = pool.allocate())
+			{
+				ptrs[count++] = p;
+			}
+			CHECK(count == inPool);
+			while (count)
+			{
+				pool.deallocate(ptrs[--count]);
+			}
+		}
+
+		// Destroying the cache gives everything back
+		Pool::cache cache(pool);
+		int count = 0;
+		while (cache.allocate())
+		{
+			count++;
+		}
+		CHECK(count == 10);
+	}
+
+	SECTION("Backend")
+	{
+		Pool pool(4);
+		concurrent_pool_backend<Pool> backend(pool);
+		const detail::VectorAllocatorBackend* b = backend.get();
+
+		void* small = b->alloc(b->userData, 16);
+		void* big = b->alloc(b->userData, 100);
+		CHECK(pool.owns(small) && !pool.owns(big));
+		b->free(b->userData, small);
+		b->free(b->userData, big);
+
+		// Sized free
+		small = b->alloc(b->userData, 16);
+		big = b->alloc(b->userData, 100);
+		b->freeSized(b->userData, small, 16);
+		b->freeSized(b->userData, big, 100);
+		CHECK(b->alloc(b->userData, 16) == small);
+		b->free(b->userData, small);
+		// The pool is destroyed before this thread exits
+		backend.flush_thread_cache();
+	}
+
+	SECTION("Multiple threads")
+	{
+		Pool pool(32);
+		constexpr int numThreads = 4;
+		pthread_t threads[numThreads];
+		ThreadData data[numThreads];
+		for (int i = 0; i < numThreads; i++)
+		{
+			data[i] = { &pool, 20000, false };
+			pthread_create(&threads[i], nullptr, stressThread, &data[i]);
+		}
+
+		for (int i = 0; i < numThreads; i++)
+		{
+			pthread_join(threads[i], nullptr);
+			CHECK(data[i].ok);
+		}
+
+		// All blocks should be back in the pool
+		Pool::cache cache(pool);
+		int count = 0;
+		while (cache.allocate())
+		{
+			count++;
+		}
+		CHECK(count == 32);
+	}
+}
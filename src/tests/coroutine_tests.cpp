@@ -0,0 +1,341 @@
+#include "test_utils.h"
+#include "impl/coroutine.h"
+#include "impl/tlsf.h"
+#include <span>
+
+using namespace cz;
+
+namespace czcoroutinetests
+{
+	int gProduced = 0;
+	int gAlive = 0;
+
+	// Tracks the lifetime of the coroutine's locals
+	struct Guard
+	{
+		Guard() { gAlive++; }
+		~Guard() { gAlive--; }
+	};
+
+	generator<int> iota(int count)
+	{
+		Guard guard;
+		for (int i = 0; i < count; i++)
+		{
+			gProduced++;
+			co_yield i;
+		}
+	}
+
+	generator<int> squares(generator<int> input)
+	{
+		for (int v : input)
+		{
+			co_yield v * v;
+		}
+	}
+
+	generator<int> evens(generator<int> input)
+	{
+		for (int v : input)
+		{
+			if (v % 2 == 0)
+			{
+				co_yield v;
+			}
+		}
+	}
+
+	// Yields the input in batches of up to N elements, reusing a single buffer
+	template<size_t N>
+	generator<std::span<const int>> batches(generator<int> input)
+	{
+		int buffer[N];
+		size_t count = 0;
+		for (int v : input)
+		{
+			buffer[count++] = v;
+			if (count == N)
+			{
+				co_yield std::span<const int>(buffer, count);
+				count = 0;
+			}
+		}
+		if (count)
+		{
+			co_yield std::span<const int>(buffer, count);
+		}
+	}
+
+	generator<int> iotaWith(std::allocator_arg_t, const detail::AllocatorBackend&, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			co_yield i;
+		}
+	}
+
+	struct Counters
+	{
+		int allocs = 0;
+		int frees = 0;
+		bool fail = false;
+	};
+
+	void* countingAlloc(void* userData, size_t bytes)
+	{
+		Counters& c = *static_cast<Counters*>(userData);
+		if (c.fail)
+		{
+			return nullptr;
+		}
+		c.allocs++;
+		return malloc(bytes);
+	}
+
+	void countingFree(void* userData, void* ptr)
+	{
+		static_cast<Counters*>(userData)->frees++;
+		free(ptr);
+	}
+
+	task<int> value(int v)
+	{
+		co_return v;
+	}
+
+	task<int> sum(int a, int b)
+	{
+		const int x = co_await value(a);
+		const int y = co_await value(b);
+		co_return x + y;
+	}
+
+	task<int> chain(int depth)
+	{
+		if (depth == 0)
+		{
+			co_return 0;
+		}
+		co_return 1 + co_await chain(depth - 1);
+	}
+
+	// Something that completes later, from outside the coroutines
+	struct Event
+	{
+		std::coroutine_handle<> waiting;
+		int value = 0;
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> h) noexcept { waiting = h; }
+		int await_resume() const noexcept { return value; }
+
+		void set(int v)
+		{
+			value = v;
+			std::coroutine_handle<> h = waiting;
+			waiting = nullptr;
+			h.resume();
+		}
+	};
+
+	task<int> waitEvent(Event& e)
+	{
+		co_return co_await e * 2;
+	}
+
+	task<> waitAndStore(Event& e, int& out)
+	{
+		out = co_await waitEvent(e);
+	}
+}
+
+using namespace czcoroutinetests;
+
+CUSTOM_TEST_CASE(cz::detail::VectorTestCase, "generator", "[coroutine]")
+{
+	gProduced = 0;
+	gAlive = 0;
+
+	SECTION("Range-for")
+	{
+		int sum = 0;
+		int count = 0;
+		for (int v : iota(5))
+		{
+			sum += v;
+			count++;
+		}
+		CHECK(count == 5 && sum == 10);
+		CHECK(gAlive == 0);
+
+		generator<int> empty;
+		CHECK(!empty.valid());
+		CHECK(empty.begin() == empty.end());
+	}
+
+	SECTION("Lazy")
+	{
+		generator<int> g = iota(1000);
+		CHECK(gProduced == 0);
+		auto it = g.begin();
+		CHECK(*it == 0 && gProduced == 1);
+		++it;
+		++it;
+		CHECK(*it == 2 && gProduced == 3);
+		CHECK(gAlive == 1);
+	}
+
+	SECTION("Breaking early destroys the frame")
+	{
+		for (int v : iota(1000))
+		{
+			if (v == 10)
+			{
+				break;
+			}
+		}
+		CHECK(gAlive == 0);
+		CHECK(gProduced == 11);
+	}
+
+	SECTION("Pipeline streams one element at a time")
+	{
+		// Same result as materializing each stage into a vector
+		vector<int> expected;
+		for (int i = 0; i < 100; i++)
+		{
+			if ((i * i) % 2 == 0)
+			{
+				expected.push_back(i * i);
+			}
+		}
+
+		vector<int> result;
+		bool oneAtATime = true;
+		for (int v : evens(squares(iota(100))))
+		{
+			// The k-th result comes from the input 2*k, so nothing past it was produced yet
+			oneAtATime = oneAtATime && gProduced == static_cast<int>(result.size()) * 2 + 1;
+			result.push_back(v);
+		}
+		CHECK(oneAtATime);
+		CHECK(result == expected);
+	}
+
+	SECTION("Batches")
+	{
+		int count = 0;
+		int sum = 0;
+		int batchCount = 0;
+		for (std::span<const int> batch : batches<8>(iota(20)))
+		{
+			CHECK(batch.size() == (batchCount < 2 ? 8u : 4u));
+			for (int v : batch)
+			{
+				sum += v;
+				count++;
+			}
+			batchCount++;
+		}
+		CHECK(batchCount == 3 && count == 20 && sum == 190);
+	}
+
+	SECTION("Frame allocation")
+	{
+		Counters counters;
+		detail::AllocatorBackend backend{ &countingAlloc, &countingFree, &counters };
+
+		SECTION("Explicit backend")
+		{
+			int sum = 0;
+			for (int v : iotaWith(std::allocator_arg, backend, 4))
+			{
+				sum += v;
+			}
+			CHECK(sum == 6);
+			CHECK(counters.allocs == 1 && counters.frees == 1);
+		}
+
+		SECTION("Default goes through the operator new backend")
+		{
+			detail::NewAllocator::_setBackend(&backend);
+			{
+				generator<int> g = iota(3);
+				CHECK(counters.allocs == 1);
+			}
+			detail::NewAllocator::_setBackend(nullptr);
+			CHECK(counters.frees == 1);
+		}
+
+		SECTION("Allocation failure gives an empty generator")
+		{
+			counters.fail = true;
+			generator<int> g = iotaWith(std::allocator_arg, backend, 4);
+			CHECK(!g.valid());
+			int count = 0;
+			for (int v : g)
+			{
+				count += v + 1;
+			}
+			CHECK(count == 0);
+		}
+
+		SECTION("tlsf")
+		{
+			alignas(16) static char memory[4096];
+			tlsf heap(memory, sizeof(memory));
+			tlsf_backend tlsfBackend(heap);
+			{
+				generator<int> g = iotaWith(std::allocator_arg, *tlsfBackend.get(), 4);
+				CHECK(heap.used_bytes() > 0);
+				CHECK(*g.begin() == 0);
+			}
+			CHECK(heap.used_bytes() == 0);
+		}
+	}
+}
+
+CUSTOM_TEST_CASE(cz::detail::VectorTestCase, "task", "[coroutine]")
+{
+	SECTION("co_await and co_return")
+	{
+		task<int> t = sum(2, 3);
+		CHECK(t.valid());
+		CHECK(!t.done());
+		t.start();
+		CHECK(t.done());
+		CHECK(t.result() == 5);
+	}
+
+	SECTION("Deep chains")
+	{
+		task<int> t = chain(1000);
+		t.start();
+		CHECK(t.done());
+		CHECK(t.result() == 1000);
+	}
+
+	SECTION("Suspending on something external")
+	{
+		Event e;
+		int out = 0;
+		task<> t = waitAndStore(e, out);
+		t.start();
+		CHECK(!t.done());
+		CHECK(e.waiting);
+		e.set(21);
+		CHECK(t.done());
+		CHECK(out == 42);
+	}
+
+	SECTION("Destroying a task that never started")
+	{
+		Event e;
+		int out = 0;
+		{
+			task<> t = waitAndStore(e, out);
+		}
+		CHECK(out == 0);
+	}
+}
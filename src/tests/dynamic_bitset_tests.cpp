@@ -0,0 +1,133 @@
+#include "test_utils.h"
+#include "impl/dynamic_bitset.h"
+
+#define BITSET_TEST_CASE(Description) \
+	CUSTOM_TEST_CASE(cz::detail::VectorTestCase, Description, "[dynamic_bitset]")
+
+using namespace cz;
+
+namespace
+{
+	constexpr size_t bpw = dynamic_bitset::bits_per_word;
+}
+
+BITSET_TEST_CASE("dynamic_bitset single bit API")
+{
+	SECTION("constructors")
+	{
+		dynamic_bitset a(bpw + 3);
+		CHECK(a.size() == bpw + 3 && a.num_words() == 2);
+		CHECK(a.none() && a.count() == 0);
+
+		dynamic_bitset b(bpw + 3, true);
+		CHECK(b.all() && b.count() == bpw + 3);
+		// Bits past size() must be kept as 0
+		CHECK(b.data()[1] == 0x7);
+	}
+
+	SECTION("set/reset/flip/test")
+	{
+		dynamic_bitset a(100);
+		a.set(0).set(63).set(99);
+		CHECK(a.test(0) && a.test(63) && a[99] && !a.test(1));
+		CHECK(a.count() == 3);
+		a.reset(63);
+		CHECK(!a.test(63) && a.count() == 2);
+		a.flip(5);
+		CHECK(a.test(5));
+		a.set(5, false);
+		CHECK(!a.test(5));
+	}
+}
+
+BITSET_TEST_CASE("dynamic_bitset bulk API")
+{
+	SECTION("set all/flip all keep unused bits cleared")
+	{
+		dynamic_bitset a(bpw * 2 + 1);
+		a.set();
+		CHECK(a.count() == bpw * 2 + 1);
+		a.flip();
+		CHECK(a.none());
+		a.flip();
+		CHECK(a.all());
+		a.reset();
+		CHECK(a.none());
+	}
+
+	SECTION("find_first/find_next")
+	{
+		dynamic_bitset a(bpw * 3);
+		CHECK(a.find_first() == dynamic_bitset::npos);
+		a.set(3).set(bpw).set(bpw * 3 - 1);
+		CHECK(a.find_first() == 3);
+		CHECK(a.find_next(3) == bpw);
+		CHECK(a.find_next(bpw) == bpw * 3 - 1);
+		CHECK(a.find_next(bpw * 3 - 1) == dynamic_bitset::npos);
+	}
+
+	SECTION("and/or/xor/and_not")
+	{
+		dynamic_bitset a(70);
+		dynamic_bitset b(70);
+		a.set(1).set(2).set(69);
+		b.set(2).set(3).set(69);
+
+		dynamic_bitset c = a & b;
+		CHECK(c.count() == 2 && c.test(2) && c.test(69));
+		c = a | b;
+		CHECK(c.count() == 4);
+		c = a ^ b;
+		CHECK(c.count() == 2 && c.test(1) && c.test(3));
+		c = a;
+		c.and_not(b);
+		CHECK(c.count() == 1 && c.test(1));
+		CHECK(c != a);
+		CHECK(dynamic_bitset(a) == a);
+	}
+
+	SECTION("and/or/xor/and_not on big sets")
+	{
+		// Big enough for the SIMD loops, with a tail
+		const size_t numBits = 64 * 37 + 5;
+		dynamic_bitset a(numBits);
+		dynamic_bitset b(numBits);
+		for (size_t i = 0; i < numBits; i++)
+		{
+			a.set(i, (i * 7) % 3 == 0);
+			b.set(i, (i * 5) % 4 == 1);
+		}
+
+		dynamic_bitset andRes = a & b;
+		dynamic_bitset orRes = a | b;
+		dynamic_bitset xorRes = a ^ b;
+		dynamic_bitset andNotRes = a;
+		andNotRes.and_not(b);
+		bool ok = true;
+		for (size_t i = 0; i < numBits; i++)
+		{
+			ok = ok && andRes.test(i) == (a.test(i) && b.test(i));
+			ok = ok && orRes.test(i) == (a.test(i) || b.test(i));
+			ok = ok && xorRes.test(i) == (a.test(i) != b.test(i));
+			ok = ok && andNotRes.test(i) == (a.test(i) && !b.test(i));
+		}
+		CHECK(ok);
+
+		// With itself
+		xorRes ^= xorRes;
+		CHECK(xorRes.none());
+	}
+
+	SECTION("resize")
+	{
+		dynamic_bitset a(bpw - 2);
+		a.set(0);
+		a.resize(bpw + 4, true);
+		CHECK(a.count() == 1 + 6);
+		CHECK(a.test(0) && !a.test(1) && a.test(bpw - 2) && a.test(bpw + 3));
+		a.resize(1);
+		CHECK(a.size() == 1 && a.count() == 1 && a.num_words() == 1);
+		a.clear();
+		CHECK(a.empty());
+	}
+}
@@ -0,0 +1,133 @@
+#include "test_utils.h"
+#include "execution"
+#include "vector"
+
+using namespace cz;
+
+namespace czexecutiontests
+{
+	using namespace czvectortests;
+
+	// Runs the same checks for all policies
+	template<typename Policy>
+	void testPolicy(Policy&& policy, int count)
+	{
+		vector<int> a;
+		fillRandom(a, count, 1);
+		vector<int> b;
+		fillRandom(b, count, 2);
+
+		long long expectedSum = 0;
+		long long expectedDot = 0;
+		size_t expectedOdd = 0;
+		for (int i = 0; i < count; i++)
+		{
+			expectedSum += a[i];
+			expectedDot += static_cast<long long>(a[i]) * b[i];
+			expectedOdd += (a[i] & 1) ? 1 : 0;
+		}
+
+		CHECK(std::reduce(policy, a.begin(), a.end(), 0ll) == expectedSum);
+		CHECK(std::reduce(policy, a.begin(), a.end(), 10ll, std::plus<>()) == expectedSum + 10);
+		CHECK(std::transform_reduce(policy, a.begin(), a.end(), b.begin(), 0ll) == expectedDot);
+		CHECK(std::transform_reduce(policy, a.begin(), a.end(), 0ll, std::plus<>(), [](int x) { return x * 2ll; }) == expectedSum * 2);
+		CHECK(std::count_if(policy, a.begin(), a.end(), [](int x) { return (x & 1) != 0; }) == expectedOdd);
+
+		vector<int> out(count, 0);
+		CHECK(std::copy(policy, a.begin(), a.end(), out.begin()) == out.end());
+		CHECK(out == a);
+
+		CHECK(std::transform(policy, a.begin(), a.end(), out.begin(), [](int x) { return x + 1; }) == out.end());
+		bool ok = true;
+		for (int i = 0; i < count; i++)
+		{
+			ok = ok && out[i] == a[i] + 1;
+		}
+		CHECK(ok);
+
+		CHECK(std::transform(policy, a.begin(), a.end(), b.begin(), out.begin(), [](int x, int y) { return x - y; }) == out.end());
+		ok = true;
+		for (int i = 0; i < count; i++)
+		{
+			ok = ok && out[i] == a[i] - b[i];
+		}
+		CHECK(ok);
+
+		std::fill(policy, out.begin(), out.end(), 7);
+		std::for_each(policy, out.begin(), out.end(), [](int& x) { x *= 2; });
+		CHECK(std::count_if(policy, out.begin(), out.end(), [](int x) { return x == 14; }) == static_cast<size_t>(count));
+	}
+}
+
+using namespace czexecutiontests;
+
+TEST_CASE("execution", "[algorithm]")
+{
+	SECTION("Policies")
+	{
+		CHECK(std::is_execution_policy_v<std::execution::sequenced_policy>);
+		CHECK(std::is_execution_policy_v<std::execution::unsequenced_policy>);
+		CHECK(std::is_execution_policy_v<std::execution::parallel_policy>);
+		CHECK(!std::is_execution_policy_v<int>);
+	}
+
+	SECTION("Sequential versions")
+	{
+		const int a[] = { 1, 2, 3, 4 };
+		CHECK(std::accumulate(a, a + 4, 0) == 10);
+		CHECK(std::reduce(a, a + 4, 1, std::multiplies<>()) == 24);
+		CHECK(std::transform_reduce(a, a + 4, a, 0) == 30);
+		CHECK(std::count_if(a, a + 4, [](int x) { return x > 2; }) == 2);
+	}
+
+	SECTION("seq")
+	{
+		testPolicy(std::execution::seq, 0);
+		testPolicy(std::execution::seq, 3);
+		testPolicy(std::execution::seq, 1000);
+	}
+
+	SECTION("unseq")
+	{
+		testPolicy(std::execution::unseq, 0);
+		testPolicy(std::execution::unseq, 3);
+		testPolicy(std::execution::unseq, 1001);
+	}
+
+	SECTION("par")
+	{
+		testPolicy(std::execution::par, 0);
+		testPolicy(std::execution::par, 3);
+		testPolicy(std::execution::par, 100003);
+	}
+
+	SECTION("par is deterministic")
+	{
+		// Float sums depend on the grouping, so this only holds if the chunks don't depend on scheduling
+		vector<float> v;
+		for (int i = 0; i < 100000; i++)
+		{
+			v.push_back(1.0f / static_cast<float>(i + 1));
+		}
+		// Same bits with 1 and 4 threads, and from run to run
+		auto reduceBits = [&](size_t threads)
+		{
+			thread_pool pool(threads);
+			set_default_thread_pool(&pool);
+			uint32_t bits[4];
+			for (uint32_t& b : bits)
+			{
+				const float sum = std::reduce(std::execution::par, v.begin(), v.end(), 0.0f);
+				memcpy(&b, &sum, sizeof(b));
+			}
+			set_default_thread_pool(nullptr);
+			CHECK(bits[0] == bits[1] && bits[0] == bits[2] && bits[0] == bits[3]);
+			return bits[0];
+		};
+
+		CHECK(reduceBits(1) == reduceBits(4));
+	}
+
+	// par uses the default pool, which otherwise keeps its memory until exit
+	shutdown_default_thread_pool();
+}
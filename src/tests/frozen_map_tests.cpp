@@ -0,0 +1,93 @@
+#include "test_utils.h"
+#include "impl/frozen_map.h"
+
+using namespace cz;
+
+namespace czfrozenmaptests
+{
+	enum class Command
+	{
+		Start,
+		Stop,
+		Status,
+		Restart
+	};
+
+	constexpr auto gCommands = make_frozen_map<std::string_view, Command>({
+		{ "start", Command::Start },
+		{ "stop", Command::Stop },
+		{ "status", Command::Status },
+		{ "restart", Command::Restart }
+	});
+
+	// Enough keys to have buckets of several sizes
+	constexpr int gNumBig = 300;
+	constexpr auto gBig = frozen_map<int, int, gNumBig>(freeze_vector<[]
+	{
+		vector<std::pair<int, int>> v;
+		for (int i = 0; i < gNumBig; i++)
+		{
+			v.push_back({ i * 7919, i });
+		}
+		return v;
+	}>());
+}
+
+using namespace czfrozenmaptests;
+
+TEST_CASE("frozen_map", "[frozen_map]")
+{
+	SECTION("Compile time lookups")
+	{
+		static_assert(gCommands.size() == 4);
+		static_assert(gCommands.find("stop")->second == Command::Stop);
+		static_assert(gCommands.contains("restart"));
+		static_assert(!gCommands.contains("star"));
+		static_assert(gCommands.count("status") == 1);
+		static_assert(gBig.find(299 * 7919)->second == 299);
+	}
+
+	SECTION("Runtime lookups")
+	{
+		char key[] = "status";
+		CHECK(gCommands.find(key) != gCommands.end());
+		CHECK(gCommands.find(key)->second == Command::Status);
+		CHECK(gCommands.find(std::string_view(key, 4)) == gCommands.end());
+		CHECK(gCommands.find("") == gCommands.end());
+
+		bool allFound = true;
+		for (int i = 0; i < gNumBig; i++)
+		{
+			auto it = gBig.find(i * 7919);
+			allFound = allFound && it != gBig.end() && it->second == i;
+		}
+		CHECK(allFound);
+
+		bool noneFound = true;
+		for (int i = 0; i < 10000; i++)
+		{
+			noneFound = noneFound && (i % 7919 == 0 || !gBig.contains(i));
+		}
+		CHECK(noneFound);
+	}
+
+	SECTION("Iteration keeps the given order")
+	{
+		Command expected = Command::Start;
+		bool inOrder = true;
+		for (const auto& item : gCommands)
+		{
+			inOrder = inOrder && item.second == expected;
+			expected = static_cast<Command>(static_cast<int>(expected) + 1);
+		}
+		CHECK(inOrder);
+	}
+
+	SECTION("Built at runtime")
+	{
+		const int base = 1000;
+		const frozen_map<int, int, 5> m({ { base, 0 }, { base + 1, 1 }, { base + 2, 2 }, { base + 3, 3 }, { base + 4, 4 } });
+		CHECK(m.find(base + 3)->second == 3);
+		CHECK(!m.contains(base + 5));
+	}
+}
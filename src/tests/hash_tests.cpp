@@ -0,0 +1,259 @@
+#include "test_utils.h"
+#include "impl/hash.h"
+
+using namespace cz;
+
+namespace czhashtests
+{
+	struct Point
+	{
+		int32_t x;
+		int32_t y;
+	};
+
+	// Deterministic pseudo random values
+	uint64_t nextRandom(uint64_t& state)
+	{
+		state = state * 6364136223846793005ull + 1442695040888963407ull;
+		return hash_mix(state);
+	}
+
+	/**
+	 * Flips each input bit, and checks every output bit flips with a probability close to 50%.
+	 * hashFn(input) hashes `inputBytes` bytes. The allowed deviation is ~5 standard deviations for 1000 samples.
+	 */
+	template<typename F>
+	bool checkAvalanche(int inputBytes, F&& hashFn)
+	{
+		static constexpr int maxBytes = 64;
+		static constexpr int samples = 1000;
+		const int inputBits = inputBytes * 8;
+		// flips[inputBit][outputBit]
+		static int flips[maxBytes * 8][64];
+		memset(flips, 0, sizeof(flips));
+
+		uint64_t state = 1;
+		uint8_t input[maxBytes];
+		for (int s = 0; s < samples; s++)
+		{
+			for (int i = 0; i < inputBytes; i++)
+			{
+				input[i] = static_cast<uint8_t>(nextRandom(state));
+			}
+			const uint64_t base = hashFn(input);
+			for (int bit = 0; bit < inputBits; bit++)
+			{
+				input[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+				const uint64_t diff = base ^ hashFn(input);
+				input[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+				for (int out = 0; out < 64; out++)
+				{
+					flips[bit][out] += (diff >> out) & 1;
+				}
+			}
+		}
+
+		for (int bit = 0; bit < inputBits; bit++)
+		{
+			for (int out = 0; out < 64; out++)
+			{
+				const double p = static_cast<double>(flips[bit][out]) / samples;
+				if (p < 0.42 || p > 0.58)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Puts keys in buckets using the low bits of the hash (what power of 2 tables do), and checks the fullest
+	 * bucket isn't much above the average
+	 */
+	template<typename F>
+	bool checkBuckets(int numKeys, F&& hashForKey)
+	{
+		static constexpr int numBuckets = 1024;
+		static int buckets[numBuckets];
+		memset(buckets, 0, sizeof(buckets));
+		for (int i = 0; i < numKeys; i++)
+		{
+			buckets[hashForKey(i) & (numBuckets - 1)]++;
+		}
+
+		int maxLoad = 0;
+		for (int b : buckets)
+		{
+			maxLoad = b > maxLoad ? b : maxLoad;
+		}
+		// With 32 keys per bucket on average, a random hash basically never goes over 2x
+		return maxLoad < 2 * numKeys / numBuckets;
+	}
+}
+
+template<>
+struct cz::is_trivially_hashable<czhashtests::Point> : std::true_type {};
+
+using namespace czhashtests;
+
+TEST_CASE("hash", "[hash]")
+{
+	SECTION("Integers")
+	{
+		hash<int> h;
+		CHECK(h(1) == h(1));
+		CHECK(h(1) != h(2));
+		CHECK(hash<uint64_t>()(0) == hash<uint64_t>()(0));
+		CHECK(hash<int8_t>()(-1) != hash<int8_t>()(1));
+		CHECK(hash<long>()(5) == hash<long>()(5));
+		CHECK(hash<long long>()(5) != hash<long long>()(6));
+		CHECK(hash<unsigned long long>()(5) == hash<uint64_t>()(5));
+		static_assert(is_trivially_hashable_v<long> && is_trivially_hashable_v<long long> &&
+			is_trivially_hashable_v<unsigned long long>, "");
+		static_assert(!is_trivially_hashable_v<float> && !is_trivially_hashable_v<double>, "");
+
+		enum class Color { Red, Green };
+		CHECK(hash<Color>()(Color::Red) != hash<Color>()(Color::Green));
+
+		int a, b;
+		CHECK(hash<int*>()(&a) == hash<int*>()(&a));
+		CHECK(hash<int*>()(&a) != hash<int*>()(&b));
+	}
+
+	SECTION("Floating point")
+	{
+		CHECK(hash<float>()(0.0f) == hash<float>()(-0.0f));
+		CHECK(hash<double>()(1.0) != hash<double>()(2.0));
+	}
+
+	SECTION("Bytes")
+	{
+		// Same contents at different alignments hash the same
+		uint8_t buf[200];
+		for (int i = 0; i < 200; i++)
+		{
+			buf[i] = static_cast<uint8_t>(i * 31);
+		}
+		uint8_t copy[201];
+		memcpy(copy + 1, buf, 200);
+
+		bool sameForAllSizes = true;
+		bool differentSizesDiffer = true;
+		for (size_t size = 0; size < 200; size++)
+		{
+			sameForAllSizes = sameForAllSizes && hash_bytes(buf, size) == hash_bytes(copy + 1, size);
+			differentSizesDiffer = differentSizesDiffer && hash_bytes(buf, size) != hash_bytes(buf, size + 1);
+		}
+		CHECK(sameForAllSizes);
+		CHECK(differentSizesDiffer);
+
+		// Zeros of different lengths, and the seed
+		const uint8_t zeros[32] = {};
+		CHECK(hash_bytes(zeros, 8) != hash_bytes(zeros, 16));
+		CHECK(hash_bytes(zeros, 8, 1) != hash_bytes(zeros, 8, 2));
+	}
+
+	SECTION("string_view")
+	{
+		char a[] = "hello world";
+		char b[] = "hello world";
+		hash<std::string_view> h;
+		CHECK(h(a) == h(b));
+		CHECK(h(std::string_view(a, 5)) == h("hello"));
+		CHECK(h("hello") != h("hellp"));
+		CHECK(h("") == h(std::string_view()));
+	}
+
+	SECTION("constexpr gives the same result as runtime")
+	{
+		// Sizes that go through the different paths of hash_bytes
+		constexpr std::string_view str = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+		constexpr size_t h3 = hash<std::string_view>()(str.substr(0, 3));
+		constexpr size_t h12 = hash<std::string_view>()(str.substr(0, 12));
+		constexpr size_t h40 = hash<std::string_view>()(str.substr(0, 40));
+		constexpr size_t h62 = hash<std::string_view>()(str);
+		constexpr size_t hInt = hash<int>()(-5);
+		CHECK(h3 == hash_bytes(str.data(), 3));
+		CHECK(h12 == hash_bytes(str.data(), 12));
+		CHECK(h40 == hash_bytes(str.data(), 40));
+		CHECK(h62 == hash_bytes(str.data(), str.size()));
+		volatile int minus5 = -5;
+		CHECK(hInt == hash<int>()(minus5));
+	}
+
+	SECTION("Ranges")
+	{
+		vector<uint8_t> v1;
+		vector<uint8_t> v2;
+		for (int i = 0; i < 100; i++)
+		{
+			v1.push_back(static_cast<uint8_t>(i));
+			v2.push_back(static_cast<uint8_t>(i));
+		}
+		CHECK(hash<vector<uint8_t>>()(v1) == hash<vector<uint8_t>>()(v2));
+		CHECK(hash<vector<uint8_t>>()(v1) == hash<std::span<const uint8_t>>()(std::span<const uint8_t>(v1.data(), v1.size())));
+		v2.back() = 0;
+		CHECK(hash<vector<uint8_t>>()(v1) != hash<vector<uint8_t>>()(v2));
+
+		vector<long long> l1(5, 7);
+		vector<long long> l2(5, 7);
+		CHECK(hash<vector<long long>>()(l1) == hash<vector<long long>>()(l2));
+		CHECK(hash<vector<long long>>()(l1) == hash_bytes(l1.data(), l1.size() * sizeof(long long)));
+
+		// Not trivially hashable, so hashed element by element
+		vector<float> f1(3, 0.0f);
+		vector<float> f2(3, -0.0f);
+		CHECK(hash<vector<float>>()(f1) == hash<vector<float>>()(f2));
+
+		// Opted-in
+		const Point points[] = { { 1, 2 }, { 3, 4 } };
+		CHECK(hash_range(points, points + 2) == hash_bytes(points, sizeof(points)));
+	}
+
+	SECTION("hash_combine")
+	{
+		size_t a = 0;
+		hash_combine(a, 1);
+		hash_combine(a, 2);
+		size_t b = 0;
+		hash_combine(b, 2);
+		hash_combine(b, 1);
+		CHECK(a != b);
+
+		size_t c = 0;
+		hash_combine(c, 1);
+		hash_combine(c, 2);
+		CHECK(a == c);
+	}
+
+	SECTION("Avalanche")
+	{
+		CHECK(checkAvalanche(8, [](const uint8_t* in)
+		{
+			uint64_t v;
+			memcpy(&v, in, 8);
+			return hash_mix(v);
+		}));
+
+		// Sizes that go through the different paths of hash_bytes
+		for (int size : { 3, 8, 16, 24, 64 })
+		{
+			CHECK(checkAvalanche(size, [size](const uint8_t* in) { return hash_bytes(in, size); }));
+		}
+	}
+
+	SECTION("Bucket distribution")
+	{
+		// Sequential keys, and keys that only differ in high bits, are the usual bad cases
+		CHECK(checkBuckets(32 * 1024, [](int i) { return hash<int>()(i); }));
+		CHECK(checkBuckets(32 * 1024, [](int i) { return hash<uint64_t>()(static_cast<uint64_t>(i) << 40); }));
+		CHECK(checkBuckets(32 * 1024, [](int i) { return hash<int*>()(reinterpret_cast<int*>(static_cast<uintptr_t>(i) * 64)); }));
+		CHECK(checkBuckets(32 * 1024, [](int i)
+		{
+			char key[16];
+			const int len = snprintf(key, sizeof(key), "key%d", i);
+			return hash<std::string_view>()(std::string_view(key, len));
+		}));
+	}
+}
@@ -0,0 +1,151 @@
+#include "test_utils.h"
+#include "impl/inplace_function.h"
+
+using namespace cz;
+
+namespace czinplacefunctiontests
+{
+	int gAlive = 0;
+
+	int twice(int v) { return v * 2; }
+
+	// Callable with non-trivial copy and destruction, but with no pointers to itself, so it's relocatable
+	struct Counted
+	{
+		explicit Counted(int v) : value(v) { ++gAlive; }
+		Counted(const Counted& other) : value(other.value) { ++gAlive; }
+		~Counted() { --gAlive; }
+		int operator()(int v) const { return v + value; }
+		int value;
+	};
+
+	using Func = inplace_function<int(int)>;
+}
+
+template<>
+struct cz::is_trivially_relocatable<czinplacefunctiontests::Counted> : std::true_type
+{
+};
+
+using namespace czinplacefunctiontests;
+
+static_assert(sizeof(Func) == 5 * sizeof(void*), "");
+// The stored callable might not be trivially relocatable
+static_assert(!is_trivially_relocatable_v<Func>, "");
+
+TEST_CASE("inplace_function", "[inplace_function]")
+{
+	gAlive = 0;
+
+	SECTION("empty")
+	{
+		Func a;
+		Func b(nullptr);
+		CHECK(!a && !b);
+		CHECK(a == nullptr);
+		int (*fn)(int) = nullptr;
+		Func c(fn);
+		CHECK(!c);
+	}
+
+	SECTION("function pointer and lambdas")
+	{
+		Func a(twice);
+		CHECK(a && a(3) == 6);
+
+		int offset = 10;
+		Func b([offset](int v) { return v + offset; });
+		CHECK(b(1) == 11);
+
+		// Mutable lambdas keep their state between calls
+		inplace_function<int()> counter([n = 0]() mutable { return ++n; });
+		CHECK(counter() == 1 && counter() == 2);
+
+		int total = 0;
+		inplace_function<void(int)> sink([&total](int v) { total += v; });
+		sink(2);
+		sink(3);
+		CHECK(total == 5);
+	}
+
+	SECTION("copy, move, assignment")
+	{
+		{
+			Func a(Counted(5));
+			CHECK(gAlive == 1);
+
+			Func b(a);
+			CHECK(gAlive == 2 && b(1) == 6);
+
+			Func c(std::move(a));
+			CHECK(!a && c(1) == 6 && gAlive == 2);
+
+			c = nullptr;
+			CHECK(!c && gAlive == 1);
+
+			c = b;
+			CHECK(c(2) == 7 && gAlive == 2);
+
+			b = twice;
+			CHECK(b(2) == 4 && gAlive == 1);
+
+			b.swap(c);
+			CHECK(b(2) == 7 && c(2) == 4 && gAlive == 1);
+		}
+		CHECK(gAlive == 0);
+	}
+
+	SECTION("Capturing a vector")
+	{
+		vector<int> values;
+		for (int i = 0; i < 100; i++)
+		{
+			values.push_back(i * 3);
+		}
+
+		Func a([values](int i) { return values[i]; });
+		Func b(twice);
+		CHECK(a(10) == 30);
+
+		Func c(std::move(a));
+		CHECK(!a && c(20) == 60);
+
+		b.swap(c);
+		CHECK(b(30) == 90 && c(30) == 60);
+
+		a = std::move(b);
+		CHECK(!b && a(99) == 297);
+
+		Func d(a);
+		a = nullptr;
+		CHECK(d(1) == 3);
+
+		vector<Func> v;
+		for (int i = 0; i < 10; i++)
+		{
+			v.push_back(d);
+		}
+		v.erase(v.begin());
+		CHECK(v.size() == 9 && v[8](2) == 6);
+	}
+
+	SECTION("in a vector")
+	{
+		{
+			vector<Func> v;
+			for (int i = 0; i < 10; i++)
+			{
+				v.emplace_back(Counted(i));
+			}
+			CHECK(gAlive == 10);
+			for (int i = 0; i < 10; i++)
+			{
+				CHECK(v[i](100) == 100 + i);
+			}
+
+			v.erase(v.begin());
+			CHECK(gAlive == 9 && v[0](0) == 1);
+		}
+		CHECK(gAlive == 0);
+	}
+}
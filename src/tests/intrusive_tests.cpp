@@ -0,0 +1,193 @@
+#include "czmut/czmut.h"
+#include "impl/intrusive.h"
+
+using namespace cz;
+
+namespace czintrusivetests
+{
+	struct Node
+	{
+		explicit Node(int value) : value(value) {}
+		int value;
+		intrusive_list_hook listHook;
+		intrusive_slist_hook slistHook;
+	};
+
+	using List = intrusive_list<Node, &Node::listHook>;
+	using SList = intrusive_slist<Node, &Node::slistHook>;
+
+	struct NodeKey
+	{
+		int operator()(const Node& n) const { return n.value; }
+	};
+
+	struct IntHash
+	{
+		size_t operator()(int v) const { return static_cast<size_t>(v); }
+	};
+
+	using HashTable = intrusive_hash_table<Node, &Node::slistHook, NodeKey, IntHash, 4>;
+
+	template<typename Container>
+	bool listEquals(Container& c, std::initializer_list<int> expected)
+	{
+		if (c.size() != expected.size())
+		{
+			return false;
+		}
+
+		const int* e = expected.begin();
+		for (auto&& n : c)
+		{
+			if (n.value != *e++)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+using namespace czintrusivetests;
+
+TEST_CASE("intrusive_list", "[intrusive]")
+{
+	Node a(1), b(2), c(3), d(4);
+	List list;
+
+	SECTION("push/pop")
+	{
+		list.push_back(b);
+		list.push_back(c);
+		list.push_front(a);
+		CHECK(listEquals(list, {1,2,3}));
+		CHECK(b.listHook.is_linked());
+		CHECK(list.front().value == 1 && list.back().value == 3);
+
+		list.pop_front();
+		list.pop_back();
+		CHECK(listEquals(list, {2}));
+		CHECK(!a.listHook.is_linked() && !c.listHook.is_linked());
+	}
+
+	SECTION("O(1) remove and insert")
+	{
+		list.push_back(a);
+		list.push_back(b);
+		list.push_back(c);
+		list.remove(b);
+		CHECK(!b.listHook.is_linked());
+		CHECK(listEquals(list, {1,3}));
+		list.insert(list.iterator_to(c), d);
+		CHECK(listEquals(list, {1,4,3}));
+		auto it = list.erase(list.iterator_to(d));
+		CHECK(it->value == 3);
+	}
+
+	SECTION("Moving an element to another list")
+	{
+		List other;
+		list.push_back(a);
+		list.remove(a);
+		other.push_back(a);
+		CHECK(list.empty() && listEquals(other, {1}));
+		other.clear();
+	}
+
+	SECTION("clear unlinks everything")
+	{
+		list.push_back(a);
+		list.push_back(b);
+		list.clear();
+		CHECK(list.empty() && !a.listHook.is_linked() && !b.listHook.is_linked());
+	}
+
+	SECTION("Copying linked elements doesn't copy the links")
+	{
+		list.push_back(a);
+		list.push_back(b);
+		list.push_back(c);
+
+		Node copy(b);
+		CHECK(copy.value == 2 && !copy.listHook.is_linked());
+
+		// Assigning to and from linked elements keeps both lists intact
+		b = d;
+		CHECK(b.value == 4 && b.listHook.is_linked());
+		d = a;
+		CHECK(!d.listHook.is_linked());
+		CHECK(listEquals(list, {1,4,3}));
+		CHECK(list.back().value == 3);
+		list.pop_back();
+		list.pop_back();
+		CHECK(listEquals(list, {1}));
+	}
+
+	list.clear();
+}
+
+TEST_CASE("intrusive_slist", "[intrusive]")
+{
+	Node a(1), b(2), c(3);
+	SList list;
+
+	SECTION("push/pop")
+	{
+		list.push_back(b);
+		list.push_front(a);
+		list.push_back(c);
+		CHECK(listEquals(list, {1,2,3}));
+		CHECK(list.back().value == 3);
+		list.pop_front();
+		CHECK(listEquals(list, {2,3}));
+	}
+
+	SECTION("remove keeps the tail valid")
+	{
+		list.push_back(a);
+		list.push_back(b);
+		list.push_back(c);
+		list.remove(c);
+		CHECK(list.back().value == 2);
+		list.push_back(c);
+		CHECK(listEquals(list, {1,2,3}));
+		list.erase_after(list.before_begin());
+		CHECK(listEquals(list, {2,3}));
+		CHECK(!a.slistHook.is_linked());
+	}
+
+	list.clear();
+}
+
+TEST_CASE("intrusive_hash_table", "[intrusive]")
+{
+	Node nodes[] = { Node(1), Node(5), Node(9), Node(2) };
+	HashTable table;
+
+	for (Node& n : nodes)
+	{
+		table.insert(n);
+	}
+	CHECK(table.size() == 4);
+
+	SECTION("find")
+	{
+		// 1, 5 and 9 all share the same bucket
+		CHECK(table.find(5) == &nodes[1]);
+		CHECK(table.find(9) == &nodes[2]);
+		CHECK(table.find(2) == &nodes[3]);
+		CHECK(table.find(13) == nullptr);
+	}
+
+	SECTION("erase")
+	{
+		table.erase(nodes[1]);
+		CHECK(table.find(5) == nullptr);
+		CHECK(table.find(1) == &nodes[0] && table.find(9) == &nodes[2]);
+		CHECK(table.erase_key(9) == &nodes[2]);
+		CHECK(table.size() == 2);
+		CHECK(!nodes[2].slistHook.is_linked());
+	}
+
+	table.clear();
+}
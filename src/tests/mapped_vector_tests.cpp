@@ -0,0 +1,111 @@
+#include "test_utils.h"
+#include "impl/mapped_vector.h"
+#include <stdio.h>
+
+using namespace cz;
+
+namespace czmappedvectortests
+{
+	struct Record
+	{
+		uint32_t id;
+		float value;
+	};
+
+	const char* gPath = "cz_mapped_vector_test.bin";
+
+	// Overwrites bytes of the file at the given offset
+	void patchFile(long offset, const void* data, size_t size)
+	{
+		FILE* f = fopen(gPath, "r+b");
+		fseek(f, offset, SEEK_SET);
+		fwrite(data, 1, size, f);
+		fclose(f);
+	}
+}
+
+using namespace czmappedvectortests;
+
+TEST_CASE("mapped_vector", "[mapped_vector]")
+{
+	Record records[1000];
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		records[i] = { i, static_cast<float>(i) * 0.5f };
+	}
+
+	SECTION("Write and map")
+	{
+		CHECK(mapped_vector<Record>::write(gPath, records, 1000) == mapped_vector_result::ok);
+
+		mapped_vector<Record> v;
+		CHECK(v.open(gPath, mapped_advice::sequential | mapped_advice::willneed) == mapped_vector_result::ok);
+		CHECK(v.is_open());
+		CHECK(v.size() == 1000);
+		CHECK(v.front().id == 0);
+		CHECK(v.back().id == 999);
+		CHECK(v[500].value == 250.0f);
+		CHECK(reinterpret_cast<uintptr_t>(v.data()) % alignof(Record) == 0);
+		CHECK(memcmp(v.data(), records, sizeof(records)) == 0);
+
+		uint32_t sum = 0;
+		for (const Record& r : v)
+		{
+			sum += r.id;
+		}
+		CHECK(sum == 999 * 1000 / 2);
+
+		// Hints are best effort, but these should be supported on any POSIX system
+		CHECK(v.advise(mapped_advice::random));
+
+		// Move
+		mapped_vector<Record> other(std::move(v));
+		CHECK(!v.is_open());
+		CHECK(v.size() == 0);
+		CHECK(other.size() == 1000);
+		other.close();
+		CHECK(other.empty());
+		CHECK(other.data() == nullptr);
+	}
+
+	SECTION("Empty file")
+	{
+		CHECK(mapped_vector<Record>::write(gPath, nullptr, 0) == mapped_vector_result::ok);
+		mapped_vector<Record> v;
+		CHECK(v.open(gPath) == mapped_vector_result::ok);
+		CHECK(v.empty());
+		CHECK(v.begin() == v.end());
+	}
+
+	SECTION("Validation")
+	{
+		mapped_vector<Record> v;
+		CHECK(v.open("cz_mapped_vector_missing.bin") == mapped_vector_result::open_failed);
+
+		CHECK(mapped_vector<Record>::write(gPath, records, 10) == mapped_vector_result::ok);
+		// Only size and alignment can be checked
+		CHECK(mapped_vector<int32_t[2]>().open(gPath) == mapped_vector_result::ok);
+		CHECK(mapped_vector<uint64_t>().open(gPath) == mapped_vector_result::bad_element);
+		CHECK(mapped_vector<uint32_t>().open(gPath) == mapped_vector_result::bad_element);
+
+		// A count bigger than what's in the file
+		const uint64_t count = 11;
+		patchFile(16, &count, sizeof(count));
+		CHECK(v.open(gPath) == mapped_vector_result::truncated);
+		CHECK(!v.is_open());
+
+		const uint32_t version = 2;
+		patchFile(4, &version, sizeof(version));
+		CHECK(v.open(gPath) == mapped_vector_result::bad_version);
+
+		patchFile(0, "XXXX", 4);
+		CHECK(v.open(gPath) == mapped_vector_result::bad_magic);
+
+		FILE* f = fopen(gPath, "wb");
+		fwrite("CZMV", 1, 4, f);
+		fclose(f);
+		CHECK(v.open(gPath) == mapped_vector_result::no_header);
+	}
+
+	remove(gPath);
+}
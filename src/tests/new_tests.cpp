@@ -0,0 +1,128 @@
+#include "test_utils.h"
+#include <new>
+
+using namespace cz;
+
+namespace cznewtests
+{
+	// Backend that counts calls, and remembers the last sizes it saw
+	struct Counters
+	{
+		int allocs = 0;
+		int frees = 0;
+		int sizedFrees = 0;
+		size_t lastAllocSize = 0;
+		size_t lastFreeSize = 0;
+	};
+
+	void* countingAlloc(void* userData, size_t bytes)
+	{
+		Counters& c = *static_cast<Counters*>(userData);
+		c.allocs++;
+		c.lastAllocSize = bytes;
+		return malloc(bytes);
+	}
+
+	void countingFree(void* userData, void* ptr)
+	{
+		static_cast<Counters*>(userData)->frees++;
+		free(ptr);
+	}
+
+	void countingFreeSized(void* userData, void* ptr, size_t bytes)
+	{
+		Counters& c = *static_cast<Counters*>(userData);
+		c.sizedFrees++;
+		c.lastFreeSize = bytes;
+		free(ptr);
+	}
+
+	struct Obj
+	{
+		Obj() { gAlive++; }
+		~Obj() { gAlive--; }
+		char data[24];
+		static inline int gAlive = 0;
+	};
+
+	struct alignas(64) Aligned
+	{
+		char data[64];
+	};
+}
+
+using namespace cznewtests;
+
+TEST_CASE("operator new/delete", "[new]")
+{
+	Counters counters;
+	detail::AllocatorBackend backend{ &countingAlloc, &countingFree, &counters, &countingFreeSized };
+	detail::NewAllocator::_setBackend(&backend);
+
+	SECTION("Sized delete")
+	{
+		Obj* obj = new Obj;
+		CHECK(counters.allocs == 1 && counters.lastAllocSize == sizeof(Obj));
+		delete obj;
+		CHECK(counters.sizedFrees == 1 && counters.lastFreeSize == sizeof(Obj));
+		CHECK(counters.frees == 0);
+	}
+
+	SECTION("Arrays")
+	{
+		int* ints = new int[10];
+		CHECK(counters.allocs == 1 && counters.lastAllocSize == 10 * sizeof(int));
+		delete[] ints;
+		CHECK(counters.sizedFrees + counters.frees == 1);
+
+		// Needs a cookie with the count, so the destructors can be called. The size given to delete includes it.
+		Obj* objs = new Obj[5];
+		CHECK(Obj::gAlive == 5);
+		const size_t allocSize = counters.lastAllocSize;
+		CHECK(allocSize >= 5 * sizeof(Obj));
+		delete[] objs;
+		CHECK(Obj::gAlive == 0);
+		CHECK(counters.lastFreeSize == allocSize);
+	}
+
+	SECTION("nothrow")
+	{
+		int* a = new (std::nothrow) int(5);
+		int* b = new (std::nothrow) int[3];
+		CHECK(a && b && *a == 5);
+		CHECK(counters.allocs == 2);
+		delete a;
+		delete[] b;
+		CHECK(counters.sizedFrees + counters.frees == 2);
+	}
+
+	SECTION("Unsized delete without a sized backend")
+	{
+		backend.freeSized = nullptr;
+		Obj* obj = new Obj;
+		delete obj;
+		CHECK(counters.frees == 1);
+	}
+
+	SECTION("Over-aligned types don't go to the backend")
+	{
+		Aligned* a = new Aligned;
+		Aligned* arr = new Aligned[3];
+		CHECK(reinterpret_cast<uintptr_t>(a) % 64 == 0);
+		CHECK(reinterpret_cast<uintptr_t>(arr) % 64 == 0);
+		delete a;
+		delete[] arr;
+		CHECK(counters.allocs == 0);
+	}
+
+	SECTION("Placement new")
+	{
+		alignas(Obj) char buf[sizeof(Obj) * 2];
+		Obj* obj = new (buf) Obj;
+		CHECK(static_cast<void*>(obj) == buf);
+		obj->~Obj();
+		CHECK(counters.allocs == 0);
+	}
+
+	detail::NewAllocator::_setBackend(nullptr);
+}
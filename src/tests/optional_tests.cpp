@@ -0,0 +1,122 @@
+#include "test_utils.h"
+#include <optional>
+
+using namespace czvectortests;
+using namespace cz;
+
+namespace czoptionaltests
+{
+	enum class Handle : int
+	{
+		Invalid = -1
+	};
+
+	struct NonCopyable
+	{
+		explicit NonCopyable(int v) : value(v) {}
+		NonCopyable(const NonCopyable&) = delete;
+		NonCopyable(NonCopyable&&) = default;
+		NonCopyable& operator=(NonCopyable&&) = default;
+		int value;
+	};
+}
+
+template<>
+struct cz::optional_niche<czoptionaltests::Handle>
+	: cz::sentinel_niche<czoptionaltests::Handle, czoptionaltests::Handle::Invalid>
+{
+};
+
+using namespace czoptionaltests;
+
+// Niche optimization
+static_assert(sizeof(optional<int*>) == sizeof(int*), "");
+static_assert(sizeof(optional<Handle>) == sizeof(Handle), "");
+static_assert(sizeof(optional<int>) == 2 * sizeof(int), "");
+
+// Trivially copyable propagation
+static_assert(std::is_trivially_copyable_v<optional<int>>, "");
+static_assert(std::is_trivially_destructible_v<optional<int>>, "");
+static_assert(std::is_trivially_copyable_v<optional<int*>>, "");
+static_assert(!std::is_trivially_copyable_v<optional<Foo>>, "");
+static_assert(!std::is_trivially_destructible_v<optional<Foo>>, "");
+static_assert(!std::is_copy_constructible_v<optional<NonCopyable>>, "");
+static_assert(std::is_move_constructible_v<optional<NonCopyable>>, "");
+
+TEST_CASE("optional", "[optional]")
+{
+	gCounter.reset();
+
+	SECTION("Basic")
+	{
+		optional<int> a;
+		CHECK(!a && !a.has_value() && a == nullopt);
+		CHECK(a.value_or(5) == 5);
+		a = 10;
+		CHECK(a && *a == 10 && a == 10 && a.value_or(5) == 10);
+		a.reset();
+		CHECK(!a);
+		CHECK(make_optional(3) == 3);
+		CHECK(optional<int>(3) != optional<int>());
+		CHECK(optional<int>() == optional<int>());
+	}
+
+	SECTION("Niche")
+	{
+		int v = 1;
+		optional<int*> p;
+		CHECK(!p);
+		p = &v;
+		CHECK(p && *p == &v);
+		// Unlike a raw pointer, nullptr is still a valid value
+		p = nullptr;
+		CHECK(p && *p == nullptr);
+		p = nullopt;
+		CHECK(!p);
+
+		// Constant expressions work too, since the sentinel is constexpr
+		constexpr optional<Handle> empty;
+		constexpr optional<Handle> five(Handle(5));
+		CHECK(!empty && five && *five == Handle(5));
+
+		optional<Handle> h;
+		CHECK(!h);
+		h = Handle(5);
+		CHECK(h && *h == Handle(5));
+	}
+
+	SECTION("Object lifetime")
+	{
+		{
+			optional<Foo> a;
+			CHECK(gCounter.alive() == 0);
+			a.emplace(1);
+			CHECK(gCounter.alive() == 1 && a->a == 1);
+
+			optional<Foo> b(a);
+			CHECK(gCounter.alive() == 2 && gCounter.copyConstructor == 1 && *b == 1);
+
+			optional<Foo> c(std::move(a));
+			CHECK(gCounter.alive() == 3 && gCounter.moveConstructor == 1 && *c == 1);
+
+			// Assigning to an engaged optional assigns the value
+			b = c;
+			CHECK(gCounter.assigned == 1);
+
+			// Assigning an empty optional destroys the value
+			b = optional<Foo>();
+			CHECK(!b && gCounter.alive() == 2);
+
+			b = std::move(c);
+			CHECK(b && gCounter.moveConstructor == 2);
+		}
+		CHECK(gCounter.alive() == 0);
+	}
+
+	SECTION("Move only")
+	{
+		optional<NonCopyable> a(std::in_place, 5);
+		optional<NonCopyable> b(std::move(a));
+		CHECK(b->value == 5);
+	}
+}
@@ -0,0 +1,158 @@
+#include "test_utils.h"
+#include "impl/priority_queue.h"
+
+#define PQ_TEST_CASE(Description) \
+	CUSTOM_TEST_CASE(cz::detail::VectorTestCase, Description, "[priority_queue]")
+
+using namespace cz;
+
+namespace czpqtests
+{
+	struct Timer
+	{
+		int deadline;
+		size_t heapIndex;
+	};
+
+	// Min-heap by deadline
+	struct TimerCompare
+	{
+		bool operator()(const Timer* a, const Timer* b) const
+		{
+			return a->deadline > b->deadline;
+		}
+	};
+
+	struct TimerIndexUpdater
+	{
+		void operator()(Timer* t, size_t index) const
+		{
+			t->heapIndex = index;
+		}
+	};
+
+	// Pops everything, checking it comes out in order
+	template<typename Queue>
+	bool popsInOrder(Queue& q, std::initializer_list<int> expected)
+	{
+		if (q.size() != expected.size())
+		{
+			return false;
+		}
+
+		for (auto&& v : expected)
+		{
+			if (q.top() != v)
+			{
+				return false;
+			}
+			q.pop();
+		}
+		return q.empty();
+	}
+}
+
+using namespace czpqtests;
+
+PQ_TEST_CASE("Heap algorithms")
+{
+	int data[] = {5, 1, 8, 3, 9, 2, 7};
+	const size_t size = sizeof(data) / sizeof(data[0]);
+
+	SECTION("make_heap")
+	{
+		std::make_heap(data, data + size);
+		CHECK(std::is_heap(data, data + size));
+		CHECK(data[0] == 9);
+	}
+
+	SECTION("push_heap/pop_heap")
+	{
+		for (size_t i = 1; i <= size; ++i)
+		{
+			std::push_heap(data, data + i);
+			CHECK(std::is_heap(data, data + i));
+		}
+
+		for (size_t i = size; i > 0; --i)
+		{
+			std::pop_heap(data, data + i);
+			CHECK(std::is_heap(data, data + i - 1));
+		}
+
+		// Popping everything leaves the array sorted
+		CHECK(cz::mut::equals(data, size, {1,2,3,5,7,8,9}));
+	}
+
+	SECTION("custom compare")
+	{
+		std::make_heap(data, data + size, std::greater<>());
+		CHECK(std::is_heap(data, data + size, std::greater<>()));
+		CHECK(data[0] == 1);
+	}
+}
+
+PQ_TEST_CASE("priority_queue")
+{
+	SECTION("binary")
+	{
+		priority_queue<int> q;
+		for (int v : {5, 1, 8, 3, 9, 2, 7})
+		{
+			q.push(v);
+		}
+		CHECK(popsInOrder(q, {9,8,7,5,3,2,1}));
+	}
+
+	SECTION("4-ary min-heap")
+	{
+		priority_queue<int, std::greater<int>, 4> q;
+		for (int v = 20; v > 0; --v)
+		{
+			q.push(v * 7 % 20);
+		}
+		CHECK(q.size() == 20 && q.top() == 0);
+		int last = -1;
+		while (!q.empty())
+		{
+			CHECK(q.top() >= last);
+			last = q.top();
+			q.pop();
+		}
+	}
+
+	SECTION("index tracking")
+	{
+		Timer timers[6] = { {50,0}, {10,0}, {40,0}, {30,0}, {20,0}, {60,0} };
+		priority_queue<Timer*, TimerCompare, 4, TimerIndexUpdater> q;
+		for (Timer& t : timers)
+		{
+			q.push(&t);
+		}
+
+		// Every timer knows where it is
+		for (Timer& t : timers)
+		{
+			CHECK(q[t.heapIndex] == &t);
+		}
+
+		timers[5].deadline = 5;
+		q.decrease_key(timers[5].heapIndex);
+		CHECK(q.top() == &timers[5]);
+
+		// Cancel a timer
+		q.erase(timers[1].heapIndex);
+		CHECK(q.size() == 5);
+
+		timers[5].deadline = 100;
+		q.update(timers[5].heapIndex);
+
+		int expected[] = {20, 30, 40, 50, 100};
+		for (int deadline : expected)
+		{
+			CHECK(q.top()->deadline == deadline);
+			CHECK(q.top()->heapIndex == 0);
+			q.pop();
+		}
+	}
+}
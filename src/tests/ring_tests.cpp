@@ -0,0 +1,183 @@
+#include "test_utils.h"
+#include "impl/ring.h"
+
+#define RING_TEST_CASE(Description) \
+	CUSTOM_TEMPLATED_TEST_CASE(cz::detail::VectorTestCase, Description, "[ring]", int, Foo)
+
+using namespace czvectortests;
+using namespace cz;
+
+// Pushes the values 1..count
+#define CREATE_RING(r, capacity, policy, count) \
+	ring<TestType> r(capacity, policy); \
+	for(int i = 1; i <= count; i++) { r.emplace_back(i); }
+
+template<typename T>
+bool ringEquals(const cz::ring<T>& r, std::initializer_list<int> expected)
+{
+	if (r.size() != expected.size())
+	{
+		return false;
+	}
+
+	size_t idx = 0;
+	for (auto&& v : expected)
+	{
+		if (r[idx++] != v)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+RING_TEST_CASE("Ring constructors")
+{
+	gCounter.reset();
+
+	SECTION("default constructor")
+	{
+		ring<TestType> r;
+		CHECK(r.size() == 0 && r.capacity() == 0 && r.empty());
+		CHECKFOO(gCounter.totalCreated() == 0);
+	}
+
+	SECTION("with capacity doesn't construct elements")
+	{
+		ring<TestType> r(4);
+		CHECK(r.size() == 0 && r.capacity() == 4);
+		CHECKFOO(gCounter.totalCreated() == 0);
+	}
+
+	SECTION("copy constructor linearizes")
+	{
+		CREATE_RING(r, 3, ring_policy::overwrite, 5);
+		CHECK(r.second_span().size() != 0);
+		gCounter.reset();
+		ring<TestType> r2(r);
+		CHECKFOO(gCounter.copyConstructor == 3);
+		CHECK(ringEquals(r2, {3,4,5}));
+		CHECK(r2.second_span().size() == 0);
+	}
+
+	SECTION("move constructor")
+	{
+		CREATE_RING(r, 3, ring_policy::grow, 3);
+		FooCounters before = gCounter;
+		ring<TestType> r2(std::move(r));
+		CHECKFOO(before == gCounter);
+		CHECK(r.size() == 0 && r.capacity() == 0);
+		CHECK(ringEquals(r2, {1,2,3}));
+	}
+
+	SECTION("destructor")
+	{
+		{
+			CREATE_RING(r, 3, ring_policy::overwrite, 5);
+		}
+		CHECKFOO(gCounter.alive() == 0);
+	}
+}
+
+RING_TEST_CASE("Ring modifiers")
+{
+	gCounter.reset();
+
+	SECTION("grow policy")
+	{
+		CREATE_RING(r, 2, ring_policy::grow, 2);
+		CHECK(r.full());
+		r.pop_front();
+		r.emplace_back(3);
+		// Wrapped around, and now growing must keep the order
+		CHECK(r.second_span().size() == 1);
+		r.emplace_back(4);
+		CHECK(r.capacity() == 4);
+		CHECK(ringEquals(r, {2,3,4}));
+		CHECK(r.second_span().size() == 0);
+	}
+
+	SECTION("overwrite policy")
+	{
+		CREATE_RING(r, 3, ring_policy::overwrite, 3);
+		gCounter.reset();
+		r.emplace_back(4);
+		r.emplace_back(5);
+		CHECK(r.capacity() == 3);
+		CHECK(ringEquals(r, {3,4,5}));
+		CHECK(r.front() == 3 && r.back() == 5);
+		// Each push constructs a temporary and move assigns it over the oldest element
+		CHECKFOO(gCounter.moveAssigned == 2 && gCounter.alive() == 0);
+	}
+
+	SECTION("overwrite with an element of itself")
+	{
+		CREATE_RING(r, 3, ring_policy::overwrite, 3);
+		r.push_back(r.front());
+		CHECK(ringEquals(r, {2,3,1}));
+	}
+
+	SECTION("pop_front and pop_back")
+	{
+		CREATE_RING(r, 4, ring_policy::overwrite, 6);
+		gCounter.reset();
+		r.pop_front();
+		CHECK(ringEquals(r, {4,5,6}));
+		r.pop_back();
+		CHECK(ringEquals(r, {4,5}));
+		r.pop_front(2);
+		CHECK(r.empty());
+		CHECKFOO(gCounter.destructor == 4);
+	}
+
+	SECTION("pop_front across the wrap around")
+	{
+		CREATE_RING(r, 4, ring_policy::overwrite, 6);
+		r.pop_front(3);
+		CHECK(ringEquals(r, {6}));
+		CHECKFOO(gCounter.alive() == 1);
+	}
+
+	SECTION("clear")
+	{
+		CREATE_RING(r, 4, ring_policy::overwrite, 6);
+		r.clear();
+		CHECK(r.empty() && r.capacity() == 4);
+		CHECKFOO(gCounter.alive() == 0);
+	}
+
+	SECTION("reserve linearizes")
+	{
+		CREATE_RING(r, 3, ring_policy::overwrite, 4);
+		r.reserve(8);
+		CHECK(r.capacity() == 8 && r.second_span().size() == 0);
+		CHECK(ringEquals(r, {2,3,4}));
+	}
+}
+
+RING_TEST_CASE("Ring spans and iterators")
+{
+	gCounter.reset();
+
+	SECTION("spans")
+	{
+		CREATE_RING(r, 4, ring_policy::overwrite, 6);
+		std::span<TestType> a = r.first_span();
+		std::span<TestType> b = r.second_span();
+		CHECK(cz::mut::equals(a.data(), a.size(), {3,4}));
+		CHECK(cz::mut::equals(b.data(), b.size(), {5,6}));
+	}
+
+	SECTION("range-based for loop")
+	{
+		CREATE_RING(r, 3, ring_policy::overwrite, 5);
+		int expected = 3;
+		for (auto&& v : static_cast<const ring<TestType>&>(r))
+		{
+			CHECK(v == expected);
+			++expected;
+		}
+		CHECK(expected == 6);
+		CHECK(r.end() - r.begin() == 3);
+	}
+}
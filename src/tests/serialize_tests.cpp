@@ -0,0 +1,250 @@
+#include "test_utils.h"
+#include "impl/serialize.h"
+
+using namespace cz;
+
+namespace czserializetests
+{
+	struct Record
+	{
+		uint32_t id;
+		float value;
+	};
+
+	struct alignas(32) Wide
+	{
+		uint8_t bytes[32];
+	};
+
+	template<typename T>
+	vector<T> makeVector(size_t count, T first)
+	{
+		vector<T> v;
+		v.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			v.push_back(first);
+			first++;
+		}
+		return v;
+	}
+}
+
+using namespace czserializetests;
+
+TEST_CASE("serialize", "[serialize]")
+{
+	vector<uint8_t> buf;
+
+	SECTION("Elements")
+	{
+		const vector<uint32_t> ints = makeVector<uint32_t>(100, 1);
+		const Record records[] = { { 1, 1.5f }, { 2, 2.5f } };
+		serialize(buf, ints);
+		serialize(buf, std::span<const Record>(records));
+		serialize(buf, vector<uint8_t>());
+		CHECK(buf.size() % 16 == 0);
+
+		// Zero-copy views point into the buffer
+		binary_reader in(buf.data(), buf.size());
+		std::span<const uint32_t> intsView;
+		std::span<const Record> recordsView;
+		std::span<const uint8_t> emptyView;
+		CHECK(deserialize(in, intsView) == serialize_result::ok);
+		CHECK(deserialize(in, recordsView) == serialize_result::ok);
+		CHECK(deserialize(in, emptyView) == serialize_result::ok);
+		CHECK(in.at_end());
+		CHECK(intsView.data() > reinterpret_cast<const uint32_t*>(buf.data()));
+		CHECK(intsView.data() < reinterpret_cast<const uint32_t*>(buf.end()));
+		CHECK(intsView.size() == 100);
+		CHECK(memcmp(intsView.data(), ints.data(), 400) == 0);
+		CHECK(recordsView.size() == 2);
+		CHECK(recordsView[1].value == 2.5f);
+		CHECK(emptyView.empty());
+
+		// Copies
+		in.set_position(0);
+		vector<uint32_t> intsCopy;
+		CHECK(deserialize(in, intsCopy) == serialize_result::ok);
+		CHECK(intsCopy == ints);
+	}
+
+	SECTION("Alignment")
+	{
+		vector<Wide> wide;
+		wide.push_back(Wide{ { 1 } });
+		serialize(buf, vector<uint8_t>(3, 7));
+		serialize(buf, wide);
+
+		binary_reader in(buf.data(), buf.size());
+		std::span<const uint8_t> bytes;
+		CHECK(deserialize(in, bytes) == serialize_result::ok);
+		vector<Wide> wideCopy;
+		CHECK(deserialize(in, wideCopy) == serialize_result::ok);
+		CHECK(wideCopy.size() == 1);
+		CHECK(wideCopy[0].bytes[0] == 1);
+
+		// A buffer that isn't aligned like when it was written can't be viewed, but can be copied
+		vector<uint8_t> ints;
+		serialize(ints, makeVector<uint32_t>(3, 1));
+		vector<uint8_t> shiftedInts(ints.size() + 1, 0);
+		memcpy(shiftedInts.data() + 1, ints.data(), ints.size());
+		binary_reader shiftedIn(shiftedInts.data() + 1, ints.size());
+		std::span<const uint32_t> view;
+		CHECK(deserialize(shiftedIn, view) == serialize_result::misaligned);
+		CHECK(shiftedIn.position() == 0);
+		vector<uint32_t> copy;
+		CHECK(deserialize(shiftedIn, copy) == serialize_result::ok);
+		CHECK(copy == makeVector<uint32_t>(3, 1));
+	}
+
+	SECTION("Nested")
+	{
+		vector<vector<uint16_t>> nested;
+		for (size_t i = 0; i < 4; i++)
+		{
+			nested.push_back(makeVector<uint16_t>(i * 3, static_cast<uint16_t>(i * 100)));
+		}
+		serialize(buf, nested);
+		serialize(buf, makeVector<uint32_t>(2, 5));
+
+		binary_reader in(buf.data(), buf.size());
+		serialized_nested_view<uint16_t> view;
+		CHECK(deserialize(in, view) == serialize_result::ok);
+		CHECK(view.size() == 4);
+		CHECK(view[0].empty());
+		CHECK(view[3].size() == 9);
+		CHECK(view[3][8] == 308);
+		CHECK(reinterpret_cast<uintptr_t>(view[2].data()) % 16 == 0);
+
+		// The reader continues after the nested block
+		std::span<const uint32_t> after;
+		CHECK(deserialize(in, after) == serialize_result::ok);
+		CHECK(after[1] == 6);
+
+		in.set_position(0);
+		vector<vector<uint16_t>> copy;
+		CHECK(deserialize(in, copy) == serialize_result::ok);
+		CHECK(copy.size() == 4);
+		bool same = true;
+		for (size_t i = 0; i < 4; i++)
+		{
+			same = same && copy[i] == nested[i];
+		}
+		CHECK(same);
+	}
+
+	SECTION("Other byte order")
+	{
+		// What a writer with the opposite byte order produces for 3 uint32_t
+		const uint8_t otherOrder = detail::serialize_native_order == 'L' ? 'B' : 'L';
+		detail::serialize_header h = { { 'C', 'Z' }, otherOrder, 'E', __builtin_bswap32(4), __builtin_bswap64(3) };
+		uint32_t data[4] = { __builtin_bswap32(1), __builtin_bswap32(2), __builtin_bswap32(0x01020304), 0 };
+		alignas(16) uint8_t block[32];
+		memcpy(block, &h, 16);
+		memcpy(block + 16, data, 16);
+
+		binary_reader in(block, sizeof(block));
+		std::span<const uint32_t> view;
+		CHECK(deserialize(in, view) == serialize_result::byte_order);
+		vector<uint32_t> copy;
+		CHECK(deserialize(in, copy) == serialize_result::ok);
+		CHECK(copy.size() == 3);
+		CHECK(copy[0] == 1);
+		CHECK(copy[2] == 0x01020304);
+
+		// Records can't be converted
+		binary_reader in2(block, sizeof(block));
+		vector<Record> records;
+		h.elementSize = __builtin_bswap32(sizeof(Record));
+		h.count = __builtin_bswap64(1);
+		memcpy(block, &h, 16);
+		CHECK(deserialize(in2, records) == serialize_result::byte_order);
+	}
+
+	SECTION("Validation")
+	{
+		serialize(buf, makeVector<uint32_t>(10, 0));
+
+		vector<uint64_t> wrongType;
+		binary_reader in(buf.data(), buf.size());
+		CHECK(deserialize(in, wrongType) == serialize_result::bad_element_size);
+		vector<vector<uint32_t>> wrongKind;
+		CHECK(deserialize(in, wrongKind) == serialize_result::bad_kind);
+
+		binary_reader truncated(buf.data(), buf.size() - 16);
+		std::span<const uint32_t> view;
+		CHECK(deserialize(truncated, view) == serialize_result::truncated);
+		binary_reader noHeader(buf.data(), 8);
+		CHECK(deserialize(noHeader, view) == serialize_result::truncated);
+
+		buf[0] = 'X';
+		CHECK(deserialize(in, view) == serialize_result::bad_header);
+
+		// Offsets going backwards, or outside the buffer
+		vector<vector<uint8_t>> nested;
+		nested.push_back(vector<uint8_t>(3, 1));
+		nested.push_back(vector<uint8_t>(3, 2));
+		vector<uint8_t> nestedBuf;
+		serialize(nestedBuf, nested);
+		uint64_t offsets[3];
+		memcpy(offsets, nestedBuf.data() + 16, sizeof(offsets));
+
+		const uint64_t backwards = offsets[0] - 16;
+		memcpy(nestedBuf.data() + 16, &backwards, 8);
+		binary_reader in2(nestedBuf.data(), nestedBuf.size());
+		serialized_nested_view<uint8_t> nestedView;
+		CHECK(deserialize(in2, nestedView) == serialize_result::bad_offsets);
+
+		memcpy(nestedBuf.data() + 16, &offsets[0], 8);
+		const uint64_t outside = nestedBuf.size() + 16;
+		memcpy(nestedBuf.data() + 32, &outside, 8);
+		CHECK(deserialize(in2, nestedView) == serialize_result::bad_offsets);
+
+		memcpy(nestedBuf.data() + 32, &offsets[2], 8);
+		CHECK(deserialize(in2, nestedView) == serialize_result::ok);
+		CHECK(nestedView[1][2] == 2);
+	}
+
+	SECTION("Validation of unaligned nested offsets")
+	{
+		// An empty inner block followed by a non empty one:
+		// nested header at 0, offsets at 16, empty block at 48, elements block at 64, end at 96
+		vector<vector<uint32_t>> nested;
+		nested.push_back(vector<uint32_t>());
+		nested.push_back(makeVector<uint32_t>(3, 1));
+		vector<uint8_t> buf;
+		serialize(buf, nested);
+		CHECK(buf.size() == 96);
+		uint64_t offsets[3];
+		memcpy(offsets, buf.data() + 16, sizeof(offsets));
+		CHECK(offsets[0] == 48 && offsets[1] == 64 && offsets[2] == 96);
+
+		binary_reader in(buf.data(), buf.size());
+		serialized_nested_view<uint32_t> view;
+
+		// Offsets before the real header still find it, since reading skips alignment padding. The view would then
+		// read garbage as the header, so these need to fail even for empty blocks
+		for (uint64_t bad : { uint64_t(40), uint64_t(41), uint64_t(47) })
+		{
+			memcpy(buf.data() + 16, &bad, 8);
+			in.set_position(0);
+			CHECK(deserialize(in, view) == serialize_result::bad_offsets);
+			CHECK(in.position() == 0);
+		}
+		memcpy(buf.data() + 16, &offsets[0], 8);
+
+		// Inside the previous block, so that one doesn't fit anymore
+		for (uint64_t bad : { uint64_t(56), uint64_t(57) })
+		{
+			memcpy(buf.data() + 24, &bad, 8);
+			in.set_position(0);
+			CHECK(deserialize(in, view) != serialize_result::ok);
+		}
+		memcpy(buf.data() + 24, &offsets[1], 8);
+
+		in.set_position(0);
+		CHECK(deserialize(in, view) == serialize_result::ok);
+		CHECK(view.size() == 2 && view[0].size() == 0 && view[1].size() == 3 && view[1][2] == 3);
+	}
+}
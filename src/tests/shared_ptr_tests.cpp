@@ -0,0 +1,93 @@
+#include "czmut/czmut.h"
+#include <memory>
+
+namespace czsharedptrtests
+{
+	int gAlive = 0;
+
+	struct Base
+	{
+		explicit Base(int v) : value(v) { ++gAlive; }
+		virtual ~Base() { --gAlive; }
+		int value;
+	};
+
+	struct Derived : public Base
+	{
+		using Base::Base;
+	};
+
+	struct Counted : public cz::intrusive_ref_counter<Counted, cz::plain_refcount>
+	{
+		Counted() { ++gAlive; }
+		~Counted() { --gAlive; }
+	};
+}
+
+using namespace czsharedptrtests;
+
+TEMPLATED_TEST_CASE("shared_ptr", "[shared_ptr]", cz::atomic_refcount, cz::plain_refcount)
+{
+	using Ptr = cz::shared_ptr<Base, TestType>;
+	using WeakPtr = cz::weak_ptr<Base, TestType>;
+	gAlive = 0;
+
+	SECTION("make_shared")
+	{
+		{
+			Ptr p = cz::make_shared<Base, TestType>(5);
+			CHECK(p->value == 5 && p.use_count() == 1 && gAlive == 1);
+			Ptr p2 = p;
+			CHECK(p.use_count() == 2 && p2 == p);
+			Ptr p3(std::move(p2));
+			CHECK(p.use_count() == 2 && !p2);
+		}
+		CHECK(gAlive == 0);
+	}
+
+	SECTION("owning an existing pointer")
+	{
+		Ptr p(new Derived(3));
+		CHECK(p.use_count() == 1 && (*p).value == 3);
+		p.reset(new Base(4));
+		CHECK(gAlive == 1 && p->value == 4);
+		p = nullptr;
+		CHECK(gAlive == 0 && p.use_count() == 0);
+	}
+
+	SECTION("derived to base")
+	{
+		cz::shared_ptr<Derived, TestType> d = cz::make_shared<Derived, TestType>(1);
+		Ptr b = d;
+		CHECK(b.use_count() == 2 && b.get() == d.get());
+	}
+
+	SECTION("weak_ptr")
+	{
+		WeakPtr w;
+		CHECK(w.expired() && !w.lock());
+		{
+			Ptr p = cz::make_shared<Base, TestType>(1);
+			w = p;
+			CHECK(!w.expired() && w.use_count() == 1);
+			Ptr locked = w.lock();
+			CHECK(locked == p && p.use_count() == 2);
+		}
+		// The object is gone, but the control block lives until the weak_ptr goes away
+		CHECK(gAlive == 0 && w.expired() && !w.lock());
+	}
+}
+
+TEST_CASE("intrusive_ptr", "[shared_ptr]")
+{
+	gAlive = 0;
+	{
+		cz::intrusive_ptr<Counted> p(new Counted());
+		CHECK(p->use_count() == 1);
+		cz::intrusive_ptr<Counted> p2 = p;
+		CHECK(p->use_count() == 2 && p2 == p);
+		p.reset();
+		CHECK(p2->use_count() == 1 && gAlive == 1);
+	}
+	CHECK(gAlive == 0);
+}
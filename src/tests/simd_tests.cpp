@@ -0,0 +1,274 @@
+#include "test_utils.h"
+#include "impl/vector.h"
+
+using namespace cz;
+
+namespace czsimdtests
+{
+	enum class Color : uint16_t
+	{
+		Red,
+		Green,
+		Blue
+	};
+
+	// Checks find/count/minmax_element against plain loops, for all sizes and start offsets up to a few registers,
+	// so the SIMD loops and the scalar tails are covered
+	template<typename T>
+	bool checkSearch(T base)
+	{
+		constexpr int maxSize = 100;
+		T data[maxSize];
+		for (int i = 0; i < maxSize; i++)
+		{
+			data[i] = static_cast<T>(base + static_cast<T>((i * 7) % 13));
+		}
+		// A few values that only appear once, and extremes
+		data[37] = static_cast<T>(base + 20);
+		data[71] = static_cast<T>(base - 5);
+
+		for (int offset = 0; offset < 4; offset++)
+		{
+			for (int size = 0; offset + size <= maxSize; size++)
+			{
+				const T* first = data + offset;
+				const T* last = first + size;
+				for (int delta = -6; delta < 22; delta++)
+				{
+					const T value = static_cast<T>(base + delta);
+					const T* expectedFind = first;
+					while (expectedFind != last && *expectedFind != value)
+					{
+						++expectedFind;
+					}
+					size_t expectedCount = 0;
+					for (const T* p = first; p != last; ++p)
+					{
+						expectedCount += (*p == value) ? 1 : 0;
+					}
+
+					if (cz::find(first, last, value) != expectedFind || cz::count(first, last, value) != expectedCount)
+					{
+						return false;
+					}
+				}
+
+				const T* expectedMin = first;
+				const T* expectedMax = first;
+				for (const T* p = first; p != last; ++p)
+				{
+					expectedMin = *p < *expectedMin ? p : expectedMin;
+					expectedMax = *p < *expectedMax ? expectedMax : p;
+				}
+				const min_max_result<const T*> mm = cz::minmax_element(first, last);
+				if (size == 0 ? (mm.min != last || mm.max != last) : (mm.min != expectedMin || mm.max != expectedMax))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	template<typename T>
+	bool checkFill(T value)
+	{
+		T data[70];
+		const T zero = T();
+		for (int offset = 0; offset < 3; offset++)
+		{
+			for (int size = 0; offset + size <= 70; size++)
+			{
+				memset(data, 0, sizeof(data));
+				cz::fill(data + offset, data + offset + size, value);
+				for (int i = 0; i < 70; i++)
+				{
+					const bool inside = i >= offset && i < offset + size;
+					if (memcmp(&data[i], inside ? &value : &zero, sizeof(T)) != 0)
+					{
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	// Compares ranges that differ in a single byte at every position
+	bool checkEqual()
+	{
+		uint8_t a[200];
+		uint8_t b[200];
+		for (int i = 0; i < 200; i++)
+		{
+			a[i] = static_cast<uint8_t>(i);
+		}
+		memcpy(b, a, sizeof(a));
+
+		for (int size = 0; size <= 200; size++)
+		{
+			if (!cz::equal(a, a + size, b))
+			{
+				return false;
+			}
+			for (int diff = 0; diff < size; diff++)
+			{
+				b[diff] ^= 0x10;
+				const bool eq = cz::equal(a, a + size, b);
+				b[diff] ^= 0x10;
+				if (eq)
+				{
+					return false;
+				}
+			}
+		}
+
+		const uint32_t c[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		const uint32_t d[] = { 1, 2, 3, 4, 5, 6, 7, 8, 10 };
+		return cz::equal(c, c + 8, d) && !cz::equal(c, c + 9, d);
+	}
+
+	// Checks the bitwise kernels against a byte loop, for all sizes up to a few registers and a few start offsets
+	template<detail::simd_bitwise_op Op>
+	bool checkBitwise()
+	{
+		uint8_t a[300];
+		uint8_t b[300];
+		uint8_t expected[300];
+		uint8_t res[300];
+		for (int i = 0; i < 300; i++)
+		{
+			a[i] = static_cast<uint8_t>(i * 37 + 11);
+			b[i] = static_cast<uint8_t>(i * 91 + 5);
+		}
+
+		for (int offset = 0; offset < 4; offset++)
+		{
+			for (int size = 0; offset + size <= 300; size++)
+			{
+				memcpy(res, a, sizeof(a));
+				memcpy(expected, a, sizeof(a));
+				for (int i = offset; i < offset + size; i++)
+				{
+					expected[i] = detail::simd_bitwise_word<Op>(a[i], b[i]);
+				}
+				detail::simd_kernel_bitwise<Op>(res + offset, b + offset, static_cast<size_t>(size));
+				if (memcmp(res, expected, sizeof(res)) != 0)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+using namespace czsimdtests;
+
+TEST_CASE("simd", "[algorithm]")
+{
+	SECTION("copy")
+	{
+		int a[10];
+		for (int i = 0; i < 10; i++)
+		{
+			a[i] = i;
+		}
+		int b[10] = {};
+		CHECK(cz::copy(a, a + 10, b) == b + 10);
+		CHECK(memcmp(a, b, sizeof(a)) == 0);
+
+		// Overlapping
+		CHECK(cz::copy(a, a + 9, a + 1) == a + 10);
+		CHECK(a[0] == 0 && a[1] == 0 && a[9] == 8);
+	}
+
+	SECTION("All levels")
+	{
+		// Forces each level the cpu supports, so all the kernels get tested
+		int levelsTested = 0;
+		for (simd_level level : { simd_level::scalar, simd_level::sse2, simd_level::avx2, simd_level::avx512 })
+		{
+			if (set_simd_level(level) != level)
+			{
+				continue;
+			}
+			levelsTested++;
+			CHECK(get_simd_level() == level);
+
+			CHECK(checkFill<int8_t>(-3));
+			CHECK(checkFill<uint16_t>(0xABCD));
+			CHECK(checkFill<int32_t>(-123456));
+			CHECK(checkFill<uint64_t>(0x0123456789ABCDEFull));
+			CHECK(checkFill<float>(1.5f));
+			CHECK(checkFill<double>(-2.25));
+
+			CHECK(checkSearch<int8_t>(0));
+			CHECK(checkSearch<int8_t>(120));
+			CHECK(checkSearch<uint8_t>(250));
+			CHECK(checkSearch<int16_t>(-30000));
+			CHECK(checkSearch<uint16_t>(65530));
+			CHECK(checkSearch<int32_t>(-7));
+			CHECK(checkSearch<uint32_t>(0x7FFFFFFE));
+			CHECK(checkSearch<int64_t>(1ll << 40));
+			CHECK(checkSearch<uint64_t>(3));
+			CHECK(checkSearch<float>(10.0f));
+
+			CHECK(checkEqual());
+			CHECK(checkBitwise<detail::simd_bitwise_op::bit_and>());
+			CHECK(checkBitwise<detail::simd_bitwise_op::bit_or>());
+			CHECK(checkBitwise<detail::simd_bitwise_op::bit_xor>());
+			CHECK(checkBitwise<detail::simd_bitwise_op::bit_and_not>());
+		}
+		CHECK(levelsTested >= 1);
+
+		// Back to the best level
+		set_simd_level(simd_level::avx512);
+	}
+
+	SECTION("Enums and pointers")
+	{
+		const Color colors[] = { Color::Red, Color::Red, Color::Green, Color::Red, Color::Red, Color::Red, Color::Red,
+			Color::Red, Color::Red, Color::Red, Color::Blue, Color::Green };
+		CHECK(cz::find(colors, colors + 12, Color::Blue) == colors + 10);
+		CHECK(cz::count(colors, colors + 12, Color::Green) == 2);
+
+		int x[20];
+		int* ptrs[20];
+		for (int i = 0; i < 20; i++)
+		{
+			ptrs[i] = &x[i % 5];
+		}
+		CHECK(cz::find(ptrs, ptrs + 20, &x[3]) == ptrs + 3);
+		CHECK(cz::count(ptrs, ptrs + 20, &x[3]) == 4);
+	}
+
+	SECTION("Floating point uses ==")
+	{
+		const float values[] = { 1.0f, -0.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f };
+		CHECK(cz::find(values, values + 9, 0.0f) == values + 1);
+		CHECK(cz::count(values, values + 9, 0.0f) == 1);
+	}
+
+	SECTION("Different value type")
+	{
+		// 300 doesn't fit in uint8_t, so it should never match 44 (300 & 0xFF)
+		uint8_t bytes[40];
+		memset(bytes, 44, sizeof(bytes));
+		CHECK(cz::find(bytes, bytes + 40, 300) == bytes + 40);
+		CHECK(cz::count(bytes, bytes + 40, 300) == 0);
+	}
+
+	SECTION("vector uses the kernels")
+	{
+		vector<int> v(1000, 42);
+		CHECK(v.size() == 1000);
+		CHECK(cz::count(v.begin(), v.end(), 42) == 1000);
+
+		vector<int> copy(v);
+		CHECK(copy == v);
+
+		v.assign(copy.begin(), copy.begin() + 10);
+		CHECK(v.size() == 10 && v[9] == 42);
+	}
+}
@@ -0,0 +1,112 @@
+#include "test_utils.h"
+#include "impl/soa_vector.h"
+
+#define SOA_TEST_CASE(Description) \
+	CUSTOM_TEMPLATED_TEST_CASE(cz::detail::VectorTestCase, Description, "[soa_vector]", int, Foo)
+
+using namespace czvectortests;
+using namespace cz;
+
+SOA_TEST_CASE("soa_vector")
+{
+	gCounter.reset();
+
+	SECTION("default constructor")
+	{
+		soa_vector<TestType, char, double> v;
+		CHECK(v.size() == 0 && v.capacity() == 0 && v.empty());
+	}
+
+	SECTION("push_back and per column access")
+	{
+		soa_vector<TestType, char, double> v;
+		v.push_back(TestType(1), 'a', 1.5);
+		v.emplace_back(2, 'b', 2.5);
+		v.emplace_back(3, 'c', 3.5);
+		CHECK(v.size() == 3);
+
+		std::span<TestType> a = v.template column<0>();
+		std::span<char> b = v.template column<1>();
+		CHECK(cz::mut::equals(a.data(), a.size(), {1,2,3}));
+		CHECK(cz::mut::equals(b.data(), b.size(), {'a','b','c'}));
+		CHECK(v.template get<2>(1) == 2.5);
+
+		// Each column must be correctly aligned inside the single allocation
+		CHECK(reinterpret_cast<uintptr_t>(v.template column<2>().data()) % alignof(double) == 0);
+		CHECKFOO(gCounter.alive() == 3);
+	}
+
+	SECTION("row proxies")
+	{
+		soa_vector<TestType, int> v;
+		v.emplace_back(1, 10);
+		v.emplace_back(2, 20);
+		auto row = v[1];
+		CHECK(row.template get<0>() == 2 && row.template get<1>() == 20);
+		row.template get<1>() = 30;
+		CHECK(v.back().template get<1>() == 30);
+		const soa_vector<TestType, int>& cv = v;
+		CHECK(cv[0].template get<1>() == 10);
+	}
+
+	SECTION("growing moves each column")
+	{
+		soa_vector<TestType, int> v;
+		v.reserve(2);
+		v.emplace_back(1, 10);
+		v.emplace_back(2, 20);
+		gCounter.reset();
+		v.emplace_back(3, 30);
+		CHECK(v.capacity() == 4);
+		CHECKFOO(gCounter.moveConstructor == 2 && gCounter.destructor == 2);
+		CHECK(cz::mut::equals(v.template column<0>().data(), 3, {1,2,3}));
+		CHECK(cz::mut::equals(v.template column<1>().data(), 3, {10,20,30}));
+	}
+
+	SECTION("copy, move, pop_back and clear")
+	{
+		soa_vector<TestType, int> v;
+		v.emplace_back(1, 10);
+		v.emplace_back(2, 20);
+
+		soa_vector<TestType, int> v2(v);
+		CHECK(cz::mut::equals(v2.template column<0>().data(), 2, {1,2}));
+
+		soa_vector<TestType, int> v3(std::move(v2));
+		CHECK(v2.size() == 0 && v3.size() == 2);
+
+		v3.pop_back();
+		CHECK(v3.size() == 1 && v3.template get<1>(0) == 10);
+		v.clear();
+		CHECK(v.empty() && v.capacity() == 2);
+		v = v3;
+		CHECK(v.size() == 1 && v.template get<0>(0) == 1);
+		CHECKFOO(gCounter.alive() == 2);
+
+		// Copying an empty soa_vector doesn't allocate
+		soa_vector<TestType, int> empty;
+		soa_vector<TestType, int> emptyCopy(empty);
+		CHECK(emptyCopy.capacity() == 0 && emptyCopy.template column<0>().data() == nullptr);
+		v.clear();
+		soa_vector<TestType, int> clearedCopy(v);
+		CHECK(clearedCopy.empty() && clearedCopy.capacity() == 0);
+	}
+
+	SECTION("over-aligned columns")
+	{
+		struct alignas(64) Wide
+		{
+			int value;
+		};
+		soa_vector<char, Wide, TestType> v;
+		for (int i = 0; i < 10; i++)
+		{
+			v.emplace_back('a', Wide{ i }, i);
+			CHECK(reinterpret_cast<uintptr_t>(v.template column<1>().data()) % 64 == 0);
+		}
+		CHECK(v.template get<1>(9).value == 9);
+		soa_vector<char, Wide, TestType> copy(v);
+		CHECK(reinterpret_cast<uintptr_t>(copy.template column<1>().data()) % 64 == 0);
+		CHECK(copy.template get<1>(5).value == 5);
+	}
+}
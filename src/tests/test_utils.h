@@ -0,0 +1,320 @@
+#pragma once
+
+//
+// Utilities shared by the container tests
+//
+
+#include "czmut/czmut.h"
+#include <string.h>
+#include <stdlib.h>
+
+// Provide my own allocator
+#define CZ_VECTOR_UNITTEST_ALLOCATOR 1
+
+#if CZ_VECTOR_UNITTEST_ALLOCATOR
+    #include "impl/aligned_alloc.h"
+
+    namespace cz::detail
+    {
+        // Allocator with simple tracking that doesn't stl or fancy, so it minimizes dependencies
+        struct VectorAllocator
+        {
+            static constexpr int maxAllocs = 20;
+            struct Info
+            {
+                 void* ptr;
+                 size_t size;
+            };
+
+            static inline Info allocs[maxAllocs];
+
+            VectorAllocator()
+            {
+                 memset(allocs, 0, sizeof(allocs));
+            }
+
+            static size_t _calcBytesAllocated()
+            {
+                 size_t total = 0;
+                 for (auto&& slot : allocs)
+                 {
+                     total += slot.size;
+                 }
+                 return total;
+            }
+
+            static size_t _calcAllocations()
+            {
+                 size_t total = 0;
+                 for (auto&& slot : allocs)
+                 {
+                     if (slot.ptr)
+                     {
+                         total++;
+                     }
+                 }
+                 return total;
+            }
+
+            static void* _alloc(size_t bytes)
+            {
+                 Info* slot = getFreeSlot();
+                 slot->ptr = malloc(bytes);
+                 CHECK(slot->ptr);
+                 slot->size = bytes;
+                 return slot->ptr;
+            }
+
+            static void _free(void* ptr)
+            {
+                 Info* slot = getUsedSlot(ptr);
+                 free(slot->ptr);
+                 slot->ptr = nullptr;
+                 slot->size = 0;
+            }
+
+            static void* _allocAligned(size_t bytes, size_t alignment)
+            {
+                 Info* slot = getFreeSlot();
+                 slot->ptr = aligned_malloc(bytes, alignment);
+                 CHECK(slot->ptr);
+                 slot->size = bytes;
+                 return slot->ptr;
+            }
+
+            static void _freeAligned(void* ptr)
+            {
+                 Info* slot = getUsedSlot(ptr);
+                 aligned_free(slot->ptr);
+                 slot->ptr = nullptr;
+                 slot->size = 0;
+            }
+        protected:
+
+            static Info* getFreeSlot()
+            {
+                 for (auto&& slot : allocs)
+                 {
+                     if (!slot.ptr)
+                     {
+                         return &slot;
+                     }
+                 }
+                 CHECK(false);
+                 return nullptr; 
+            }
+
+            static Info* getUsedSlot(void* ptr)
+            {
+                 for (auto&& slot : allocs)
+                 {
+                     if (slot.ptr == ptr)
+                     {
+                         return &slot;
+                     }
+                 }
+                 CHECK(false);
+                 return nullptr;
+            }
+
+        };
+        
+        struct VectorAllocatorScopedCheck
+        {
+            VectorAllocatorScopedCheck()
+            {
+                 CHECK(VectorAllocator::_calcAllocations()==0);
+                 CHECK(VectorAllocator::_calcBytesAllocated()==0);
+            }
+            ~VectorAllocatorScopedCheck()
+            {
+                 CHECK(VectorAllocator::_calcAllocations()==0);
+                 CHECK(VectorAllocator::_calcBytesAllocated()==0);
+            }
+        };
+
+        class VectorTestCase : public ::cz::mut::detail::TestCase
+        {
+        public:
+            using TestCase::TestCase;
+            virtual void onEnter() override
+            {
+                 CHECK(VectorAllocator::_calcAllocations()==0);
+                 CHECK(VectorAllocator::_calcBytesAllocated()==0);
+            }
+            
+            virtual void onExit() override
+            {
+                 CHECK(VectorAllocator::_calcAllocations()==0);
+                 CHECK(VectorAllocator::_calcBytesAllocated()==0);
+            }
+        };
+    } // namespace cz::detail
+
+#else
+	namespace cz::detail
+    {
+        using VectorTestCase = cz::mut::TestCase;
+    }
+#endif
+
+#include "impl/vector.h"
+
+// Putting these inside a named namespace instead of anonymous namespace, because Visual Studio's debugger has problems
+// with symbols in anonymous namespaces
+namespace czvectortests
+{
+
+    struct FooCounters
+    {
+        int valueCounter;
+        int destructor;
+        int defaultConstructor;
+        int constructor;
+        int copyConstructor;
+        int moveConstructor;
+        int constructorExtra;
+        int assigned;
+        int moveAssigned;
+
+        FooCounters()
+        {
+            memset(this, 0, sizeof(*this));
+        }
+
+        int totalCreated() const
+        {
+            return defaultConstructor + constructor + copyConstructor + moveConstructor + constructorExtra;
+        }
+
+        int alive() const
+        {
+            return totalCreated() - destructor;
+        }
+
+        void reset()
+        {
+            memset(this, 0, sizeof(*this));
+        }
+
+        bool operator==(const FooCounters& other) const
+        {
+            return memcmp(this, &other, sizeof(*this)) == 0 ? true : false;
+        }
+    };
+
+    inline FooCounters gCounter;
+    	
+    struct Foo
+    {
+        template<typename... Args>
+        void log(Args&&... args)
+        {
+            //printf(std::forward<Args>(args)...);
+        }
+
+        Foo()
+        {
+            a = ++gCounter.valueCounter;
+            log("%p: Default Constructor (%d)\n", this, a);
+            ++gCounter.defaultConstructor;
+        }
+
+        ~Foo()
+        {
+            log("%p: Destructor(%d)\n", this, a);
+            ++gCounter.destructor;
+        }
+
+        explicit Foo(int a) : a(a)
+        {
+            log("%p: Constructor(%d)\n", this, a);
+            ++gCounter.constructor;
+        }
+
+        explicit Foo(int a, int dummy) : a(a)
+        {
+            log("%p: Constructor(%d, %d)\n", this, a, dummy);
+            ++gCounter.constructorExtra;
+        }
+
+        Foo(const Foo& other) : a(other.a)
+        {
+            log("%p: Copy constructor(%d)\n", this, other.a);
+            ++gCounter.copyConstructor;
+        }
+
+        Foo(Foo&& other) noexcept : a(other.a)
+        {
+            log("%p: Move constructor(%d)\n", this, other.a);
+            other.a = 0;
+            ++gCounter.moveConstructor;
+        }
+
+    	operator int() const
+    	{
+        	return a;
+    	}
+
+        bool operator==(int other) const
+        {
+            return a == other;
+        }
+
+        bool operator!=(int other) const
+        {
+            return a != other;
+        }
+
+        bool operator==(const Foo& other) const
+        {
+            return a == other.a;
+        }
+
+        bool operator!=(const Foo& other) const
+        {
+            return a != other.a;
+        }
+
+        Foo& operator=(const Foo& other)
+        {
+            if (this != &other)
+            {
+                 log("%p: assigned (%d) = (%d)\n", this, a, other.a);
+                 a = other.a;
+                 ++gCounter.assigned;
+            }
+            return *this;
+        }
+
+        Foo& operator=(Foo&& other)
+        {
+            if (this != &other)
+            {
+                 log("%p: move assigned (%d) = (%d)\n", this, a, other.a);
+                 a = other.a;
+                 other.a = 0;
+                 ++gCounter.moveAssigned;
+            }
+            return *this;
+        }
+
+        int a;
+    };
+
+    // Deterministic pseudo random values in [0, 1000)
+    inline void fillRandom(cz::vector<int>& v, int count, uint32_t seed)
+    {
+        v.clear();
+        v.reserve(count);
+        for (int i = 0; i < count; i++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            v.push_back(static_cast<int>(seed >> 8) % 1000);
+        }
+    }
+}
+
+// We only check object counters if using vectors of Foo
+#define CHECKFOO(expr) \
+    if constexpr (std::is_same_v<TestType, Foo>) { CHECK(expr) }
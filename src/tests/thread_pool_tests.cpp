@@ -0,0 +1,157 @@
+#include "test_utils.h"
+#include "impl/thread_pool.h"
+
+using namespace cz;
+using namespace czvectortests;
+
+TEST_CASE("sort", "[algorithm]")
+{
+	vector<int> v;
+
+	SECTION("Small and edge cases")
+	{
+		std::sort(v.begin(), v.end());
+		CHECK(v.size() == 0);
+
+		const int a[] = { 3, 1, 2 };
+		v.assign(a, a + 3);
+		std::sort(v.begin(), v.end());
+		CHECK(cz::mut::equals(v.data(), v.size(), { 1, 2, 3 }));
+
+		const int b[] = { 1, 2, 3, 4 };
+		v.assign(b, b + 4);
+		std::sort(v.begin(), v.end(), std::greater<>());
+		CHECK(cz::mut::equals(v.data(), v.size(), { 4, 3, 2, 1 }));
+	}
+
+	SECTION("Big")
+	{
+		fillRandom(v, 5000, 1);
+		std::sort(v.begin(), v.end());
+		CHECK(std::is_sorted(v.begin(), v.end()));
+
+		// Already sorted, reversed, and all equal, which are bad cases for naive quicksort
+		std::sort(v.begin(), v.end());
+		CHECK(std::is_sorted(v.begin(), v.end()));
+		std::sort(v.begin(), v.end(), std::greater<>());
+		CHECK(std::is_sorted(v.begin(), v.end(), std::greater<>()));
+		for (int& i : v)
+		{
+			i = 7;
+		}
+		std::sort(v.begin(), v.end());
+		CHECK(std::is_sorted(v.begin(), v.end()));
+	}
+}
+
+TEST_CASE("thread_pool", "[thread_pool]")
+{
+	thread_pool pool(4);
+	CHECK(pool.concurrency() == 4);
+
+	SECTION("parallel_for")
+	{
+		vector<int> v(10000, 0);
+		parallel_for(pool, v.begin(), v.end(), 100, [](int* first, int* last)
+		{
+			for (; first != last; ++first)
+			{
+				*first += 1;
+			}
+		});
+
+		bool allOnes = true;
+		for (int i : v)
+		{
+			allOnes = allOnes && (i == 1);
+		}
+		CHECK(allOnes);
+
+		// Integer ranges
+		int chunks = 0;
+		int tooBig = 0;
+		parallel_for(pool, 0, 1000, 10, [&](int first, int last)
+		{
+			__atomic_fetch_add(&chunks, 1, __ATOMIC_RELAXED);
+			if (last - first > 10)
+			{
+				__atomic_fetch_add(&tooBig, 1, __ATOMIC_RELAXED);
+			}
+		});
+		CHECK(chunks >= 100 && tooBig == 0);
+	}
+
+	SECTION("parallel_reduce")
+	{
+		vector<int> v;
+		fillRandom(v, 10000, 2);
+		long long expected = 0;
+		for (int i : v)
+		{
+			expected += i;
+		}
+
+		long long sum = parallel_reduce(pool, v.begin(), v.end(), 64, 0ll,
+			[](int* first, int* last)
+			{
+				long long s = 0;
+				for (; first != last; ++first)
+				{
+					s += *first;
+				}
+				return s;
+			},
+			[](long long a, long long b) { return a + b; });
+		CHECK(sum == expected);
+
+		// Non commutative combine, to check the order is kept
+		const int digits[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+		long long number = parallel_reduce(pool, digits, digits + 8, 1, 0ll,
+			[](const int* first, const int*) { return static_cast<long long>(*first); },
+			[](long long a, long long b)
+			{
+				long long scale = 1;
+				for (long long tmp = b; tmp; tmp /= 10)
+				{
+					scale *= 10;
+				}
+				return a * scale + b;
+			});
+		CHECK(number == 12345678);
+	}
+
+	SECTION("parallel_sort")
+	{
+		vector<int> v;
+		fillRandom(v, 50000, 3);
+		parallel_sort(pool, v.begin(), v.end(), std::less<>(), 1000);
+		CHECK(std::is_sorted(v.begin(), v.end()));
+	}
+
+	SECTION("Single thread pool")
+	{
+		thread_pool single(1);
+		vector<int> v;
+		fillRandom(v, 1000, 4);
+		parallel_sort(single, v.begin(), v.end(), std::less<>(), 100);
+		CHECK(std::is_sorted(v.begin(), v.end()));
+	}
+
+	SECTION("Default pool shutdown")
+	{
+		vector<int> v;
+		fillRandom(v, 10000, 5);
+		thread_pool* first = &default_thread_pool();
+		CHECK(&default_thread_pool() == first);
+		parallel_sort(v.begin(), v.end());
+		CHECK(std::is_sorted(v.begin(), v.end()));
+
+		// Releases the threads and memory, and is created again when needed
+		shutdown_default_thread_pool();
+		shutdown_default_thread_pool();
+		fillRandom(v, 10000, 6);
+		parallel_sort(v.begin(), v.end());
+		CHECK(std::is_sorted(v.begin(), v.end()));
+		shutdown_default_thread_pool();
+	}
+}
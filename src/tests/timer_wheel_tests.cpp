@@ -0,0 +1,231 @@
+#include "test_utils.h"
+#include "impl/timer_wheel.h"
+
+using namespace cz;
+
+namespace cztimerwheeltests
+{
+	// Small xorshift, so the stress test is the same on every run
+	struct Random
+	{
+		uint32_t state = 2463534242u;
+
+		uint32_t next()
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+	};
+
+	struct Fired
+	{
+		int count = 0;
+		uint64_t lastTick = 0;
+		bool inOrder = true;
+	};
+}
+
+using namespace cztimerwheeltests;
+
+CUSTOM_TEST_CASE(cz::detail::VectorTestCase, "timer_wheel", "[timer_wheel]")
+{
+	timer_wheel<> wheel(100);
+	CHECK(wheel.capacity() == 100);
+	CHECK(wheel.empty());
+
+	SECTION("Expires at the right tick")
+	{
+		int fired = 0;
+		uint64_t firedAt = 0;
+		timer_handle h = wheel.schedule(5, [&] { fired++; firedAt = wheel.now(); });
+		CHECK(h.is_valid());
+		CHECK(wheel.is_pending(h));
+		CHECK(wheel.remaining(h) == 5);
+		CHECK(wheel.size() == 1);
+
+		CHECK(wheel.advance(4) == 0);
+		CHECK(fired == 0);
+		CHECK(wheel.remaining(h) == 1);
+		CHECK(wheel.advance(1) == 1);
+		CHECK(fired == 1 && firedAt == 5);
+		CHECK(!wheel.is_pending(h));
+		CHECK(wheel.empty());
+		CHECK(wheel.advance(1000) == 0);
+		CHECK(wheel.now() == 1005);
+	}
+
+	SECTION("Cancel")
+	{
+		int fired = 0;
+		timer_handle a = wheel.schedule(10, [&] { fired++; });
+		timer_handle b = wheel.schedule(10, [&] { fired += 10; });
+		CHECK(wheel.cancel(a));
+		CHECK(!wheel.cancel(a));
+		CHECK(!wheel.is_pending(a));
+		CHECK(!wheel.cancel(timer_handle()));
+		wheel.advance(10);
+		CHECK(fired == 10);
+		// Already expired
+		CHECK(!wheel.cancel(b));
+
+		// A stale handle doesn't affect the timer that reused its node
+		timer_handle c = wheel.schedule(1, [&] { fired += 100; });
+		CHECK(c.index == b.index || c.index == a.index);
+		CHECK(!wheel.cancel(c.index == a.index ? a : b));
+		wheel.advance(1);
+		CHECK(fired == 110);
+	}
+
+	SECTION("Far timers cascade down through the levels")
+	{
+		Fired fired;
+		const uint64_t delays[] = { 1, 63, 64, 65, 4095, 4096, 4097, 300000, (uint64_t(1) << 24) + 12345 };
+		for (uint64_t d : delays)
+		{
+			wheel.schedule(d, [&fired, &wheel, d]
+			{
+				fired.inOrder = fired.inOrder && wheel.now() == d && wheel.now() >= fired.lastTick;
+				fired.lastTick = wheel.now();
+				fired.count++;
+			});
+		}
+
+		// Big jumps, and single ticks
+		wheel.advance(10);
+		for (int i = 0; i < 100; i++)
+		{
+			wheel.advance(1);
+		}
+		wheel.advance(299000);
+		wheel.advance(uint64_t(1) << 25);
+		CHECK(fired.count == 9);
+		CHECK(fired.inOrder);
+		CHECK(wheel.empty());
+	}
+
+	SECTION("Huge jumps skip empty ticks")
+	{
+		// Stepping through every level 0 ring would take hours
+		CHECK(wheel.advance(uint64_t(1) << 50) == 0);
+		CHECK(wheel.now() == uint64_t(1) << 50);
+		wheel.advance(12345);
+
+		// Timers beyond what the levels cover, scheduled from a tick that isn't at any level boundary
+		Fired fired;
+		const uint64_t start = wheel.now();
+		const uint64_t delays[] = { 5, (uint64_t(1) << 24) - 1, uint64_t(1) << 24, (uint64_t(1) << 40) + 777 };
+		for (uint64_t d : delays)
+		{
+			const uint64_t expiry = start + d;
+			wheel.schedule(d, [&fired, &wheel, expiry]
+			{
+				fired.inOrder = fired.inOrder && wheel.now() == expiry && wheel.now() >= fired.lastTick;
+				fired.lastTick = wheel.now();
+				fired.count++;
+			});
+		}
+
+		CHECK(wheel.advance(uint64_t(1) << 30) == 3);
+		CHECK(wheel.advance(uint64_t(1) << 42) == 1);
+		CHECK(fired.count == 4);
+		CHECK(fired.inOrder);
+		CHECK(wheel.empty());
+	}
+
+	SECTION("Callbacks can schedule and cancel")
+	{
+		struct State
+		{
+			timer_wheel<>* wheel;
+			int fired = 0;
+			bool cancelledSelf = false;
+			bool cancelledOther = false;
+			timer_handle self;
+			timer_handle other;
+		} state;
+		state.wheel = &wheel;
+
+		state.other = wheel.schedule(4, [&state] { state.fired += 100; });
+		state.self = wheel.schedule(3, [&state]
+		{
+			state.fired++;
+			// Running timers are no longer pending
+			state.cancelledSelf = state.wheel->cancel(state.self);
+			state.cancelledOther = state.wheel->cancel(state.other);
+			// Rescheduling for now goes to the next tick
+			state.wheel->schedule(0, [&state] { state.fired += 10; });
+		});
+
+		CHECK(wheel.advance(3) == 1);
+		CHECK(state.fired == 1);
+		CHECK(!state.cancelledSelf && state.cancelledOther);
+		CHECK(wheel.advance(1) == 1);
+		CHECK(state.fired == 11);
+	}
+
+	SECTION("Pool exhaustion")
+	{
+		int fired = 0;
+		for (int i = 0; i < 100; i++)
+		{
+			CHECK(wheel.schedule(i + 1, [&] { fired++; }).is_valid());
+		}
+		CHECK(!wheel.schedule(1, [&] { fired++; }).is_valid());
+		CHECK(wheel.advance(50) == 50);
+		CHECK(wheel.schedule(1, [&] { fired++; }).is_valid());
+		wheel.advance(100);
+		CHECK(fired == 101);
+	}
+
+	SECTION("Random schedule/cancel matches a brute force simulation")
+	{
+		constexpr int count = 100;
+		struct State
+		{
+			timer_handle handles[count];
+			uint64_t expiry[count] = {};
+			bool pending[count] = {};
+			bool ok = true;
+		} state;
+		Random rnd;
+
+		for (int step = 0; step < 2000; step++)
+		{
+			const int idx = static_cast<int>(rnd.next() % count);
+			if (state.pending[idx] && rnd.next() % 2)
+			{
+				state.ok = state.ok && wheel.cancel(state.handles[idx]);
+				state.pending[idx] = false;
+			}
+			else if (!state.pending[idx])
+			{
+				// Mostly near timers, some in the higher levels, and a few beyond what the levels cover
+				const uint32_t kind = rnd.next() % 16;
+				const uint64_t delay = kind == 0 ? rnd.next() % (1 << 26) + 1 :
+					(kind < 4 ? rnd.next() % 20000 + 1 : rnd.next() % 100 + 1);
+				state.expiry[idx] = wheel.now() + delay;
+				state.pending[idx] = true;
+				State* s = &state;
+				timer_wheel<>* w = &wheel;
+				state.handles[idx] = wheel.schedule(delay, [s, w, idx]
+				{
+					s->ok = s->ok && s->pending[idx] && s->expiry[idx] == w->now();
+					s->pending[idx] = false;
+				});
+			}
+
+			wheel.advance(rnd.next() % 64 == 0 ? rnd.next() % 1000000 : rnd.next() % 50);
+			for (int i = 0; i < count; i++)
+			{
+				state.ok = state.ok && (!state.pending[i] || state.expiry[i] > wheel.now());
+			}
+		}
+		CHECK(state.ok);
+		CHECK(wheel.size() == static_cast<size_t>(std::count_if(state.pending, state.pending + count, [](bool p) { return p; })));
+		wheel.advance(uint64_t(1) << 27);
+		CHECK(wheel.empty());
+		CHECK(std::count_if(state.pending, state.pending + count, [](bool p) { return p; }) == 0);
+	}
+}
@@ -0,0 +1,220 @@
+#include "test_utils.h"
+#include "impl/tlsf.h"
+
+using namespace cz;
+
+namespace cztlsftests
+{
+	alignas(64) char gMemory[64 * 1024];
+	alignas(64) char gMemory2[4 * 1024];
+
+	// Small xorshift, so the stress test is the same on every run
+	struct Random
+	{
+		uint32_t state = 2463534242u;
+
+		uint32_t next()
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+	};
+}
+
+using namespace cztlsftests;
+
+TEST_CASE("tlsf", "[tlsf]")
+{
+	tlsf heap(gMemory, sizeof(gMemory));
+	const tlsf_stats initial = heap.stats();
+	CHECK(initial.totalBytes > 63 * 1024 && initial.totalBytes < sizeof(gMemory));
+	CHECK(initial.freeBlocks == 1);
+	CHECK(initial.largestFreeBlock == initial.totalBytes);
+	CHECK(heap.validate());
+
+	SECTION("Allocate and free")
+	{
+		void* a = heap.allocate(10);
+		void* b = heap.allocate(100);
+		void* c = heap.allocate(0);
+		CHECK(a && b && c);
+		CHECK(reinterpret_cast<uintptr_t>(a) % tlsf::alignment == 0);
+		CHECK(reinterpret_cast<uintptr_t>(b) % tlsf::alignment == 0);
+		CHECK(tlsf::usable_size(a) >= 10);
+		CHECK(tlsf::usable_size(b) >= 100);
+		CHECK(heap.owns(a) && heap.owns(b) && heap.owns(c));
+		CHECK(!heap.owns(gMemory2));
+		memset(a, 0xAA, 10);
+		memset(b, 0xBB, 100);
+
+		tlsf_stats s = heap.stats();
+		CHECK(s.usedBlocks == 3);
+		CHECK(s.usedBytes == tlsf::usable_size(a) + tlsf::usable_size(b) + tlsf::usable_size(c));
+		CHECK(s.freeBlocks == 1);
+		CHECK(heap.validate());
+
+		// Freeing the middle one leaves a hole, that merges with the neighbours once they are freed too
+		heap.deallocate(b);
+		CHECK(heap.stats().freeBlocks == 2);
+		CHECK(heap.validate());
+		heap.deallocate(a);
+		CHECK(heap.stats().freeBlocks == 2);
+		heap.deallocate(c);
+		s = heap.stats();
+		CHECK(s.freeBlocks == 1);
+		CHECK(s.usedBytes == 0);
+		CHECK(s.largestFreeBlock == initial.largestFreeBlock);
+		CHECK(s.peakUsedBytes >= 110);
+		CHECK(heap.validate());
+
+		heap.deallocate(nullptr);
+	}
+
+	SECTION("Reuses freed blocks")
+	{
+		void* a = heap.allocate(200);
+		void* b = heap.allocate(200);
+		heap.deallocate(a);
+		CHECK(heap.allocate(150) == a);
+		heap.deallocate(a);
+		heap.deallocate(b);
+	}
+
+	SECTION("Exhaustion")
+	{
+		CHECK(heap.allocate(sizeof(gMemory)) == nullptr);
+		CHECK(heap.allocate(tlsf::max_allocation + 1) == nullptr);
+
+		void* ptrs[100];
+		int count = 0;
+		while (count < 100 && (ptrs[count] = heap.allocate(1000)) != nullptr)
+		{
+			count++;
+		}
+		CHECK(count > 50 && count < 100);
+		CHECK(heap.validate());
+		for (int i = 0; i < count; i++)
+		{
+			heap.deallocate(ptrs[i]);
+		}
+		CHECK(heap.stats().freeBlocks == 1);
+		CHECK(heap.validate());
+	}
+
+	SECTION("Multiple regions")
+	{
+		CHECK(!heap.add_region(gMemory2, 8));
+		CHECK(heap.add_region(gMemory2, sizeof(gMemory2)));
+		CHECK(heap.total_bytes() > initial.totalBytes + 3 * 1024);
+		CHECK(heap.stats().freeBlocks == 2);
+
+		// Bigger than what's left in the first region, but fits in the second
+		void* big = heap.allocate(initial.totalBytes - 2048);
+		void* small = heap.allocate(2048);
+		CHECK(big && small);
+		CHECK(small >= static_cast<void*>(gMemory2) && small < static_cast<void*>(gMemory2 + sizeof(gMemory2)));
+		CHECK(heap.validate());
+
+		int walked = 0;
+		heap.walk([&walked](const void*, size_t, bool used)
+		{
+			if (used)
+			{
+				walked++;
+			}
+		});
+		CHECK(walked == 2);
+
+		heap.deallocate(big);
+		heap.deallocate(small);
+		CHECK(heap.stats().freeBlocks == 2);
+		CHECK(heap.validate());
+	}
+
+	SECTION("Random allocations")
+	{
+		Random rnd;
+		void* ptrs[64] = {};
+		size_t sizes[64] = {};
+		bool ok = true;
+		for (int i = 0; i < 5000; i++)
+		{
+			const uint32_t idx = rnd.next() % 64;
+			if (ptrs[idx])
+			{
+				// Check nobody else wrote to it
+				const unsigned char* p = static_cast<const unsigned char*>(ptrs[idx]);
+				for (size_t b = 0; b < sizes[idx]; b++)
+				{
+					ok = ok && p[b] == (idx & 0xFF);
+				}
+				heap.deallocate(ptrs[idx]);
+				ptrs[idx] = nullptr;
+			}
+			else
+			{
+				sizes[idx] = (rnd.next() % 8 == 0) ? rnd.next() % 4000 : rnd.next() % 100;
+				ptrs[idx] = heap.allocate(sizes[idx]);
+				if (ptrs[idx])
+				{
+					memset(ptrs[idx], idx & 0xFF, sizes[idx]);
+				}
+			}
+
+			if (i % 100 == 0)
+			{
+				ok = ok && heap.validate();
+			}
+		}
+		CHECK(ok);
+
+		for (void* p : ptrs)
+		{
+			heap.deallocate(p);
+		}
+		const tlsf_stats s = heap.stats();
+		CHECK(s.freeBlocks == 1);
+		CHECK(s.usedBlocks == 0);
+		CHECK(s.largestFreeBlock == initial.largestFreeBlock);
+		CHECK(heap.validate());
+	}
+
+	SECTION("Backend")
+	{
+		void* before = malloc(16);
+
+		tlsf_backend backend(heap);
+		const detail::AllocatorBackend* b = backend.get();
+		void* ptr = b->alloc(b->userData, 100);
+		CHECK(heap.owns(ptr));
+		CHECK(b->alloc(b->userData, sizeof(gMemory)) == nullptr);
+		b->free(b->userData, ptr);
+		// Not from the heap, so it goes to free
+		b->free(b->userData, before);
+		CHECK(heap.used_bytes() == 0);
+
+		tlsf_backend fallback(heap, true);
+		b = fallback.get();
+		ptr = b->alloc(b->userData, sizeof(gMemory));
+		CHECK(ptr && !heap.owns(ptr));
+		b->free(b->userData, ptr);
+	}
+
+	SECTION("Global operator new")
+	{
+		int* before = new int(1);
+
+		tlsf_backend backend(heap);
+		detail::NewAllocator::_setBackend(backend.get());
+		int* a = new int(2);
+		CHECK(heap.owns(a));
+		CHECK(*a == 2);
+		delete a;
+		delete before;
+		detail::NewAllocator::_setBackend(nullptr);
+
+		CHECK(heap.used_bytes() == 0);
+	}
+}
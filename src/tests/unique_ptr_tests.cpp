@@ -0,0 +1,172 @@
+#include "czmut/czmut.h"
+#include <memory>
+
+namespace czuniqueptrtests
+{
+	int gDestroyed = 0;
+
+	struct Base
+	{
+		explicit Base(int v) : value(v) {}
+		virtual ~Base() { ++gDestroyed; }
+		int value;
+	};
+
+	struct Derived : public Base
+	{
+		using Base::Base;
+	};
+
+	struct EmptyDeleter
+	{
+		void operator()(Base* p) const { delete p; }
+	};
+
+	struct StatefulDeleter
+	{
+		int* counter;
+		void operator()(Base* p) const { ++(*counter); delete p; }
+	};
+
+	// Simple fixed size pool, to test allocate_unique
+	struct Pool
+	{
+		alignas(8) char buf[4][32];
+		bool used[4] = {};
+		int allocations = 0;
+
+		void* allocate(size_t bytes, size_t alignment)
+		{
+			CHECK(bytes <= sizeof(buf[0]) && alignment <= 8);
+			for (int i = 0; i < 4; i++)
+			{
+				if (!used[i])
+				{
+					used[i] = true;
+					++allocations;
+					return buf[i];
+				}
+			}
+			return nullptr;
+		}
+
+		void deallocate(void* ptr, size_t)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				if (buf[i] == ptr)
+				{
+					used[i] = false;
+					--allocations;
+				}
+			}
+		}
+	};
+
+	//
+	// Stateless deleters must not add to the size
+	//
+	static_assert(sizeof(std::unique_ptr<int>) == sizeof(int*), "");
+	static_assert(sizeof(std::unique_ptr<int[]>) == sizeof(int*), "");
+	static_assert(sizeof(std::unique_ptr<Base, EmptyDeleter>) == sizeof(Base*), "");
+	static_assert(sizeof(std::unique_ptr<Base, StatefulDeleter>) == sizeof(Base*) + sizeof(int*), "");
+	static_assert(sizeof(std::unique_ptr<Base, cz::allocator_delete<Base, Pool>>) == 2 * sizeof(Base*), "");
+
+	//
+	// Only conversions that delete with the right deleter are allowed
+	//
+	static_assert(std::is_constructible_v<std::unique_ptr<Base>, std::unique_ptr<Derived>&&>, "");
+	static_assert(std::is_assignable_v<std::unique_ptr<Base>&, std::unique_ptr<Derived>&&>, "");
+	static_assert(std::is_constructible_v<std::default_delete<Base>, const std::default_delete<Derived>&>, "");
+	// Array memory must not be freed with scalar delete
+	static_assert(!std::is_constructible_v<std::unique_ptr<int>, std::unique_ptr<int[]>&&>, "");
+	static_assert(!std::is_assignable_v<std::unique_ptr<int>&, std::unique_ptr<int[]>&&>, "");
+	// Unrelated or base to derived pointers
+	static_assert(!std::is_constructible_v<std::unique_ptr<Derived>, std::unique_ptr<Base>&&>, "");
+	static_assert(!std::is_constructible_v<std::unique_ptr<int>, std::unique_ptr<float>&&>, "");
+	static_assert(!std::is_assignable_v<std::unique_ptr<Derived>&, std::unique_ptr<Base>&&>, "");
+	static_assert(!std::is_constructible_v<std::default_delete<Derived>, const std::default_delete<Base>&>, "");
+	static_assert(!std::is_constructible_v<std::default_delete<int>, const std::default_delete<float>&>, "");
+	// Deleters that don't convert
+	static_assert(!std::is_constructible_v<std::unique_ptr<Base, EmptyDeleter>, std::unique_ptr<Derived>&&>, "");
+	static_assert(!std::is_constructible_v<std::unique_ptr<Base>, std::unique_ptr<Derived, StatefulDeleter>&&>, "");
+}
+
+using namespace czuniqueptrtests;
+
+TEST_CASE("unique_ptr", "[unique_ptr]")
+{
+	gDestroyed = 0;
+
+	SECTION("basic ownership")
+	{
+		{
+			std::unique_ptr<Base> p = std::make_unique<Base>(5);
+			CHECK(p && p->value == 5 && (*p).value == 5);
+			std::unique_ptr<Base> p2(std::move(p));
+			CHECK(!p && p == nullptr && p2 != nullptr);
+		}
+		CHECK(gDestroyed == 1);
+	}
+
+	SECTION("reset and release")
+	{
+		std::unique_ptr<Base> p(new Base(1));
+		p.reset(new Base(2));
+		CHECK(gDestroyed == 1 && p->value == 2);
+		Base* raw = p.release();
+		CHECK(!p && gDestroyed == 1);
+		delete raw;
+		p.reset();
+		CHECK(gDestroyed == 2);
+	}
+
+	SECTION("move assignment deletes the old object")
+	{
+		std::unique_ptr<Base> a(new Base(1));
+		std::unique_ptr<Base> b(new Base(2));
+		a = std::move(b);
+		CHECK(gDestroyed == 1 && a->value == 2 && !b);
+		a = nullptr;
+		CHECK(gDestroyed == 2);
+	}
+
+	SECTION("derived to base")
+	{
+		std::unique_ptr<Base> p = std::make_unique<Derived>(3);
+		CHECK(p->value == 3);
+		p = std::make_unique<Derived>(4);
+		CHECK(gDestroyed == 1 && p->value == 4);
+	}
+
+	SECTION("custom deleters")
+	{
+		int counter = 0;
+		{
+			std::unique_ptr<Base, StatefulDeleter> p(new Base(1), StatefulDeleter{&counter});
+			std::unique_ptr<Base, StatefulDeleter> p2(std::move(p));
+			CHECK(p2.get_deleter().counter == &counter);
+		}
+		CHECK(counter == 1 && gDestroyed == 1);
+	}
+
+	SECTION("array form")
+	{
+		std::unique_ptr<int[]> a = std::make_unique<int[]>(4);
+		CHECK(a[0] == 0 && a[3] == 0);
+		a[2] = 7;
+		CHECK(a.get()[2] == 7);
+		a.reset(new int[2]);
+	}
+
+	SECTION("allocate_unique")
+	{
+		Pool pool;
+		{
+			auto p = cz::allocate_unique<Derived>(pool, 9);
+			CHECK(p->value == 9 && pool.allocations == 1);
+			CHECK(reinterpret_cast<char*>(p.get()) == pool.buf[0]);
+		}
+		CHECK(pool.allocations == 0 && gDestroyed == 1);
+	}
+}
@@ -0,0 +1,91 @@
+#include "test_utils.h"
+#include <variant>
+
+using namespace czvectortests;
+using namespace cz;
+
+namespace czvarianttests
+{
+	struct Visitor
+	{
+		int operator()(int v) const { return v; }
+		int operator()(float v) const { return static_cast<int>(v) * 10; }
+		int operator()(const Foo& v) const { return v.a * 100; }
+	};
+}
+
+using namespace czvarianttests;
+
+// Smallest discriminant that fits
+static_assert(sizeof(variant<char, bool>) == 2, "");
+static_assert(sizeof(detail::variant_index_t<254>) == 1, "");
+static_assert(sizeof(detail::variant_index_t<255>) == 2, "");
+static_assert(sizeof(variant<int, float>) == 2 * sizeof(int), "");
+
+// Trivially copyable propagation
+static_assert(std::is_trivially_copyable_v<variant<int, float, char*>>, "");
+static_assert(std::is_trivially_destructible_v<variant<int, float>>, "");
+static_assert(!std::is_trivially_copyable_v<variant<int, Foo>>, "");
+static_assert(!std::is_trivially_destructible_v<variant<int, Foo>>, "");
+
+TEST_CASE("variant", "[variant]")
+{
+	gCounter.reset();
+
+	SECTION("Basic")
+	{
+		variant<int, float> v;
+		CHECK(v.index() == 0 && get<int>(v) == 0);
+		v = 2.0f;
+		CHECK(v.index() == 1 && holds_alternative<float>(v) && get<1>(v) == 2.0f);
+		CHECK(get_if<int>(&v) == nullptr && *get_if<float>(&v) == 2.0f);
+		v = 3;
+		CHECK(holds_alternative<int>(v) && get<int>(v) == 3);
+		CHECK((v == variant<int, float>(3)));
+		CHECK((v != variant<int, float>(3.0f)));
+
+		variant<monostate, int> m;
+		CHECK(holds_alternative<monostate>(m));
+	}
+
+	SECTION("visit")
+	{
+		variant<int, float, Foo> v(std::in_place_type<Foo>, 2);
+		CHECK(visit(Visitor(), v) == 200);
+		v = 5;
+		CHECK(visit(Visitor(), v) == 5);
+		v.emplace<float>(1.0f);
+		CHECK(visit(Visitor(), v) == 10);
+
+		// Visitor modifying the value
+		variant<int, float> n(1.0f);
+		visit([](auto& val) { val = val + 1; }, n);
+		CHECK(get<float>(n) == 2.0f);
+	}
+
+	SECTION("Object lifetime")
+	{
+		{
+			variant<int, Foo> a(std::in_place_index<1>, 1);
+			CHECK(gCounter.alive() == 1);
+
+			variant<int, Foo> b(a);
+			CHECK(gCounter.alive() == 2 && gCounter.copyConstructor == 1 && get<Foo>(b) == 1);
+
+			variant<int, Foo> c(std::move(a));
+			CHECK(gCounter.alive() == 3 && gCounter.moveConstructor == 1);
+
+			// Same alternative, so it assigns
+			b = c;
+			CHECK(gCounter.assigned == 1 && gCounter.alive() == 3);
+
+			// Different alternative, so it destroys the Foo
+			b = 5;
+			CHECK(gCounter.alive() == 2 && get<int>(b) == 5);
+
+			b = std::move(c);
+			CHECK(gCounter.alive() == 3 && gCounter.moveConstructor == 2 && get<Foo>(b) == 1);
+		}
+		CHECK(gCounter.alive() == 0);
+	}
+}
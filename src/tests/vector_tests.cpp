@@ -1,145 +1,8 @@
-#include "czmut/czmut.h"
-#include <string.h>
-#include <stdlib.h>
-
-// Provide my own allocator
-#define CZ_VECTOR_UNITTEST_ALLOCATOR 1
-
-#if CZ_VECTOR_UNITTEST_ALLOCATOR
-    namespace cz::detail
-    {
-        // Allocator with simple tracking that doesn't stl or fancy, so it minimizes dependencies
-        struct VectorAllocator
-        {
-            static constexpr int maxAllocs = 20;
-            struct Info
-            {
-                 void* ptr;
-                 size_t size;
-            };
-
-            static Info allocs[maxAllocs];
-
-            VectorAllocator()
-            {
-                 memset(allocs, 0, sizeof(allocs));
-            }
-
-            static size_t _calcBytesAllocated()
-            {
-                 size_t total = 0;
-                 for (auto&& slot : allocs)
-                 {
-                     total += slot.size;
-                 }
-                 return total;
-            }
-
-            static size_t _calcAllocations()
-            {
-                 size_t total = 0;
-                 for (auto&& slot : allocs)
-                 {
-                     if (slot.ptr)
-                     {
-                         total++;
-                     }
-                 }
-                 return total;
-            }
-
-            static void* _alloc(size_t bytes)
-            {
-                 Info* slot = getFreeSlot();
-                 slot->ptr = malloc(bytes);
-                 CHECK(slot->ptr);
-                 slot->size = bytes;
-                 return slot->ptr;
-            }
-
-            static void _free(void* ptr)
-            {
-                 Info* slot = getUsedSlot(ptr);
-                 free(slot->ptr);
-                 slot->ptr = nullptr;
-                 slot->size = 0;
-            }
-        protected:
-
-            static Info* getFreeSlot()
-            {
-                 for (auto&& slot : allocs)
-                 {
-                     if (!slot.ptr)
-                     {
-                         return &slot;
-                     }
-                 }
-                 CHECK(false);
-                 return nullptr; 
-            }
-
-            static Info* getUsedSlot(void* ptr)
-            {
-                 for (auto&& slot : allocs)
-                 {
-                     if (slot.ptr == ptr)
-                     {
-                         return &slot;
-                     }
-                 }
-                 CHECK(false);
-                 return nullptr;
-            }
-
-        };
-        
-        struct VectorAllocatorScopedCheck
-        {
-            VectorAllocatorScopedCheck()
-            {
-                 CHECK(VectorAllocator::_calcAllocations()==0);
-                 CHECK(VectorAllocator::_calcBytesAllocated()==0);
-            }
-            ~VectorAllocatorScopedCheck()
-            {
-                 CHECK(VectorAllocator::_calcAllocations()==0);
-                 CHECK(VectorAllocator::_calcBytesAllocated()==0);
-            }
-        };
-
-        VectorAllocator::Info VectorAllocator::allocs[VectorAllocator::maxAllocs]; \
-    	
-        class VectorTestCase : public ::cz::mut::detail::TestCase
-        {
-        public:
-            using TestCase::TestCase;
-            virtual void onEnter() override
-            {
-                 CHECK(VectorAllocator::_calcAllocations()==0);
-                 CHECK(VectorAllocator::_calcBytesAllocated()==0);
-            }
-            
-            virtual void onExit() override
-            {
-                 CHECK(VectorAllocator::_calcAllocations()==0);
-                 CHECK(VectorAllocator::_calcBytesAllocated()==0);
-            }
-        };
-    } // namespace cz::detail
-
-#else
-	namespace cz::detail
-    {
-        using VectorTestCase = cz::mut::TestCase;
-    }
-#endif
+#include "test_utils.h"
 
 #define VECTOR_TEST_CASE(Description) \
 	CUSTOM_TEMPLATED_TEST_CASE(cz::detail::VectorTestCase, Description, "[vector]", int, Foo)
 
-#include "impl/vector.h"
-
 //
 // Setup things that tells us if we can test behavior against STL
 #ifdef _WIN32
@@ -154,151 +17,6 @@
 	#include <vector>
 #endif
 
-// Putting these inside a named namespace instead of anonymous namespace, because Visual Studio's debugger has problems
-// with symbols in anonymous namespaces
-namespace czvectortests
-{
-
-    struct FooCounters
-    {
-        int valueCounter;
-        int destructor;
-        int defaultConstructor;
-        int constructor;
-        int copyConstructor;
-        int moveConstructor;
-        int constructorExtra;
-        int assigned;
-        int moveAssigned;
-
-        FooCounters()
-        {
-            memset(this, 0, sizeof(*this));
-        }
-
-        int totalCreated() const
-        {
-            return defaultConstructor + constructor + copyConstructor + moveConstructor + constructorExtra;
-        }
-
-        int alive() const
-        {
-            return totalCreated() - destructor;
-        }
-
-        void reset()
-        {
-            memset(this, 0, sizeof(*this));
-        }
-
-        bool operator==(const FooCounters& other) const
-        {
-            return memcmp(this, &other, sizeof(*this)) == 0 ? true : false;
-        }
-    } gCounter;
-    	
-    struct Foo
-    {
-        template<typename... Args>
-        void log(Args&&... args)
-        {
-            //printf(std::forward<Args>(args)...);
-        }
-
-        Foo()
-        {
-            a = ++gCounter.valueCounter;
-            log("%p: Default Constructor (%d)\n", this, a);
-            ++gCounter.defaultConstructor;
-        }
-
-        ~Foo()
-        {
-            log("%p: Destructor(%d)\n", this, a);
-            ++gCounter.destructor;
-        }
-
-        explicit Foo(int a) : a(a)
-        {
-            log("%p: Constructor(%d)\n", this, a);
-            ++gCounter.constructor;
-        }
-
-        explicit Foo(int a, int dummy) : a(a)
-        {
-            log("%p: Constructor(%d, %d)\n", this, a, dummy);
-            ++gCounter.constructorExtra;
-        }
-
-        Foo(const Foo& other) : a(other.a)
-        {
-            log("%p: Copy constructor(%d)\n", this, other.a);
-            ++gCounter.copyConstructor;
-        }
-
-        Foo(Foo&& other) noexcept : a(other.a)
-        {
-            log("%p: Move constructor(%d)\n", this, other.a);
-            other.a = 0;
-            ++gCounter.moveConstructor;
-        }
-
-    	operator int() const
-    	{
-        	return a;
-    	}
-
-        bool operator==(int other) const
-        {
-            return a == other;
-        }
-
-        bool operator!=(int other) const
-        {
-            return a != other;
-        }
-
-        bool operator==(const Foo& other) const
-        {
-            return a == other.a;
-        }
-
-        bool operator!=(const Foo& other) const
-        {
-            return a != other.a;
-        }
-
-        Foo& operator=(const Foo& other)
-        {
-            if (this != &other)
-            {
-                 log("%p: assigned (%d) = (%d)\n", this, a, other.a);
-                 a = other.a;
-                 ++gCounter.assigned;
-            }
-            return *this;
-        }
-
-        Foo& operator=(Foo&& other)
-        {
-            if (this != &other)
-            {
-                 log("%p: move assigned (%d) = (%d)\n", this, a, other.a);
-                 a = other.a;
-                 other.a = 0;
-                 ++gCounter.moveAssigned;
-            }
-            return *this;
-        }
-
-        int a;
-    };
-}
-
-// We only check object counters if using vectors of Foo
-#define CHECKFOO(expr) \
-    if constexpr (std::is_same_v<TestType, Foo>) { CHECK(expr) }
-
 #define CREATE_DEFAULT_VECTOR(v, count) \
     vector<TestType> v(count); \
 	if constexpr(std::is_same_v<TestType, int>) \
@@ -823,6 +541,55 @@ VECTOR_TEST_CASE("Modifiers API")
 
 	}
 
+	SECTION("insert range")
+	{
+		// Every position, with ranges shorter and longer than the tail, with and without enough capacity
+		bool allOk = true;
+		for (int doReserve = 0; doReserve < 2; doReserve++)
+		{
+			for (int count = 0; count <= 4; count++)
+			{
+				for (int idx = 0; idx <= 3; idx++)
+				{
+					gCounter.reset();
+					vector<TestType> range;
+					for (int i = 0; i < count; i++)
+					{
+						range.emplace_back(100 + i);
+					}
+
+					vector<TestType> v;
+					if (doReserve)
+					{
+						v.reserve(3 + count);
+					}
+					for (int i = 0; i < 3; i++)
+					{
+						v.emplace_back(i);
+					}
+
+					int expected[7];
+					for (int i = 0, src = 0; i < 3 + count; i++)
+					{
+						expected[i] = (i >= idx && i < idx + count) ? 100 + (i - idx) : src++;
+					}
+
+					TestType* it = v.insert(v.begin() + idx, range.begin(), range.end());
+					allOk = allOk && it == v.begin() + idx && v.size() == static_cast<size_t>(3 + count);
+					for (int i = 0; i < 3 + count; i++)
+					{
+						allOk = allOk && v[i] == expected[i];
+					}
+					if constexpr (std::is_same_v<TestType, Foo>)
+					{
+						allOk = allOk && gCounter.alive() == 3 + 2 * count;
+					}
+				}
+			}
+		}
+		CHECK(allOk);
+	}
+
 	SECTION("push_back")
 	{
 		// No need for complex tests, since it just uses emplace_back internally
@@ -965,3 +732,266 @@ VECTOR_TEST_CASE("operators")
 		CHECK(a != c);
 	}
 }
+
+namespace czvectortests
+{
+	// Exercises most of the API in constant evaluation, so any memset/memmove/reinterpret_cast left in those paths
+	// fails to compile
+	constexpr int constexprSum()
+	{
+		vector<int> v;
+		for (int i = 0; i < 10; i++)
+		{
+			v.push_back(i);
+		}
+		v.insert(v.begin(), 100);
+		v.erase(v.begin() + 1, v.begin() + 3);
+		v.pop_back();
+		v.shrink_to_fit();
+
+		vector<int> copy(v);
+		vector<int> other(3, 7);
+		other = copy;
+		if (!(other == v))
+		{
+			return -1;
+		}
+		other.assign(v.begin(), v.begin() + 2);
+
+		int sum = 0;
+		for (int i : v)
+		{
+			sum += i;
+		}
+		return sum + static_cast<int>(other.size());
+	}
+
+	// Non trivial elements
+	constexpr size_t constexprNested()
+	{
+		vector<vector<int>> v;
+		for (int i = 0; i < 5; i++)
+		{
+			v.emplace_back(static_cast<size_t>(i), i);
+		}
+		v.erase(v.begin());
+		v.emplace(v.begin(), 2, 0);
+		size_t count = 0;
+		for (const vector<int>& inner : v)
+		{
+			count += inner.size();
+		}
+		return count;
+	}
+
+	constexpr auto gSquares = freeze_vector<[]
+	{
+		vector<int> v;
+		for (int i = 0; i < 8; i++)
+		{
+			v.push_back(i * i);
+		}
+		return v;
+	}>();
+}
+
+VECTOR_TEST_CASE("constexpr")
+{
+	static_assert(constexprSum() == 100 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 2);
+	static_assert(constexprNested() == 2 + 1 + 2 + 3 + 4);
+	static_assert(gSquares.size() == 8);
+	static_assert(gSquares[7] == 49);
+
+	// Same code at runtime gives the same results
+	CHECK(constexprSum() == 100 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 2);
+	CHECK(constexprNested() == 2 + 1 + 2 + 3 + 4);
+	CHECK(gSquares[3] == 9);
+}
+
+namespace czvectortests
+{
+	struct alignas(32) Lane
+	{
+		float v[8];
+	};
+}
+
+CUSTOM_TEST_CASE(cz::detail::VectorTestCase, "Alignment", "[vector]")
+{
+	SECTION("Over-aligned T")
+	{
+		vector<Lane> v;
+		bool aligned = true;
+		for (int i = 0; i < 10; i++)
+		{
+			v.push_back(Lane{ { static_cast<float>(i) } });
+			aligned = aligned && reinterpret_cast<uintptr_t>(v.data()) % alignof(Lane) == 0;
+		}
+		CHECK(aligned);
+		CHECK(v[9].v[0] == 9.0f);
+
+		vector<Lane> copy(v);
+		CHECK(reinterpret_cast<uintptr_t>(copy.data()) % alignof(Lane) == 0);
+		CHECK(copy.size() == 10);
+
+		// Plain new/delete use the aligned overloads
+		Lane* lane = new Lane;
+		CHECK(reinterpret_cast<uintptr_t>(lane) % alignof(Lane) == 0);
+		delete lane;
+	}
+
+	SECTION("Alignment bigger than alignof(T)")
+	{
+		vector<float, 64> v;
+		bool aligned = true;
+		for (int i = 0; i < 100; i++)
+		{
+			v.push_back(static_cast<float>(i));
+			aligned = aligned && reinterpret_cast<uintptr_t>(v.data()) % 64 == 0;
+		}
+		v.shrink_to_fit();
+		aligned = aligned && reinterpret_cast<uintptr_t>(v.data()) % 64 == 0;
+		CHECK(aligned);
+
+		vector<float, 64> other(3, 1.0f);
+		other = v;
+		CHECK(other == v);
+		CHECK(reinterpret_cast<uintptr_t>(other.data()) % 64 == 0);
+
+		vector<float, 64> moved(std::move(other));
+		CHECK(moved.size() == 100);
+		CHECK(moved[99] == 99.0f);
+	}
+}
+
+VECTOR_TEST_CASE("Bulk erase")
+{
+	gCounter.reset();
+	CREATE_DEFAULT_VECTOR(v, 10);
+
+	SECTION("erase_if")
+	{
+		gCounter.reset();
+		CHECK(erase_if(v, [](const TestType& e) { return e % 3 == 0; }) == 3);
+		CHECK(cz::mut::equals(v.data(), v.size(), {1,2,4,5,7,8,10}));
+		// Each kept element after the first removed one is moved once, and the removed ones destroyed
+		CHECKFOO(gCounter.moveAssigned == 5 && gCounter.destructor == 3);
+
+		CHECK(erase_if(v, [](const TestType&) { return false; }) == 0);
+		CHECK(v.size() == 7);
+		CHECK(erase_if(v, [](const TestType&) { return true; }) == 7);
+		CHECK(v.empty());
+	}
+
+	SECTION("Predicate is called once per element")
+	{
+		// Several runs of kept and removed elements, ending with removed ones
+		int calls = 0;
+		CHECK(erase_if(v, [&calls](const TestType& e) { ++calls; return e == 3 || e == 4 || e == 7 || e >= 9; }) == 5);
+		CHECK(calls == 10);
+		CHECK(cz::mut::equals(v.data(), v.size(), {1,2,5,6,8}));
+
+		// A stateful predicate sees each element once, in order
+		int seen = 0;
+		CHECK(erase_if(v, [&seen](const TestType&) { return (seen++ % 2) == 1; }) == 2);
+		CHECK(seen == 5);
+		CHECK(cz::mut::equals(v.data(), v.size(), {1,5,8}));
+	}
+
+	SECTION("erase value")
+	{
+		v[2] = TestType(1);
+		v[9] = TestType(1);
+		CHECK(erase(v, 1) == 3);
+		CHECK(cz::mut::equals(v.data(), v.size(), {2,4,5,6,7,8,9}));
+		CHECK(erase(v, 100) == 0);
+	}
+
+	SECTION("erase_unordered")
+	{
+		gCounter.reset();
+		TestType* p = v.erase_unordered(&v[2]);
+		CHECK(*p == 10);
+		CHECK(cz::mut::equals(v.data(), v.size(), {1,2,10,4,5,6,7,8,9}));
+		CHECKFOO(gCounter.moveAssigned == 1 && gCounter.destructor == 1);
+
+		p = v.erase_unordered(&v.back());
+		CHECK(p == v.end());
+		CHECK(cz::mut::equals(v.data(), v.size(), {1,2,10,4,5,6,7,8}));
+
+		while (!v.empty())
+		{
+			v.erase_unordered(v.begin());
+		}
+		CHECKFOO(gCounter.destructor == 10);
+	}
+
+	SECTION("unique")
+	{
+		vector<TestType> dups;
+		for (int i : {1, 1, 2, 3, 3, 3, 1, 4, 4})
+		{
+			dups.emplace_back(i);
+		}
+		dups.erase(std::unique(dups.begin(), dups.end()), dups.end());
+		CHECK(cz::mut::equals(dups.data(), dups.size(), {1,2,3,1,4}));
+
+		vector<TestType> empty;
+		CHECK(std::unique(empty.begin(), empty.end()) == empty.end());
+	}
+
+	SECTION("stable_partition")
+	{
+		TestType* mid = std::stable_partition(v.begin(), v.end(), [](const TestType& e) { return e % 2 == 0; });
+		CHECK(mid == v.begin() + 5);
+		CHECK(cz::mut::equals(v.data(), v.size(), {2,4,6,8,10,1,3,5,7,9}));
+
+		mid = std::stable_partition(v.begin(), v.end(), [](const TestType&) { return true; });
+		CHECK(mid == v.end());
+		CHECK(cz::mut::equals(v.data(), v.size(), {2,4,6,8,10,1,3,5,7,9}));
+	}
+
+	SECTION("rotate")
+	{
+		CHECK(std::rotate(v.begin(), v.begin() + 3, v.end()) == v.begin() + 7);
+		CHECK(cz::mut::equals(v.data(), v.size(), {4,5,6,7,8,9,10,1,2,3}));
+		CHECK(std::rotate(v.begin(), v.begin(), v.end()) == v.end());
+		CHECK(std::rotate(v.begin(), v.end(), v.end()) == v.begin());
+	}
+
+	SECTION("remove_if matches a one by one erase")
+	{
+		// Different densities, including runs of kept and removed elements of all lengths
+		bool ok = true;
+		for (int period = 1; period < 8; period++)
+		{
+			vector<TestType> a;
+			vector<TestType> b;
+			for (int i = 0; i < 50; i++)
+			{
+				a.emplace_back(i);
+				b.emplace_back(i);
+			}
+			auto pred = [period](const TestType& e) { return (e / period) % 2 == 0; };
+
+			erase_if(a, pred);
+			for (size_t i = 0; i < b.size();)
+			{
+				if (pred(b[i]))
+				{
+					b.erase(b.begin() + i);
+				}
+				else
+				{
+					i++;
+				}
+			}
+			ok = ok && a.size() == b.size();
+			for (size_t i = 0; ok && i < a.size(); i++)
+			{
+				ok = ok && static_cast<int>(a[i]) == static_cast<int>(b[i]);
+			}
+		}
+		CHECK(ok);
+	}
+}